@@ -53,6 +53,7 @@ typedef const char  *(*rp_app_desc_func)(void);
 typedef int          (*rp_set_params_func)(rp_app_params_t *p, int len);
 typedef int          (*rp_get_params_func)(rp_app_params_t **p);
 typedef int          (*rp_get_signals_func)(float ***s, int *sig_num, int *sig_len);
+typedef int          (*rp_get_waterfall_func)(unsigned int since, void *buf, int len);
 
 /*WebSocket Server part*/
 typedef void		(*rp_ws_set_params_interval_func)(int);
@@ -64,6 +65,8 @@ typedef const char     *(*rp_ws_get_signals_func)(void);
 typedef int		(*rp_ws_set_params_func)(const char *_params);
 typedef int		(*rp_ws_set_signals_func)(const char *_signals);
 typedef void	(*rp_ws_gzip_func)(const char *_in, void* _data, size_t* _size);
+typedef int		(*rp_ws_get_signal_frames_func)(unsigned int _mask, const void** _frames, size_t* _sizes);
+typedef void	(*rp_ws_set_params_notify_func)(void (*_notify)(void));
 
 typedef struct rp_bazaar_app_s {
     /* Initialization function - called when app. is loaded */
@@ -83,6 +86,9 @@ typedef struct rp_bazaar_app_s {
     rp_get_params_func       get_params_func;
     /* Retrieves last good signals from the application */
     rp_get_signals_func      get_signals_func;
+    /* Optional, copies the binary waterfall rows newer than 'since' to buf,
+     * with buf NULL returns the maximal size */
+    rp_get_waterfall_func    get_waterfall_func;
 
 	/*WebSocket Server part*/
 
@@ -98,6 +104,8 @@ typedef struct rp_bazaar_app_s {
 	rp_ws_set_params_interval_func ws_set_params_demo_func;
 	rp_ws_set_params_func verify_app_license_func;
 	rp_ws_gzip_func ws_gzip_func;
+	rp_ws_get_signal_frames_func ws_get_signal_frames_func; /* optional */
+	rp_ws_set_params_notify_func ws_set_params_notify_func; /* optional */
 
     /* Dynamic library handle */
     void            *handle;
@@ -36,6 +36,7 @@ const char *c_rp_set_params_str   = "rp_set_params";
 const char *c_rp_get_params_str   = "rp_get_params";
 const char *c_rp_set_signals_str  = "rp_set_signals";
 const char *c_rp_get_signals_str  = "rp_get_signals";
+const char *c_rp_get_waterfall_str = "rp_get_waterfall";
 
 //start web socket function str
 
@@ -48,6 +49,8 @@ const char *c_ws_get_params_str   = "ws_get_params";
 const char *c_ws_set_signals_str  = "ws_set_signals";
 const char *c_ws_get_signals_str  = "ws_get_signals";
 const char* c_ws_gzip_str = "ws_gzip";
+const char* c_ws_get_signal_frames_str = "ws_get_signal_frames";
+const char* c_ws_set_params_notify_str = "ws_set_params_notify";
 // end web socket function str
 
 /** Get MAC address of a specific NIC via sysfs */
@@ -404,6 +407,9 @@ int rp_bazaar_app_load_module(const char *app_file, rp_bazaar_app_t *app)
     if(!app->get_signals_func)
         return -7;
 
+    /* Optional, only applications with a waterfall diagram */
+    app->get_waterfall_func = dlsym(app->handle, c_rp_get_waterfall_str);
+
     // start web socket functionality
     app->ws_api_supported = 1;
     app->ws_set_params_interval_func = dlsym(app->handle, c_ws_set_params_interval_str);
@@ -469,6 +475,11 @@ int rp_bazaar_app_load_module(const char *app_file, rp_bazaar_app_t *app)
         fprintf(stderr, "Cannot resolve '%s' function.\n", c_ws_gzip_str);
     }
 
+    /* Binary signal frames are optional, older applications send only JSON */
+    app->ws_get_signal_frames_func = dlsym(app->handle, c_ws_get_signal_frames_str);
+    /* Optional, without it parameters are sent only on the timer */
+    app->ws_set_params_notify_func = dlsym(app->handle, c_ws_set_params_notify_str);
+
     // end web socket functionality
 
     app->file_name = (char *)malloc(strlen(app_file)+1);
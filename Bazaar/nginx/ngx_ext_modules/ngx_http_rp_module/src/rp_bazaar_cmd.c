@@ -536,6 +536,8 @@ int rp_bazaar_start(ngx_http_request_t *r,
         params.get_signals_func = rp_module_ctx.app.ws_get_signals_func;
         params.set_signals_func = rp_module_ctx.app.ws_set_signals_func;
         params.gzip_func = rp_module_ctx.app.ws_gzip_func;
+        params.get_signal_frames_func = rp_module_ctx.app.ws_get_signal_frames_func;
+        params.set_params_notify_func = rp_module_ctx.app.ws_set_params_notify_func;
         fprintf(stderr, "Starting WS-server\n");
 
         start_ws_server(&params);
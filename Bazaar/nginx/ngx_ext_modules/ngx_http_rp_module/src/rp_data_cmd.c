@@ -25,6 +25,9 @@
 static float **rp_signals = NULL;
 static int     rp_signals_dirty = 0;
 
+static const char *c_waterfall_uri = "/data/waterfall";
+static const char *c_binary_content_str = "application/octet-stream";
+
 #define TRACE(args...) fprintf(stderr, args)
 
 
@@ -38,6 +41,81 @@ typedef struct rp_data_ctx_s {
 } rp_data_ctx_t;
 
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Handler function for /data/waterfall GET requests.
+ *
+ * Replies with the binary waterfall rows which the application computed after
+ * the row sequence given by the 'since' argument (0 or missing for all rows
+ * still held by the application). The reply format is defined by the
+ * application, the client polls it when the row sequence parameter changes.
+ *
+ * @retval NGX_HTTP_NOT_ALLOWED            Not a GET request
+ * @retval NGX_HTTP_NOT_FOUND              Application without waterfall rows
+ * @retval NGX_HTTP_INTERNAL_SERVER_ERROR  Failure while getting the rows
+ * @retval other                           returned value from ngx_http_output_filter()
+ */
+static ngx_int_t rp_data_waterfall_handler(ngx_http_request_t *r)
+{
+    ngx_str_t   arg_name = ngx_string("arg_since");
+    ngx_http_variable_value_t *arg_val;
+    ngx_buf_t  *b;
+    ngx_chain_t out;
+    ngx_int_t   rc;
+    unsigned int since = 0;
+    int len;
+
+    if(!(r->method & NGX_HTTP_GET)) {
+        return NGX_HTTP_NOT_ALLOWED;
+    }
+
+    if(!rp_module_ctx.app.handle || !rp_module_ctx.app.get_waterfall_func) {
+        return NGX_HTTP_NOT_FOUND;
+    }
+
+    arg_val = ngx_http_get_variable(r, &arg_name,
+                                    ngx_hash_key(arg_name.data, arg_name.len));
+    if(arg_val && !arg_val->not_found && arg_val->valid && arg_val->len) {
+        ngx_int_t v = ngx_atoi(arg_val->data, arg_val->len);
+        if(v > 0)
+            since = (unsigned int)v;
+    }
+
+    len = rp_module_ctx.app.get_waterfall_func(since, NULL, 0);
+    if(len <= 0) {
+        return NGX_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    b = ngx_create_temp_buf(r->pool, len);
+    if(b == NULL) {
+        rp_error(r->connection->log, "Can not allocate memory");
+        return NGX_HTTP_INTERNAL_SERVER_ERROR;
+    }
+    len = rp_module_ctx.app.get_waterfall_func(since, b->pos, len);
+    if(len < 0) {
+        return NGX_HTTP_INTERNAL_SERVER_ERROR;
+    }
+    b->last = b->pos + len;
+    b->last_buf = b->last_in_chain = 1;
+    b->flush = 1;
+    out.buf = b;
+    out.next = NULL;
+
+    r->headers_out.content_type_len = strlen(c_binary_content_str);
+    r->headers_out.content_type.len = strlen(c_binary_content_str);
+    r->headers_out.content_type.data = (u_char *)c_binary_content_str;
+    r->headers_out.status = NGX_HTTP_OK;
+    r->headers_out.content_length_n = len;
+
+    rc = ngx_http_send_header(r);
+    if (rc == NGX_ERROR || rc > NGX_OK || r->header_only) {
+        return rc;
+    }
+
+    return ngx_http_output_filter(r, &out);
+}
+
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Handler function for /data GET & POST requests.
@@ -60,6 +138,11 @@ ngx_int_t rp_data_cmd_handler(ngx_http_request_t *r)
         return NGX_HTTP_NOT_ALLOWED;
     }
 
+    if((r->uri.len >= strlen(c_waterfall_uri)) &&
+       (ngx_strncmp(r->uri.data, c_waterfall_uri, strlen(c_waterfall_uri)) == 0)) {
+        return rp_data_waterfall_handler(r);
+    }
+
     rp_debug(r->connection->log, "%s: %s", __FUNCTION__,
              (r->method & NGX_HTTP_GET) ? "GET" : "POST");
 
@@ -2,6 +2,8 @@
 
 #include <libjson.h>
 
+class CSignalFrame;
+
 class CBaseParameter  //base class for parameter and signal
 {
 public:
@@ -17,6 +19,7 @@ public:
 		AccessModes
 	};
 
+	CBaseParameter() : m_Queued(false) {};
 	virtual ~CBaseParameter(){};
 	virtual const char* GetName() const = 0;
 	virtual void Update() = 0;		//apply change of value
@@ -27,4 +30,9 @@ public:
 	virtual bool IsNewValue() const = 0;
 	virtual void ClearNewValue() = 0;
 	virtual bool NeedSend(bool _no_need=false) const { return _no_need; };
+	virtual void WriteFrame(CSignalFrame& _frame) const {};	// append the signal to a binary frame
+
+protected:
+	friend class CDataManager;
+	bool m_Queued;	// in the list of changed parameters of CDataManager
 };
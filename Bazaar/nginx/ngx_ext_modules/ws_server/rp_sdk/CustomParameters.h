@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "Parameter.h"
+#include "SignalFrame.h"
 
 #define CONFIG_VAR 1
 
@@ -18,6 +19,7 @@ public:
 	void Set(const Type& _value)
 	{
 		this->m_Value.value = _value;
+		this->Changed();
 	}
 
 	bool IsValueChanged() const
@@ -108,12 +110,14 @@ public:
 	void Set(const Type& _value)
 	{
 		this->m_Value.value = CheckMinMax(_value);
+		this->Changed();
 	}
 
 	void SetMax(const Type& _max)
 	{
 		this->m_Value.max = _max;
 		this->m_Value.value = CheckMinMax(this->m_Value.value);
+		this->Changed();
 	}
 
 	const Type& GetMax()
@@ -125,6 +129,7 @@ public:
 	{
 		this->m_Value.min = _min;
 		this->m_Value.value = CheckMinMax(this->m_Value.value);
+		this->Changed();
 	}
 
 	const Type& GetMin()
@@ -156,6 +161,7 @@ public:
 	{
 		this->m_Value.value = CheckMinMax(_value);
 		m_NeedSend = true;
+		this->Changed();
 	}
 
 	bool NeedSend(bool _no_need=false) const
@@ -216,6 +222,11 @@ public:
 		return n;
 	}
 
+	void WriteFrame(CSignalFrame& _frame) const
+	{
+		_frame.Add(this->m_Value.name, this->m_Value.value.data(), this->m_Value.value.size());
+	}
+
 	const Type& operator [](int _index) const
 	{
 		return this->m_Value.value.at(_index);
@@ -342,6 +353,7 @@ public:
 	void Set(const std::string& _value)
 	{
 		this->m_Value.value = _value;
+		this->Changed();
 	}
 };
 
@@ -37,9 +37,13 @@ inline bool CDataManager::NeedSend(const CBaseParameter& param) const
 CDataManager::CDataManager()
 	: m_params()
 	, m_signals()
+	, m_updating_params(false)
+	, m_params_notify(NULL)
 	, m_param_interval(20)
 	, m_signal_interval(20)
 	, m_send_all_params(true)
+	, m_signal_sequence(0)
+	, m_signals_json()
 {
 }
 
@@ -53,6 +57,11 @@ void CDataManager::RegisterParam(CBaseParameter * _param)
 {
 	dbg_printf("RegisterParam: %s\n", _param->GetName());
 	m_params.push_back(_param);
+	if(!m_params_index.emplace(_param->GetName(), _param).second)
+		dbg_printf("Parameter %s is already registered\n", _param->GetName());
+	CBaseParameter::AccessMode mode = _param->GetAccessMode();
+	if(mode == CBaseParameter::AccessMode::RWSA || mode == CBaseParameter::AccessMode::ROSA)
+		m_always_params.push_back(_param);
 	dbg_printf("Registered params: %d\n", m_params.size());
 }
 
@@ -60,16 +69,56 @@ void CDataManager::RegisterSignal(CBaseParameter * _signal)
 {
 	dbg_printf("RegisterSignal: %s\n", _signal->GetName());
 	m_signals.push_back(_signal);
+	if(!m_signals_index.emplace(_signal->GetName(), _signal).second)
+		dbg_printf("Signal %s is already registered\n", _signal->GetName());
 	dbg_printf("Registered signals: %d\n", m_signals.size());
 }
 
+static void EraseParam(std::vector<CBaseParameter *>& _list, CBaseParameter * _param)
+{
+	for(std::vector<CBaseParameter *>::iterator it = _list.begin(); it != _list.end(); ++it)
+	{
+		if(*it == _param)
+		{
+			_list.erase(it);
+			return;
+		}
+	}
+}
+
+// The index points to the first parameter with the name that is still registered
+static void EraseIndex(std::unordered_map<std::string, CBaseParameter*>& _index, const std::vector<CBaseParameter *>& _list, CBaseParameter * _param)
+{
+	std::unordered_map<std::string, CBaseParameter*>::iterator it = _index.find(_param->GetName());
+	if(it == _index.end() || it->second != _param)
+		return;
+	_index.erase(it);
+	for(size_t i=0; i < _list.size(); i++)
+	{
+		if(strcmp(_list[i]->GetName(), _param->GetName())==0)
+		{
+			_index.emplace(_list[i]->GetName(), _list[i]);
+			return;
+		}
+	}
+}
+
 void CDataManager::UnRegisterParam(const char * _name)
 {
 	for (std::vector<CBaseParameter *>::iterator it =  m_params.begin() ; it !=  m_params.end(); ++it)
 	{
 		if(strcmp((*it)->GetName(),_name)==0)
 		{
+			CBaseParameter * param = *it;
 			m_params.erase(it);
+			EraseIndex(m_params_index, m_params, param);
+			EraseParam(m_always_params, param);
+			EraseParam(m_new_params, param);
+			{
+				std::lock_guard<std::mutex> lock(m_changed_mutex);
+				EraseParam(m_changed_params, param);
+				param->m_Queued = false;
+			}
 			dbg_printf("UnRegisterParam: %s\n", _name);
 			return;
 		}
@@ -78,11 +127,14 @@ void CDataManager::UnRegisterParam(const char * _name)
 
 void CDataManager::UnRegisterSignal(const char * _name)
 {
-	for (std::vector<CBaseParameter *>::iterator it =  m_signals.begin() ; it !=  m_params.end(); ++it)
+	for (std::vector<CBaseParameter *>::iterator it =  m_signals.begin() ; it !=  m_signals.end(); ++it)
 	{
 		if(strcmp((*it)->GetName(),_name)==0)
 		{
+			CBaseParameter * signal = *it;
 			m_signals.erase(it);
+			EraseIndex(m_signals_index, m_signals, signal);
+			EraseParam(m_new_signals, signal);
 			dbg_printf("UnRegisterSignal: %s\n", _name);
 			return;
 		}
@@ -105,17 +157,53 @@ void CDataManager::UpdateAllSignals()
 
 std::string CDataManager::GetParamsJson()
 {
+	{
+		std::lock_guard<std::mutex> lock(m_changed_mutex);
+		m_updating_params = true;
+	}
 	UpdateParams();
+
+	// Only the queued parameters can have changed since the last call
+	std::vector<CBaseParameter*> changed;
+	{
+		std::lock_guard<std::mutex> lock(m_changed_mutex);
+		changed.swap(m_changed_params);
+		for(size_t i=0; i < changed.size(); i++)
+			changed[i]->m_Queued = false;
+	}
+	const std::vector<CBaseParameter*>& check = m_send_all_params ? m_params : changed;
+
 	JSONNode params(JSON_NODE);
 	params.set_name("parameters");
-	for(size_t i=0; i < m_params.size(); i++) {
-		if(NeedSend(*m_params[i])) {
+	for(size_t i=0; i < check.size(); i++) {
+		if(NeedSend(*check[i])) {
 			JSONNode n(JSON_NODE);
-			n = m_params[i]->GetJSONObject();
-			m_params[i]->NeedSend(true); // no need
+			n = check[i]->GetJSONObject();
+			check[i]->NeedSend(true); // no need
 			params.push_back(n);
 		}
 	}
+	if(!m_send_all_params) {
+		for(size_t i=0; i < m_always_params.size(); i++) {
+			JSONNode n(JSON_NODE);
+			n = m_always_params[i]->GetJSONObject();
+			m_always_params[i]->NeedSend(true);
+			params.push_back(n);
+		}
+	}
+
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> lock(m_changed_mutex);
+		m_updating_params = false;
+		// Queued by another thread while this update was running
+		notify = !m_changed_params.empty() && m_params_notify;
+	}
+	if(notify)
+		m_params_notify();
+
+	if(params.size() == 0 && !m_send_all_params)
+		return "";
 
 	JSONNode data_node(JSON_NODE);
 	data_node.set_name("data");
@@ -124,25 +212,87 @@ std::string CDataManager::GetParamsJson()
 	return data_node.write();
 }
 
+void CDataManager::ParamChanged(CBaseParameter * _param)
+{
+	CBaseParameter::AccessMode mode = _param->GetAccessMode();
+	if(mode == CBaseParameter::AccessMode::RWSA || mode == CBaseParameter::AccessMode::ROSA)
+		return;
+
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> lock(m_changed_mutex);
+		if(_param->m_Queued)
+			return;
+		_param->m_Queued = true;
+		m_changed_params.push_back(_param);
+		// Changes made by UpdateParams go out with the update that is running
+		notify = m_changed_params.size() == 1 && !m_updating_params && m_params_notify;
+	}
+	if(notify)
+		m_params_notify();
+}
+
+void CDataManager::SetParamsNotify(void (*_notify)(void))
+{
+	std::lock_guard<std::mutex> lock(m_changed_mutex);
+	m_params_notify = _notify;
+}
+
 std::string CDataManager::GetSignalsJson()
+{
+	const void* frames[CSignalFrame::Formats];
+	size_t sizes[CSignalFrame::Formats];
+	GetSignalFrames(1u << CSignalFrame::JSON, frames, sizes);
+	return m_signals_json;
+}
+
+void CDataManager::GetSignalFrames(unsigned int _mask, const void** _frames, size_t* _sizes)
 {
 	UpdateSignals();
-	JSONNode signals(JSON_NODE);
-	signals.set_name("signals");
+	std::vector<CBaseParameter*> send;
 	for(size_t i=0; i < m_signals.size(); i++) {
-		if(NeedSend(*m_signals[i])) {
+		if(NeedSend(*m_signals[i]))
+			send.push_back(m_signals[i]);
+	}
+
+	for(int f = 0; f < CSignalFrame::Formats; f++) {
+		_frames[f] = NULL;
+		_sizes[f] = 0;
+	}
+
+	if(_mask & (1u << CSignalFrame::JSON)) {
+		JSONNode signals(JSON_NODE);
+		signals.set_name("signals");
+		for(size_t i=0; i < send.size(); i++) {
 			JSONNode n(JSON_NODE);
-			n = m_signals[i]->GetJSONObject();
+			n = send[i]->GetJSONObject();
 			signals.push_back(n);
-			m_signals[i]->Update();
 		}
+
+		JSONNode data_node(JSON_NODE);
+		data_node.set_name("data");
+		data_node.push_back(signals);
+		m_signals_json = data_node.write();
+		_frames[CSignalFrame::JSON] = m_signals_json.c_str();
+		_sizes[CSignalFrame::JSON] = m_signals_json.size();
 	}
 
-	JSONNode data_node(JSON_NODE);
-	data_node.set_name("data");
-	data_node.push_back(signals);
+	for(int f = CSignalFrame::JSON + 1; f < CSignalFrame::Formats; f++) {
+		if(!(_mask & (1u << f)))
+			continue;
+		CSignalFrame& frame = m_signal_frames[f];
+		frame.Begin((CSignalFrame::Format)f, m_signal_sequence);
+		for(size_t i=0; i < send.size(); i++)
+			send[i]->WriteFrame(frame);
+		frame.End();
+		_frames[f] = frame.Data();
+		_sizes[f] = frame.Size();
+	}
+
+	for(size_t i=0; i < send.size(); i++)
+		send[i]->Update();
+	m_signal_sequence++;
 	PostUpdateSignals();
-	return data_node.write();
 }
 
 void CDataManager::OnNewParams(std::string _params)
@@ -151,22 +301,18 @@ void CDataManager::OnNewParams(std::string _params)
 	n = libjson::parse(_params);
 	JSONNode m(JSON_NODE);
 
-	for (size_t i=0; i < m_params.size(); ++i)
-		m_params[i]->ClearNewValue();
+	for (size_t i=0; i < m_new_params.size(); ++i)
+		m_new_params[i]->ClearNewValue();
+	m_new_params.clear();
 
 	for (size_t i=0; i < n.size(); ++i)
 	{
 		m = n.at(i);
-		std::string name = m.name();
-
-		for (size_t j=0; j < m_params.size(); ++j)
+		std::unordered_map<std::string, CBaseParameter*>::iterator it = m_params_index.find(m.name());
+		if (it != m_params_index.end() && it->second->GetAccessMode() != CBaseParameter::AccessMode::RO)
 		{
-			if (m_params[j]->GetAccessMode() != CBaseParameter::AccessMode::RO)
-			{
-				std::string param_name = m_params[j]->GetName();
-				if (name == param_name)
-					m_params[j]->SetValueFromJSON(m);
-			}
+			it->second->SetValueFromJSON(m);
+			m_new_params.push_back(it->second);
 		}
 	}
 
@@ -183,20 +329,17 @@ void CDataManager::OnNewSignals(std::string _signals)
 	n = libjson::parse(_signals);
 	JSONNode m(JSON_NODE);
 
-	for(size_t i=0; i < m_signals.size(); i++)
-		m_signals[i]->ClearNewValue();
+	for(size_t i=0; i < m_new_signals.size(); i++)
+		m_new_signals[i]->ClearNewValue();
+	m_new_signals.clear();
 
 	for(size_t i=0; i < n.size(); i++) {
 		m = n.at(i);
-		const char* name = m.name().c_str();
-
-		for(size_t j=0; j < m_signals.size(); j++) {
-			if(m_signals[j]->GetAccessMode() != CBaseParameter::AccessMode::RO)
-			{
-				const char* param_name = m_signals[j]->GetName();
-				if(!strcmp(param_name, name))
-					m_signals[j]->SetValueFromJSON(m);
-			}
+		std::unordered_map<std::string, CBaseParameter*>::iterator it = m_signals_index.find(m.name());
+		if(it != m_signals_index.end() && it->second->GetAccessMode() != CBaseParameter::AccessMode::RO)
+		{
+			it->second->SetValueFromJSON(m);
+			m_new_signals.push_back(it->second);
 		}
 	}
 
@@ -226,6 +369,14 @@ void CDataManager::SetSignalInterval(int _interval)
 void CDataManager::SendAllParams()
 {
 	m_send_all_params = true;
+	void (*notify)(void) = NULL;
+	{
+		std::lock_guard<std::mutex> lock(m_changed_mutex);
+		if(!m_updating_params)
+			notify = m_params_notify;
+	}
+	if(notify)
+		notify();
 }
 
 // DEPRECATED
@@ -289,6 +440,25 @@ extern "C" const char* ws_get_signals(void)
 	return res.c_str();
 }
 
+// Signals of one update in every format of the mask, the frames stay valid until the next call
+extern "C" int ws_get_signal_frames(unsigned int _mask, const void** _frames, size_t* _sizes)
+{
+	CDataManager * man = CDataManager::GetInstance();
+	if(man)
+	{
+		man->GetSignalFrames(_mask, _frames, _sizes);
+		return 1;
+	}
+	return 0;
+}
+
+extern "C" void ws_set_params_notify(void (*_notify)(void))
+{
+	CDataManager * man = CDataManager::GetInstance();
+	if(man)
+		man->SetParamsNotify(_notify);
+}
+
 extern "C" void ws_set_params_interval(int _interval)
 {
 	CDataManager * man = CDataManager::GetInstance();
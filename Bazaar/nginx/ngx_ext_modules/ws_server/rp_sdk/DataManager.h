@@ -2,7 +2,10 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <mutex>
 #include "BaseParameter.h"
+#include "SignalFrame.h"
 
 struct Data {
 	char* data;
@@ -20,9 +23,21 @@ private:
 
 	std::vector<CBaseParameter*> m_params;
 	std::vector<CBaseParameter*> m_signals;
+	std::unordered_map<std::string, CBaseParameter*> m_params_index; //first registered parameter of each name
+	std::unordered_map<std::string, CBaseParameter*> m_signals_index;
+	std::vector<CBaseParameter*> m_always_params; //RWSA and ROSA, sent on every update
+	std::vector<CBaseParameter*> m_changed_params; //queued by Set and Value, the only others checked for changes
+	std::vector<CBaseParameter*> m_new_params; //received in the last message
+	std::vector<CBaseParameter*> m_new_signals;
+	std::mutex m_changed_mutex;
+	bool m_updating_params;
+	void (*m_params_notify)(void);
 	int m_param_interval; //parameters send time interval in milliseconds
 	int m_signal_interval; //signals send time interval in milliseconds
 	bool m_send_all_params;
+	uint32_t m_signal_sequence;
+	std::string m_signals_json;
+	CSignalFrame m_signal_frames[CSignalFrame::Formats];
 
 public:
 	static CDataManager* GetInstance();
@@ -33,15 +48,13 @@ public:
 	
 	template<class T>
 	T* GetByName(std::string _name){
-		for (auto x : m_params) { 
-			if (std::string(x->GetName()) == _name)
-				return dynamic_cast<T*>(x);
+		auto it = m_params_index.find(_name);
+		if (it == m_params_index.end()) {
+			it = m_signals_index.find(_name);
+			if (it == m_signals_index.end())
+				return nullptr;
 		}
-		for (auto x : m_signals) { 
-			if (std::string(x->GetName()) == _name)
-				return dynamic_cast<T*>(x);
-		}
-		return nullptr;
+		return dynamic_cast<T*>(it->second);
 	}
 	const std::vector<CBaseParameter*>* GetParametersList() {return &m_params;}
 	const std::vector<CBaseParameter*>* GetSignalList(){return &m_signals;}
@@ -49,8 +62,11 @@ public:
 	void UnRegisterParam(const char * _name);
 	void UnRegisterSignal(const char * _name);
 
-	std::string GetParamsJson(); //get all parameters in JSON-formatted string
+	std::string GetParamsJson(); //get changed parameters in JSON-formatted string, empty if nothing changed
+	void ParamChanged(CBaseParameter * _param); //queue a parameter for the next GetParamsJson
+	void SetParamsNotify(void (*_notify)(void)); //called when the first parameter is queued, the server then sends without waiting for the timer
 	std::string GetSignalsJson(); //get all signals in JSON-formatted string
+	void GetSignalFrames(unsigned int _mask, const void** _frames, size_t* _sizes); //update signals once and write every format in the mask, bit n is CSignalFrame::Format n
 
 	void OnNewParams(std::string _params); //is involved when new data received from server, data is JSON-formatted string
 	void OnNewSignals(std::string _signals); //is involved when new data received from server, data is JSON-formatted string
@@ -58,7 +74,7 @@ public:
 	int GetParamInterval();
 	int GetSignalInterval();
 
-	void SetParamInterval(int _interval);
+	void SetParamInterval(int _interval); //0 sends parameters only on change
 	void SetSignalInterval(int _interval);
 
 	void SendAllParams();
@@ -86,3 +102,5 @@ extern "C" const char * ws_get_signals(void);
 extern "C" int ws_set_params(const char *_params);
 extern "C" int ws_set_signals(const char *_signals);
 extern "C" void ws_gzip(const char* _in, void* _out, size_t* size_);
+extern "C" int ws_get_signal_frames(unsigned int _mask, const void** _frames, size_t* _sizes);
+extern "C" void ws_set_params_notify(void (*_notify)(void));
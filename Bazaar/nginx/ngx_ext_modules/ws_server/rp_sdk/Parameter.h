@@ -32,8 +32,11 @@ public:
 	void ClearNewValue();
 
 protected:
+	void Changed(); //queue the parameter for the next send
+
 	TParam<T, ValueT> m_Value; //parameter or signal struct data
 	std::shared_ptr<TParam<T, ValueT>> m_TmpValue; //temp storage of parameter or signal data received from server
+	bool m_IsParam;
 
 };
 
@@ -52,6 +55,7 @@ inline CParameter<T, ValueT>::CParameter(std::string _name, AccessMode _access_m
 	m_Value.max = _max;
 	m_Value.access_mode = _access_mode;
 	m_Value.fpga_update = _fpga_update;
+	m_IsParam = true;
 
 	CDataManager * man = CDataManager::GetInstance();
 	if(man)
@@ -67,15 +71,18 @@ inline CParameter<T, ValueT>::CParameter(std::string _name, AccessMode _access_m
 //	m_Value.max;
 	m_Value.access_mode = _access_mode;
 //	m_Value.fpga_update;
+	m_IsParam = false;
 
 	CDataManager * man = CDataManager::GetInstance();
 	if(man)
 		man->RegisterSignal(this);
 }
 
+// The value can be changed through the reference, so the parameter is queued
 template <typename T, typename ValueT>
 inline ValueT& CParameter<T, ValueT>::Value()
 {
+	Changed();
 	return m_Value.value;
 }
 
@@ -134,6 +141,13 @@ inline bool CParameter<T, ValueT>::IsNewValue() const
 	return (m_TmpValue.get() != nullptr);
 }
 
+template <typename T, typename ValueT>
+inline void CParameter<T, ValueT>::Changed()
+{
+	if(m_IsParam && !m_Queued)
+		CDataManager::GetInstance()->ParamChanged(this);
+}
+
 template <typename T, typename ValueT>
 inline void CParameter<T, ValueT>::ClearNewValue()
 {
@@ -0,0 +1,245 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "SignalFrame.h"
+
+namespace
+{
+
+struct FrameHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t count;
+	uint32_t sequence;
+};
+
+struct SignalHeader
+{
+	uint16_t name_size;
+	uint8_t encoding;
+	uint8_t reserved;
+	uint32_t size;
+	uint32_t bytes;
+	float scale;
+	float offset;
+};
+
+inline size_t Align4(size_t _size)
+{
+	return (_size + 3) & ~(size_t)3;
+}
+
+// IEEE 754 half float, rounded to nearest even
+inline uint16_t FloatToHalf(float _value)
+{
+	uint32_t x;
+	memcpy(&x, &_value, sizeof(x));
+	uint16_t sign = (x >> 16) & 0x8000;
+	uint32_t absx = x & 0x7fffffff;
+
+	if(absx >= 0x47800000) // overflow, inf and nan
+		return sign | (absx > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+	if(absx < 0x38800000) // subnormal half
+	{
+		if(absx < 0x33000000)
+			return sign;
+		uint32_t mantissa = (absx & 0x7fffff) | 0x800000;
+		uint32_t shift = 126 - (absx >> 23);
+		uint32_t h = mantissa >> shift;
+		uint32_t rem = mantissa & ((1u << shift) - 1);
+		uint32_t half = 1u << (shift - 1);
+		if(rem > half || (rem == half && (h & 1)))
+			h++;
+		return sign | h;
+	}
+
+	uint32_t h = (absx >> 13) - (112 << 10);
+	uint32_t rem = absx & 0x1fff;
+	if(rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+		h++;
+	return sign | h;
+}
+
+inline void CopyFloat(float* _out, const float* _in, size_t _size)
+{
+	memcpy(_out, _in, _size * sizeof(float));
+}
+
+inline void CopyFloat(float* _out, const double* _in, size_t _size)
+{
+	for(size_t i = 0; i < _size; i++)
+		_out[i] = _in[i];
+}
+
+}
+
+CSignalFrame::CSignalFrame()
+	: m_Format(F32)
+	, m_Count(0)
+	, m_Size(0)
+	, m_Header(0)
+	, m_Buffer()
+	, m_Quantized()
+{
+}
+
+void CSignalFrame::Begin(Format _format, uint32_t _sequence)
+{
+	m_Format = _format;
+	m_Count = 0;
+	m_Size = 0;
+	FrameHeader h = { {'R', 'P', 'S', 'G'}, VERSION, 0, _sequence };
+	memcpy(Reserve(sizeof(h)), &h, sizeof(h));
+	m_Size = sizeof(h);
+}
+
+void CSignalFrame::End()
+{
+	memcpy(m_Buffer.data() + offsetof(FrameHeader, count), &m_Count, sizeof(m_Count));
+}
+
+void CSignalFrame::Add(const std::string& _name, const float* _data, size_t _size)
+{
+	AddReal(_name, _data, _size);
+}
+
+void CSignalFrame::Add(const std::string& _name, const double* _data, size_t _size)
+{
+	AddReal(_name, _data, _size);
+}
+
+void CSignalFrame::Add(const std::string& _name, const int* _data, size_t _size)
+{
+	size_t bytes = _size * sizeof(int32_t);
+	memcpy(AddSignal(_name, ENC_I32, _size, bytes, 1, 0), _data, bytes);
+	FinishSignal(bytes);
+}
+
+void CSignalFrame::Add(const std::string& _name, const uint8_t* _data, size_t _size)
+{
+	memcpy(AddSignal(_name, ENC_U8, _size, _size, 1, 0), _data, _size);
+	FinishSignal(_size);
+}
+
+template <typename T>
+void CSignalFrame::AddReal(const std::string& _name, const T* _data, size_t _size)
+{
+	switch(m_Format)
+	{
+		case F16:
+		{
+			uint16_t* out = (uint16_t*)AddSignal(_name, ENC_F16, _size, _size * 2, 1, 0);
+			for(size_t i = 0; i < _size; i++)
+				out[i] = FloatToHalf(_data[i]);
+			FinishSignal(_size * 2);
+			break;
+		}
+		case I16:
+		{
+			float scale, offset;
+			Quantize(_data, _size, scale, offset);
+			memcpy(AddSignal(_name, ENC_I16, _size, _size * 2, scale, offset), m_Quantized.data(), _size * 2);
+			FinishSignal(_size * 2);
+			break;
+		}
+		case DELTA:
+		{
+			float scale, offset;
+			Quantize(_data, _size, scale, offset);
+			uint8_t* out = AddSignal(_name, ENC_DELTA, _size, _size * 3, scale, offset);
+			size_t bytes = 0;
+			int prev = 0;
+			for(size_t i = 0; i < _size; i++)
+			{
+				int q = m_Quantized[i];
+				int d = q - prev;
+				prev = q;
+				if(d >= -127 && d <= 127)
+				{
+					out[bytes++] = (uint8_t)d;
+				}
+				else
+				{
+					out[bytes++] = 0x80;
+					out[bytes++] = q & 0xff;
+					out[bytes++] = (q >> 8) & 0xff;
+				}
+			}
+			FinishSignal(bytes);
+			break;
+		}
+		default:
+		{
+			CopyFloat((float*)AddSignal(_name, ENC_F32, _size, _size * 4, 1, 0), _data, _size);
+			FinishSignal(_size * 4);
+			break;
+		}
+	}
+}
+
+// Maps the finite range of the signal to -32768..32767, nan and inf are clamped
+template <typename T>
+void CSignalFrame::Quantize(const T* _data, size_t _size, float& _scale, float& _offset)
+{
+	double min = INFINITY;
+	double max = -INFINITY;
+	for(size_t i = 0; i < _size; i++)
+	{
+		double v = _data[i];
+		if(!isfinite(v))
+			continue;
+		min = std::min(min, v);
+		max = std::max(max, v);
+	}
+	double scale = max > min ? (max - min) / 65535.0 : 0;
+	double offset = max >= min ? min + 32768.0 * scale : 0;
+	double inv = scale > 0 ? 1.0 / scale : 0;
+
+	m_Quantized.resize(_size);
+	for(size_t i = 0; i < _size; i++)
+	{
+		double x = (_data[i] - offset) * inv;
+		if(x >= 32767)
+			m_Quantized[i] = 32767;
+		else if(x > -32768)
+			m_Quantized[i] = (int16_t)lrint(x);
+		else
+			m_Quantized[i] = -32768;
+	}
+	_scale = scale;
+	_offset = offset;
+}
+
+// Writes the header and name of a signal and returns the space for up to _bytes of data
+uint8_t* CSignalFrame::AddSignal(const std::string& _name, Encoding _encoding, size_t _size, size_t _bytes, float _scale, float _offset)
+{
+	size_t name_size = std::min<size_t>(_name.size(), UINT16_MAX);
+	size_t head = sizeof(SignalHeader) + Align4(name_size);
+	uint8_t* p = Reserve(head + Align4(_bytes));
+	SignalHeader h = { (uint16_t)name_size, (uint8_t)_encoding, 0, (uint32_t)_size, (uint32_t)_bytes, _scale, _offset };
+	memcpy(p, &h, sizeof(h));
+	memcpy(p + sizeof(h), _name.data(), name_size);
+	memset(p + sizeof(h) + name_size, 0, head - sizeof(h) - name_size);
+	m_Header = m_Size;
+	m_Size += head;
+	m_Count++;
+	return p + head;
+}
+
+void CSignalFrame::FinishSignal(size_t _bytes)
+{
+	uint32_t bytes = _bytes;
+	memcpy(m_Buffer.data() + m_Header + offsetof(SignalHeader, bytes), &bytes, sizeof(bytes));
+	memset(m_Buffer.data() + m_Size + _bytes, 0, Align4(_bytes) - _bytes);
+	m_Size += Align4(_bytes);
+}
+
+// The buffer only grows, so after the first frames no allocation is done
+uint8_t* CSignalFrame::Reserve(size_t _bytes)
+{
+	if(m_Buffer.size() < m_Size + _bytes)
+		m_Buffer.resize(m_Size + _bytes);
+	return m_Buffer.data() + m_Size;
+}
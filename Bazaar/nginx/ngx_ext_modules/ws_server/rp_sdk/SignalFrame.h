@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*
+ * Binary signal frame, the alternative to the gzipped JSON signals.
+ * All fields are little-endian, every block starts on a 4 byte boundary,
+ * so the client can view the data with typed arrays without copying.
+ *
+ * frame header (12 bytes)
+ *   char     magic[4]     "RPSG", a gzip stream starts with 0x1f 0x8b
+ *   uint16   version
+ *   uint16   count        number of signals
+ *   uint32   sequence     incremented on every signal update of the application
+ * per signal
+ *   uint16   name_size
+ *   uint8    encoding     Encoding
+ *   uint8    reserved
+ *   uint32   size         number of values
+ *   uint32   bytes        size of the data block
+ *   float    scale        I16 and DELTA: value = offset + q * scale
+ *   float    offset
+ *   char     name[name_size], padded to 4 bytes
+ *   data[bytes], padded to 4 bytes
+ *
+ * Int and byte signals are always sent as I32 and U8, the format only selects
+ * the encoding of float and double signals.
+ * DELTA codes the I16 values as differences to the previous value: one int8 for
+ * differences from -127 to 127, otherwise the byte 0x80 followed by the int16 value.
+ */
+class CSignalFrame
+{
+public:
+	enum Format
+	{
+		JSON = 0,	// gzipped JSON text, not a frame
+		F32,
+		F16,
+		I16,
+		DELTA,
+
+		Formats
+	};
+
+	enum Encoding
+	{
+		ENC_F32 = 0,
+		ENC_I32,
+		ENC_U8,
+		ENC_F16,
+		ENC_I16,
+		ENC_DELTA
+	};
+
+	static const uint16_t VERSION = 1;
+
+	CSignalFrame();
+
+	void Begin(Format _format, uint32_t _sequence);
+	void Add(const std::string& _name, const float* _data, size_t _size);
+	void Add(const std::string& _name, const double* _data, size_t _size);
+	void Add(const std::string& _name, const int* _data, size_t _size);
+	void Add(const std::string& _name, const uint8_t* _data, size_t _size);
+	void End();
+
+	const uint8_t* Data() const { return m_Buffer.data(); }
+	size_t Size() const { return m_Size; }
+
+	// Name used by the client in {"signals_format": name}, Formats if unknown
+	static Format FormatFromName(const std::string& _name)
+	{
+		static const char* names[Formats] = { "json", "f32", "f16", "i16", "delta" };
+		for(int i = 0; i < Formats; i++)
+			if(_name == names[i])
+				return (Format)i;
+		return Formats;
+	}
+
+private:
+	template <typename T> void AddReal(const std::string& _name, const T* _data, size_t _size);
+	template <typename T> void Quantize(const T* _data, size_t _size, float& _scale, float& _offset);
+	uint8_t* AddSignal(const std::string& _name, Encoding _encoding, size_t _size, size_t _bytes, float _scale, float _offset);
+	void FinishSignal(size_t _bytes);
+	uint8_t* Reserve(size_t _bytes);
+
+	Format m_Format;
+	uint16_t m_Count;
+	size_t m_Size;
+	size_t m_Header;	// offset of the last signal header
+	std::vector<uint8_t> m_Buffer;
+	std::vector<int16_t> m_Quantized;
+};
@@ -11,6 +11,7 @@
 #include <streambuf>
 #include <string>
 #include <future>
+#include <algorithm>
 
 #include <math.h>
 
@@ -19,14 +20,44 @@ using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
 using websocketpp::lib::bind;
 
+rp_websocket_server* rp_websocket_server::m_instance = NULL;
+
+// A slow client gets every MAX_DIVIDER-th update at least
+#define MAX_DIVIDER 16
+// Sends with an empty queue before the rate of a client goes up again
+#define RECOVER_SENDS 25
+#define PING_INTERVAL std::chrono::seconds(1)
+#define GZIP_BUFFER_SIZE 1000000
+
+rp_websocket_server::client_state::client_state(uint32_t _id)
+    : id(_id)
+    , format(CSignalFrame::JSON)
+    , divider(1)
+    , skipped(0)
+    , clean(0)
+    , sent(0)
+    , dropped(0)
+    , queued(0)
+    , ping_pending(false)
+    , ping_time()
+    , latency_ms(0)
+{
+}
+
 rp_websocket_server::rp_websocket_server()
     : m_params(NULL)
     , m_OnClosed(false)
+    , m_params_pending(false)
+    , m_gzip_buffer(GZIP_BUFFER_SIZE)
+    , m_next_client(0)
 {
 }
 
 rp_websocket_server::rp_websocket_server(struct server_parameters* params)
     : m_params(params)
+    , m_params_pending(false)
+    , m_gzip_buffer(GZIP_BUFFER_SIZE)
+    , m_next_client(0)
 {
     // set up access channels to only log interesting things
     m_endpoint.clear_access_channels(websocketpp::log::alevel::all);
@@ -43,6 +74,7 @@ rp_websocket_server::rp_websocket_server(struct server_parameters* params)
     m_endpoint.set_close_handler(bind(&rp_websocket_server::on_close,this,::_1));
     m_endpoint.set_http_handler(bind(&rp_websocket_server::on_http,this,::_1));
     m_endpoint.set_message_handler(bind(&rp_websocket_server::on_message,this,::_1,::_2));
+    m_endpoint.set_pong_handler(bind(&rp_websocket_server::on_pong,this,::_1,::_2));
     m_out.open("/var/log/redpitaya_nginx/ws_server.log", std::ofstream::out | std::ofstream::app);
     m_endpoint.get_alog().set_ostream(&m_out);
     m_endpoint.get_alog().write(websocketpp::log::alevel::app, "ws_server constructor");
@@ -104,6 +136,12 @@ void rp_websocket_server::set_param_timer() {
 	if(m_param_timer!=NULL)
 		m_param_timer->cancel();
 	int interval = m_params->get_params_interval_func != 0 ?  m_params->get_params_interval_func() : m_params->param_interval;
+	if (interval <= 0) {
+		// Without the timer the parameters are only sent on change
+		if (m_params->set_params_notify_func)
+			return;
+		interval = m_params->param_interval;
+	}
 	// fprintf(stderr, "set_param_timer interval %d\n", interval);
 	m_param_timer = m_endpoint.set_timer(
 		interval,
@@ -123,7 +161,32 @@ void rp_websocket_server::on_signal_timer(websocketpp::lib::error_code const & e
 		return;
 	}
 
-	con_list::iterator it;
+	ping_clients();
+
+	if (m_params->get_signal_frames_func) {
+		// One update of the application gives the signals in every format in use
+		unsigned int mask = 0;
+		for (con_list::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+			mask |= 1u << it->second.format;
+		}
+		const void* frames[CSignalFrame::Formats];
+		size_t sizes[CSignalFrame::Formats];
+		m_params->get_signal_frames_func(mask, frames, sizes);
+
+		if (frames[CSignalFrame::JSON]) {
+			size_t size;
+			m_params->gzip_func((const char*)frames[CSignalFrame::JSON], m_gzip_buffer.data(), &size);
+			send_signals(CSignalFrame::JSON, m_gzip_buffer.data(), size);
+		}
+		// Frames go out as they are, without gzip
+		for (int f = CSignalFrame::JSON + 1; f < CSignalFrame::Formats; f++) {
+			if (frames[f])
+				send_signals((CSignalFrame::Format)f, frames[f], sizes[f]);
+		}
+		set_signal_timer();
+		return;
+	}
+
 	const char* signals = m_params->get_signals_func();
 
 //	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "on_signal_timer");
@@ -134,20 +197,111 @@ void rp_websocket_server::on_signal_timer(websocketpp::lib::error_code const & e
 		m_endpoint.get_alog().write(websocketpp::log::alevel::app, signals);
 	}
 
-	std::string js(signals);
-	static char buf[1000000];
 	size_t size;
-	m_params->gzip_func(js.c_str(), buf, &size);
+	m_params->gzip_func(signals, m_gzip_buffer.data(), &size);
 
-	if (size) {
-		for (it = m_connections.begin(); it != m_connections.end(); ++it) {
-			m_endpoint.send(*it, buf, size, websocketpp::frame::opcode::binary);
-		}
-	}
+	send_signals(CSignalFrame::JSON, m_gzip_buffer.data(), size);
 	// set timer for next check
 	set_signal_timer();
 }
 
+// The data is encoded once for all clients of the format. A client that has not
+// taken the previous signals yet skips these, so it always gets the newest ones,
+// and its rate goes down until the queue stays empty.
+void rp_websocket_server::send_signals(CSignalFrame::Format format, const void* data, size_t size) {
+
+	if (!size)
+		return;
+	for (con_list::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+		client_state& client = it->second;
+		if (client.format != format)
+			continue;
+		if (++client.skipped < client.divider)
+			continue;
+		client.skipped = 0;
+
+		websocketpp::lib::error_code ec;
+		server::connection_ptr con = m_endpoint.get_con_from_hdl(it->first, ec);
+		if (ec)
+			continue;
+		client.queued = con->get_buffered_amount();
+		if (client.queued > 0) {
+			client.dropped++;
+			client.clean = 0;
+			if (client.divider < MAX_DIVIDER)
+				client.divider *= 2;
+			continue;
+		}
+
+		m_endpoint.send(it->first, data, size, websocketpp::frame::opcode::binary, ec);
+		if (ec)
+			continue;
+		client.sent++;
+		if (++client.clean >= RECOVER_SENDS && client.divider > 1) {
+			client.divider--;
+			client.clean = 0;
+		}
+	}
+}
+
+// The pong comes after the data queued before the ping, so the round trip includes the queue
+void rp_websocket_server::ping_clients() {
+
+	clock::time_point now = clock::now();
+	for (con_list::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+		client_state& client = it->second;
+		if (client.ping_pending || now - client.ping_time < PING_INTERVAL)
+			continue;
+		websocketpp::lib::error_code ec;
+		m_endpoint.ping(it->first, "rp", ec);
+		if (!ec) {
+			client.ping_pending = true;
+			client.ping_time = now;
+		}
+	}
+}
+
+void rp_websocket_server::on_pong(connection_hdl hdl, std::string payload) {
+
+	con_list::iterator it = m_connections.find(hdl);
+	if (it == m_connections.end() || !it->second.ping_pending)
+		return;
+	client_state& client = it->second;
+	client.ping_pending = false;
+	client.latency_ms = std::chrono::duration<double, std::milli>(clock::now() - client.ping_time).count();
+}
+
+// Sent as a text message, the data messages are binary
+void rp_websocket_server::send_stats(connection_hdl hdl) {
+
+	static const char* format_names[CSignalFrame::Formats] = { "json", "f32", "f16", "i16", "delta" };
+	clock::time_point now = clock::now();
+	JSONNode clients(JSON_ARRAY);
+	clients.set_name("ws_stats");
+	for (con_list::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+		const client_state& client = it->second;
+		double latency = client.latency_ms;
+		// A pong that is late already tells more than the last one
+		if (client.ping_pending)
+			latency = std::max(latency, std::chrono::duration<double, std::milli>(now - client.ping_time).count());
+		JSONNode n(JSON_NODE);
+		n.push_back(JSONNode("id", (unsigned long)client.id));
+		n.push_back(JSONNode("self", !m_connections.key_comp()(it->first, hdl) && !m_connections.key_comp()(hdl, it->first)));
+		n.push_back(JSONNode("format", std::string(format_names[client.format])));
+		n.push_back(JSONNode("latency_ms", latency));
+		n.push_back(JSONNode("sent", client.sent));
+		n.push_back(JSONNode("dropped", client.dropped));
+		n.push_back(JSONNode("divider", client.divider));
+		n.push_back(JSONNode("queued", (unsigned long)client.queued));
+		clients.push_back(n);
+	}
+	JSONNode root(JSON_NODE);
+	root.push_back(clients);
+
+	websocketpp::lib::error_code ec;
+	m_endpoint.send(hdl, root.write(), websocketpp::frame::opcode::text, ec);
+}
+
 void rp_websocket_server::on_param_timer(websocketpp::lib::error_code const & ec) {
 
 	if (ec) {
@@ -156,8 +310,18 @@ void rp_websocket_server::on_param_timer(websocketpp::lib::error_code const & ec
 		return;
 	}
 
+	send_params();
+	// set timer for next check
+	set_param_timer();
+}
+
+void rp_websocket_server::send_params() {
+
 	con_list::iterator it;
 	const char* params = m_params->get_params_func();
+	// Nothing changed since the last send
+	if (!*params)
+		return;
 //	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "on_param_timer");
 	static int once = 1;
 	if(once)
@@ -166,18 +330,30 @@ void rp_websocket_server::on_param_timer(websocketpp::lib::error_code const & ec
 		m_endpoint.get_alog().write(websocketpp::log::alevel::app, params);
 	}
 
-	std::string js(params);
-	static char buf[1000000];
+	// Parameters are sent as changes, so they are never dropped
 	size_t size;
-	m_params->gzip_func(js.c_str(), buf, &size);
+	m_params->gzip_func(params, m_gzip_buffer.data(), &size);
 
 	if (size) {
 		for (it = m_connections.begin(); it != m_connections.end(); ++it) {
-			m_endpoint.send(*it, buf, size, websocketpp::frame::opcode::binary);
+			m_endpoint.send(it->first, m_gzip_buffer.data(), size, websocketpp::frame::opcode::binary);
 		}
 	}
-	// set timer for next check
-	set_param_timer();
+}
+
+// Called by the application on any thread, the send runs on the server thread
+void rp_websocket_server::on_params_changed() {
+
+	rp_websocket_server* server = m_instance;
+	if (server && !server->m_params_pending.exchange(true)) {
+		server->m_endpoint.get_io_service().post(bind(&rp_websocket_server::on_params_push, server));
+	}
+}
+
+void rp_websocket_server::on_params_push() {
+
+	m_params_pending = false;
+	send_params();
 }
 
 void rp_websocket_server::on_http(connection_hdl hdl) {
@@ -231,7 +407,7 @@ void rp_websocket_server::on_http(connection_hdl hdl) {
 void rp_websocket_server::on_open(connection_hdl hdl)
 {
 	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "ws server on connection");
-	m_connections.insert(hdl);
+	m_connections.insert(std::make_pair(hdl, client_state(m_next_client++)));
 }
 
 void rp_websocket_server::on_close(connection_hdl hdl) {
@@ -266,6 +442,25 @@ void rp_websocket_server::on_message(connection_hdl hdl, server::message_ptr msg
 		set_signal_timer();
 		m_params->set_signals_func(data_str);
 	}
+	else if(name == "signals_format")
+	{
+		std::string format_name = child.as_string();
+		CSignalFrame::Format format = CSignalFrame::FormatFromName(format_name);
+		con_list::iterator it = m_connections.find(hdl);
+		if(format == CSignalFrame::Formats || (format != CSignalFrame::JSON && !m_params->get_signal_frames_func))
+		{
+			m_endpoint.get_alog().write(websocketpp::log::alevel::app,
+				"Signals format is not supported: " + format_name);
+		}
+		else if(it != m_connections.end())
+		{
+			it->second.format = format;
+		}
+	}
+	else if(name == "ws_stats")
+	{
+		send_stats(hdl);
+	}
 
 }
 
@@ -279,6 +474,10 @@ void rp_websocket_server::start(std::string docroot, uint16_t port)
 	m_thread = thread(bind(&rp_websocket_server::run,this, docroot,  port));
 	set_signal_timer();
 	set_param_timer();
+	if (m_params->set_params_notify_func) {
+		m_instance = this;
+		m_params->set_params_notify_func(&rp_websocket_server::on_params_changed);
+	}
 }
 
 void rp_websocket_server::join()
@@ -294,14 +493,19 @@ void rp_websocket_server::stop()
 
 	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "stop ws_server");
 
+	if (m_params->set_params_notify_func) {
+		m_params->set_params_notify_func(NULL);
+		m_instance = NULL;
+	}
 	m_endpoint.stop_listening();
 	m_endpoint.stop();
-	m_param_timer->cancel();
+	if (m_param_timer)
+		m_param_timer->cancel();
 	m_signal_timer->cancel();
 	con_list::iterator it;
 
 	for (it = m_connections.begin(); it != m_connections.end(); ++it) {
-		connection_hdl hdl = *it;
+		connection_hdl hdl = it->first;
 
 		try{
               		m_endpoint.close(hdl, websocketpp::close::status::normal, "shutdown");
@@ -3,11 +3,15 @@
 #include <websocketpp/server.hpp>
 #include <websocketpp/common/thread.hpp>
 //#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
-#include <set>
+#include <map>
 #include <fstream>
+#include <atomic>
+#include <chrono>
+#include <vector>
 
 #include "libjson/_internal/Source/JSONNode.h"
 #include "ws_server.h"
+#include "rp_sdk/SignalFrame.h"
 
 //class config2{};
 
@@ -36,13 +40,40 @@ public:
 
     void on_signal_timer(websocketpp::lib::error_code const & ec);
     void on_param_timer(websocketpp::lib::error_code const & ec);
+    void on_params_push();
+    static void on_params_changed();
     void on_http(connection_hdl hdl);
     void on_open(connection_hdl hdl);
     void on_close(connection_hdl hdl);
     void on_message(connection_hdl hdl, server::message_ptr msg);
+    void on_pong(connection_hdl hdl, std::string payload);
 
 private:
-    typedef std::set<connection_hdl,std::owner_less<connection_hdl>> con_list;
+    typedef std::chrono::steady_clock clock;
+
+    struct client_state {
+        client_state(uint32_t id);
+
+        uint32_t id;
+        CSignalFrame::Format format; // gzipped JSON until the client asks for frames
+        unsigned int divider;        // signals go to the client on every divider-th update
+        unsigned int skipped;        // updates since the last signals for the client
+        unsigned int clean;          // signals sent in a row with an empty send queue
+        unsigned long sent;
+        unsigned long dropped;       // signals not sent because the previous ones were still queued
+        size_t queued;               // bytes in the send queue at the last update
+        bool ping_pending;
+        clock::time_point ping_time;
+        double latency_ms;           // round trip of the last ping, it waits behind the queued data
+    };
+    typedef std::map<connection_hdl,client_state,std::owner_less<connection_hdl>> con_list;
+
+    void send_signals(CSignalFrame::Format format, const void* data, size_t size);
+    void send_params();
+    void ping_clients();
+    void send_stats(connection_hdl hdl);
+
+    static rp_websocket_server* m_instance; // receiver of the parameter change notifications
 
     struct server_parameters* m_params;
     server m_endpoint;
@@ -53,6 +84,9 @@ private:
     std::string m_docroot;
 	std::ofstream m_out;
 	volatile bool m_OnClosed;
+	std::atomic<bool> m_params_pending;
+	std::vector<char> m_gzip_buffer;
+	uint32_t m_next_client;
 };
 
 }
@@ -29,6 +29,8 @@ void start_ws_server(const struct server_parameters * _params)
 		loaded_params->get_signals_func = _params->get_signals_func;
 		loaded_params->set_signals_func = _params->set_signals_func;
 		loaded_params->gzip_func = _params->gzip_func;
+		loaded_params->get_signal_frames_func = _params->get_signal_frames_func;
+		loaded_params->set_params_notify_func = _params->set_params_notify_func;
 	}
 	if(_params != 0 && _params->port != 0)
 		loaded_params->port = _params->port;
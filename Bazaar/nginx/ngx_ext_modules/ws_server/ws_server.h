@@ -12,6 +12,9 @@ typedef const char     *(*ws_get_signals_func)(void);
 typedef int		(*ws_set_params_func)(const char *_params);
 typedef int		(*ws_set_signals_func)(const char *_signals);
 typedef void	(*ws_gzip_func)(const char *_in, void* _out, size_t* _size);
+typedef int		(*ws_get_signal_frames_func)(unsigned int _mask, const void** _frames, size_t* _sizes);
+typedef void	(*ws_notify_func)(void);
+typedef void	(*ws_set_params_notify_func)(ws_notify_func _notify);
 
 // The following struct can be used to define specific parameters
 struct server_parameters {
@@ -24,6 +27,8 @@ struct server_parameters {
 	ws_set_params_func set_params_func;
 	ws_set_signals_func set_signals_func;
 	ws_gzip_func gzip_func;
+	ws_get_signal_frames_func get_signal_frames_func; // optional, binary signal frames
+	ws_set_params_notify_func set_params_notify_func; // optional, parameters are sent when they change
 	int signal_interval; // in ms
 	int param_interval; // in ms
 	int port;
@@ -22,10 +22,17 @@
 #include <stdio.h>
 #include <math.h>
 #include <pthread.h>
-//#include <mutex>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <map>
 #include "ba_api.h"
 #include <chrono>
+#ifdef ARCH_ARM
 #include "arm_neon.h"
+#endif
 
 #include "rp_hw-calib.h"
 #include "rp_hw-profiles.h"
@@ -82,17 +89,6 @@ data_t RMS(const std::vector<float> &data, int size){
     return result;
 }
 
-float ba_trapezoidalApprox(double *data, float T, int size)
-{
-        double result = 0;
-
-        for(int i = 0; i < size - 1; i++){
-                result += data[i] + data[i+1];
-        }
-        result = ((T / 2.0) * result);
-        return result;
-}
-
 
 float l_inter(float a, float b, float f){
     return a + f * (b - a);
@@ -239,105 +235,167 @@ data_t phaseCalculator(data_t freq_HZ, data_t samplesPerSecond, int numSamples,i
 	return phaseShift;
 }
 
-int rp_BaDataAnalysisTrap(const rp_ba_buffer_t &buffer,
-                                        uint32_t size,
-                                        float _freq, // 2*pi*f
-                                        int decimation,
-                                        float *gain,
-                                        float *phase_out,
-                                        float input_threshold)
-{
-
-		float w_out = _freq*2 * M_PI;
-
-        double ang, u_dut_1_phase, u_dut_2_phase, phase;
-
-        double T = (decimation / rp_BaGetADCSpeed());
-
-		std::vector<double> u_dut_1;
-		u_dut_1.reserve(size);
-		std::vector<double> u_dut_2;
-		u_dut_2.reserve(size);
-        // double u_dut_1[size];
-        // double u_dut_2[size];
-        // double u_dut_1_s[2][size];
-        // double u_dut_2_s[2][size];
-
-		std::vector<double> u_dut_1_s[2];
-		u_dut_1_s[0].reserve(size);
-		u_dut_1_s[1].reserve(size);
-		std::vector<double> u_dut_2_s[2];
-		u_dut_2_s[0].reserve(size);
-		u_dut_2_s[1].reserve(size);
-
-
-        double component_lock_in[2][2];
-        int ret_value = RP_OK;
-
-        for (size_t i = 0; i < size; i++){
-                u_dut_1[i] = ceil(buffer.ch2[i] * 1000.0) / 1000.0;
-                u_dut_2[i] = ceil(buffer.ch1[i] * 1000.0) / 1000.0;
-        }
-
-        if (size > 0){
-                double u1_max = u_dut_1[0];
-                double u1_min = u_dut_1[0];
-                double u2_max = u_dut_2[0];
-                double u2_min = u_dut_2[0];
-                for (size_t i = 1; i < size; i++){
-                        if (u1_max < u_dut_1[i]) u1_max = u_dut_1[i];
-                        if (u2_max < u_dut_2[i]) u2_max = u_dut_2[i];
-                        if (u1_min > u_dut_1[i]) u1_min = u_dut_1[i];
-                        if (u2_min > u_dut_2[i]) u2_min = u_dut_2[i];
-                }
-                if ((u1_max - u1_min) < input_threshold) ret_value = RP_EIPV;
-                if ((u2_max - u2_min) < input_threshold) ret_value = RP_EIPV;
-
-        }
-
-        for (size_t i = 0; i < size; i++){
-                ang = (i * T * w_out);
-
-                u_dut_1_s[0][i] = u_dut_1[i] * sin(ang);
-                u_dut_1_s[1][i] = u_dut_1[i] * sin(ang + (M_PI / 2));
-
-                u_dut_2_s[0][i] = u_dut_2[i] * sin(ang);
-                u_dut_2_s[1][i] = u_dut_2[i] * sin(ang + (M_PI / 2));
-        }
-
-        /* Trapezoidal approximation */
-        component_lock_in[0][0] = ba_trapezoidalApprox(u_dut_1_s[0].data(), T, size); //U_X
-        component_lock_in[0][1] = ba_trapezoidalApprox(u_dut_1_s[1].data(), T, size); //U_Y
-        component_lock_in[1][0] = ba_trapezoidalApprox(u_dut_2_s[0].data(), T, size); //I_X
-        component_lock_in[1][1] = ba_trapezoidalApprox(u_dut_2_s[1].data(), T, size); //I_Y
-
-        /* Calculating voltage amplitude and phase */
-        // u_dut_1_ampl = 2.0 * (sqrtf(powf(component_lock_in[0][0], 2.0) + powf(component_lock_in[0][1], 2.0)));
-
-        u_dut_1_phase = atan2f(component_lock_in[0][1], component_lock_in[0][0]);
-
-        /* Calculating current amplitude and phase */
-        // u_dut_2_ampl = 2.0 * (sqrtf(powf(component_lock_in[1][0], 2.0) + powf(component_lock_in[1][1], 2.0)));
+/* Samples summed in float before the sums go to double */
+#define BA_LOCKIN_BLOCK 256
+
+/* Quadrature sums and statistics of both channels */
+struct ba_lockin_t{
+	double sin_sum[2];
+	double cos_sum[2];
+	double sq_sum[2];
+	float min[2];
+	float max[2];
+};
+
+/* sin and cos of i * theta, by rotation with an exact restart every block, so libm is called once per block */
+static void ba_quadratureTable(std::vector<float> &sin_t, std::vector<float> &cos_t, size_t size, double theta){
+	sin_t.resize(size);
+	cos_t.resize(size);
+	double w_re = cos(theta);
+	double w_im = sin(theta);
+	double z_re = 1;
+	double z_im = 0;
+	for (size_t i = 0; i < size; i++){
+		if (i % BA_LOCKIN_BLOCK == 0){
+			z_re = cos(theta * i);
+			z_im = sin(theta * i);
+		}
+		cos_t[i] = z_re;
+		sin_t[i] = z_im;
+		double re = z_re * w_re - z_im * w_im;
+		z_im = z_re * w_im + z_im * w_re;
+		z_re = re;
+	}
+}
 
-        u_dut_2_phase = atan2f(component_lock_in[1][1], component_lock_in[1][0]);
+static void ba_lockinClear(ba_lockin_t *out){
+	for (int ch = 0; ch < 2; ch++){
+		out->sin_sum[ch] = out->cos_sum[ch] = out->sq_sum[ch] = 0;
+		out->min[ch] = 1e9;
+		out->max[ch] = -1e9;
+	}
+}
 
-        phase = u_dut_1_phase - u_dut_2_phase;
+/* Adds samples [begin, end) of both channels to out */
+static void ba_lockin(const float *ch1, const float *ch2, const float *sin_t, const float *cos_t, size_t begin, size_t end, ba_lockin_t *out){
+	const float *ch[2] = { ch1, ch2 };
+	for (size_t b = begin; b < end; b += BA_LOCKIN_BLOCK){
+		size_t e = b + BA_LOCKIN_BLOCK < end ? b + BA_LOCKIN_BLOCK : end;
+		for (int c = 0; c < 2; c++){
+			const float *x = ch[c];
+			float s = 0, co = 0, sq = 0;
+			float mn = out->min[c], mx = out->max[c];
+			size_t i = b;
+#ifdef ARCH_ARM
+			float32x4_t vs = vdupq_n_f32(0);
+			float32x4_t vc = vdupq_n_f32(0);
+			float32x4_t vsq = vdupq_n_f32(0);
+			float32x4_t vmn = vdupq_n_f32(mn);
+			float32x4_t vmx = vdupq_n_f32(mx);
+			for (; i + 4 <= e; i += 4){
+				float32x4_t v = vld1q_f32(x + i);
+				vs = vmlaq_f32(vs, v, vld1q_f32(sin_t + i));
+				vc = vmlaq_f32(vc, v, vld1q_f32(cos_t + i));
+				vsq = vmlaq_f32(vsq, v, v);
+				vmn = vminq_f32(vmn, v);
+				vmx = vmaxq_f32(vmx, v);
+			}
+			float ls[4], lc[4], lsq[4], lmn[4], lmx[4];
+			vst1q_f32(ls, vs);
+			vst1q_f32(lc, vc);
+			vst1q_f32(lsq, vsq);
+			vst1q_f32(lmn, vmn);
+			vst1q_f32(lmx, vmx);
+			for (int k = 0; k < 4; k++){
+				s += ls[k];
+				co += lc[k];
+				sq += lsq[k];
+				mn = lmn[k] < mn ? lmn[k] : mn;
+				mx = lmx[k] > mx ? lmx[k] : mx;
+			}
+#endif
+			for (; i < e; i++){
+				s += x[i] * sin_t[i];
+				co += x[i] * cos_t[i];
+				sq += x[i] * x[i];
+				mn = x[i] < mn ? x[i] : mn;
+				mx = x[i] > mx ? x[i] : mx;
+			}
+			out->sin_sum[c] += s;
+			out->cos_sum[c] += co;
+			out->sq_sum[c] += sq;
+			out->min[c] = mn;
+			out->max[c] = mx;
+		}
+	}
+}
 
-        /* Phase has to be limited between M_PI and -M_PI. */
-        if (phase <= -M_PI)
-                phase += 2*M_PI;
-        else if (phase >= M_PI)
-                phase -= 2*M_PI;
+/* Phase of ch2 against ch1 from the quadrature sums, in [rad] */
+static double ba_lockinPhase(const ba_lockin_t &l){
+	double phase = atan2(l.cos_sum[1], l.sin_sum[1]) - atan2(l.cos_sum[0], l.sin_sum[0]);
+	/* Phase has to be limited between M_PI and -M_PI. */
+	if (phase <= -M_PI)
+		phase += 2*M_PI;
+	else if (phase >= M_PI)
+		phase -= 2*M_PI;
+	return phase;
+}
 
-        *phase_out = phase * (180.0 / M_PI);
-		// Old logic
-        // *gain = u_dut_1_ampl / u_dut_2_ampl;
+/*
+ * Lock-in analysis with precomputed quadrature tables: the gain is the RMS ratio of ch2 to ch1
+ * and the phase that of the components at the excitation frequency. settled is false when the
+ * responses of the two halves of the buffer differ by more than tolerance, relative to their mean.
+ */
+static int ba_dataAnalysisLockIn(const rp_ba_buffer_t &buffer,
+					uint32_t size,
+					float _freq,
+					int decimation,
+					float input_threshold,
+					float tolerance,
+					std::vector<float> &sin_t,
+					std::vector<float> &cos_t,
+					float *gain,
+					float *phase_out,
+					bool *settled)
+{
+	int ret_value = RP_OK;
+	double theta = 2 * M_PI * _freq * decimation / rp_BaGetADCSpeed();
+	ba_lockin_t half[2];
+
+	ba_quadratureTable(sin_t, cos_t, size, theta);
+	ba_lockinClear(&half[0]);
+	ba_lockinClear(&half[1]);
+	ba_lockin(buffer.ch1.data(), buffer.ch2.data(), sin_t.data(), cos_t.data(), 0, size / 2, &half[0]);
+	ba_lockin(buffer.ch1.data(), buffer.ch2.data(), sin_t.data(), cos_t.data(), size / 2, size, &half[1]);
+
+	ba_lockin_t all;
+	for (int c = 0; c < 2; c++){
+		all.sin_sum[c] = half[0].sin_sum[c] + half[1].sin_sum[c];
+		all.cos_sum[c] = half[0].cos_sum[c] + half[1].cos_sum[c];
+		all.sq_sum[c] = half[0].sq_sum[c] + half[1].sq_sum[c];
+		all.min[c] = half[0].min[c] < half[1].min[c] ? half[0].min[c] : half[1].min[c];
+		all.max[c] = half[0].max[c] > half[1].max[c] ? half[0].max[c] : half[1].max[c];
+		if ((all.max[c] - all.min[c]) < input_threshold) ret_value = RP_EIPV;
+	}
 
-		data_t sig1_rms =  RMS(buffer.ch1,size);
-		data_t sig2_rms =  RMS(buffer.ch2,size);
-		*gain = sig2_rms / sig1_rms;
+	*phase_out = ba_lockinPhase(all) * (180.0 / M_PI);
+	*gain = size > 0 && all.sq_sum[0] > 0 ? sqrt(all.sq_sum[1] / all.sq_sum[0]) : 0;
 
-        return ret_value;
+	/* Complex responses ch2 / ch1 of both halves */
+	double h_re[2], h_im[2];
+	for (int k = 0; k < 2; k++){
+		double den = half[k].sin_sum[0] * half[k].sin_sum[0] + half[k].cos_sum[0] * half[k].cos_sum[0];
+		if (den <= 0){
+			*settled = true;
+			return ret_value;
+		}
+		h_re[k] = (half[k].sin_sum[1] * half[k].sin_sum[0] + half[k].cos_sum[1] * half[k].cos_sum[0]) / den;
+		h_im[k] = (half[k].cos_sum[1] * half[k].sin_sum[0] - half[k].sin_sum[1] * half[k].cos_sum[0]) / den;
+	}
+	double diff = hypot(h_re[0] - h_re[1], h_im[0] - h_im[1]);
+	double mean = hypot(h_re[0] + h_re[1], h_im[0] + h_im[1]) / 2;
+	*settled = diff <= tolerance * mean;
+	return ret_value;
 }
 
 
@@ -520,8 +578,17 @@ int rp_BaSafeThreadGen(rp_channel_t _channel, float _frequency, float _ampl, flo
 	return RP_OK;
 }
 
+/* Changes the frequency of the running generator, without a reset and without settling */
+int rp_BaSafeThreadGenFreq(rp_channel_t _channel, float _frequency)
+{
+	pthread_mutex_lock(&mutex);
+	EXEC_CHECK_MUTEX(rp_GenFreq(_channel, _frequency), mutex);
+	pthread_mutex_unlock(&mutex);
+	return RP_OK;
+}
+
 
-int rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, int _decimation, int _acq_size, float _trigger)
+int rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, int _decimation, int _acq_size, float _trigger, steady_clock::time_point _settled)
 {
 	(void)(_trigger);
 	uint32_t pos = 0;
@@ -539,6 +606,11 @@ int rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, int _decimation, int _acq_si
 	EXEC_CHECK_MUTEX(rp_AcqSetTriggerDelay(-ADC_BUFFER_SIZE / 2.0 + acq_u_size), mutex);
 	EXEC_CHECK_MUTEX(rp_AcqStart(), mutex);
 	usleep(sleep_time);
+	// The response has to settle before the trigger, the buffer fills meanwhile
+	auto now = steady_clock::now();
+	if (now < _settled){
+		usleep(duration_cast<microseconds>(_settled - now).count());
+	}
 	// Trigger, it is needed for the RP_DEC_1 decimation
 	EXEC_CHECK_MUTEX(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW), mutex);
 
@@ -569,14 +641,9 @@ int rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, int _decimation, int _acq_si
 	return RP_OK;
 }
 
-int rp_BaGetAmplPhase(float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t &_buffer, float* _amplitude, float* _phase, float _freq,float _input_threshold)
+/* Decimation and acquisition size of a measurement of _periods_number periods of _freq */
+static void ba_stepParams(float _freq, int _periods_number, int *_decimation, int *_acq_size)
 {
-    float gain = 0;
-    float phase_out = 0;
-    int acq_size;
-
-    //Generate a sinusoidal wave form
-    rp_BaSafeThreadGen(RP_CH_1, _freq, _amplitude_in, _dc_bias);
     int size_buff_limit = ADC_BUFFER_SIZE / 4;
 	int sampls = size_buff_limit / _periods_number;
 	int decimation = rp_BaGetADCSpeed() / (sampls * _freq);
@@ -598,17 +665,531 @@ int rp_BaGetAmplPhase(float _amplitude_in, float _dc_bias, int _periods_number,
         decimation = 65536;
     }
 
-	acq_size = round((static_cast<float>(_periods_number) * rp_BaGetADCSpeed()) / (_freq * decimation));
+	*_decimation = decimation;
+	*_acq_size = round((static_cast<float>(_periods_number) * rp_BaGetADCSpeed()) / (_freq * decimation));
+}
+
+int rp_BaGetAmplPhase(float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t &_buffer, float* _amplitude, float* _phase, float _freq,float _input_threshold)
+{
+    float gain = 0;
+    float phase_out = 0;
+    bool settled;
+    int acq_size;
+    int decimation;
+    std::vector<float> sin_t, cos_t;
+
+    //Generate a sinusoidal wave form
+    rp_BaSafeThreadGen(RP_CH_1, _freq, _amplitude_in, _dc_bias);
+    ba_stepParams(_freq, _periods_number, &decimation, &acq_size);
 
 	fprintf(stderr,"Dec %d freq %f acq_size %d\n",decimation,_freq,acq_size);
 
     rp_BaSafeThreadAcqData(_buffer,decimation, acq_size,_amplitude_in);
     rp_GenOutDisable(RP_CH_1);
-    //int ret = rp_BaDataAnalysis(_buffer, acq_size, ADC_SAMPLE_RATE / decimation,_freq, samples_period,  &gain, &phase_out,_input_threshold);
-	int ret = rp_BaDataAnalysisTrap(_buffer, acq_size, _freq, decimation,  &gain, &phase_out,_input_threshold);
+	int ret = ba_dataAnalysisLockIn(_buffer, acq_size, _freq, decimation, _input_threshold, 1, sin_t, cos_t, &gain, &phase_out, &settled);
 
     *_amplitude = 10.*logf(gain);
     *_phase = phase_out;
 	if (std::isnan(*_amplitude) || std::isinf(*_amplitude)) ret =  RP_EOOR;
     return ret;
 }
+
+
+/* Settling before the first point, when nothing is known about the response */
+#define BA_SETTLE_FIRST_US  10000
+#define BA_SETTLE_MIN_US    100
+#define BA_SETTLE_MAX_US    1000000
+/* Settling in periods of the excitation and in group delays of the response */
+#define BA_SETTLE_PERIODS   2
+#define BA_SETTLE_DELAYS    5
+/* Relative difference of the responses of the two halves that passes as settled */
+#define BA_SETTLE_TOLERANCE 0.05
+#define BA_SETTLE_RETRIES   2
+/* One buffer acquired, one analysed and one spare */
+#define BA_PIPELINE_BUFFERS 3
+
+struct ba_job_t{
+	size_t index;
+	size_t buffer;
+	int decimation;
+	int acq_size;
+	int retry;
+};
+
+struct ba_sweep_state_t{
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<ba_job_t> analyse;   // Acquired, waiting for the analysis
+	std::deque<ba_job_t> redo;      // Not settled, acquired again before the next points
+	std::deque<size_t> free_buffers;
+	size_t in_flight = 0;           // Jobs taken by the acquisition and not analysed yet
+	double delay_us = -1;           // Group delay of the last two points, -1 before
+	bool stop = false;
+};
+
+struct ba_point_acc_t{
+	float amplitude = 0;
+	float phase = 0;
+	unsigned int done = 0;
+	int status = RP_OK;
+};
+
+static int ba_settleUs(float _freq, double _delay_us, int _retry)
+{
+	double settle = _delay_us < 0 ? BA_SETTLE_FIRST_US : BA_SETTLE_MIN_US;
+	settle = std::max(settle, BA_SETTLE_PERIODS * 1e6 / _freq);
+	if (_delay_us >= 0){
+		settle = std::max(settle, BA_SETTLE_DELAYS * _delay_us);
+	}
+	settle *= 1 << _retry;
+	return std::min(settle, (double)BA_SETTLE_MAX_US);
+}
+
+static void ba_analysisThread(const rp_ba_sweep_t *sweep, std::vector<rp_ba_buffer_t> *buffers, ba_sweep_state_t *st, const std::function<void(const rp_ba_point_t &)> *result)
+{
+	std::vector<float> sin_t, cos_t;
+	std::vector<ba_point_acc_t> acc(sweep->freqs.size());
+	size_t next_result = 0;
+
+	for (;;) {
+		ba_job_t job;
+		{
+			std::unique_lock<std::mutex> lock(st->mtx);
+			st->cv.wait(lock, [st]{ return st->stop || !st->analyse.empty(); });
+			if (st->analyse.empty()){
+				return;
+			}
+			job = st->analyse.front();
+			st->analyse.pop_front();
+		}
+
+		float gain = 0, phase = 0;
+		bool settled = true;
+		int ret = ba_dataAnalysisLockIn((*buffers)[job.buffer], job.acq_size, sweep->freqs[job.index], job.decimation,
+										sweep->input_threshold, BA_SETTLE_TOLERANCE, sin_t, cos_t, &gain, &phase, &settled);
+		float amplitude = 10.*logf(gain);
+		if (std::isnan(amplitude) || std::isinf(amplitude)) ret = RP_EOOR;
+
+		std::vector<rp_ba_point_t> points;
+		{
+			std::lock_guard<std::mutex> lock(st->mtx);
+			st->free_buffers.push_back(job.buffer);
+			st->in_flight--;
+			if (!settled && ret == RP_OK && job.retry < BA_SETTLE_RETRIES){
+				job.retry++;
+				st->redo.push_back(job);
+			} else {
+				auto &a = acc[job.index];
+				if (ret != RP_EOOR){
+					a.amplitude += amplitude;
+				}
+				if (ret != RP_OK){
+					a.status = ret;
+				}
+				a.phase = phase;
+				a.done++;
+				/* Results go out in order, the group delay of each new pair drives the settling */
+				while (next_result < acc.size() && acc[next_result].done == sweep->averaging){
+					rp_ba_point_t p;
+					p.index = next_result;
+					p.freq = sweep->freqs[next_result];
+					p.amplitude = acc[next_result].amplitude / sweep->averaging;
+					p.phase = acc[next_result].phase;
+					p.status = acc[next_result].status;
+					if (next_result > 0 && p.freq != sweep->freqs[next_result - 1]){
+						double dphi = p.phase - acc[next_result - 1].phase;
+						if (dphi <= -180)
+							dphi += 360;
+						else if (dphi > 180)
+							dphi -= 360;
+						st->delay_us = fabs(dphi / 360.0 / (p.freq - sweep->freqs[next_result - 1])) * 1e6;
+					}
+					points.push_back(p);
+					next_result++;
+				}
+			}
+			st->cv.notify_all();
+		}
+		for (auto &p : points){
+			(*result)(p);
+		}
+	}
+}
+
+int rp_BaSweep(const rp_ba_sweep_t &sweep, const std::function<void(const rp_ba_point_t &)> &result)
+{
+	if (sweep.freqs.empty() || sweep.averaging == 0){
+		return RP_OK;
+	}
+
+	std::vector<rp_ba_buffer_t> buffers(BA_PIPELINE_BUFFERS, rp_ba_buffer_t(ADC_BUFFER_SIZE));
+	ba_sweep_state_t st;
+	for (size_t i = 0; i < buffers.size(); i++){
+		st.free_buffers.push_back(i);
+	}
+
+	/* The generator runs through the whole sweep, only its frequency changes */
+	auto changed = steady_clock::now();
+	float gen_freq = sweep.freqs[0];
+	int ret = rp_BaSafeThreadGen(sweep.channel, gen_freq, sweep.amplitude, sweep.dc_bias);
+	if (ret != RP_OK){
+		return ret;
+	}
+
+	std::thread analysis(ba_analysisThread, &sweep, &buffers, &st, &result);
+
+	size_t next = 0;
+	unsigned int repeat = 0;
+	for (;;) {
+		ba_job_t job;
+		double delay_us;
+		{
+			std::unique_lock<std::mutex> lock(st.mtx);
+			st.cv.wait(lock, [&]{ return !st.free_buffers.empty() && (!st.redo.empty() || next < sweep.freqs.size() || st.in_flight == 0); });
+			if (!st.redo.empty()){
+				job = st.redo.front();
+				st.redo.pop_front();
+			} else if (next < sweep.freqs.size()){
+				job.index = next;
+				job.retry = 0;
+				if (++repeat == sweep.averaging){
+					repeat = 0;
+					next++;
+				}
+			} else {
+				break;
+			}
+			job.buffer = st.free_buffers.front();
+			st.free_buffers.pop_front();
+			st.in_flight++;
+			delay_us = st.delay_us;
+		}
+
+		float freq = sweep.freqs[job.index];
+		ba_stepParams(freq, sweep.periods_number, &job.decimation, &job.acq_size);
+		if (freq != gen_freq){
+			ret = rp_BaSafeThreadGenFreq(sweep.channel, freq);
+			gen_freq = freq;
+			changed = steady_clock::now();
+		}
+		if (ret == RP_OK){
+			auto settled = changed + microseconds(ba_settleUs(freq, delay_us, job.retry));
+			ret = rp_BaSafeThreadAcqData(buffers[job.buffer], job.decimation, job.acq_size, sweep.amplitude, settled);
+		}
+
+		std::lock_guard<std::mutex> lock(st.mtx);
+		if (ret != RP_OK){
+			st.free_buffers.push_back(job.buffer);
+			st.in_flight--;
+			break;
+		}
+		st.analyse.push_back(job);
+		st.cv.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(st.mtx);
+		st.stop = true;
+		st.cv.notify_all();
+	}
+	analysis.join();
+	rp_GenOutDisable(sweep.channel);
+	return ret;
+}
+
+
+/* Bins of the lowest and the highest tone of a multi-tone band */
+#define BA_MT_BIN_MIN       16
+#define BA_MT_BIN_MAX       2048
+/* Unexcited bins searched around a tone for the noise estimate, and used at most */
+#define BA_MT_NOISE_SPAN    8
+#define BA_MT_NOISE_BINS    4
+/*
+ * Crest factor optimisation: at most BA_MT_CREST_ITER passes, it stops once a pass lowers the
+ * peak by less than BA_MT_CREST_GAIN. The clipping level is against the RMS.
+ */
+#define BA_MT_CREST_ITER    4
+#define BA_MT_CREST_GAIN    0.005
+#define BA_MT_CREST_CLIP    1.0
+
+/* DFT bin k of n samples with the Goertzel recurrence */
+static void ba_goertzel(const float *x, size_t n, int k, double *re, double *im){
+	double w = 2 * M_PI * k / n;
+	double coeff = 2 * cos(w);
+	double s1 = 0, s2 = 0;
+	for (size_t i = 0; i < n; i++){
+		double s0 = x[i] + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	/* The filter output is the bin rotated by -w */
+	*re = s1 * cos(w) - s2;
+	*im = s1 * sin(w);
+}
+
+/* Sum of unit cosines at bins with phases, by rotation as in ba_quadratureTable() */
+static void ba_multiSineSynth(const std::vector<int> &bins, const std::vector<double> &phases, std::vector<float> &wave){
+	size_t n = wave.size();
+	std::fill(wave.begin(), wave.end(), 0.f);
+	for (size_t m = 0; m < bins.size(); m++){
+		double w = 2 * M_PI * bins[m] / n;
+		double w_re = cos(w), w_im = sin(w);
+		double z_re = 0, z_im = 0;
+		for (size_t i = 0; i < n; i++){
+			if (i % BA_LOCKIN_BLOCK == 0){
+				z_re = cos(w * i + phases[m]);
+				z_im = sin(w * i + phases[m]);
+			}
+			wave[i] += z_re;
+			double re = z_re * w_re - z_im * w_im;
+			z_im = z_re * w_im + z_im * w_re;
+			z_re = re;
+		}
+	}
+}
+
+/* Phases found for each set of bins, repeated sweeps skip the optimisation */
+static std::map<std::vector<int>, std::vector<double>> ba_mt_phases;
+
+/*
+ * Multi-sine with equal tone amplitudes normalised to a peak of 1. Schroeder phases are
+ * improved by clipping the peaks and taking back the phases of the tones, the amplitude of
+ * each tone (1 / peak of the unit sum) is returned.
+ * The passes cost one synthesis and one Goertzel filter per tone over the whole waveform.
+ * For the sparse log spaced tones of a sweep they gain only a few percent, so there are few.
+ */
+static float ba_multiSine(const std::vector<int> &bins, std::vector<float> &wave){
+	size_t tones = bins.size();
+	auto cached = ba_mt_phases.find(bins);
+	if (cached != ba_mt_phases.end()){
+		ba_multiSineSynth(bins, cached->second, wave);
+		float peak = 0;
+		for (float v : wave){
+			peak = std::max(peak, fabsf(v));
+		}
+		for (float &v : wave){
+			v /= peak;
+		}
+		return 1 / peak;
+	}
+
+	std::vector<double> phases(tones);
+	/* Schroeder phases for any bins, the tones sweep through the period like a chirp */
+	double sum_bins = 0;
+	for (size_t m = 0; m < tones; m++){
+		phases[m] = -2 * M_PI * ((double)m * bins[m] - sum_bins) / tones;
+		sum_bins += bins[m];
+	}
+
+	float best_peak = 0;
+	std::vector<double> best_phases = phases;
+	for (int iter = 0; iter < BA_MT_CREST_ITER; iter++){
+		ba_multiSineSynth(bins, phases, wave);
+		float peak = 0;
+		double sq = 0;
+		for (float v : wave){
+			peak = std::max(peak, fabsf(v));
+			sq += v * v;
+		}
+		bool improved = iter == 0 || peak < best_peak * (1 - BA_MT_CREST_GAIN);
+		if (iter == 0 || peak < best_peak){
+			best_peak = peak;
+			best_phases = phases;
+		}
+		if (!improved || iter == BA_MT_CREST_ITER - 1){
+			break;
+		}
+		float clip = BA_MT_CREST_CLIP * sqrt(sq / wave.size());
+		for (float &v : wave){
+			v = std::max(-clip, std::min(clip, v));
+		}
+		for (size_t m = 0; m < tones; m++){
+			double re, im;
+			ba_goertzel(wave.data(), wave.size(), bins[m], &re, &im);
+			/* The synthesis uses cosines, the bin phase of cos(w i + p) is p */
+			phases[m] = atan2(im, re);
+		}
+	}
+
+	/* The loop stops before clipping, so the wave holds the last phases */
+	if (best_phases != phases){
+		ba_multiSineSynth(bins, best_phases, wave);
+	}
+	for (float &v : wave){
+		v /= best_peak;
+	}
+	ba_mt_phases[bins] = best_phases;
+	return 1 / best_peak;
+}
+
+/* Plays the multi-sine of a band, wave has one period at f0 */
+static int ba_multiToneGen(const rp_ba_sweep_t &sweep, std::vector<float> &wave, double f0){
+	pthread_mutex_lock(&mutex);
+	EXEC_CHECK_MUTEX(rp_GenReset(), mutex);
+	EXEC_CHECK_MUTEX(rp_GenWaveform(sweep.channel, RP_WAVEFORM_ARBITRARY), mutex);
+	EXEC_CHECK_MUTEX(rp_GenArbWaveform(sweep.channel, wave.data(), wave.size()), mutex);
+	EXEC_CHECK_MUTEX(rp_GenAmp(sweep.channel, sweep.amplitude), mutex);
+	EXEC_CHECK_MUTEX(rp_GenOffset(sweep.channel, sweep.dc_bias), mutex);
+	EXEC_CHECK_MUTEX(rp_GenFreq(sweep.channel, f0), mutex);
+	EXEC_CHECK_MUTEX(rp_GenOutEnable(sweep.channel), mutex);
+	EXEC_CHECK_MUTEX(rp_GenResetTrigger(sweep.channel), mutex);
+	pthread_mutex_unlock(&mutex);
+	return RP_OK;
+}
+
+int rp_BaMultiTone(const rp_ba_sweep_t &sweep, float _min_snr_db, const std::function<void(const rp_ba_point_t &)> &result)
+{
+	const size_t n = ADC_BUFFER_SIZE;
+	double fs = rp_BaGetADCSpeed();
+	std::vector<rp_ba_point_t> points(sweep.freqs.size());
+	std::vector<bool> measured(sweep.freqs.size(), false);
+	rp_ba_buffer_t buffer(n);
+	std::vector<float> wave(n);
+	int ret = RP_OK;
+
+	for (size_t i = 0; i < points.size(); i++){
+		points[i].index = i;
+		points[i].freq = sweep.freqs[i];
+	}
+
+	/* Bands in the order of the frequencies, the lowest one of each at BA_MT_BIN_MIN */
+	std::vector<size_t> order(sweep.freqs.size());
+	for (size_t i = 0; i < order.size(); i++){
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b){ return sweep.freqs[a] < sweep.freqs[b]; });
+
+	for (size_t first = 0; first < order.size() && ret == RP_OK;){
+		float f_lo = sweep.freqs[order[first]];
+		double dec_f = ceil(fs * BA_MT_BIN_MIN / (n * f_lo));
+		int decimation = dec_f < 1 ? 1 : (dec_f > 65536 ? 65536 : (int)dec_f);
+		if (decimation < 16){
+			/* Only powers of two below 16 */
+			int d = 1;
+			while (d < decimation)
+				d *= 2;
+			decimation = d;
+		}
+		double f0 = fs / ((double)decimation * n);
+
+		/* Tones of the band, points sharing a bin share the measurement */
+		std::vector<int> bins;
+		std::vector<int> point_bin(order.size(), -1);
+		size_t last = first;
+		for (; last < order.size(); last++){
+			int k = round(sweep.freqs[order[last]] / f0);
+			if (k > BA_MT_BIN_MAX)
+				break;
+			k = std::max(k, 1);
+			if (bins.empty() || bins.back() != k)
+				bins.push_back(k);
+			point_bin[last] = bins.size() - 1;
+		}
+		if (last == first){
+			/* Above the highest tone even at decimation 1, left to the single tone sweep */
+			first++;
+			continue;
+		}
+
+		auto wave_start = steady_clock::now();
+		float tone_ampl = ba_multiSine(bins, wave);
+		double wave_ms = duration_cast<microseconds>(steady_clock::now() - wave_start).count() / 1000.0;
+
+		auto changed = steady_clock::now();
+		ret = ba_multiToneGen(sweep, wave, f0);
+		if (ret != RP_OK){
+			/* The bands measured so far are still reported */
+			rp_GenOutDisable(sweep.channel);
+			break;
+		}
+
+		/* The first point settling of the single tone sweep for the lowest tone */
+		auto settled = changed + microseconds(ba_settleUs(bins.front() * f0, -1, 0));
+		ret = rp_BaSafeThreadAcqData(buffer, decimation, n, sweep.amplitude, settled);
+		rp_GenOutDisable(sweep.channel);
+		if (ret != RP_OK)
+			break;
+
+		/* Responses and noise of the tones */
+		size_t remeasure = 0;
+		for (size_t b = 0; b < bins.size(); b++){
+			int k = bins[b];
+			double re[2], im[2];
+			ba_goertzel(buffer.ch1.data(), n, k, &re[0], &im[0]);
+			ba_goertzel(buffer.ch2.data(), n, k, &re[1], &im[1]);
+
+			double noise[2] = { 0, 0 };
+			int noise_bins = 0;
+			for (int d = 1; d <= BA_MT_NOISE_SPAN && noise_bins < BA_MT_NOISE_BINS; d++){
+				for (int kn : { k - d, k + d }){
+					if (kn < 1 || kn >= (int)n / 2 || std::binary_search(bins.begin(), bins.end(), kn) || noise_bins == BA_MT_NOISE_BINS)
+						continue;
+					for (int c = 0; c < 2; c++){
+						double nre, nim;
+						ba_goertzel(c == 0 ? buffer.ch1.data() : buffer.ch2.data(), n, kn, &nre, &nim);
+						noise[c] += nre * nre + nim * nim;
+					}
+					noise_bins++;
+				}
+			}
+
+			double p1 = re[0] * re[0] + im[0] * im[0];
+			double p2 = re[1] * re[1] + im[1] * im[1];
+			double snr = 0;
+			if (noise_bins > 0){
+				double snr1 = p1 / std::max(noise[0] / noise_bins, 1e-30);
+				double snr2 = p2 / std::max(noise[1] / noise_bins, 1e-30);
+				snr = 10 * log10(std::min(snr1, snr2));
+			}
+
+			for (size_t j = first; j < last; j++){
+				if (point_bin[j] != (int)b)
+					continue;
+				rp_ba_point_t &p = points[order[j]];
+				if (noise_bins == 0 || snr < _min_snr_db || p1 <= 0){
+					remeasure++;
+					continue;
+				}
+				/* Ratio of the bins, the same as the lock-in of the single tone sweep */
+				double h_re = (re[1] * re[0] + im[1] * im[0]) / p1;
+				double h_im = (im[1] * re[0] - re[1] * im[0]) / p1;
+				p.freq = k * f0;
+				p.amplitude = 10. * log(hypot(h_re, h_im));
+				p.phase = atan2(h_im, h_re) * (180.0 / M_PI);
+				p.status = RP_OK;
+				measured[order[j]] = true;
+			}
+		}
+
+		fprintf(stderr, "Multi-tone dec %d f0 %f tones %zu tone amplitude %f waveform %.1f ms re-measure %zu\n",
+				decimation, f0, bins.size(), tone_ampl * sweep.amplitude, wave_ms, remeasure);
+		first = last;
+	}
+
+	/* Single tone sweep of the rest */
+	if (ret == RP_OK){
+		rp_ba_sweep_t rest = sweep;
+		std::vector<size_t> rest_index;
+		rest.freqs.clear();
+		for (size_t i = 0; i < points.size(); i++){
+			if (!measured[i]){
+				rest.freqs.push_back(sweep.freqs[i]);
+				rest_index.push_back(i);
+			}
+		}
+		ret = rp_BaSweep(rest, [&](const rp_ba_point_t &p){
+			rp_ba_point_t &dst = points[rest_index[p.index]];
+			dst.amplitude = p.amplitude;
+			dst.phase = p.phase;
+			dst.status = p.status;
+			measured[rest_index[p.index]] = true;
+		});
+	}
+
+	for (auto &p : points){
+		if (measured[p.index]){
+			result(p);
+		}
+	}
+	return ret;
+}
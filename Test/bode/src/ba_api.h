@@ -20,6 +20,8 @@
 #include <stdbool.h>
 #include <vector>
 #include <cstddef>
+#include <functional>
+#include <chrono>
 #include "rp.h"
 
 #define BA_CALIB_FILENAME "/tmp/ba_calib.data"
@@ -32,12 +34,53 @@ struct rp_ba_buffer_t{
 	explicit rp_ba_buffer_t(size_t size): ch1(size), ch2(size) {}
 };
 
+/* Settings of a pipelined sweep, see rp_BaSweep() */
+struct rp_ba_sweep_t{
+	rp_channel_t channel = RP_CH_1;
+	float amplitude = 1;
+	float dc_bias = 0;
+	int periods_number = 8;
+	unsigned int averaging = 1;
+	float input_threshold = 0;
+	std::vector<float> freqs;
+};
+
+/* Result of one sweep frequency */
+struct rp_ba_point_t{
+	size_t index;
+	float freq;
+	float amplitude; // [dB]
+	float phase;     // [deg]
+	int status;      // RP_OK, RP_EIPV or RP_EOOR
+};
+
 auto rp_BaDataAnalysis(const rp_ba_buffer_t &buffer,uint32_t size, float samplesPerSecond,float _freq,  int  samples_period, float *gain, float *phase_out) -> int;
 auto rp_BaSafeThreadAcqPrepare() -> int;
 auto rp_BaSafeThreadGen(rp_channel_t _channel, float _frequency, float _ampl, float _dc_bias) -> int;
-auto rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, rp_acq_decimation_t _decimation, int _acq_size, int _dec, float _trigger) -> int;
+auto rp_BaSafeThreadGenFreq(rp_channel_t _channel, float _frequency) -> int;
+auto rp_BaSafeThreadAcqData(rp_ba_buffer_t &_buffer, int _decimation, int _acq_size, float _trigger, std::chrono::steady_clock::time_point _settled = {}) -> int;
 auto rp_BaGetAmplPhase(float _amplitude_in, float _dc_bias, int _periods_number, rp_ba_buffer_t &_buffer, float* _amplitude, float* _phase, float _freq,float _input_threshold) -> int;
 
+/*
+ * Measures all sweep.freqs with the acquisition of the next frequency running
+ * while the previous one is analysed on the other core. The settling time before
+ * each acquisition follows the group delay measured on the previous points, an
+ * acquisition whose two halves disagree is repeated with a longer one.
+ * result is called from the analysis thread, in the order of sweep.freqs.
+ */
+auto rp_BaSweep(const rp_ba_sweep_t &sweep, const std::function<void(const rp_ba_point_t &)> &result) -> int;
+
+/*
+ * Measures the sweep with multi-sine excitations, one acquisition per band of about two decades.
+ * The frequencies of a band are moved to harmonics of the band fundamental (the arbitrary
+ * waveform rate) with crest factor optimised phases, and each response comes from a Goertzel
+ * filter at its bin. Points whose SNR against the nearby unexcited bins is below _min_snr_db,
+ * or which have no such bins, are measured again by rp_BaSweep(). Results keep the order of
+ * sweep.freqs. Their freq is the measured frequency. After an error the points measured
+ * so far are still reported and the error is returned.
+ */
+auto rp_BaMultiTone(const rp_ba_sweep_t &sweep, float _min_snr_db, const std::function<void(const rp_ba_point_t &)> &result) -> int;
+
 auto rp_BaCalibGain(float _freq, float _ampl) -> float;
 auto rp_BaCalibPhase(float _freq, float _phase) -> float;
 auto rp_BaResetCalibration() -> int;
@@ -54,7 +54,8 @@ void usage() {
                        "[count/steps] "
                        "[start freq] "
                        "[stop freq] "
-                       "[scale type]\n"
+                       "[scale type] "
+                       "[mode]\n"
             "or\n"
             "\t%s -calib\n"
             "\n"
@@ -67,6 +68,9 @@ void usage() {
             "\tstart freq         Lower frequency limit in Hz [3 - 62.5e6].\n"
             "\tstop freq          Upper frequency limit in Hz [3 - 62.5e6].\n"
             "\tscale type         0 - linear, 1 - logarithmic.\n"
+            "\tmode               Optional, 0 - one tone at a time (default), 1 - multi-tone.\n"
+            "\t                   Multi-tone measures about two decades per acquisition, the\n"
+            "\t                   frequencies are rounded to the harmonics of the waveform.\n"
             "\t-calib             Starts calibration mode. The calibration values will be saved in:"
             BA_CALIB_FILENAME
             "\n"
@@ -88,6 +92,7 @@ int main(int argc, char *argv[]) {
     double end_frequency = rp_BaGetADCSpeed() / 2.0;
     c_max_frequency = end_frequency;
     unsigned int scale_type = 1;
+    unsigned int measure_mode = 0;
     int ignored __attribute__((unused));
 
     /** Set program name */
@@ -194,6 +199,15 @@ int main(int argc, char *argv[]) {
             usage();
             return -1;
         }
+        /// Measure mode (0=single tone, 1=multi-tone)
+        if (argc > 9) {
+            measure_mode = strtod(argv[9], NULL);
+            if ( measure_mode > 1 ) {
+                fprintf(stderr, "Invalid mode!\n\n");
+                usage();
+                return -1;
+            }
+        }
     }
 
     /** Parameters initialization and calculation */
@@ -264,55 +278,49 @@ int main(int argc, char *argv[]) {
 
    // fprintf(stderr, "a %f b %f c %f\n", a, b, c);
 
-    float old_freq = start_frequency;
-    //float old_steps = steps;
-    rp_Init();
-    rp_BaSafeThreadAcqPrepare();
-
-    while(steps > 0) {
-
-
-        float amplitude = 0, phase_out = 0;
-        float current_freq = 0.;
-        //float next_freq = 0.;
+    rp_ba_sweep_t sweep;
+    sweep.channel = ch == 0 ? RP_CH_1 : RP_CH_2;
+    sweep.amplitude = ampl;
+    sweep.dc_bias = DC_bias;
+    sweep.periods_number = periods_number;
+    sweep.averaging = averaging_num;
+    sweep.input_threshold = 0;
 
+    float old_freq = start_frequency;
+    for (cur_step = 0; cur_step < (int)steps; cur_step++) {
         if (scale_type) {
             // Log
-            current_freq = pow(10.f, c * cur_step + a);
-         //   next_freq = pow(10.f, c * (cur_step + 1) + a);
+            sweep.freqs.push_back(pow(10.f, c * cur_step + a));
         } else {
             // Linear
-            current_freq = static_cast<float>(old_freq) + freq_step * cur_step;
-          //  next_freq = static_cast<float>(old_freq) + freq_step * (cur_step + 1);
+            sweep.freqs.push_back(static_cast<float>(old_freq) + freq_step * cur_step);
         }
+    }
 
-        for (unsigned int i = 0; i < averaging_num; ++i)
-        {
-            float ampl_out = 0;
-
-            if (rp_BaGetAmplPhase(ampl, DC_bias,periods_number, buffer, &ampl_out, &phase_out, current_freq,0) ==  RP_EOOR) // isnan && isinf
-            {
-                --steps;
-                continue;
-            }
-            amplitude += ampl_out;
-        }
-        amplitude /= averaging_num;
+    rp_Init();
+    rp_BaSafeThreadAcqPrepare();
 
-        --steps;
-        cur_step++;
-        float calib_ampl = rp_BaCalibGain(current_freq, amplitude);
-        float calib_phase = rp_BaCalibPhase(current_freq, phase_out);
-        fprintf(file_frequency, "%.5f\n", current_freq);
+    auto write_point = [&](const rp_ba_point_t &point) {
+        float calib_ampl = rp_BaCalibGain(point.freq, point.amplitude);
+        float calib_phase = rp_BaCalibPhase(point.freq, point.phase);
+        fprintf(file_frequency, "%.5f\n", point.freq);
         fprintf(file_amplitude, "%.5f\n", calib_ampl);
         fprintf(file_phase,     "%.5f\n", calib_phase);
 
         if (calibMode) // save data in calibration mode
         {
-			rp_BaWriteCalib(current_freq,amplitude,phase_out);
+			rp_BaWriteCalib(point.freq,point.amplitude,point.phase);
         }
 
-        printf("%.2f    %.5f    %.5f\n", current_freq, calib_phase, calib_ampl);
+        printf("%.2f    %.5f    %.5f\n", point.freq, calib_phase, calib_ampl);
+    };
+
+    if (measure_mode == 1) {
+        /* Tones below 40 dB SNR are measured again one at a time */
+        rp_BaMultiTone(sweep, 40, write_point);
+    } else {
+        /* Acquisition of the next frequency overlaps the analysis of the current one */
+        rp_BaSweep(sweep, write_point);
     }
 
     rp_Release();
@@ -0,0 +1,208 @@
+/**
+ * @brief Red Pitaya acquisition engine benchmark.
+ *
+ * Times the rp_acq kernels on a synthetic 16k sample ring buffer and checks
+ * the results against plain reference loops. Run it on the board:
+ *   make -C apps-free/common bench && apps-free/common/bench/acq_bench
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <limits.h>
+
+#include "rp_acq.h"
+
+#define SIG_LEN    (16*1024)
+#define OUT_LEN    (2*1024)
+#define SMPL_FREQ  125e6
+
+static int in_signal[SIG_LEN];
+static float out_signal[OUT_LEN];
+static int failed = 0;
+
+
+/*----------------------------------------------------------------------------------*/
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+/* Sine with noise in the 14 bit two's complement format of the FPGA buffers */
+static void fill_signal(int periods, int amp)
+{
+    int i;
+    for(i = 0; i < SIG_LEN; i++) {
+        int v = amp * sin(2 * M_PI * periods * i / SIG_LEN) + (rand() % 64) - 32;
+        in_signal[i] = v & ((1 << RP_ACQ_ADC_BITS) - 1);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void check(int cond, const char *name)
+{
+    if(!cond) {
+        printf("FAIL %s\n", name);
+        failed++;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void bench_min_max(int loops)
+{
+    int min, max, ref_min = INT_MAX, ref_max = INT_MIN, i;
+    int64_t sum, ref_sum = 0;
+    double t;
+
+    for(i = 0; i < SIG_LEN; i++) {
+        int v = rp_acq_adc_sign(in_signal[i]);
+        ref_min = v < ref_min ? v : ref_min;
+        ref_max = v > ref_max ? v : ref_max;
+        ref_sum += v;
+    }
+
+    t = now_us();
+    for(i = 0; i < loops; i++)
+        rp_acq_min_max(in_signal, SIG_LEN, i % SIG_LEN, SIG_LEN, &min, &max, &sum);
+    t = (now_us() - t) / loops;
+
+    check(min == ref_min && max == ref_max && sum == ref_sum, "min_max");
+    printf("rp_acq_min_max   %8.1f us / %d samples\n", t, SIG_LEN);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void bench_decimate(int loops, int step)
+{
+    double t;
+    int i;
+
+    t = now_us();
+    for(i = 0; i < loops; i++)
+        rp_acq_decimate(out_signal, in_signal, SIG_LEN, 100, step, OUT_LEN,
+                        1.0, 10, 0.1);
+    t = (now_us() - t) / loops;
+
+    for(i = 0; i < OUT_LEN; i++) {
+        float ref = rp_acq_cnv_cnt_to_v(in_signal[(100 + i * step) % SIG_LEN],
+                                        1.0, 10, 0.1);
+        if(out_signal[i] != ref) {
+            check(0, "decimate");
+            break;
+        }
+    }
+    printf("rp_acq_decimate  %8.1f us / %d samples, step %d\n", t, OUT_LEN, step);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void bench_decimate_cols(int loops, int step, int mode)
+{
+    double t;
+    int i, j;
+
+    t = now_us();
+    for(i = 0; i < loops; i++)
+        rp_acq_decimate_cols(out_signal, in_signal, SIG_LEN, 100, step,
+                             OUT_LEN, mode, 1.0, 10, 0.1);
+    t = (now_us() - t) / loops;
+
+    for(i = 0; i < OUT_LEN; i += 2) {
+        /* reference extremes of the column, or means of its two points */
+        int min = INT_MAX, max = INT_MIN, min_pos = 0, max_pos = 0;
+        int64_t sum[2] = { 0, 0 };
+        float ref[2];
+
+        for(j = 0; j < 2 * step; j++) {
+            int v = rp_acq_adc_sign(in_signal[(100 + i * step + j) % SIG_LEN]);
+            if(v < min) {
+                min = v;
+                min_pos = j;
+            }
+            if(v > max) {
+                max = v;
+                max_pos = j;
+            }
+            sum[j / step] += v;
+        }
+        if(mode == RP_ACQ_DEC_AVG) {
+            ref[0] = sum[0] / (float)step * 1.0 / 8192;
+            ref[1] = sum[1] / (float)step * 1.0 / 8192;
+            if(fabs(out_signal[i] - 0.1 - 10 / 8192.0 - ref[0]) > 1e-5 ||
+               fabs(out_signal[i+1] - 0.1 - 10 / 8192.0 - ref[1]) > 1e-5) {
+                check(0, "decimate_cols avg");
+                break;
+            }
+        } else {
+            /* in the order they occur */
+            ref[max_pos < min_pos] = rp_acq_cnv_cnt_to_v(min & 0x3fff, 1.0,
+                                                          10, 0.1);
+            ref[max_pos >= min_pos] = rp_acq_cnv_cnt_to_v(max & 0x3fff, 1.0,
+                                                           10, 0.1);
+            if(out_signal[i] != ref[0] || out_signal[i+1] != ref[1]) {
+                check(0, "decimate_cols peak");
+                break;
+            }
+        }
+    }
+    printf("rp_acq_decimate_cols %5.1f us / %d samples, step %d, %s\n", t,
+           OUT_LEN, step, (mode == RP_ACQ_DEC_AVG) ? "avg" : "peak");
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void bench_period(int loops, int periods)
+{
+    rp_acq_meas_t meas;
+    int min, max, i;
+    double t;
+
+    rp_acq_meas_clear(&meas);
+    rp_acq_meas_min_max(&meas, in_signal, SIG_LEN, 0, SIG_LEN);
+
+    t = now_us();
+    for(i = 0; i < loops; i++)
+        rp_acq_meas_period(&meas, in_signal, SIG_LEN, 0, SMPL_FREQ, 1, &min, &max);
+    t = (now_us() - t) / loops;
+
+    check(fabs(meas.freq - SMPL_FREQ * periods / SIG_LEN) <
+          0.01 * SMPL_FREQ * periods / SIG_LEN, "period");
+    printf("rp_acq_period    %8.1f us / %d samples\n", t, SIG_LEN);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    int loops = (argc > 1) ? atoi(argv[1]) : 1000;
+
+    if(loops <= 0)
+        loops = 1;
+
+    fill_signal(64, 4000);
+    bench_min_max(loops);
+    bench_decimate(loops, 1);
+    bench_decimate(loops, 8);
+    bench_decimate_cols(loops, 8, RP_ACQ_DEC_PEAK);
+    bench_decimate_cols(loops, 8, RP_ACQ_DEC_AVG);
+    bench_period(loops, 64);
+
+    if(failed) {
+        printf("FAILED %d checks\n", failed);
+        return 1;
+    }
+    return 0;
+}
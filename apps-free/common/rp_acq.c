@@ -0,0 +1,493 @@
+/**
+ * @brief Red Pitaya acquisition and measurement engine.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/eventfd.h>
+
+#include "rp_acq.h"
+#include "acq_measure.h"
+
+static const int c_adc_full = 1 << (RP_ACQ_ADC_BITS - 1);
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_acq_min_max(const int *in, int size, int start, int len,
+                    int *min, int *max, int64_t *sum)
+{
+    acq_meas_t m;
+
+    /* edges are not needed, low > high disables them */
+    acq_MeasureCnts((const volatile uint32_t *)in, size, start, len,
+                    RP_ACQ_ADC_BITS, true, 1, 0, &m);
+
+    *min = m.min;
+    *max = m.max;
+    *sum = m.sum;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_meas_clear(rp_acq_meas_t *meas)
+{
+    meas->min = 1e9;
+    meas->max = -1e9;
+    meas->amp = 0;
+    meas->avg = 0;
+    meas->freq = 0;
+    meas->period = 0;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_meas_min_max(rp_acq_meas_t *meas, const int *in, int size,
+                        int start, int len)
+{
+    int min, max;
+    int64_t sum;
+
+    if(len <= 0)
+        return 0;
+
+    rp_acq_min_max(in, size, start, len, &min, &max, &sum);
+    if(meas->min > min)
+        meas->min = min;
+    if(meas->max < max)
+        meas->max = max;
+    meas->avg += sum;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_meas_avg_amp(rp_acq_meas_t *meas, int avg_len)
+{
+    meas->avg /= avg_len;
+    meas->amp = meas->max - meas->min;
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+float rp_acq_period(const int *in, int size, int trig_ptr, float meas_min,
+                    float meas_max, float smpl_freq, int dec_factor,
+                    int *min, int *max)
+{
+    const float c_meas_freq_thr = 100;
+    const float c_min_period = 19.6e-9; // 51 MHz
+
+    float thr1, thr2, cen;
+    float period = 0;
+    acq_meas_t m;
+
+    float acq_dur = (float)size / smpl_freq * (float)dec_factor;
+
+    cen = (meas_max + meas_min) / 2;
+
+    thr1 = cen + 0.2 * (meas_min - cen);
+    thr2 = cen + 0.2 * (meas_max - cen);
+
+    /* Counts below thr1 arm the edge, counts at or above thr2 complete it. Another
+     * max, min calculation over the whole buffer avoids evaluation errors on slower
+     * signals */
+    acq_MeasureCnts((const volatile uint32_t *)in, size, trig_ptr, size,
+                    RP_ACQ_ADC_BITS, true, (int32_t)ceilf(thr1),
+                    (int32_t)ceilf(thr2), &m);
+
+    *min = m.min;
+    *max = m.max;
+
+    /* Period calculation - mean over all edges, interpolated to the middle level */
+    if(m.rising >= 2) {
+        period = (m.last_rising - m.first_rising) /
+            (smpl_freq * (m.rising - 1)) * dec_factor;
+    }
+
+    if( ((thr2 - thr1) < c_meas_freq_thr) ||
+         (period * 3 >= acq_dur)    ||
+         (period < c_min_period) )
+    {
+        period = 0;
+    }
+
+    return period;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_meas_period(rp_acq_meas_t *meas, const int *in, int size,
+                       int trig_ptr, float smpl_freq, int dec_factor,
+                       int *min, int *max)
+{
+    meas->period = rp_acq_period(in, size, trig_ptr, meas->min, meas->max,
+                                 smpl_freq, dec_factor, min, max);
+    meas->freq = (meas->period > 0) ? 1.0 / meas->period : 0;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static inline float rp_acq_meas_cnv_cnt(float data, float adc_max_v)
+{
+    return (data * adc_max_v / (float)c_adc_full);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_meas_convert(rp_acq_meas_t *meas, float adc_max_v,
+                        int32_t cal_dc_offs)
+{
+    meas->min = rp_acq_meas_cnv_cnt(meas->min+cal_dc_offs, adc_max_v);
+    meas->max = rp_acq_meas_cnv_cnt(meas->max+cal_dc_offs, adc_max_v);
+    meas->amp = rp_acq_meas_cnv_cnt(meas->amp, adc_max_v);
+    meas->avg = rp_acq_meas_cnv_cnt(meas->avg+cal_dc_offs, adc_max_v);
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+/* Signed ADC counts, possibly averaged, to [V] */
+static inline float rp_acq_cnv_to_v(float m, float adc_max_v,
+                                    int calib_dc_off, float user_dc_off)
+{
+    /* adopt ADC count with calibrated DC offset */
+    m += calib_dc_off;
+
+    /* map ADC counts into user units */
+    if(m < -c_adc_full)
+        m = -c_adc_full;
+    else if(m > c_adc_full)
+        m = c_adc_full;
+
+    /* and adopt the calculation with user specified DC offset */
+    return m * adc_max_v / (float)c_adc_full + user_dc_off;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+float rp_acq_cnv_cnt_to_v(int cnts, float adc_max_v,
+                          int calib_dc_off, float user_dc_off)
+{
+    return rp_acq_cnv_to_v(rp_acq_adc_sign(cnts), adc_max_v, calib_dc_off,
+                           user_dc_off);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_decimate(float *out, const int *in, int size, int start, int step,
+                    int n, float adc_max_v, int calib_dc_off,
+                    float user_dc_off)
+{
+    int i;
+
+    start %= size;
+    for(i = 0; i < n; i++) {
+        out[i] = rp_acq_cnv_cnt_to_v(in[start], adc_max_v, calib_dc_off,
+                                     user_dc_off);
+        start += step;
+        if(start >= size)
+            start %= size;
+    }
+
+    return start;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_decimate_cols(float *out, const int *in, int size, int start,
+                         int step, int n, int mode, float adc_max_v,
+                         int calib_dc_off, float user_dc_off)
+{
+    acq_bin_t bins[RP_ACQ_DEC_MAX_OUT];
+    int i, len;
+
+    if(step <= 1)
+        return rp_acq_decimate(out, in, size, start, step, n, adc_max_v,
+                               calib_dc_off, user_dc_off);
+
+    start %= size;
+    for(i = 0; i < n; i += len) {
+        len = n - i;
+        if(len > RP_ACQ_DEC_MAX_OUT)
+            len = RP_ACQ_DEC_MAX_OUT;
+
+        /* one bin per output point, a column is a pair of bins */
+        acq_MeasureBins((const volatile uint32_t *)in, size, start, step,
+                        len, RP_ACQ_ADC_BITS, true, mode == RP_ACQ_DEC_PEAK,
+                        bins);
+        start = (start + (int64_t)step * len) % size;
+
+        if(mode == RP_ACQ_DEC_AVG) {
+            int j;
+            for(j = 0; j < len; j++)
+                out[i+j] = rp_acq_cnv_to_v((float)bins[j].sum / step,
+                                           adc_max_v, calib_dc_off,
+                                           user_dc_off);
+        } else {
+            int j;
+            for(j = 0; j + 1 < len; j += 2) {
+                acq_bin_t *a = &bins[j], *b = &bins[j+1];
+                int min = (a->min < b->min) ? a->min : b->min;
+                int max = (a->max > b->max) ? a->max : b->max;
+                /* first occurrences in the column, a wins ties */
+                uint32_t min_pos = (a->min == min) ? a->min_pos
+                                                   : step + b->min_pos;
+                uint32_t max_pos = (a->max == max) ? a->max_pos
+                                                   : step + b->max_pos;
+                int max_first = (max_pos < min_pos);
+
+                out[i+j]   = rp_acq_cnv_to_v(max_first ? max : min, adc_max_v,
+                                             calib_dc_off, user_dc_off);
+                out[i+j+1] = rp_acq_cnv_to_v(max_first ? min : max, adc_max_v,
+                                             calib_dc_off, user_dc_off);
+            }
+            /* odd point count, the last column has one bin */
+            if(j < len)
+                out[i+j] = rp_acq_cnv_to_v((float)bins[j].sum / step,
+                                           adc_max_v, calib_dc_off,
+                                           user_dc_off);
+        }
+    }
+
+    return start;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static double rp_acq_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void rp_acq_event_report(rp_acq_event_t *ev)
+{
+    fprintf(stderr, "%s: %u trigger wakeups, latency last %.0f us, "
+            "avg %.0f us, max %.0f us (%s)\n", ev->name, ev->stats.count,
+            ev->stats.last_us, ev->stats.avg_us, ev->stats.max_us,
+            (ev->uio_fd >= 0) ? "interrupt" : "polling");
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_event_init(rp_acq_event_t *ev, const char *name, int max_sleep_us)
+{
+    const char *uio = getenv("RP_ACQ_TRIG_UIO");
+    const char *report = getenv("RP_ACQ_WAIT_REPORT");
+
+    memset(ev, 0, sizeof(*ev));
+    ev->name = name;
+    ev->max_sleep_us = (max_sleep_us > 0) ? max_sleep_us : 1000;
+    ev->avg_wait_us = ev->max_sleep_us;
+    ev->report_s = report ? atoi(report) : 0;
+    ev->report_t = rp_acq_now_us();
+
+    ev->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(ev->wake_fd < 0) {
+        fprintf(stderr, "%s: eventfd() failed: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    ev->uio_fd = -1;
+    if(uio && uio[0]) {
+        ev->uio_fd = open(uio, O_RDWR | O_CLOEXEC);
+        if(ev->uio_fd < 0)
+            fprintf(stderr, "%s: trigger interrupt %s not available (%s), "
+                    "polling\n", name, uio, strerror(errno));
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_acq_event_close(rp_acq_event_t *ev)
+{
+    if(ev->stats.count)
+        rp_acq_event_report(ev);
+    if(ev->uio_fd >= 0)
+        close(ev->uio_fd);
+    if(ev->wake_fd >= 0)
+        close(ev->wake_fd);
+    ev->uio_fd = ev->wake_fd = -1;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_acq_event_wake(rp_acq_event_t *ev)
+{
+    uint64_t one = 1;
+    if(ev->wake_fd >= 0 && write(ev->wake_fd, &one, sizeof(one)) < 0) {
+        /* counter is already non-zero, the waiter wakes anyway */
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void rp_acq_event_ready(rp_acq_event_t *ev, double t_start,
+                               double t_event, double t_ready)
+{
+    /* the waits that were long do not spin next time */
+    const float c_wait_avg_w = 0.125;
+    float lat = t_ready - t_event;
+
+    ev->avg_wait_us += c_wait_avg_w * ((t_ready - t_start) - ev->avg_wait_us);
+
+    ev->stats.count++;
+    ev->stats.last_us = lat;
+    ev->lat_sum_us += lat;
+    ev->stats.avg_us = ev->lat_sum_us / ev->stats.count;
+    if(lat > ev->stats.max_us)
+        ev->stats.max_us = lat;
+
+    if(ev->report_s > 0 && (t_ready - ev->report_t) >= ev->report_s * 1e6) {
+        rp_acq_event_report(ev);
+        ev->report_t = t_ready;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_event_wait(rp_acq_event_t *ev, rp_acq_cond_func ready,
+                      rp_acq_cond_func abort, void *arg, int timeout_us)
+{
+    /* spinning pays off only when the trigger usually comes this soon */
+    const float c_spin_max_us = 200;
+    const int c_sleep_min_us = 20;
+    const int c_abort_period_us = 10000;
+
+    double t_start = rp_acq_now_us();
+    double t_check, t_abort, now;
+    int sleep_us = c_sleep_min_us;
+
+    if(abort && abort(arg))
+        return RP_ACQ_WAIT_ABORT;
+    if(ready && ready(arg))
+        return RP_ACQ_WAIT_READY;
+    if(timeout_us == 0)
+        return RP_ACQ_WAIT_TIMEOUT;
+    t_check = t_abort = rp_acq_now_us();
+
+    /* spin */
+    if(ready && ev->uio_fd < 0 && ev->avg_wait_us < c_spin_max_us) {
+        float spin_us = 2 * ev->avg_wait_us;
+        while((now = rp_acq_now_us()) - t_start < spin_us) {
+            if(ready(arg)) {
+                rp_acq_event_ready(ev, t_start, t_check, now);
+                return RP_ACQ_WAIT_READY;
+            }
+            t_check = now;
+        }
+    }
+
+    /* sleep until the interrupt, a wake or the next poll */
+    while(1) {
+        struct pollfd fds[2];
+        struct timespec ts;
+        int nfds = 1, wait_us, woken;
+        uint64_t cnt;
+
+        fds[0].fd = ev->wake_fd;
+        fds[0].events = POLLIN;
+        if(ready && ev->uio_fd >= 0) {
+            /* enable the interrupt before the check, so it can not be lost */
+            int32_t enable = 1;
+            if(write(ev->uio_fd, &enable, sizeof(enable)) == sizeof(enable)) {
+                fds[1].fd = ev->uio_fd;
+                fds[1].events = POLLIN;
+                nfds = 2;
+            }
+            if(ready(arg)) {
+                now = rp_acq_now_us();
+                rp_acq_event_ready(ev, t_start, t_check, now);
+                return RP_ACQ_WAIT_READY;
+            }
+        }
+
+        /* with the interrupt only the abort and the timeout are polled */
+        wait_us = (nfds == 2 || !ready) ? c_abort_period_us : sleep_us;
+        if(timeout_us > 0) {
+            int left = timeout_us - (int)(rp_acq_now_us() - t_start);
+            if(left < wait_us)
+                wait_us = (left > 0) ? left : 0;
+        }
+        ts.tv_sec = wait_us / 1000000;
+        ts.tv_nsec = (wait_us % 1000000) * 1000;
+        woken = ppoll(fds, nfds, &ts, NULL);
+        now = rp_acq_now_us();
+
+        if(woken > 0 && (fds[0].revents & POLLIN)) {
+            if(read(ev->wake_fd, &cnt, sizeof(cnt)) < 0) {
+                /* already drained */
+            }
+        }
+        if(abort && ((woken > 0 && (fds[0].revents & POLLIN)) ||
+                     now - t_abort >= c_abort_period_us)) {
+            t_abort = now;
+            if(abort(arg))
+                return RP_ACQ_WAIT_ABORT;
+        }
+        if(nfds == 2 && woken > 0 && (fds[1].revents & POLLIN)) {
+            int32_t irqs;
+            if(read(ev->uio_fd, &irqs, sizeof(irqs)) < 0) {
+                /* counted by the kernel, nothing to do */
+            }
+            t_check = now;
+        }
+
+        if(ready) {
+            if(ready(arg)) {
+                rp_acq_event_ready(ev, t_start, t_check, rp_acq_now_us());
+                return RP_ACQ_WAIT_READY;
+            }
+            t_check = rp_acq_now_us();
+        }
+        if(timeout_us > 0 && now - t_start >= timeout_us)
+            return RP_ACQ_WAIT_TIMEOUT;
+
+        sleep_us *= 2;
+        if(sleep_us > ev->max_sleep_us)
+            sleep_us = ev->max_sleep_us;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_acq_time_unit_factor(int time_unit)
+{
+    switch(time_unit) {
+    case 0:
+        /* [us] */
+        return 1e6;
+    case 1:
+        /* [ms] */
+        return 1e3;
+    case 2:
+    default:
+        /* [s] */
+        return 1;
+    }
+}
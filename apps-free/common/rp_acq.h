@@ -0,0 +1,151 @@
+/**
+ * @brief Red Pitaya acquisition and measurement engine, shared by the
+ *        apps-free workers (scope, bode_plotter, teslameter, ...).
+ *
+ * The functions work on the raw FPGA ring buffers (14 bit two's complement
+ * ADC samples in int words) and do not touch the FPGA registers, so the same
+ * kernels serve all applications and can be benchmarked on their own
+ * (common/bench). Min/max and period use the single pass measurement kernel
+ * of librp (rp-api/api/src/acq_measure.c), built from the same source.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __RP_ACQ_H
+#define __RP_ACQ_H
+
+#include <stdint.h>
+
+#define RP_ACQ_ADC_BITS 14
+
+/* Signal measurement results, in ADC counts until rp_acq_meas_convert() */
+typedef struct rp_acq_meas_s {
+    float min;
+    float max;
+    float amp;
+    float avg;
+    float freq;
+    float period;
+} rp_acq_meas_t;
+
+/* Condition checked by rp_acq_event_wait(), returns non-zero when met */
+typedef int (*rp_acq_cond_func)(void *arg);
+
+/* Sign extension of a raw ADC sample */
+static inline int rp_acq_adc_sign(int in_data)
+{
+    int s_data = in_data;
+    if(s_data & (1<<(RP_ACQ_ADC_BITS-1)))
+        s_data = -1 * ((s_data ^ ((1<<RP_ACQ_ADC_BITS)-1)) + 1);
+    return s_data;
+}
+
+/* Minimum, maximum and sum of len samples of the ring buffer in (size
+ * samples) starting at index start */
+void rp_acq_min_max(const int *in, int size, int start, int len,
+                    int *min, int *max, int64_t *sum);
+
+/*** Measurements ***/
+int rp_acq_meas_clear(rp_acq_meas_t *meas);
+/* Accumulates min, max and sum of the samples, can be called for parts of
+ * the signal (long acquisitions) */
+int rp_acq_meas_min_max(rp_acq_meas_t *meas, const int *in, int size,
+                        int start, int len);
+int rp_acq_meas_avg_amp(rp_acq_meas_t *meas, int avg_len);
+/* Period of the signal from the trigger pointer on, with the thresholds
+ * from meas->min and meas->max, averaged over all edges of the buffer.
+ * Returns period in [s], 0 if not measurable. min and max are the extremes
+ * of the buffer, measured in the same pass. */
+float rp_acq_period(const int *in, int size, int trig_ptr, float meas_min,
+                    float meas_max, float smpl_freq, int dec_factor,
+                    int *min, int *max);
+/* Sets meas->period and meas->freq, see rp_acq_period() */
+int rp_acq_meas_period(rp_acq_meas_t *meas, const int *in, int size,
+                       int trig_ptr, float smpl_freq, int dec_factor,
+                       int *min, int *max);
+/* Converts the results from ADC counts to [V] */
+int rp_acq_meas_convert(rp_acq_meas_t *meas, float adc_max_v,
+                        int32_t cal_dc_offs);
+
+/*** Decimation ***/
+/* ADC counts to [V] with calibrated and user DC offsets */
+float rp_acq_cnv_cnt_to_v(int cnts, float adc_max_v,
+                          int calib_dc_off, float user_dc_off);
+/* Takes n samples from the ring buffer in (size samples), every step-th 
+ * sample from index start on, and converts them to [V].
+ * Returns the ring index after the last taken sample. */
+int rp_acq_decimate(float *out, const int *in, int size, int start, int step,
+                    int n, float adc_max_v, int calib_dc_off,
+                    float user_dc_off);
+
+/* Display decimation modes of rp_acq_decimate_cols() */
+#define RP_ACQ_DEC_PEAK      0  /* min and max of each column */
+#define RP_ACQ_DEC_AVG       1  /* mean of each point */
+/* Points computed per kernel call, n may be larger */
+#define RP_ACQ_DEC_MAX_OUT   256
+
+/* Like rp_acq_decimate(), but each of the n points stands for all step
+ * samples from its position on instead of the first one. Pairs of points
+ * form columns of 2 * step samples. RP_ACQ_DEC_PEAK outputs the minimum and
+ * the maximum of each column, in the order of their first occurrences (a
+ * flat column outputs the minimum first), so glitches between the taken
+ * samples stay visible. RP_ACQ_DEC_AVG outputs the mean of the step samples
+ * of each point. Step 1 is the same as rp_acq_decimate(). */
+int rp_acq_decimate_cols(float *out, const int *in, int size, int start,
+                         int step, int n, int mode, float adc_max_v,
+                         int calib_dc_off, float user_dc_off);
+
+/*** Trigger ***/
+/* Results of rp_acq_event_wait() */
+#define RP_ACQ_WAIT_READY    0
+#define RP_ACQ_WAIT_ABORT    1
+#define RP_ACQ_WAIT_TIMEOUT  2
+
+/* Wakeup latency of the waits that returned RP_ACQ_WAIT_READY: time from
+ * the last check that found the condition unmet (or from the interrupt) to
+ * the check that found it met, in [us] */
+typedef struct rp_acq_event_stats_s {
+    unsigned int count;
+    float        last_us;
+    float        avg_us;
+    float        max_us;
+} rp_acq_event_stats_t;
+
+/* Trigger event of a worker thread. The wait blocks on the trigger interrupt
+ * when the FPGA image exports one (UIO device in the RP_ACQ_TRIG_UIO
+ * environment variable), otherwise it spins for short expected waits and
+ * sleeps with growing intervals for long ones. Other threads cancel it with
+ * rp_acq_event_wake() when they change the worker state. The latency
+ * statistics go to stderr at close and every RP_ACQ_WAIT_REPORT seconds. */
+typedef struct rp_acq_event_s {
+    const char          *name;
+    int                  uio_fd;        /* -1 without trigger interrupt */
+    int                  wake_fd;       /* eventfd of rp_acq_event_wake() */
+    int                  max_sleep_us;
+    float                avg_wait_us;   /* drives the spin time */
+    int                  report_s;      /* RP_ACQ_WAIT_REPORT, 0 - at close only */
+    double               report_t;
+    double               lat_sum_us;
+    rp_acq_event_stats_t stats;
+} rp_acq_event_t;
+
+int rp_acq_event_init(rp_acq_event_t *ev, const char *name, int max_sleep_us);
+void rp_acq_event_close(rp_acq_event_t *ev);
+/* Makes a pending or the next wait check abort(arg), from any thread */
+void rp_acq_event_wake(rp_acq_event_t *ev);
+/* Waits until ready(arg) returns non-zero (RP_ACQ_WAIT_READY), abort(arg)
+ * returns non-zero (RP_ACQ_WAIT_ABORT) or timeout_us passes
+ * (RP_ACQ_WAIT_TIMEOUT, never with timeout_us < 0). Without ready it only
+ * waits for abort or the timeout. abort is checked after the wakes and at
+ * least every 10 ms. */
+int rp_acq_event_wait(rp_acq_event_t *ev, rp_acq_cond_func ready,
+                      rp_acq_cond_func abort, void *arg, int timeout_us);
+
+/* Time unit (0 - [us], 1 - [ms], 2 - [s]) to factor from [s] */
+int rp_acq_time_unit_factor(int time_unit);
+
+#endif /* __RP_ACQ_H */
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 
 #include "worker.h"
+#include "rp_acq.h"
 #include "fpga.h"
 #include "dsp.h"
 #include "fpga_awg.h"
@@ -96,10 +97,41 @@ pthread_mutex_t        rp_spectr_sig_mutex = PTHREAD_MUTEX_INITIALIZER;
 float                **rp_spectr_signals = NULL;
 int                    rp_spectr_signals_dirty = 0;
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_spectr_event;
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_spectr_wait_s {
+    rp_spectr_worker_state_t old_state;
+    rp_spectr_worker_state_t state;
+    int params_dirty;
+} rp_spectr_wait_t;
+
+static int rp_spectr_wait_abort(void *arg)
+{
+    rp_spectr_wait_t *wait = (rp_spectr_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_spectr_ctrl_mutex);
+    wait->state = rp_spectr_ctrl;
+    wait->params_dirty = rp_spectr_params_dirty;
+    pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (wait->state != wait->old_state) || wait->params_dirty;
+}
+
+static int rp_spectr_wait_trigger(void *arg)
+{
+    return spectr_fpga_triggered();
+}
+
 int rp_spectr_worker_init(void)
 {
     int ret_val;
 
+    if(rp_acq_event_init(&rp_spectr_event, "freqanalyzer", 1000) < 0)
+        return -1;
+
     rp_spectr_ctrl               = rp_spectr_idle_state;
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = 1;
@@ -152,6 +184,7 @@ int rp_spectr_worker_init(void)
                        rp_spectr_worker_thread, NULL);
     if(ret_val != 0) {
         spectr_fpga_exit();
+        rp_acq_event_close(&rp_spectr_event);
 
         rp_cleanup_signals(&rp_spectr_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -215,6 +248,7 @@ int rp_spectr_worker_exit(void)
         fprintf(stderr, "pthread_join() failed: %s\n", 
                 strerror(errno));
     }
+    rp_acq_event_close(&rp_spectr_event);
     rp_spectr_worker_clean();
     return 0;
 }
@@ -226,6 +260,7 @@ int rp_spectr_worker_change_state(rp_spectr_worker_state_t new_state)
     pthread_mutex_lock(&rp_spectr_ctrl_mutex);
     rp_spectr_ctrl = new_state;
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+    rp_acq_event_wake(&rp_spectr_event);
     return 0;
 }
 
@@ -236,6 +271,7 @@ int rp_spectr_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = fpga_update;
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+    rp_acq_event_wake(&rp_spectr_event);
     return 0;
 }
 
@@ -289,6 +325,7 @@ void *rp_spectr_worker_thread(void *args)
     rp_app_params_t          curr_params[PARAMS_NUM];
     int                      fpga_update = 1;
     int                      params_dirty = 1;
+    rp_spectr_wait_t         wait = { 0, 0, 0 };
 
     // TODO: Name these
     int jj_state = 0;
@@ -336,7 +373,9 @@ void *rp_spectr_worker_thread(void *args)
         }
 
         if(state == rp_spectr_idle_state) {
-            usleep(10000);
+            wait.old_state = state;
+            rp_acq_event_wait(&rp_spectr_event, NULL, rp_spectr_wait_abort,
+                              &wait, -1);
             continue;
         }
 
@@ -403,21 +442,12 @@ void *rp_spectr_worker_thread(void *args)
             break;
         }
 
-        /* polling until data is ready */
-        while(1) {
-            pthread_mutex_lock(&rp_spectr_ctrl_mutex);
-            state = rp_spectr_ctrl;
-            params_dirty = rp_spectr_params_dirty;
-            pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                break;
-            }
-                
-            if(spectr_fpga_triggered()) {
-                break;
-            }
-        }
+        /* waiting until data is ready */
+        wait.old_state = old_state;
+        rp_acq_event_wait(&rp_spectr_event, rp_spectr_wait_trigger,
+                          rp_spectr_wait_abort, &wait, -1);
+        state        = wait.state;
+        params_dirty = wait.params_dirty;
 
         if((state != old_state) || params_dirty) {
             params_dirty = 0;
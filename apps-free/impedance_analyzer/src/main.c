@@ -883,7 +883,7 @@ int rp_get_params(rp_app_params_t **p)
 
     pthread_mutex_lock(&rp_main_params_mutex);
     t_unit_factor =  
-        rp_osc_get_time_unit_factor(rp_main_params[TIME_UNIT_PARAM].value);
+        rp_acq_time_unit_factor(rp_main_params[TIME_UNIT_PARAM].value);
 
     for(i = 0; i < PARAMS_NUM; i++) {
         int p_strlen = strlen(rp_main_params[i].name);
@@ -10,6 +10,8 @@
 #ifndef __MAIN_H
 #define __MAIN_H
 
+#include "rp_acq.h"
+
 #ifdef DEBUG
 #  define TRACE(args...) fprintf(stderr, args)
 #else
@@ -31,14 +33,7 @@ typedef struct rp_app_params_s {
  */
 
  /* TODO: Delete this strcuture */
-typedef struct rp_osc_meas_res_s {
-    float min;
-    float max;
-    float amp;
-    float avg;
-    float freq;
-    float period;
-} rp_osc_meas_res_t;
+typedef rp_acq_meas_t rp_osc_meas_res_t;
 
 
 /* Parameters indexes - these defines should be in the same order as 
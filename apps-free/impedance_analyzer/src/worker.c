@@ -45,12 +45,60 @@ int measure_counter = 0;
 int steps_counter = 0;
 int measure_method = 0;
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_osc_event;
+
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_osc_wait_s {
+    rp_osc_worker_state_t old_state;
+    rp_osc_worker_state_t state;
+    int                   params_dirty;
+    int                   long_acq;
+    int                   init_trig_ptr;
+} rp_osc_wait_t;
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_osc_wait_abort(void *arg)
+{
+    rp_osc_wait_t *w = (rp_osc_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_osc_ctrl_mutex);
+    w->state = rp_osc_ctrl;
+    w->params_dirty = rp_osc_params_dirty;
+    pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (w->state != w->old_state) || w->params_dirty;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_osc_wait_trigger(void *arg)
+{
+    rp_osc_wait_t *w = (rp_osc_wait_t *)arg;
+    int trig_ptr, curr_ptr;
+
+    /* for non-long acquisition wait for trigger */
+    if(!w->long_acq)
+        return osc_fpga_triggered();
+
+    /* FPGA wrote new trigger pointer - which means new trigger happened */
+    osc_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
+    return (w->init_trig_ptr != trig_ptr) || osc_fpga_triggered();
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int rp_osc_worker_init(rp_app_params_t *params, int params_len,
                        rp_calib_params_t *calib_params)
 {
     int ret_val;
 
+    if(rp_acq_event_init(&rp_osc_event, "impedance_analyzer", 1000) < 0)
+        return -1;
+
     rp_osc_ctrl               = rp_osc_idle_state;
     rp_osc_params_dirty       = 0;
     rp_osc_params_fpga_update = 0;
@@ -87,6 +135,7 @@ int rp_osc_worker_init(rp_app_params_t *params, int params_len,
         pthread_create(rp_osc_thread_handler, NULL, rp_osc_worker_thread, NULL);
     if(ret_val != 0) {
         osc_fpga_exit();
+        rp_acq_event_close(&rp_osc_event);
 
         rp_cleanup_signals(&rp_osc_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -115,6 +164,7 @@ int rp_osc_worker_exit(void)
                 strerror(errno));
     }
     osc_fpga_exit();
+    rp_acq_event_close(&rp_osc_event);
 
     rp_cleanup_signals(&rp_osc_signals);
     rp_cleanup_signals(&rp_tmp_signals);
@@ -133,6 +183,7 @@ int rp_osc_worker_change_state(rp_osc_worker_state_t new_state)
     pthread_mutex_lock(&rp_osc_ctrl_mutex);
     rp_osc_ctrl = new_state;
     pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+    rp_acq_event_wake(&rp_osc_event);
     return 0;
 }
 
@@ -158,6 +209,7 @@ int rp_osc_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_osc_params[PARAMS_NUM].value = -1;
 
     pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+    rp_acq_event_wake(&rp_osc_event);
     return 0;
 }
 
@@ -532,13 +584,15 @@ void *rp_osc_worker_thread(void *args)
         }
 
         if(state == rp_osc_idle_state) {
-            usleep(10000);
+            /* sleep until the state or the parameters change */
+            rp_osc_wait_t idle = { state, state, 0, 0, 0 };
+            rp_acq_event_wait(&rp_osc_event, NULL, rp_osc_wait_abort, &idle, -1);
             continue;
         }
 
         if(time_vect_update) {
             float unit_factor = 
-                rp_osc_get_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
+                rp_acq_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
             float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                            curr_params[MIN_GUI_PARAM].value) / unit_factor;
 
@@ -600,31 +654,13 @@ void *rp_osc_worker_thread(void *args)
 
         if(long_acq_idx == 0) {
             /* polling until data is ready */
-            while(1) {
-                pthread_mutex_lock(&rp_osc_ctrl_mutex);
-                state = rp_osc_ctrl;
-                params_dirty = rp_osc_params_dirty;
-                pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    break;
-                }
-                
-                if(!long_acq && osc_fpga_triggered()) {
-                    /* for non-long acquisition wait for trigger */
-                    break;
-                } else if(long_acq) {
-                    int trig_ptr, curr_ptr;
-                    osc_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
-                    if((long_acq_init_trig_ptr != trig_ptr) || osc_fpga_triggered()) {
-                        /* FPGA wrote new trigger pointer - which means
-                         * new trigger happened 
-                         */
-                        break;
-                    }
-                }
-                usleep(1000);
-            }
+            rp_osc_wait_t wait = { old_state, state, 0, long_acq,
+                                   long_acq_init_trig_ptr };
+
+            rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                              rp_osc_wait_abort, &wait, -1);
+            state = wait.state;
+            params_dirty = wait.params_dirty;
         }
 
         if((state != old_state) || params_dirty) {
@@ -645,7 +681,7 @@ void *rp_osc_worker_thread(void *args)
                 int t_start_idx = 
                     round(curr_params[MIN_GUI_PARAM].value / smpl_period);
                 float unit_factor = 
-                    rp_osc_get_time_unit_factor(
+                    rp_acq_time_unit_factor(
                                          curr_params[TIME_UNIT_PARAM].value);
                 float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                                curr_params[MIN_GUI_PARAM].value) / 
@@ -758,7 +794,7 @@ int rp_osc_prepare_time_vector(float **out_signal, int dec_factor,
     float t_step, t_curr;
     int   out_idx, in_idx;
     int   idx_step;
-    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);;
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);;
 
     float *s = *out_signal;
 
@@ -1027,7 +1063,7 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
     int    in_idx = *next_wr_ptr;
 
     float smpl_period = c_osc_fpga_smpl_period * dec_factor;
-    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);
 
     int curr_ptr;
     /* check if we have reached currently acquired signals in FPGA */
@@ -1056,14 +1092,14 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
             break;
 
         cha_out[next_out_idx] = 
-            osc_fpga_cnv_cnt_to_v(cha_in_signal[in_idx], ch1_max_adc_v,
-                                  rp_calib_params->fe_ch1_dc_offs,
-                                  ch1_user_dc_off);
+            rp_acq_cnv_cnt_to_v(cha_in_signal[in_idx], ch1_max_adc_v,
+                                rp_calib_params->fe_ch1_dc_offs,
+                                ch1_user_dc_off);
 
         chb_out[next_out_idx] = 
-            osc_fpga_cnv_cnt_to_v(chb_in_signal[in_idx], ch2_max_adc_v,
-                                  rp_calib_params->fe_ch1_dc_offs,
-                                  ch2_user_dc_off);
+            rp_acq_cnv_cnt_to_v(chb_in_signal[in_idx], ch2_max_adc_v,
+                                rp_calib_params->fe_ch1_dc_offs,
+                                ch2_user_dc_off);
 
         t_out[next_out_idx]   = 
             (t_start + ((next_out_idx*step_wr_ptr)*smpl_period))*t_unit_factor;
@@ -1076,31 +1112,6 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
 }
 
 
-/*----------------------------------------------------------------------------------*/
-int rp_osc_get_time_unit_factor(int time_unit)
-{
-    int t_unit_factor;
-
-    switch(time_unit) {
-    case 0:
-        /* [us] */
-        t_unit_factor = 1e6;
-        break;
-    case 1:
-        /* [ms] */
-        t_unit_factor = 1e3;
-        break;
-    case 2:
-    default:
-        /* [s] */
-        t_unit_factor = 1;
-        break;
-    }
-
-    return t_unit_factor;
-}
-
-
 /*----------------------------------------------------------------------------------*/
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
                     float ch1_max_adc_v, float ch2_max_adc_v,
@@ -1108,8 +1119,7 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
                     int ch1_probe_att, int ch2_probe_att, int ch1_gain, int ch2_gain, int en_avg_at_dec)
 {
     const int c_noise_thr = 500; /* noise threshold */
-    rp_osc_worker_state_t old_state, state;
-    int params_dirty;
+    rp_osc_wait_t wait = { 0 };
     /* Min/maxes from both channel */
     int max_cha = INT_MIN;
     int max_chb = INT_MIN;
@@ -1128,7 +1138,7 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
     for (iter=0; iter < 10; iter++) {
         /* 10 auto-trigger acquisitions */
         pthread_mutex_lock(&rp_osc_ctrl_mutex);
-        old_state = state = rp_osc_ctrl;
+        wait.old_state = rp_osc_ctrl;
         pthread_mutex_unlock(&rp_osc_ctrl_mutex);
 
         osc_fpga_reset();
@@ -1144,20 +1154,9 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
         osc_fpga_set_trigger(1);
 
         /* Wait for trigger to finish */
-        while(1) {
-            pthread_mutex_lock(&rp_osc_ctrl_mutex);
-            state = rp_osc_ctrl;
-            params_dirty = rp_osc_params_dirty;
-            pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                return -1;
-            }
-            if(osc_fpga_triggered()) {
-                break;
-            }
-            usleep(500);
-        }
+        if(rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                             rp_osc_wait_abort, &wait, -1))
+            return -1;
 
         /* Get the signals - available at rp_fpga_chX_signal vectors */
         for(smpl_cnt = 0; smpl_cnt < OSC_FPGA_SIG_LEN; smpl_cnt++) {
@@ -1282,21 +1281,9 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
 
             /* Wait for trigger */
             /* Wait for trigger to finish */
-            while(1) {
-                pthread_mutex_lock(&rp_osc_ctrl_mutex);
-                state = rp_osc_ctrl;
-                params_dirty = rp_osc_params_dirty;
-                pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    return -1;
-                }
-                if(osc_fpga_triggered()) {
-                    break;
-                }    
-                usleep(500);
-            }
+            if(rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                                 rp_osc_wait_abort, &wait, -1))
+                return -1;
 
             // Checking where acquisition starts
             osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig); 
@@ -1425,16 +1412,6 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
 }
 
 
-
-/*----------------------------------------------------------------------------------*/
-int rp_osc_adc_sign(int in_data)
-{
-    int s_data = in_data;
-    if(s_data & (1<<(c_osc_fpga_adc_bits-1)))
-        s_data = -1 * ((s_data ^ ((1<<c_osc_fpga_adc_bits)-1)) + 1);
-    return s_data;
-}
-
 int rp_load_data(float save_data){
     /* If the user wants to load all the data */
     if(save_data == 2){
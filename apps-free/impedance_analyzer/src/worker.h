@@ -76,9 +76,6 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
                     float ch1_user_dc_off, float ch2_user_dc_off,
                     int ch1_probe_att, int ch2_probe_att, int ch1_gain, int ch2_gain, int en_avg_at_dec);
 
-/* helper function - returns the factor for time unit conversion */
-int rp_osc_get_time_unit_factor(int time_unit);
-
 /* Thread functions declared here */
 
 void* lcr_thread(void *conversation_pipes);
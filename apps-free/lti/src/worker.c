@@ -25,6 +25,7 @@
 #include <dirent.h>
 
 #include "worker.h"
+#include "rp_acq.h"
 #include "fpga_lti.h"
 #include "generate_basic.h"
 #include "dsp.h"
@@ -70,10 +71,52 @@ float                **rp_lti_signals = NULL;
 
 int                    rp_lti_signals_dirty = 0;
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_lti_event;
+
+/* Largest DSP block the running loop waits for, in samples */
+#define LTI_DSP_BLOCK 64
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_lti_wait_s {
+    rp_lti_worker_state_t old_state;
+    rp_lti_worker_state_t state;
+    int params_dirty;
+    int dsp_ptr;                 /* next sample of the DSP algorithm */
+    int dsp_block;               /* samples to wait for past dsp_ptr */
+} rp_lti_wait_t;
+
+static int rp_lti_wait_abort(void *arg)
+{
+    rp_lti_wait_t *wait = (rp_lti_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_lti_ctrl_mutex);
+    wait->state = rp_lti_ctrl;
+    wait->params_dirty = rp_lti_params_dirty;
+    pthread_mutex_unlock(&rp_lti_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (wait->state != wait->old_state) || wait->params_dirty;
+}
+
+static int rp_lti_wait_block(void *arg)
+{
+    rp_lti_wait_t *wait = (rp_lti_wait_t *)arg;
+    int wr_ptr;
+
+    /* lti_fpga_online_dsp() processes up to the sample before wr_ptr */
+    lti_fpga_get_wr_ptr(&wr_ptr, NULL);
+    return ((wr_ptr - wait->dsp_ptr + LTI_FPGA_SIG_LEN) % LTI_FPGA_SIG_LEN)
+        > wait->dsp_block;
+}
+
 int rp_lti_worker_init(void)
 {
     int ret_val;
 
+    if(rp_acq_event_init(&rp_lti_event, "lti", 1000) < 0)
+        return -1;
+
     rp_lti_ctrl               = rp_lti_idle_state;
     rp_lti_params_dirty       = 1;
     rp_lti_params_fpga_update = 1;
@@ -145,6 +188,7 @@ int rp_lti_worker_init(void)
                        rp_lti_worker_thread, NULL);
     if(ret_val != 0) {
         lti_fpga_exit();
+        rp_acq_event_close(&rp_lti_event);
 
         rp_cleanup_signals(&rp_lti_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -215,6 +259,7 @@ int rp_lti_worker_exit(void)
         fprintf(stderr, "pthread_join() failed: %s\n", 
                 strerror(errno));
     }
+    rp_acq_event_close(&rp_lti_event);
     rp_lti_worker_clean();
     
     return 0;
@@ -227,6 +272,7 @@ int rp_lti_worker_change_state(rp_lti_worker_state_t new_state)
     pthread_mutex_lock(&rp_lti_ctrl_mutex);
     rp_lti_ctrl = new_state;
     pthread_mutex_unlock(&rp_lti_ctrl_mutex);
+    rp_acq_event_wake(&rp_lti_event);
     return 0;
 }
 
@@ -237,6 +283,7 @@ int rp_lti_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_lti_params_dirty       = 1;    
     rp_lti_params_fpga_update = fpga_update;
     pthread_mutex_unlock(&rp_lti_ctrl_mutex);
+    rp_acq_event_wake(&rp_lti_event);
     return 0;
 }
 
@@ -298,7 +345,9 @@ void *rp_lti_worker_thread(void *args)
     
     int                      armed=0;
     int                      gen_start_ptr,rp_dsp_loc_ptr;
+    int                      gen_delay = 0;
     int                      indx;
+    rp_lti_wait_t            wait = { 0, 0, 0, 0, 0 };
     
     float                    curr_dec;
     
@@ -349,8 +398,9 @@ void *rp_lti_worker_thread(void *args)
         }
 
         if(state == rp_lti_idle_state) {
-	  
-            usleep(100);
+            rp_lti_wait_t idle = { state, state, 0 };
+
+            rp_acq_event_wait(&rp_lti_event, NULL, rp_lti_wait_abort, &idle, -1);
             continue;
         }
 
@@ -369,6 +419,11 @@ void *rp_lti_worker_thread(void *args)
         // Check input buffer sampling rate
         curr_dec=lti_fpga_cnv_freq_range_to_dec(curr_params[FREQ_RANGE_PARAM].value);
         
+        // Experimentally a safe generator delay is 3000 locs at 122 kHz
+        gen_delay=round(3000.0*1024.0/curr_dec);
+        // Wait for blocks well below the generator delay (64 locs: 0.5 ms at 122 kHz)
+        wait.dsp_block=gen_delay/4 < LTI_DSP_BLOCK ? gen_delay/4 : LTI_DSP_BLOCK;
+        
         
         // Start signal generator: the output samples will be continuosly updated by the DSP algorithm
 	
@@ -441,16 +496,14 @@ void *rp_lti_worker_thread(void *args)
 	// returns ADC input samples (rp_cha_in) 
 	     
 	   
-	rp_dsp_loc_ptr=lti_fpga_online_dsp(&rp_cha_in, &rp_chb_in, round(3000.0*1024.0/curr_dec), 
+	rp_dsp_loc_ptr=lti_fpga_online_dsp(&rp_cha_in, &rp_chb_in, gen_delay, 
 					    &rp_dsp_state_a, &rp_dsp_state_b, 
 				            &rp_dsp_par_a, &rp_dsp_par_b, 
 				           rp_dsp_loc_ptr, 
 				           &rp_fpga_cha_gen, &rp_fpga_chb_gen);
+	wait.dsp_ptr=rp_dsp_loc_ptr;
 		
 	
-	// Experimentally a safe generator delay is 3000 locs at 122 kHz
-	
-	
 	
 	} 
 	
@@ -466,7 +519,12 @@ void *rp_lti_worker_thread(void *args)
 	
 	
          rp_lti_set_signals(rp_tmp_signals);
-	 usleep(100);
+
+        /* Wait until the next DSP block is acquired, without the DSP
+         * running (unsupported range) until the parameters change */
+        wait.old_state = state;
+        rp_acq_event_wait(&rp_lti_event, armed ? rp_lti_wait_block : NULL,
+                          rp_lti_wait_abort, &wait, -1);
 	
 	
 
@@ -15,6 +15,8 @@
 #ifndef __MAIN_H
 #define __MAIN_H
 
+#include "rp_acq.h"
+
 #ifdef DEBUG
 #  define TRACE(args...) fprintf(stderr, args)
 #else
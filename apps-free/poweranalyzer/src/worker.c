@@ -80,6 +80,82 @@ rp_pwr_harm_t *harmonics = NULL;
 rp_calib_params_t *rp_calib_params = NULL;
 
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_pwr_event;
+/* Signal event of the DSP thread, woken also when the signal is ready */
+static rp_acq_event_t rp_pwr_dsp_event;
+
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_pwr_wait_s {
+    rp_pwr_worker_state_t old_state;
+    rp_pwr_worker_state_t state;
+    int                   params_dirty;
+    int                   long_acq;
+    int                   init_trig_ptr;
+} rp_pwr_wait_t;
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_pwr_wait_abort(void *arg)
+{
+    rp_pwr_wait_t *w = (rp_pwr_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_pwr_ctrl_mutex);
+    w->state = rp_pwr_ctrl;
+    w->params_dirty = rp_pwr_params_dirty;
+    pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (w->state != w->old_state) || w->params_dirty;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_pwr_wait_trigger(void *arg)
+{
+    rp_pwr_wait_t *w = (rp_pwr_wait_t *)arg;
+    int trig_ptr, curr_ptr;
+
+    /* for non-long acquisition wait for trigger */
+    if(!w->long_acq)
+        return pwr_fpga_triggered();
+
+    /* FPGA wrote new trigger pointer - which means new trigger happened */
+    pwr_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
+    return (w->init_trig_ptr != trig_ptr) || pwr_fpga_triggered();
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_pwr_dsp_wait_ready(void *arg)
+{
+    int sig_ready;
+
+    pthread_mutex_lock(&rp_pwr_dsp_sig_mutex);
+    sig_ready = rp_pwr_dsp_sig_ready;
+    pthread_mutex_unlock(&rp_pwr_dsp_sig_mutex);
+
+    return sig_ready == 1;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_pwr_dsp_wait_abort(void *arg)
+{
+    rp_pwr_worker_state_t *state = (rp_pwr_worker_state_t *)arg;
+    int params_dirty;
+
+    pthread_mutex_lock(&rp_pwr_ctrl_mutex);
+    *state = rp_pwr_ctrl;
+    params_dirty = rp_pwr_dsp_params_dirty;
+    pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
+
+    return (*state == rp_pwr_quit_state) || (*state == rp_pwr_abort_state) ||
+           (*state == rp_pwr_auto_set_state) || params_dirty;
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int rp_pwr_worker_init(rp_app_params_t *params, int params_len,
                        rp_calib_params_t *calib_params)
@@ -87,6 +163,13 @@ int rp_pwr_worker_init(rp_app_params_t *params, int params_len,
     int ret_val_1;
     int ret_val_2;
 
+    if(rp_acq_event_init(&rp_pwr_event, "poweranalyzer", 1000) < 0)
+        return -1;
+    if(rp_acq_event_init(&rp_pwr_dsp_event, "poweranalyzer dsp", 1000) < 0) {
+        rp_acq_event_close(&rp_pwr_event);
+        return -1;
+    }
+
     rp_pwr_ctrl               = rp_pwr_idle_state;
     rp_pwr_params_dirty       = 0;
     rp_pwr_dsp_params_dirty   = 0;
@@ -171,6 +254,8 @@ int rp_pwr_worker_init(rp_app_params_t *params, int params_len,
         pthread_create(rp_pwr_thread_handler_2, NULL, rp_pwr_dsp_thread, NULL);
     if(ret_val_1 != 0 || ret_val_2 !=0) {
         pwr_fpga_exit();
+        rp_acq_event_close(&rp_pwr_event);
+        rp_acq_event_close(&rp_pwr_dsp_event);
 
         rp_cleanup_signals(&rp_pwr_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -275,6 +360,8 @@ int rp_pwr_worker_exit(void)
     unset_transducer_and_led();
     house_release();
     pwr_fpga_exit();
+    rp_acq_event_close(&rp_pwr_event);
+    rp_acq_event_close(&rp_pwr_dsp_event);
     rp_pwr_worker_clean();
 
     rp_clean_params(rp_pwr_params);
@@ -291,6 +378,8 @@ int rp_pwr_worker_change_state(rp_pwr_worker_state_t new_state)
     pthread_mutex_lock(&rp_pwr_ctrl_mutex);
     rp_pwr_ctrl = new_state;
     pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
+    rp_acq_event_wake(&rp_pwr_event);
+    rp_acq_event_wake(&rp_pwr_dsp_event);
     return 0;
 }
 
@@ -317,6 +406,8 @@ int rp_pwr_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_pwr_params[PARAMS_NUM].value = -1;
 
     pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
+    rp_acq_event_wake(&rp_pwr_event);
+    rp_acq_event_wake(&rp_pwr_dsp_event);
     return 0;
 }
 
@@ -576,7 +667,9 @@ void *rp_pwr_worker_thread(void *args)
         }
 
         if(state == rp_pwr_idle_state) {
-            usleep(10000);
+            /* sleep until the state or the parameters change */
+            rp_pwr_wait_t idle = { state, state, 0, 0, 0 };
+            rp_acq_event_wait(&rp_pwr_event, NULL, rp_pwr_wait_abort, &idle, -1);
             continue;
         }
 
@@ -586,7 +679,7 @@ void *rp_pwr_worker_thread(void *args)
             pthread_mutex_unlock(&rp_pwr_dsp_sig_mutex);
 			
             float unit_factor = 
-                rp_pwr_get_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
+                rp_acq_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
             float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                            curr_params[MIN_GUI_PARAM].value) / unit_factor;
 
@@ -655,31 +748,13 @@ void *rp_pwr_worker_thread(void *args)
 
         if(long_acq_idx == 0) {
             /* polling until data is ready */
-            while(1) {
-                pthread_mutex_lock(&rp_pwr_ctrl_mutex);
-                state = rp_pwr_ctrl;
-                params_dirty = rp_pwr_params_dirty;
-                pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    break;
-                }
-                
-                if(!long_acq && pwr_fpga_triggered()) {
-                    /* for non-long acquisition wait for trigger */
-                    break;
-                } else if(long_acq) {
-                    int trig_ptr, curr_ptr;
-                    pwr_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
-                    if((long_acq_init_trig_ptr != trig_ptr) || pwr_fpga_triggered()) {
-                        /* FPGA wrote new trigger pointer - which means
-                         * new trigger happened 
-                         */
-                        break;
-                    }
-                }
-                usleep(1000);
-            }
+            rp_pwr_wait_t wait = { old_state, state, 0, long_acq,
+                                   long_acq_init_trig_ptr };
+
+            rp_acq_event_wait(&rp_pwr_event, rp_pwr_wait_trigger,
+                              rp_pwr_wait_abort, &wait, -1);
+            state = wait.state;
+            params_dirty = wait.params_dirty;
         }
 
         if((state != old_state) || params_dirty) {
@@ -700,7 +775,7 @@ void *rp_pwr_worker_thread(void *args)
                 int t_start_idx = 
                     round(curr_params[MIN_GUI_PARAM].value / smpl_period);
                 float unit_factor = 
-                    rp_pwr_get_time_unit_factor(
+                    rp_acq_time_unit_factor(
                                          curr_params[TIME_UNIT_PARAM].value);
                 float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                                curr_params[MIN_GUI_PARAM].value) / 
@@ -779,6 +854,7 @@ void *rp_pwr_worker_thread(void *args)
                 pthread_mutex_lock(&rp_pwr_dsp_sig_mutex);
 	            rp_pwr_dsp_sig_ready = 1;
                 pthread_mutex_unlock(&rp_pwr_dsp_sig_mutex);
+                rp_acq_event_wake(&rp_pwr_dsp_event);
 
                 pwr_fpga_get_wr_ptr(NULL, &long_acq_init_trig_ptr);
 
@@ -839,7 +915,7 @@ int rp_pwr_prepare_time_vector(float **out_signal, int dec_factor,
     float t_step, t_curr;
     int   out_idx, in_idx;
     int   idx_step;
-    int   t_unit_factor = rp_pwr_get_time_unit_factor(time_unit);;
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);;
 
     float *s = *out_signal;
 
@@ -874,7 +950,7 @@ int rp_pwr_decimate(float **cha_signal, int *in_cha_signal,
 {
     int t_start_idx, t_stop_idx;
     float smpl_period = c_pwr_fpga_smpl_period * dec_factor;
-    int   t_unit_factor = rp_pwr_get_time_unit_factor(time_unit);
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);
     int t_step;
     int in_idx, out_idx, t_idx;
     int wr_ptr_curr, wr_ptr_trig;
@@ -927,6 +1003,7 @@ int rp_pwr_decimate(float **cha_signal, int *in_cha_signal,
     pthread_mutex_lock(&rp_pwr_dsp_sig_mutex);
 	rp_pwr_dsp_sig_ready = 1;
     pthread_mutex_unlock(&rp_pwr_dsp_sig_mutex);
+    rp_acq_event_wake(&rp_pwr_dsp_event);
 
     
 
@@ -978,7 +1055,7 @@ int rp_pwr_decimate_partial(float **cha_out_signal, int *cha_in_signal,
     int    in_idx = *next_wr_ptr;
 
     float smpl_period = c_pwr_fpga_smpl_period * dec_factor;
-    int   t_unit_factor = rp_pwr_get_time_unit_factor(time_unit);
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);
 
     int curr_ptr;
     /* check if we have reached currently acquired signals in FPGA */
@@ -1042,31 +1119,6 @@ int rp_pwr_decimate_partial(float **cha_out_signal, int *cha_in_signal,
 }
 
 
-/*----------------------------------------------------------------------------------*/
-int rp_pwr_get_time_unit_factor(int time_unit)
-{
-    int t_unit_factor;
-
-    switch(time_unit) {
-    case 0:
-        /* [us] */
-        t_unit_factor = 1e6;
-        break;
-    case 1:
-        /* [ms] */
-        t_unit_factor = 1e3;
-        break;
-    case 2:
-    default:
-        /* [s] */
-        t_unit_factor = 1;
-        break;
-    }
-
-    return t_unit_factor;
-}
-
-
 /*----------------------------------------------------------------------------------*/
 int rp_pwr_auto_set(rp_app_params_t *orig_params, 
                     float ch1_max_adc_v, float ch2_max_adc_v,
@@ -1075,8 +1127,7 @@ int rp_pwr_auto_set(rp_app_params_t *orig_params,
                     int ch2_gain, int en_avg_at_dec)
 {
     const int c_noise_thr = 10; /* noise threshold */
-    rp_pwr_worker_state_t old_state, state;
-    int params_dirty;
+    rp_pwr_wait_t wait = { 0 };
     /* Min/maxes from both channel */
     int max_cha = INT_MIN;
     int max_chb = INT_MIN;
@@ -1098,7 +1149,7 @@ int rp_pwr_auto_set(rp_app_params_t *orig_params,
     for (iter=0; iter < 10; iter++) {
         /* 10 auto-trigger acquisitions */
         pthread_mutex_lock(&rp_pwr_ctrl_mutex);
-        old_state = state = rp_pwr_ctrl;
+        wait.old_state = rp_pwr_ctrl;
         pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
 
         pwr_fpga_reset();
@@ -1114,20 +1165,9 @@ int rp_pwr_auto_set(rp_app_params_t *orig_params,
         pwr_fpga_set_trigger(1);
 
         /* Wait for trigger to finish */
-        while(1) {
-            pthread_mutex_lock(&rp_pwr_ctrl_mutex);
-            state = rp_pwr_ctrl;
-            params_dirty = rp_pwr_params_dirty;
-            pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                return -1;
-            }
-            if(pwr_fpga_triggered()) {
-                break;
-            }
-            usleep(500);
-        }
+        if(rp_acq_event_wait(&rp_pwr_event, rp_pwr_wait_trigger,
+                             rp_pwr_wait_abort, &wait, -1))
+            return -1;
 
         /* Get the signals - available at rp_fpga_chX_signal vectors */
         for(smpl_cnt = 0; smpl_cnt < PWR_FPGA_SIG_LEN; smpl_cnt++) {
@@ -1286,21 +1326,9 @@ int rp_pwr_auto_set(rp_app_params_t *orig_params,
 
             /* Wait for trigger */
             /* Wait for trigger to finish */
-            while(1) {
-                pthread_mutex_lock(&rp_pwr_ctrl_mutex);
-                state = rp_pwr_ctrl;
-                params_dirty = rp_pwr_params_dirty;
-                pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
-
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    return -1;
-                }
-                if(pwr_fpga_triggered()) {
-                    break;
-                }    
-                usleep(500);
-            }
+            if(rp_acq_event_wait(&rp_pwr_event, rp_pwr_wait_trigger,
+                                 rp_pwr_wait_abort, &wait, -1))
+                return -1;
 
             // Checking where acquisition starts
             pwr_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
@@ -1406,7 +1434,6 @@ void *rp_pwr_dsp_thread(void *args)
 	rp_pwr_meas_res_t     meas;
 	float ch1_max_adc_v = 1, ch2_max_adc_v = 1;
 	float ch1_user_dc_off = 0, ch2_user_dc_off = 0;
-	int   sig_ready = 0;
 		
 	double bin_max_amp1;
 	double bin_max_amp2;
@@ -1507,29 +1534,14 @@ void *rp_pwr_dsp_thread(void *args)
             continue;
 		}
 		
-        while(1) {
-			
-			pthread_mutex_lock(&rp_pwr_dsp_sig_mutex);
-			sig_ready = rp_pwr_dsp_sig_ready;
-			pthread_mutex_unlock(&rp_pwr_dsp_sig_mutex);
-			
-			if(sig_ready == 1) {
-			    rp_pwr_copy_buffer(&rp_cha_in[0], &rp_chb_in[0],
-                                   rp_calib_params->fe_ch1_dc_offs,
-                                   rp_calib_params->fe_ch2_dc_offs);
-                break;
-		    }
-		    
-		    pthread_mutex_lock(&rp_pwr_ctrl_mutex);
-            state = rp_pwr_ctrl;
-            pthread_mutex_unlock(&rp_pwr_ctrl_mutex);
-            if((state == rp_pwr_quit_state) || (state == rp_pwr_abort_state) ||
-               (state == rp_pwr_auto_set_state) || rp_pwr_dsp_params_dirty) {
-                break;
-            }
-		    usleep(70);
-		    
-	    }
+        /* wait for the signal of the worker thread */
+        if(rp_acq_event_wait(&rp_pwr_dsp_event, rp_pwr_dsp_wait_ready,
+                             rp_pwr_dsp_wait_abort, &state, -1) ==
+           RP_ACQ_WAIT_READY) {
+            rp_pwr_copy_buffer(&rp_cha_in[0], &rp_chb_in[0],
+                               rp_calib_params->fe_ch1_dc_offs,
+                               rp_calib_params->fe_ch2_dc_offs);
+        }
 	    
 	    pthread_mutex_lock(&rp_pwr_ctrl_mutex);
         state = rp_pwr_ctrl;
@@ -1896,20 +1908,10 @@ int rp_pwr_harmonics_clear(rp_pwr_harm_t *harm_meas)
     return 0;
 }
 
-/*----------------------------------------------------------------------------------*/
-inline int rp_pwr_adc_sign(int in_data)
-{
-    int s_data = in_data;
-    if(s_data & (1<<(c_pwr_fpga_adc_bits-1)))
-        s_data = -1 * ((s_data ^ ((1<<c_pwr_fpga_adc_bits)-1)) + 1);
-    return s_data;
-}
-
-
 /*----------------------------------------------------------------------------------*/
 int rp_pwr_meas_min_max(rp_pwr_ch_meas_res_t *ch_meas, int sig_data)
 {
-    int s_data = rp_pwr_adc_sign(sig_data);
+    int s_data = rp_acq_adc_sign(sig_data);
 
     if(ch_meas->min > s_data)
         ch_meas->min = s_data;
@@ -1951,77 +1953,9 @@ int rp_pwr_meas_period(rp_pwr_ch_meas_res_t *ch1_meas, rp_pwr_ch_meas_res_t *ch2
 int meas_period(rp_pwr_ch_meas_res_t *meas, int *in_signal, int wr_ptr_trig, int dec_factor,
                 int *min, int *max)
 {
-	float period = 0;
-	
-    const float c_meas_freq_thr = 100;
-    const int c_meas_time_thr = PWR_FPGA_SIG_LEN / 8;
-    const float c_min_period = 19.6e-9; // 51 MHz
-
-    float thr1, thr2, cen;
-    int state = 0;
-    int trig_t[2] = { 0, 0 };
-    int trig_cnt = 0;
-    int ix, ix_corr;
-
-    float acq_dur=(float)(PWR_FPGA_SIG_LEN)/((float) c_pwr_fpga_smpl_freq) * (float) dec_factor;
-
-    cen = (meas->max + meas->min) / 2;
-
-    thr1 = cen + 0.2 * (meas->min - cen);
-    thr2 = cen + 0.2 * (meas->max - cen);
-
-    *max = INT_MIN;
-    *min = INT_MAX;
-
-    for(ix = 0; ix < (PWR_FPGA_SIG_LEN); ix++) {
-        ix_corr = ix + wr_ptr_trig;
-
-        if (ix_corr >= PWR_FPGA_SIG_LEN) {
-            ix_corr %= PWR_FPGA_SIG_LEN;
-        }
-
-        int sa = rp_pwr_adc_sign(in_signal[ix_corr]);
-
-        /* Another max, min calculation at lower rate to avoid evaluation errors on slower signals */
-        if (sa > *max)
-            *max = sa;
-        if (sa < *min)
-            *min = sa;
-
-        /* Lower transitions */
-        if((state == 0) && (ix_corr > 0) && (sa < thr1)) {
-            state = 1;
-        }
-
-        /* Upper transitions - count them & store edge times. */
-        if((state == 1) && (sa >= thr2) ) {
-            state = 0;
-            if (trig_cnt++ == 0) {
-                trig_t[0] = ix;
-            } else {
-                trig_t[1] = ix;
-            }
-        }
-
-        if ((trig_t[1] - trig_t[0]) > c_meas_time_thr) {
-            break;
-        }
-    }
-
-    /* Period calculation - taking into account at least meas_time_thr samples */
-    if(trig_cnt >= 2) {
-        period = (trig_t[1] - trig_t[0]) /
-            ((float)c_pwr_fpga_smpl_freq * (trig_cnt - 1)) * dec_factor;
-    }
-
-    if( ((thr2 - thr1) < c_meas_freq_thr) ||
-         (period * 3 >= acq_dur)    ||
-         (period < c_min_period) )
-    {
-        period = 0;
-    }
-
-    return period;
+    return rp_acq_period(in_signal, PWR_FPGA_SIG_LEN, wr_ptr_trig,
+                         meas->min, meas->max, c_pwr_fpga_smpl_freq,
+                         dec_factor, min, max);
 }
 
 
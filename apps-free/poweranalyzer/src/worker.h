@@ -100,9 +100,6 @@ int rp_pwr_auto_set(rp_app_params_t *orig_params,
                     float ch1_probe_att, float ch2_probe_att, int ch1_gain, 
                     int ch2_gain, int en_avg_at_dec);
 
-/* helper function - returns the factor for time unit conversion */
-int rp_pwr_get_time_unit_factor(int time_unit);
-
 float pwr_cnv_cnt_to_v(double cnts, float adc_max_v,
                        int calib_dc_off, float user_dc_off,
                        float diff_probe_att);
@@ -18,6 +18,8 @@
 #ifndef __MAIN_H
 #define __MAIN_H
 
+#include "rp_acq.h"
+
 #ifdef DEBUG
 #  define TRACE(args...) fprintf(stderr, args)
 #else
@@ -37,14 +39,7 @@ typedef struct rp_app_params_s {
 /* Signal measurement results structure - filled in worker and updated when
  * also measurement signal is stored from worker 
  */
-typedef struct rp_osc_meas_res_s {
-    float min;
-    float max;
-    float amp;
-    float avg;
-    float freq;
-    float period;
-} rp_osc_meas_res_t;
+typedef rp_acq_meas_t rp_osc_meas_res_t;
 
 /* Parameters indexes - these defines should be in the same order as 
  * rp_app_params_t structure defined in main.c */
@@ -75,7 +75,8 @@ int rp_osc_decimate(float **cha_signal, int *in_cha_signal,
                     float t_start, float t_stop, int time_unit,
                     rp_osc_meas_res_t *ch1_meas, rp_osc_meas_res_t *ch2_meas,
                     float ch1_max_adc_v, float ch2_max_adc_v,
-                    float ch1_user_dc_off, float ch2_user_dc_off);
+                    float ch1_user_dc_off, float ch2_user_dc_off,
+                    int dec_mode);
 
 int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal, 
                             float **chb_out_signal, int *chb_in_signal,
@@ -85,7 +86,8 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
                             rp_osc_meas_res_t *ch1_meas,
                             rp_osc_meas_res_t *ch2_meas,
                             float ch1_max_adc_v, float ch2_max_adc_v,
-                            float ch1_user_dc_off, float ch2_user_dc_off);
+                            float ch1_user_dc_off, float ch2_user_dc_off,
+                            int dec_mode);
 
 /* Auto-set algorithm */
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
@@ -93,21 +95,9 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
                     float ch1_user_dc_off, float ch2_user_dc_off,
                     int ch1_probe_att, int ch2_probe_att, int ch1_gain, int ch2_gain, int en_avg_at_dec);
 
-/* helper function - returns the factor for time unit conversion */
-int rp_osc_get_time_unit_factor(int time_unit);
-
-/* helper function - clears the measurement structure */
-int rp_osc_meas_clear(rp_osc_meas_res_t *ch_meas);
-/* helper function - calculates min, max and accumulates average value */
-int rp_osc_meas_min_max(rp_osc_meas_res_t *ch_meas, int sig_data);
-/* helper function - calculates average and amplitude */
-int rp_osc_meas_avg_amp(rp_osc_meas_res_t *ch_meas, int avg_len);
-/* helper function - calculates period and frequency */
+/* helper function - calculates period and frequency, the measurement
+ * kernels are in rp_acq.h */
 int rp_osc_meas_period(rp_osc_meas_res_t *ch1_meas, rp_osc_meas_res_t *ch2_meas, 
                        int *in_cha_signal, int *in_chb_signal, int dec_factor);
-int meas_period(rp_osc_meas_res_t *meas, int *in_signal, int wr_ptr_trig, int dec_factor,
-                int *min, int *max);
-/* helper function - convert CNT to V for meas. data (min, max, amp, avg) */
-int rp_osc_meas_convert(rp_osc_meas_res_t *ch_meas, float adc_max_v, int32_t cal_dc_offs);
 
 #endif /* __WORKER_H*/
@@ -25,6 +25,7 @@
 #include "version.h"
 #include "worker.h"
 #include "fpga.h"
+#include "waterfall.h"
 
 /* Describe app. parameters with some info/limitations */
 static rp_app_params_t rp_main_params[PARAMS_NUM+1] = {
@@ -57,8 +58,9 @@ static rp_app_params_t rp_main_params[PARAMS_NUM+1] = {
         "peak2_power", 0, 0, 1,         -1e7, 1e7 },
     { /* peak2_unit - same enumeration as freq_unit */
         "peak2_unit", 0, 0, 1,         0,         2 },
-    { /* JPG Waterfall files index */
-        "w_idx", 0, 0, 1, 0, 1000 },
+    { /* Sequence of the last waterfall row (lower 24 bits), changes when
+       * there are new rows to read from rp_get_waterfall() */
+        "w_idx", 0, 0, 1, 0, 0xffffff },
 	{ /* en_avg_at_dec:
 		   *    0 - disable
 		   *    1 - enable */
@@ -223,7 +225,7 @@ int rp_get_signals(float ***s, int *sig_num, int *sig_len)
         return -1;
     }
 
-    rp_main_params[JPG_FILE_IDX_PARAM].value     = (float)result.jpg_idx;
+    rp_main_params[WF_ROW_SEQ_PARAM].value       = (float)(result.wf_seq & 0xffffff);
     rp_main_params[PEAK_PW_CHA_PARAM].value      = (float)result.peak_pw_cha;
     rp_main_params[PEAK_PW_FREQ_CHA_PARAM].value = (float)result.peak_pw_freq_cha;
     rp_main_params[PEAK_PW_CHB_PARAM].value      = (float)result.peak_pw_chb;
@@ -233,6 +235,12 @@ int rp_get_signals(float ***s, int *sig_num, int *sig_len)
     return 0;
 }
 
+/* Waterfall rows newer than since, see rp_spectr_wf_get_rows() */
+int rp_get_waterfall(unsigned int since, void *buf, int len)
+{
+    return rp_spectr_wf_get_rows(since, (unsigned char *)buf, len);
+}
+
 int rp_create_signals(float ***a_signals)
 {
     int i;
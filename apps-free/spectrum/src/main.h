@@ -38,7 +38,7 @@ typedef struct rp_app_params_s {
 #define PEAK_PW_FREQ_CHB_PARAM 7
 #define PEAK_PW_CHB_PARAM      8
 #define PEAK_UNIT_CHB_PARAM    9
-#define JPG_FILE_IDX_PARAM     10
+#define WF_ROW_SEQ_PARAM       10
 #define EN_AVG_AT_DEC   		11
 
 /* Output signals */
@@ -50,6 +50,7 @@ int rp_app_exit(void);
 int rp_set_params(rp_app_params_t *p, int len);
 int rp_get_params(rp_app_params_t **p);
 int rp_get_signals(float ***s, int *sig_num, int *sig_len);
+int rp_get_waterfall(unsigned int since, void *buf, int len);
 
 /* Internal helper functions */
 int  rp_create_signals(float ***a_signals);
@@ -18,12 +18,11 @@
 #include <math.h>
 #include <string.h>
 #include <errno.h>
-
-#include "jpeglib.h"
+#include <stdint.h>
+#include <pthread.h>
 
 #include "waterfall.h"
 #include "dsp.h"
-#include "wf_colmap.h"
 
 /* TODO: More appripriate names */
 float g_mm = 0.0;
@@ -50,18 +49,16 @@ int g_spectr_wf_col;
 int *rp_wf_cha_dec_map = NULL;
 int *rp_wf_chb_dec_map = NULL;
 
-/* Maps which is builded from multiple acquisitions, size:
- * RP_SPECTR_WF_COL * RP_SPECTR_WF_LIN 
- */
-int *rp_wf_cha_cont_map = NULL;
-int *rp_wf_chb_cont_map = NULL;
-int  rp_wf_cont_map_idx = -1;
-
-/* The following structures are of R,G,B order data 
- * Size is RP_SPECTR_WF_COL * RP_SPECTR_WF_LIN * 3 (for RGB) 
+/* Ring of the last RP_SPECTR_WF_LIN rows builded from multiple acquisitions,
+ * each row is g_spectr_wf_col bytes of channel A followed by channel B.
+ * Row with sequence number seq is at index (seq - 1) % RP_SPECTR_WF_LIN,
+ * rows from rp_wf_row_first to rp_wf_row_seq are valid.
+ * Written by the worker thread, read by the web server.
  */
-JSAMPLE *rp_wf_cha_wat = NULL;
-JSAMPLE *rp_wf_chb_wat = NULL;
+unsigned char   *rp_wf_rows      = NULL;
+unsigned int     rp_wf_row_seq   = 0;
+unsigned int     rp_wf_row_first = 1;
+pthread_mutex_t  rp_wf_rows_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 int rp_spectr_wf_init(void)
 {
@@ -109,28 +106,15 @@ int rp_spectr_wf_init(void)
         return -1;
     }
 
-    rp_wf_cha_cont_map = (int *)malloc(RP_SPECTR_WF_LIN * g_spectr_wf_col
-                                       * sizeof(int));
-    rp_wf_chb_cont_map = (int *)malloc(RP_SPECTR_WF_LIN * g_spectr_wf_col
-                                       * sizeof(int));
-    if(!rp_wf_cha_cont_map || !rp_wf_chb_cont_map) {
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    rp_wf_rows = (unsigned char *)malloc(RP_SPECTR_WF_LIN * 2 * g_spectr_wf_col);
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
+    if(!rp_wf_rows) {
         fprintf(stderr, "rp_spectr_wf_init() can not allocate memory\n");
         rp_spectr_wf_clean();
         return -1;
     }
     rp_spectr_wf_clean_map();
-    
-    /* Initialize the rp_wf_cha_wat & chb_wat structures which will be used
-     * to build a picture - x3 is for R,G,B
-     */
-    rp_wf_cha_wat = (JSAMPLE *)malloc(RP_SPECTR_WF_LIN * g_spectr_wf_col *
-                                      3 * sizeof(JSAMPLE));
-    rp_wf_chb_wat = (JSAMPLE *)malloc(RP_SPECTR_WF_LIN * g_spectr_wf_col *
-                                      3 * sizeof(JSAMPLE));
-    if(!rp_wf_cha_wat || !rp_wf_chb_wat) {
-        fprintf(stderr, "rp_spectr_wf_init() can not allocate memory\n");
-        return -1;
-    }
 
     return 0;
 }
@@ -157,37 +141,26 @@ int rp_spectr_wf_clean(void)
         free(rp_wf_chb_dec_map);
         rp_wf_chb_dec_map = NULL;
     }
-    if(rp_wf_cha_cont_map) {
-        free(rp_wf_cha_cont_map);
-        rp_wf_cha_cont_map = NULL;
-    }
-    if(rp_wf_chb_cont_map) {
-        free(rp_wf_chb_cont_map);
-        rp_wf_chb_cont_map = NULL;
-    }
-    if(rp_wf_cha_wat) {
-        free(rp_wf_cha_wat);
-        rp_wf_cha_wat = NULL;
-    }
-    if(rp_wf_chb_wat) {
-        free(rp_wf_chb_wat);
-        rp_wf_chb_wat = NULL;
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    if(rp_wf_rows) {
+        free(rp_wf_rows);
+        rp_wf_rows = NULL;
     }
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
     return 0;
 }
 
+/* The sequence continues, clients see the gap and clear their picture */
 int rp_spectr_wf_clean_map(void)
 {
-    if(!rp_wf_cha_cont_map || !rp_wf_chb_cont_map) {
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    if(!rp_wf_rows) {
+        pthread_mutex_unlock(&rp_wf_rows_mutex);
         fprintf(stderr, "rp_spectr_wf_clean_map() not initialized!\n");
         return -1;
     }
-
-    memset(rp_wf_cha_cont_map, 0, 
-           RP_SPECTR_WF_LIN * g_spectr_wf_col * sizeof(int));
-    memset(rp_wf_chb_cont_map, 0, 
-           RP_SPECTR_WF_LIN * g_spectr_wf_col * sizeof(int));
-    rp_wf_cont_map_idx = RP_SPECTR_WF_LIN - 1; /* start with the last line */
+    rp_wf_row_first = rp_wf_row_seq + 1;
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
 
     return 0;
 }
@@ -223,39 +196,69 @@ int rp_spectr_wf_calc(double *cha_in, double *chb_in)
     return 0;
 }
 
-int rp_spectr_wf_save_jpeg(const char *wf_cha_file, const char *wf_chb_file) 
+unsigned int rp_spectr_wf_get_seq(void)
 {
-    if(!rp_wf_cha_cont_map || !rp_wf_chb_cont_map || 
-       !rp_wf_cha_wat || !rp_wf_chb_wat) {
-        fprintf(stderr, "rp_spectr_wf_save_jpeg(): not initialized\n");
-        return -1;
-    }
-    
-    if(rp_spectr_wf_create_rgb(rp_wf_cha_cont_map, &rp_wf_cha_wat) < 0) {
-        fprintf(stderr, "rp_spectr_wf_save_jpeg(): rp_spectr_wf_create_rgb() "
-                " failed\n");
+    unsigned int seq;
+
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    seq = rp_wf_row_seq;
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
+
+    return seq;
+}
+
+int rp_spectr_wf_get_rows(unsigned int since, unsigned char *buf, int len)
+{
+    const int row_len = 2 * g_spectr_wf_col;
+    unsigned int seq, first, count, max_rows, i;
+    uint16_t     hdr_cols, hdr_count;
+
+    if(!buf)
+        return RP_SPECTR_WF_HDR_LEN + RP_SPECTR_WF_LIN * row_len;
+
+    if(len < RP_SPECTR_WF_HDR_LEN) {
+        fprintf(stderr, "rp_spectr_wf_get_rows(): buffer too small\n");
         return -1;
     }
 
-    if(rp_spectr_wf_create_rgb(rp_wf_chb_cont_map, &rp_wf_chb_wat) < 0) {
-        fprintf(stderr, "rp_spectr_wf_save_jpeg(): rp_spectr_wf_create_rgb() "
-                " failed\n");
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    if(!rp_wf_rows) {
+        pthread_mutex_unlock(&rp_wf_rows_mutex);
+        fprintf(stderr, "rp_spectr_wf_get_rows() not initialized\n");
         return -1;
     }
 
-    if(rp_spectr_wf_comp_jpeg(rp_wf_cha_wat, wf_cha_file) < 0) {
-        fprintf(stderr, "rp_spectr_wf_save_jpeg(): rp_spectr_wf_comp_jpeg() "
-                " failed\n");
-        return -1;
+    seq = rp_wf_row_seq;
+    /* Client from before a restart of the application gets all rows */
+    if(since > seq)
+        since = 0;
+    first = since + 1;
+    if(first < rp_wf_row_first)
+        first = rp_wf_row_first;
+
+    count = seq + 1 - first;
+    max_rows = (len - RP_SPECTR_WF_HDR_LEN) / row_len;
+    if(count > max_rows) {
+        count = max_rows;
+        first = seq + 1 - count;
     }
 
-    if(rp_spectr_wf_comp_jpeg(rp_wf_chb_wat, wf_chb_file) < 0) {
-        fprintf(stderr, "rp_spectr_wf_save_jpeg(): rp_spectr_wf_comp_jpeg() "
-                " failed\n");
-        return -1;
+    for(i = 0; i < count; i++) {
+        memcpy(&buf[RP_SPECTR_WF_HDR_LEN + i * row_len],
+               &rp_wf_rows[((first + i - 1) % RP_SPECTR_WF_LIN) * row_len],
+               row_len);
     }
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
 
-    return 0;
+    hdr_cols  = g_spectr_wf_col;
+    hdr_count = count;
+    memcpy(&buf[0], "RPWF", 4);
+    memcpy(&buf[4], &hdr_cols, sizeof(hdr_cols));
+    memcpy(&buf[6], &hdr_count, sizeof(hdr_count));
+    memcpy(&buf[8], &seq, sizeof(seq));
+    memcpy(&buf[12], &first, sizeof(first));
+
+    return RP_SPECTR_WF_HDR_LEN + count * row_len;
 }
 
 /* Signal lengths:
@@ -334,103 +337,27 @@ int rp_spectr_wf_dec_map(double *cha_in, double *chb_in,
 
 int rp_spectr_wf_add_to_map(int *cha_in, int *chb_in)
 {
-    int start_idx;
-    if(!cha_in || !chb_in || !rp_wf_cha_cont_map || !rp_wf_chb_cont_map ||
-       (rp_wf_cont_map_idx == -1)) {
-        fprintf(stderr, "rp_spectr_wf_add_to_map() not initialized\n");
-        return -1;
-    }
-
-    start_idx = (rp_wf_cont_map_idx * g_spectr_wf_col);
-
-    memcpy(&rp_wf_cha_cont_map[start_idx], &cha_in[0], 
-           g_spectr_wf_col * sizeof(int));
-    memcpy(&rp_wf_chb_cont_map[start_idx], &chb_in[0], 
-           g_spectr_wf_col * sizeof(int));
-    
-    /* Decrease the rp_wf_cont_map_idx and wraps it if necessary but be sure to 
-     * wrap it if necessary 
-     * TODO: Should we clean last map or override it?
-     */
-    if(--rp_wf_cont_map_idx < 0)
-        rp_wf_cont_map_idx = RP_SPECTR_WF_LIN - 1;
-
-    return 0;
-}
-
-int rp_spectr_wf_create_rgb(int *data_in, JSAMPLE **data_out)
-{
-    JSAMPLE *data_o = *data_out;
-    int i, j;
-    int start_map_idx = (rp_wf_cont_map_idx+1) * g_spectr_wf_col - 1;
-
-    if(!data_in || !data_o) {
-        fprintf(stderr, "rp_spectr_wf_create_rgb() not initialized\n");
-        return -1;
-    }
-
-    /* Data out is of format R, G, B, R, G, B ... R, G, B */
-    for(i = (g_spectr_wf_col * RP_SPECTR_WF_LIN * 3 - 1), j = start_map_idx; 
-        i >= 2; i-=3, j--) {
-        int colmap_idx;
-        if(j < 0) {
-            j = g_spectr_wf_col * RP_SPECTR_WF_LIN - 1;
-        }
-        colmap_idx = data_in[j];
-
-        data_o[i-2] = rp_wf_colmap[colmap_idx][0];
-        data_o[i-1] = rp_wf_colmap[colmap_idx][1];
-        data_o[i-0] = rp_wf_colmap[colmap_idx][2];
-    }
-
-    return 0;
-}
-
-int rp_spectr_wf_comp_jpeg(JSAMPLE *data_in, const char *file_str)
-{
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr       jerr;
-    FILE                       *out_file;
-    JSAMPROW                    row_pointer[1];
-    int                         row_stride;
-
-    if(!data_in) {
-        fprintf(stderr, "rp_spectr_wf_comp_jpeg() not initialized\n");
-        return -1;
-    }
-
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_compress(&cinfo);
+    unsigned char *row;
+    int i;
 
-    if((out_file = fopen(file_str, "wb")) == NULL) {
-        fprintf(stderr, "rp_spectr_wf_comp_jpeg() can not open file (%s): %s\n", 
-                file_str, strerror(errno));
+    pthread_mutex_lock(&rp_wf_rows_mutex);
+    if(!cha_in || !chb_in || !rp_wf_rows) {
+        pthread_mutex_unlock(&rp_wf_rows_mutex);
+        fprintf(stderr, "rp_spectr_wf_add_to_map() not initialized\n");
         return -1;
     }
-    jpeg_stdio_dest(&cinfo, out_file);
-
-    cinfo.image_width      = g_spectr_wf_col;
-    cinfo.image_height     = RP_SPECTR_WF_LIN;
-    cinfo.input_components = 3;
-    cinfo.in_color_space   = JCS_RGB;
-
-    jpeg_set_defaults(&cinfo);
-    jpeg_set_quality(&cinfo, 95, TRUE);
-    jpeg_start_compress(&cinfo, TRUE);
 
-    row_stride = cinfo.image_width * 3;
-    while(cinfo.next_scanline < cinfo.image_height) {
-        row_pointer[0] = &data_in[cinfo.next_scanline * row_stride];
-        (void)jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    row = &rp_wf_rows[(rp_wf_row_seq % RP_SPECTR_WF_LIN) * 2 * g_spectr_wf_col];
+    for(i = 0; i < g_spectr_wf_col; i++) {
+        row[i]                   = cha_in[i];
+        row[g_spectr_wf_col + i] = chb_in[i];
     }
 
-    jpeg_finish_compress(&cinfo);
-
-    fclose(out_file);
-
-    jpeg_destroy_compress(&cinfo);
-
-    sync();
+    /* The oldest row is overwritten when the ring is full */
+    rp_wf_row_seq++;
+    if(rp_wf_row_seq - rp_wf_row_first >= RP_SPECTR_WF_LIN)
+        rp_wf_row_first = rp_wf_row_seq - RP_SPECTR_WF_LIN + 1;
+    pthread_mutex_unlock(&rp_wf_rows_mutex);
 
     return 0;
 }
@@ -25,7 +25,20 @@
 #define RP_SPECTR_WF_MAP_MAX  64
 #define RP_SPECTR_WF_MAP_NOI  20
 
-#include "jpeglib.h"
+/* Reply of rp_spectr_wf_get_rows(), native (little-endian) byte order:
+ *   char     magic[4]  "RPWF"
+ *   uint16   cols      values per channel in a row
+ *   uint16   count     number of rows in the reply
+ *   uint32   seq       sequence number of the newest row, 0 before the first row
+ *   uint32   first     sequence number of the first row in the reply, when it is
+ *                      above since + 1 the rows in between are lost (ring
+ *                      overflow or rp_spectr_wf_clean_map()) and the client
+ *                      should clear its picture
+ *   count rows, oldest first, each cols bytes of channel A and cols bytes of
+ *   channel B. Values are colour map indexes 1..RP_SPECTR_WF_MAP_MAX, the colour
+ *   mapping and scrolling is done by the client.
+ */
+#define RP_SPECTR_WF_HDR_LEN  16
 
 /*** Main Warerfall module calls ****/
 int rp_spectr_wf_init(void);
@@ -40,8 +53,15 @@ int rp_spectr_wf_clean_map(void);
 int rp_spectr_wf_calc(double *cha_in, double *chb_in);
 
 
-/* Build the waterfall diagram out of the collected acquisitions and stores it */
-int rp_spectr_wf_save_jpeg(const char *wf_file1, const char *wf_file2);
+/* Sequence number of the newest row in the map */
+unsigned int rp_spectr_wf_get_seq(void);
+
+/* Copies the rows newer than since to buf, at most the last RP_SPECTR_WF_LIN
+ * rows and only the newest ones which fit to len bytes.
+ * Returns the number of bytes written or the maximal reply size if buf is 
+ * NULL, -1 on error. May be called from any thread.
+ */
+int rp_spectr_wf_get_rows(unsigned int since, unsigned char *buf, int len);
 
 /*** Internal steps used in the processing ***/
 /* Convolution:
@@ -62,15 +82,4 @@ int rp_spectr_wf_dec_map(double *cha_in, double *chb_in,
  */
 int rp_spectr_wf_add_to_map(int *cha_in, int *chb_in);
 
-/* Creates RGB image in internal structures, used to dump JPEG or BMP
- * Input signal length = RP_SPECTR_WF_COL * RP_SPECTR_WF_LIN 
- * Output signal length = RP_SPECTR_WF_COL * RP_SPECTR_WF_LIN * 3 (RGB) 
- */
-int rp_spectr_wf_create_rgb(int *data_in, JSAMPLE **data_out);
-
-/* Compress image and store it, 
- * Input signal is of size RP_SPECTR_WF_COL * RP_SPECTR_WF_LIN *3 
- */
-int rp_spectr_wf_comp_jpeg(JSAMPLE *data_in, const char *file_out);
-
 #endif //__WATERFALL_H
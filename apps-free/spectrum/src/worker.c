@@ -19,25 +19,13 @@
 #include <unistd.h>
 #include <math.h>
 #include <stdlib.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <dirent.h>
 
 #include "worker.h"
+#include "rp_acq.h"
 #include "fpga.h"
 #include "dsp.h"
 #include "waterfall.h"
 
-/* JPG outputs: c_jpg_file_path+[1|2]+_+jpg_cnt(3 digits)+c_jpg_file_suf */
-const char c_jpg_dir_path[]="/tmp/ram";
-const char c_jpg_file_name[]="wat";
-const char c_jpg_file_path[]="/tmp/ram/wat";
-const char c_jpg_file_suf[]=".jpg";
-const int  c_jpg_max_file  = 63;
-const int  c_save_jpg_cnt  = 10; /* Repetition how often the JPG is stored */
-char      *jpg_fname_cha = NULL;
-char      *jpg_fname_chb = NULL;
-
 pthread_t *rp_spectr_thread_handler = NULL;
 void *rp_spectr_worker_thread(void *args);
 
@@ -69,16 +57,45 @@ float                **rp_spectr_signals = NULL;
 rp_spectr_worker_res_t rp_spectr_result;
 int                    rp_spectr_signals_dirty = 0;
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_spectr_event;
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_spectr_wait_s {
+    rp_spectr_worker_state_t old_state;
+    rp_spectr_worker_state_t state;
+    int params_dirty;
+} rp_spectr_wait_t;
+
+static int rp_spectr_wait_abort(void *arg)
+{
+    rp_spectr_wait_t *wait = (rp_spectr_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_spectr_ctrl_mutex);
+    wait->state = rp_spectr_ctrl;
+    wait->params_dirty = rp_spectr_params_dirty;
+    pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (wait->state != wait->old_state) || wait->params_dirty;
+}
+
+static int rp_spectr_wait_trigger(void *arg)
+{
+    return spectr_fpga_triggered();
+}
+
 int rp_spectr_worker_init(void)
 {
     int ret_val;
 
+    if(rp_acq_event_init(&rp_spectr_event, "spectrum", 1000) < 0)
+        return -1;
+
     rp_spectr_ctrl               = rp_spectr_idle_state;
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = 1;
 
-    rp_spectr_clean_tmpdir(c_jpg_dir_path);
-
     rp_cleanup_signals(&rp_spectr_signals);
     if(rp_create_signals(&rp_spectr_signals) < 0)
         return -1;
@@ -99,15 +116,6 @@ int rp_spectr_worker_init(void)
         return -1;
     }
 
-    jpg_fname_cha = 
-        (char *)malloc((strlen(c_jpg_file_path)+strlen(c_jpg_file_suf)+5+1));
-    jpg_fname_chb = 
-        (char *)malloc((strlen(c_jpg_file_path)+strlen(c_jpg_file_suf)+5+1));
-    if(!jpg_fname_cha || !jpg_fname_chb) {
-        rp_spectr_worker_clean();
-        return -1;
-    }
-
     if(spectr_fpga_init() < 0) {
         rp_spectr_worker_clean();
         return -1;
@@ -142,6 +150,7 @@ int rp_spectr_worker_init(void)
                        rp_spectr_worker_thread, NULL);
     if(ret_val != 0) {
         spectr_fpga_exit();
+        rp_acq_event_close(&rp_spectr_event);
 
         rp_cleanup_signals(&rp_spectr_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -162,14 +171,6 @@ int rp_spectr_worker_clean(void)
     rp_spectr_fft_clean();
     rp_spectr_wf_clean();
 
-    if(jpg_fname_cha) {
-        free(jpg_fname_cha);
-        jpg_fname_cha = NULL;
-    }
-    if(jpg_fname_chb) {
-        free(jpg_fname_chb);
-        jpg_fname_chb = NULL;
-    }
     if(rp_cha_in) {
         free(rp_cha_in);
         rp_cha_in = NULL;
@@ -204,8 +205,8 @@ int rp_spectr_worker_exit(void)
         fprintf(stderr, "pthread_join() failed: %s\n", 
                 strerror(errno));
     }
+    rp_acq_event_close(&rp_spectr_event);
     rp_spectr_worker_clean();
-    rp_spectr_clean_tmpdir(c_jpg_dir_path);
     return 0;
 }
 
@@ -216,6 +217,7 @@ int rp_spectr_worker_change_state(rp_spectr_worker_state_t new_state)
     pthread_mutex_lock(&rp_spectr_ctrl_mutex);
     rp_spectr_ctrl = new_state;
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+    rp_acq_event_wake(&rp_spectr_event);
     return 0;
 }
 
@@ -226,6 +228,7 @@ int rp_spectr_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = fpga_update;
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+    rp_acq_event_wake(&rp_spectr_event);
     return 0;
 }
 
@@ -237,55 +240,6 @@ int rp_spectr_clean_signals(void)
     return 0;
 }
 
-int rp_spectr_clean_tmpdir(const char *dir)
-{
-    DIR *dp;
-    struct dirent *ep;
-    int fname_len = strlen(c_jpg_file_name);
-    int fsuf_len = strlen(c_jpg_file_suf);
-    int ret = 0;
-
-    if((dp = opendir(dir)) == NULL) {
-        fprintf(stderr, "%s() opendir() failed: %s\n",
-                __FUNCTION__, strerror(errno));
-        return -1;
-    }
-
-    while((ep = readdir(dp))) {
-        const char *filename = ep->d_name;
-        int f_len = strlen(filename);
-
-        if((f_len > fname_len) &&
-                (strncmp(filename, c_jpg_file_name, fname_len) == 0) &&
-                (strncmp(&filename[f_len-fsuf_len], c_jpg_file_suf, fsuf_len) == 0)) {
-
-            int full_name_len = strlen(dir) + strlen(filename) + 2;
-            char *full_name;
-            full_name = (char *)malloc(full_name_len * sizeof(char));
-            if(full_name == NULL) {
-                fprintf(stderr, "%s() malloc() failed: %s\n",
-                        __FUNCTION__, strerror(errno));
-                ret = -1;
-                break;
-            }
-            sprintf(full_name, "%s/%s", dir, filename);
-            full_name[full_name_len-1]='\0';
-            if(unlink((const char *)full_name) < 0) {
-                fprintf(stderr, "%s() unlink() for '%s' failed: %s\n",
-                        __FUNCTION__, full_name, strerror(errno));
-                /* still continue erasing */
-                ret = -1;
-            }
-
-            free(full_name);
-        }
-    }
-
-    closedir(dp);
-
-    return ret;
-}
-
 int rp_spectr_get_signals(float ***signals, rp_spectr_worker_res_t *result)
 {
     float **s = *signals;
@@ -301,7 +255,7 @@ int rp_spectr_get_signals(float ***signals, rp_spectr_worker_res_t *result)
 
     rp_spectr_signals_dirty = 0;
 
-    result->jpg_idx          = rp_spectr_result.jpg_idx;
+    result->wf_seq           = rp_spectr_result.wf_seq;
     result->peak_pw_cha      = rp_spectr_result.peak_pw_cha;
     result->peak_pw_freq_cha = rp_spectr_result.peak_pw_freq_cha;
     result->peak_pw_chb      = rp_spectr_result.peak_pw_chb;
@@ -320,7 +274,7 @@ int rp_spectr_set_signals(float **source, rp_spectr_worker_res_t result)
 
     rp_spectr_signals_dirty = 1;
 
-    rp_spectr_result.jpg_idx          = result.jpg_idx;
+    rp_spectr_result.wf_seq           = result.wf_seq;
     rp_spectr_result.peak_pw_cha      = result.peak_pw_cha;
     rp_spectr_result.peak_pw_freq_cha = result.peak_pw_freq_cha;
     rp_spectr_result.peak_pw_chb      = result.peak_pw_chb;
@@ -337,10 +291,7 @@ void *rp_spectr_worker_thread(void *args)
     rp_app_params_t          curr_params[PARAMS_NUM];
     int                      fpga_update = 1;
     int                      params_dirty = 1;
-    int                      loop_cnt = 0; /* each N save jpeg */
-    int                      jpg_fn_cnt = 0;
-    /* depends on freq_range - do not save too much or too less */
-    int                      jpg_write_div = 10;
+    rp_spectr_wait_t         wait = { 0, 0, 0 };
     rp_spectr_worker_res_t   tmp_result;
 
     pthread_mutex_lock(&rp_spectr_ctrl_mutex);
@@ -377,24 +328,12 @@ void *rp_spectr_worker_thread(void *args)
 
             fpga_update = 0;
             rp_spectr_wf_clean_map();
-            switch((int)curr_params[FREQ_RANGE_PARAM].value) {
-            case 0:
-            case 1:
-                jpg_write_div = 10;
-                break;
-            case 2:
-            case 3:
-                jpg_write_div = 5;
-                break;
-            case 4:
-            case 5:
-                jpg_write_div = 0;
-                break;
-            }
         }
 
         if(state == rp_spectr_idle_state) {
-            usleep(10000);
+            wait.old_state = state;
+            rp_acq_event_wait(&rp_spectr_event, NULL, rp_spectr_wait_abort,
+                              &wait, -1);
             continue;
         }
 
@@ -415,21 +354,12 @@ void *rp_spectr_worker_thread(void *args)
             break;
         }
 
-        /* polling until data is ready */
-        while(1) {
-            pthread_mutex_lock(&rp_spectr_ctrl_mutex);
-            state = rp_spectr_ctrl;
-            params_dirty = rp_spectr_params_dirty;
-            pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                break;
-            }
-                
-            if(spectr_fpga_triggered()) {
-                break;
-            }
-        }
+        /* waiting until data is ready */
+        wait.old_state = old_state;
+        rp_acq_event_wait(&rp_spectr_event, rp_spectr_wait_trigger,
+                          rp_spectr_wait_abort, &wait, -1);
+        state        = wait.state;
+        params_dirty = wait.params_dirty;
 
         if((state != old_state) || params_dirty) {
             params_dirty = 0;
@@ -463,29 +393,13 @@ void *rp_spectr_worker_thread(void *args)
                              &tmp_result.peak_pw_freq_chb,
                              curr_params[FREQ_RANGE_PARAM].value);
 
-        /* Calculate the map used for Waterfall diagram  */
+        /* Add the new row to the Waterfall diagram, the clients read the
+         * rows they miss from the map */
         rp_spectr_wf_calc(&rp_cha_fft[0], &rp_chb_fft[0]);
 
-        if((jpg_write_div == 0) || (loop_cnt++%jpg_write_div == 0)) {
-            jpg_fn_cnt++;
-            if(jpg_fn_cnt > c_jpg_max_file) 
-                jpg_fn_cnt = 0;
-
-            sprintf(jpg_fname_cha, "%s%01d_%03d%s", c_jpg_file_path, 
-                    1, jpg_fn_cnt, c_jpg_file_suf);
-            sprintf(jpg_fname_chb, "%s%01d_%03d%s", c_jpg_file_path, 
-                    2, jpg_fn_cnt, c_jpg_file_suf);
-            rp_spectr_wf_save_jpeg(jpg_fname_cha, jpg_fname_chb);
-
-            /* Report index back to the user */
-        } else if(loop_cnt > 1e6) {
-            loop_cnt = 0;
-        }
-
-
-        /* Copy the result to the output part - and also the index of
-         * last JPEG file index */
-        tmp_result.jpg_idx = jpg_fn_cnt;
+        /* Copy the result to the output part - and also the sequence of
+         * the last waterfall row */
+        tmp_result.wf_seq = rp_spectr_wf_get_seq();
         rp_spectr_set_signals(rp_tmp_signals, tmp_result);
 
         usleep(10000);
@@ -25,9 +25,9 @@ typedef enum rp_spectr_worker_state_e {
     rp_spectr_nonexisting_state /* must be last */
 } rp_spectr_worker_state_t;
 
-/* Worker results (not signal but calculated peaks and jpeg index */
+/* Worker results (not signal but calculated peaks and waterfall row sequence */
 typedef struct rp_spectr_worker_res_s {
-    int   jpg_idx;
+    unsigned int wf_seq;
     float peak_pw_cha;
     float peak_pw_freq_cha;
     float peak_pw_chb;
@@ -42,8 +42,6 @@ int rp_spectr_worker_update_params(rp_app_params_t *params, int fpga_update);
 
 /* removes 'dirty' flags */
 int rp_spectr_clean_signals(void);
-/* Cleans up temporary directory (JPGs) */
-int rp_spectr_clean_tmpdir(const char *dir);
 
 /* Returns:
  *  0 - new signals (dirty signal) are copied to the output 
@@ -137,12 +137,60 @@ int                  *rp_fpga_cha_signal, *rp_fpga_chb_signal;
 rp_calib_params_t *rp_calib_params = NULL;
 
 
+/* Trigger event of the worker thread, woken on state and parameter changes */
+static rp_acq_event_t rp_osc_event;
+
+
+/* Trigger conditions for rp_acq_event_wait() */
+typedef struct rp_osc_wait_s {
+    rp_osc_worker_state_t old_state;
+    rp_osc_worker_state_t state;
+    int                   params_dirty;
+    int                   long_acq;
+    int                   init_trig_ptr;
+} rp_osc_wait_t;
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_osc_wait_abort(void *arg)
+{
+    rp_osc_wait_t *w = (rp_osc_wait_t *)arg;
+
+    pthread_mutex_lock(&rp_osc_ctrl_mutex);
+    w->state = rp_osc_ctrl;
+    w->params_dirty = rp_osc_params_dirty;
+    pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+
+    /* change in state, abort polling */
+    return (w->state != w->old_state) || w->params_dirty;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static int rp_osc_wait_trigger(void *arg)
+{
+    rp_osc_wait_t *w = (rp_osc_wait_t *)arg;
+    int trig_ptr, curr_ptr;
+
+    /* for non-long acquisition wait for trigger */
+    if(!w->long_acq)
+        return osc_fpga_triggered();
+
+    /* FPGA wrote new trigger pointer - which means new trigger happened */
+    osc_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
+    return (w->init_trig_ptr != trig_ptr) || osc_fpga_triggered();
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int rp_osc_worker_init(rp_app_params_t *params, int params_len,
                        rp_calib_params_t *calib_params)
 {
     int ret_val;
 
+    if(rp_acq_event_init(&rp_osc_event, "teslameter", 1000) < 0)
+        return -1;
+
     rp_osc_ctrl               = rp_osc_idle_state;
     rp_osc_params_dirty       = 0;
     rp_osc_params_fpga_update = 0;
@@ -179,6 +227,7 @@ int rp_osc_worker_init(rp_app_params_t *params, int params_len,
         pthread_create(rp_osc_thread_handler, NULL, rp_osc_worker_thread, NULL);
     if(ret_val != 0) {
         osc_fpga_exit();
+        rp_acq_event_close(&rp_osc_event);
 
         rp_cleanup_signals(&rp_osc_signals);
         rp_cleanup_signals(&rp_tmp_signals);
@@ -207,6 +256,7 @@ int rp_osc_worker_exit(void)
                 strerror(errno));
     }
     osc_fpga_exit();
+    rp_acq_event_close(&rp_osc_event);
 
     rp_cleanup_signals(&rp_osc_signals);
     rp_cleanup_signals(&rp_tmp_signals);
@@ -225,6 +275,7 @@ int rp_osc_worker_change_state(rp_osc_worker_state_t new_state)
     pthread_mutex_lock(&rp_osc_ctrl_mutex);
     rp_osc_ctrl = new_state;
     pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+    rp_acq_event_wake(&rp_osc_event);
     return 0;
 }
 
@@ -250,6 +301,7 @@ int rp_osc_worker_update_params(rp_app_params_t *params, int fpga_update)
     rp_osc_params[PARAMS_NUM].value = -1;
 
     pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+    rp_acq_event_wake(&rp_osc_event);
     return 0;
 }
 
@@ -322,6 +374,7 @@ void *rp_osc_worker_thread(void *args)
     int                   time_vect_update = 0;
     uint32_t              trig_source = 0;
     int                   params_dirty = 0;
+    int                   dec_mode;
 
     /* Long acquisition special function */
     int long_acq = 0; /* long_acq if acq_time > 1 [s] */
@@ -442,13 +495,15 @@ void *rp_osc_worker_thread(void *args)
         }
 
         if(state == rp_osc_idle_state) {
-            usleep(10000);
+            /* sleep until the state or the parameters change */
+            rp_osc_wait_t idle = { state, state, 0, 0, 0 };
+            rp_acq_event_wait(&rp_osc_event, NULL, rp_osc_wait_abort, &idle, -1);
             continue;
         }
 
         if(time_vect_update) {
             float unit_factor = 
-                rp_osc_get_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
+                rp_acq_time_unit_factor(curr_params[TIME_UNIT_PARAM].value);
             float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                            curr_params[MIN_GUI_PARAM].value) / unit_factor;
 
@@ -469,8 +524,8 @@ void *rp_osc_worker_thread(void *args)
                  * when it changes we will act like official 'trigger' 
                  * came
                  */
-                rp_osc_meas_clear(&ch1_meas);
-                rp_osc_meas_clear(&ch2_meas);
+                rp_acq_meas_clear(&ch1_meas);
+                rp_acq_meas_clear(&ch2_meas);
                 osc_fpga_get_wr_ptr(NULL, &long_acq_init_trig_ptr);
             } else {
                 long_acq_first_wr_ptr  = 0;
@@ -515,31 +570,13 @@ void *rp_osc_worker_thread(void *args)
 
         if(long_acq_idx == 0) {
             /* polling until data is ready */
-            while(1) {
-                pthread_mutex_lock(&rp_osc_ctrl_mutex);
-                state = rp_osc_ctrl;
-                params_dirty = rp_osc_params_dirty;
-                pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    break;
-                }
-                
-                if(!long_acq && osc_fpga_triggered()) {
-                    /* for non-long acquisition wait for trigger */
-                    break;
-                } else if(long_acq) {
-                    int trig_ptr, curr_ptr;
-                    osc_fpga_get_wr_ptr(&curr_ptr, &trig_ptr);
-                    if((long_acq_init_trig_ptr != trig_ptr) || osc_fpga_triggered()) {
-                        /* FPGA wrote new trigger pointer - which means
-                         * new trigger happened 
-                         */
-                        break;
-                    }
-                }
-                usleep(1000);
-            }
+            rp_osc_wait_t wait = { old_state, state, 0, long_acq,
+                                   long_acq_init_trig_ptr };
+
+            rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                              rp_osc_wait_abort, &wait, -1);
+            state = wait.state;
+            params_dirty = wait.params_dirty;
         }
 
         if((state != old_state) || params_dirty) {
@@ -560,7 +597,7 @@ void *rp_osc_worker_thread(void *args)
                 int t_start_idx = 
                     round(curr_params[MIN_GUI_PARAM].value / smpl_period);
                 float unit_factor = 
-                    rp_osc_get_time_unit_factor(
+                    rp_acq_time_unit_factor(
                                          curr_params[TIME_UNIT_PARAM].value);
                 float t_acq = (curr_params[MAX_GUI_PARAM].value - 
                                curr_params[MIN_GUI_PARAM].value) / 
@@ -583,8 +620,8 @@ void *rp_osc_worker_thread(void *args)
                         round((t_acq / (c_osc_fpga_smpl_period * dec_factor)) / 
                               (SIGNAL_LENGTH-1));
 
-                rp_osc_meas_clear(&ch1_meas);
-                rp_osc_meas_clear(&ch2_meas);
+                rp_acq_meas_clear(&ch1_meas);
+                rp_acq_meas_clear(&ch2_meas);
             }
              
             /* we are after trigger - so let's wait a while to collect some 
@@ -600,10 +637,15 @@ void *rp_osc_worker_thread(void *args)
         if((state != old_state) || params_dirty)
             continue;
 
+        /* Display columns show their peaks, or their mean when averaging
+         * at decimation is enabled */
+        dec_mode = curr_params[EN_AVG_AT_DEC].value ? RP_ACQ_DEC_AVG :
+                                                      RP_ACQ_DEC_PEAK;
+
         if(!long_acq) {
             /* Triggered, decimate & convert the values */
-            rp_osc_meas_clear(&ch1_meas);
-            rp_osc_meas_clear(&ch2_meas);
+            rp_acq_meas_clear(&ch1_meas);
+            rp_acq_meas_clear(&ch2_meas);
             rp_osc_decimate((float **)&rp_tmp_signals[1], &rp_fpga_cha_signal[0],
                             (float **)&rp_tmp_signals[2], &rp_fpga_chb_signal[0],
                             (float **)&rp_tmp_signals[0], dec_factor, 
@@ -619,7 +661,7 @@ void *rp_osc_worker_thread(void *args)
                             curr_params[GAIN_CH2].value,
                              curr_params[SCALE_DECADE_TESLA_CH1].value,
                              curr_params[SCALE_DECADE_TESLA_CH2].value, 
-                             tesla_fd);
+                             tesla_fd, dec_mode);
         } else {
             long_acq_idx = rp_osc_decimate_partial((float **)&rp_tmp_signals[1], 
                                              &rp_fpga_cha_signal[0], 
@@ -642,7 +684,7 @@ void *rp_osc_worker_thread(void *args)
                                              curr_params[GAIN_CH2].value,
                                              curr_params[SCALE_DECADE_TESLA_CH1].value,
                                              curr_params[SCALE_DECADE_TESLA_CH2].value,
-                                             tesla_fd);
+                                             tesla_fd, dec_mode);
 
             /* Acquisition over, start one more! */
             if(long_acq_idx >= SIGNAL_LENGTH-1) {
@@ -674,8 +716,8 @@ void *rp_osc_worker_thread(void *args)
         /* copy the results to the user buffer - if we are finished or not */
         if(!long_acq || long_acq_idx == 0) {
             /* Finish the measurement */
-            rp_osc_meas_avg_amp(&ch1_meas, OSC_FPGA_SIG_LEN);
-            rp_osc_meas_avg_amp(&ch2_meas, OSC_FPGA_SIG_LEN);
+            rp_acq_meas_avg_amp(&ch1_meas, OSC_FPGA_SIG_LEN);
+            rp_acq_meas_avg_amp(&ch2_meas, OSC_FPGA_SIG_LEN);
 
 
 
@@ -683,8 +725,8 @@ void *rp_osc_worker_thread(void *args)
             
             rp_osc_meas_period(&ch1_meas, &ch2_meas, &rp_fpga_cha_signal[0], 
                                &rp_fpga_chb_signal[0], dec_factor);
-            rp_osc_meas_convert(&ch1_meas, ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs);
-            rp_osc_meas_convert(&ch2_meas, ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs);
+            rp_acq_meas_convert(&ch1_meas, ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs);
+            rp_acq_meas_convert(&ch2_meas, ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs);
             
             rp_osc_set_meas_data(ch1_meas, ch2_meas, tesla_fd);
             rp_osc_set_signals(rp_tmp_signals, SIGNAL_LENGTH-1);
@@ -708,7 +750,7 @@ int rp_osc_prepare_time_vector(float **out_signal, int dec_factor,
     float t_step, t_curr;
     int   out_idx, in_idx;
     int   idx_step;
-    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);;
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);;
 
     float *s = *out_signal;
 
@@ -745,11 +787,11 @@ int rp_osc_decimate(float **cha_signal, int *in_cha_signal,
                     int gain_ch2,
                     int tesla_scale_decade_ch1, 
                     int tesla_scale_decade_ch2,
-                    int tesla_fd)
+                    int tesla_fd, int dec_mode)
 {
     int t_start_idx, t_stop_idx;
     float smpl_period = c_osc_fpga_smpl_period * dec_factor;
-    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);
     int t_step;
     int in_idx, out_idx, t_idx;
     int wr_ptr_curr, wr_ptr_trig;
@@ -791,98 +833,81 @@ int rp_osc_decimate(float **cha_signal, int *in_cha_signal,
         in_idx = in_idx % OSC_FPGA_SIG_LEN;
 
     /* First perform measurements on non-decimated signal:
-     *  - min, max - performed in the loop
+     *  - min, max - accumulated over the whole buffer
      *  - avg, amp - performed after the loop
      *  - freq, period - performed in the next decimation loop
      */
-    for(out_idx=0; out_idx < OSC_FPGA_SIG_LEN; out_idx++) {
-        rp_osc_meas_min_max(ch1_meas, in_cha_signal[out_idx]);
-        rp_osc_meas_min_max(ch2_meas, in_chb_signal[out_idx]);
+    rp_acq_meas_min_max(ch1_meas, in_cha_signal, OSC_FPGA_SIG_LEN,
+                        0, OSC_FPGA_SIG_LEN);
+    rp_acq_meas_min_max(ch2_meas, in_chb_signal, OSC_FPGA_SIG_LEN,
+                        0, OSC_FPGA_SIG_LEN);
+
+    //this attempt didnt work - data loss - moved to javascript handler
+    if(tesla_scale_decade_ch1 == 0){
+        decade_ch1 = 1e-3;
+    }
+    else if (tesla_scale_decade_ch1 == 1){
+        decade_ch1 = 1e-6;
+    }
+    else if (tesla_scale_decade_ch1 == 2){
+        decade_ch1 = 1e-9;
     }
 
-    for(out_idx=0, t_idx=0; out_idx < SIGNAL_LENGTH; 
-        out_idx++, in_idx+=t_step, t_idx+=t_step) {
-        /* Wrap the pointer */
-        if(in_idx >= OSC_FPGA_SIG_LEN)
-            in_idx = in_idx % OSC_FPGA_SIG_LEN;
-
-
-        
-
-        //this attempt didnt work - data loss - moved to javascript handler
-        if(tesla_scale_decade_ch1 == 0){
-            decade_ch1 = 1e-3;
-        }
-        else if (tesla_scale_decade_ch1 == 1){
-            decade_ch1 = 1e-6;
-        }
-        else if (tesla_scale_decade_ch1 == 2){
-            decade_ch1 = 1e-9;
-        }
-
-        //this attempt didnt work - data loss - moved to javascript handler
-        if(tesla_scale_decade_ch2 == 0){
-            decade_ch2 = 1e-3;
-        }
-        else if (tesla_scale_decade_ch2 == 1){
-            decade_ch2 = 1e-6;
-        }
-        else if (tesla_scale_decade_ch2 == 2){
-            decade_ch2 = 1e-9;
-        }
-
-        if ( gain_ch1 == 2 ){
-            gain_factor_ch1 = 100;
-        }
-        else if ( gain_ch1 == 1 ){
-            gain_factor_ch1 = 10;
-        }
-        else {
-            gain_factor_ch1 = 1;
-        }
-
-        if ( gain_ch2 == 2 ){
-            gain_factor_ch2 = 100;
-        }
-        else if ( gain_ch2 == 1 ){
-            gain_factor_ch2 = 10;
-        }
-        else {
-            gain_factor_ch2 = 1;
-        }
-
-        /*remove this two lines to enable decade fetures -tesla - this feature was moved 
-        to javascript */
-        decade_ch2 = 1;
-        decade_ch1 = 1;
+    //this attempt didnt work - data loss - moved to javascript handler
+    if(tesla_scale_decade_ch2 == 0){
+        decade_ch2 = 1e-3;
+    }
+    else if (tesla_scale_decade_ch2 == 1){
+        decade_ch2 = 1e-6;
+    }
+    else if (tesla_scale_decade_ch2 == 2){
+        decade_ch2 = 1e-9;
+    }
 
-        
+    if ( gain_ch1 == 2 ){
+        gain_factor_ch1 = 100;
+    }
+    else if ( gain_ch1 == 1 ){
+        gain_factor_ch1 = 10;
+    }
+    else {
+        gain_factor_ch1 = 1;
+    }
 
-        
-        
+    if ( gain_ch2 == 2 ){
+        gain_factor_ch2 = 100;
+    }
+    else if ( gain_ch2 == 1 ){
+        gain_factor_ch2 = 10;
+    }
+    else {
+        gain_factor_ch2 = 1;
+    }
 
-        cha_s[out_idx] = osc_fpga_cnv_cnt_to_v(in_cha_signal[in_idx], ch1_max_adc_v,
-                                               rp_calib_params->fe_ch1_dc_offs,
-                                               ch1_user_dc_off) * ch1_scale_tesla * gain_factor_ch1 * decade_ch1 ; // tesla scaling factor
-        
+    /*remove this two lines to enable decade fetures -tesla - this feature was moved 
+    to javascript */
+    decade_ch2 = 1;
+    decade_ch1 = 1;
 
-        
-        chb_s[out_idx] = osc_fpga_cnv_cnt_to_v(in_chb_signal[in_idx], ch2_max_adc_v,
-                                               rp_calib_params->fe_ch2_dc_offs,
-                                               ch2_user_dc_off) * ch2_scale_tesla * gain_factor_ch2 * decade_ch2 ; // tesla scaling factor
-        
+    rp_acq_decimate_cols(cha_s, in_cha_signal, OSC_FPGA_SIG_LEN, in_idx, t_step,
+                         SIGNAL_LENGTH, dec_mode, ch1_max_adc_v,
+                         rp_calib_params->fe_ch1_dc_offs, ch1_user_dc_off);
+    rp_acq_decimate_cols(chb_s, in_chb_signal, OSC_FPGA_SIG_LEN, in_idx, t_step,
+                         SIGNAL_LENGTH, dec_mode, ch2_max_adc_v,
+                         rp_calib_params->fe_ch2_dc_offs, ch2_user_dc_off);
 
+    for(out_idx=0, t_idx=0; out_idx < SIGNAL_LENGTH; out_idx++, t_idx+=t_step) {
+        // tesla scaling factor
+        cha_s[out_idx] *= ch1_scale_tesla * gain_factor_ch1 * decade_ch1;
+        chb_s[out_idx] *= ch2_scale_tesla * gain_factor_ch2 * decade_ch2;
 
         t[out_idx] = (t_start + (t_idx * smpl_period)) * t_unit_factor;
+    }
 
-        /* A bug in FPGA? - Trig & write pointers not sample-accurate. */
-        if ( (dec_factor > 64) && (out_idx == 1) ) {
-            int i;
-            for (i=0; i < out_idx; i++) {
-                cha_s[i] = cha_s[out_idx];
-                chb_s[i] = chb_s[out_idx];
-            }
-        }
+    /* A bug in FPGA? - Trig & write pointers not sample-accurate. */
+    if(dec_factor > 64) {
+        cha_s[0] = cha_s[1];
+        chb_s[0] = chb_s[1];
     }
 
     return 0;
@@ -906,7 +931,7 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
                             int gain_ch2, 
                             int tesla_scale_decade_ch1, 
                             int tesla_scale_decade_ch2,
-                            int tesla_fd)
+                            int tesla_fd, int dec_mode)
 {
     float *cha_out = *cha_out_signal;
     float *chb_out = *chb_out_signal;
@@ -914,58 +939,52 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
     int    in_idx = *next_wr_ptr;
 
     float smpl_period = c_osc_fpga_smpl_period * dec_factor;
-    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);
+    int   t_unit_factor = rp_acq_time_unit_factor(time_unit);
 
-    int curr_ptr;
+    int curr_ptr, n, i;
     /* check if we have reached currently acquired signals in FPGA */
     osc_fpga_get_wr_ptr(&curr_ptr, NULL);
 
-    for(; in_idx < curr_ptr; in_idx++) {
-        if(in_idx >= OSC_FPGA_SIG_LEN)
-            in_idx = in_idx % OSC_FPGA_SIG_LEN;
-        rp_osc_meas_min_max(ch1_meas, cha_in_signal[in_idx]);
-        rp_osc_meas_min_max(ch2_meas, chb_in_signal[in_idx]);
-    }
+    rp_acq_meas_min_max(ch1_meas, cha_in_signal, OSC_FPGA_SIG_LEN,
+                        in_idx, curr_ptr - in_idx);
+    rp_acq_meas_min_max(ch2_meas, chb_in_signal, OSC_FPGA_SIG_LEN,
+                        in_idx, curr_ptr - in_idx);
 
-    in_idx = *next_wr_ptr;
-
-    for(; (next_out_idx < SIGNAL_LENGTH); next_out_idx++, 
-            in_idx += step_wr_ptr) {
-        int curr_ptr;
-        int diff_ptr;
-        /* check if we have reached currently acquired signals in FPGA */
-        osc_fpga_get_wr_ptr(&curr_ptr, NULL);
-        if(in_idx >= OSC_FPGA_SIG_LEN)
-            in_idx = in_idx % OSC_FPGA_SIG_LEN;
-        diff_ptr = (in_idx-curr_ptr);
-        /* Check that we did not hit the curr ptr (and that pointer is not
-         * wrapped 
-         */
-        if((in_idx >= curr_ptr) && (diff_ptr > 0) && (diff_ptr < 100))
-            break;
+    /* decimate the points acquired since the last call, in whole columns */
+    if(in_idx >= OSC_FPGA_SIG_LEN)
+        in_idx = in_idx % OSC_FPGA_SIG_LEN;
+    if(step_wr_ptr < 1)
+        step_wr_ptr = 1;
+    n = ((curr_ptr - in_idx + OSC_FPGA_SIG_LEN) % OSC_FPGA_SIG_LEN) / step_wr_ptr;
+    if(n >= SIGNAL_LENGTH - next_out_idx)
+        n = SIGNAL_LENGTH - next_out_idx;
+    else
+        n &= ~1;
+
+    rp_acq_decimate_cols(&cha_out[next_out_idx], cha_in_signal,
+                         OSC_FPGA_SIG_LEN, in_idx, step_wr_ptr, n, dec_mode,
+                         ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs,
+                         ch1_user_dc_off);
+    in_idx = rp_acq_decimate_cols(&chb_out[next_out_idx], chb_in_signal,
+                                  OSC_FPGA_SIG_LEN, in_idx, step_wr_ptr, n,
+                                  dec_mode, ch2_max_adc_v,
+                                  rp_calib_params->fe_ch2_dc_offs,
+                                  ch2_user_dc_off);
+    for(i = next_out_idx; i < next_out_idx + n; i++) {
+        cha_out[i] *= ch1_scale_tesla; // tesla scaling factor
+        chb_out[i] *= ch2_scale_tesla; // tesla scaling factor
+    }
+    for(i = next_out_idx; i < next_out_idx + n; i++)
+        t_out[i] = (t_start + ((i*step_wr_ptr)*smpl_period))*t_unit_factor;
 
-        cha_out[next_out_idx] = 
-            osc_fpga_cnv_cnt_to_v(cha_in_signal[in_idx], ch1_max_adc_v,
-                                  rp_calib_params->fe_ch1_dc_offs,
-                                  ch1_user_dc_off) * ch1_scale_tesla; // tesla scaling factor
-
-        chb_out[next_out_idx] = 
-            osc_fpga_cnv_cnt_to_v(chb_in_signal[in_idx], ch2_max_adc_v,
-                                  rp_calib_params->fe_ch1_dc_offs,
-                                  ch2_user_dc_off) * ch2_scale_tesla; // tesla scaling factor
-
-        t_out[next_out_idx]   = 
-            (t_start + ((next_out_idx*step_wr_ptr)*smpl_period))*t_unit_factor;
-
-        /* A bug in FPGA? - Trig & write pointers not sample-accurate. */
-        if ( (dec_factor > 64) && (next_out_idx == 2) ) {
-             int i;
-             for (i=0; i < next_out_idx; i++) {
-                 cha_out[i] = cha_out[next_out_idx];
-                 chb_out[i] = chb_out[next_out_idx];
-             }
-         }
+    /* A bug in FPGA? - Trig & write pointers not sample-accurate. */
+    if((dec_factor > 64) && (next_out_idx <= 2) && (next_out_idx + n > 2)) {
+        for(i = 0; i < 2; i++) {
+            cha_out[i] = cha_out[2];
+            chb_out[i] = chb_out[2];
+        }
     }
+    next_out_idx += n;
 
     *next_wr_ptr = in_idx;
 
@@ -973,31 +992,6 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
 }
 
 
-/*----------------------------------------------------------------------------------*/
-int rp_osc_get_time_unit_factor(int time_unit)
-{
-    int t_unit_factor;
-
-    switch(time_unit) {
-    case 0:
-        /* [us] */
-        t_unit_factor = 1e6;
-        break;
-    case 1:
-        /* [ms] */
-        t_unit_factor = 1e3;
-        break;
-    case 2:
-    default:
-        /* [s] */
-        t_unit_factor = 1;
-        break;
-    }
-
-    return t_unit_factor;
-}
-
-
 /*----------------------------------------------------------------------------------*/
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
                     float ch1_max_adc_v, float ch2_max_adc_v,
@@ -1005,8 +999,7 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
                     int ch1_probe_att, int ch2_probe_att, int ch1_gain, int ch2_gain, int en_avg_at_dec)
 {
     const int c_noise_thr = 500; /* noise threshold */
-    rp_osc_worker_state_t old_state, state;
-    int params_dirty;
+    rp_osc_wait_t wait = { 0 };
     /* Min/maxes from both channel */
     int max_cha = INT_MIN;
     int max_chb = INT_MIN;
@@ -1028,7 +1021,7 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
     for (iter=0; iter < 10; iter++) {
         /* 10 auto-trigger acquisitions */
         pthread_mutex_lock(&rp_osc_ctrl_mutex);
-        old_state = state = rp_osc_ctrl;
+        wait.old_state = rp_osc_ctrl;
         pthread_mutex_unlock(&rp_osc_ctrl_mutex);
 
         osc_fpga_reset();
@@ -1044,20 +1037,9 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
         osc_fpga_set_trigger(1);
 
         /* Wait for trigger to finish */
-        while(1) {
-            pthread_mutex_lock(&rp_osc_ctrl_mutex);
-            state = rp_osc_ctrl;
-            params_dirty = rp_osc_params_dirty;
-            pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                return -1;
-            }
-            if(osc_fpga_triggered()) {
-                break;
-            }
-            usleep(500);
-        }
+        if(rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                             rp_osc_wait_abort, &wait, -1))
+            return -1;
 
         /* Get the signals - available at rp_fpga_chX_signal vectors */
         for(smpl_cnt = 0; smpl_cnt < OSC_FPGA_SIG_LEN; smpl_cnt++) {
@@ -1215,21 +1197,9 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
 
             /* Wait for trigger */
             /* Wait for trigger to finish */
-            while(1) {
-                pthread_mutex_lock(&rp_osc_ctrl_mutex);
-                state = rp_osc_ctrl;
-                params_dirty = rp_osc_params_dirty;
-                pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    return -1;
-                }
-                if(osc_fpga_triggered()) {
-                    break;
-                }    
-                usleep(500);
-            }
+            if(rp_acq_event_wait(&rp_osc_event, rp_osc_wait_trigger,
+                                 rp_osc_wait_abort, &wait, -1))
+                return -1;
 
             // Checking where acquisition starts
             osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
@@ -1239,11 +1209,13 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
             int dec_factor = osc_fpga_cnv_time_range_to_dec(time_range);
 
             rp_osc_meas_res_t meas;
-            rp_osc_meas_clear(&meas);
+            rp_acq_meas_clear(&meas);
             meas.min = min_y;
             meas.max = max_y;
 
-            meas_period(&meas, sig_data, wr_ptr_trig, dec_factor, &loc_min, &loc_max);
+            rp_acq_meas_period(&meas, sig_data, OSC_FPGA_SIG_LEN, wr_ptr_trig,
+                               c_osc_fpga_smpl_freq, dec_factor,
+                               &loc_min, &loc_max);
             period = meas.period;
             TRACE("AUTO: period = %.6f\n", period);
 
@@ -1317,55 +1289,6 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
 }
 
 
-/*----------------------------------------------------------------------------------*/
-int rp_osc_meas_clear(rp_osc_meas_res_t *ch_meas)
-{
-    ch_meas->min = 1e9;
-    ch_meas->max = -1e9;
-    ch_meas->amp = 0;
-    ch_meas->avg = 0;
-    ch_meas->freq = 0;
-    ch_meas->period = 0;
-
-    return 0;
-}
-
-
-/*----------------------------------------------------------------------------------*/
-inline int rp_osc_adc_sign(int in_data)
-{
-    int s_data = in_data;
-    if(s_data & (1<<(c_osc_fpga_adc_bits-1)))
-        s_data = -1 * ((s_data ^ ((1<<c_osc_fpga_adc_bits)-1)) + 1);
-    return s_data;
-}
-
-
-/*----------------------------------------------------------------------------------*/
-int rp_osc_meas_min_max(rp_osc_meas_res_t *ch_meas, int sig_data)
-{
-    int s_data = rp_osc_adc_sign(sig_data);
-
-    if(ch_meas->min > s_data)
-        ch_meas->min = s_data;
-    if(ch_meas->max < s_data)
-        ch_meas->max = s_data;
-
-    ch_meas->avg += s_data;
-
-    return 0;
-}
-
-
-/*----------------------------------------------------------------------------------*/
-int rp_osc_meas_avg_amp(rp_osc_meas_res_t *ch_meas, int avg_len)
-{
-    ch_meas->avg /= avg_len;
-    ch_meas->amp = ch_meas->max - ch_meas->min;
-    return 0;
-}
-
-
 /*----------------------------------------------------------------------------------*/
 int rp_osc_meas_period(rp_osc_meas_res_t *ch1_meas, rp_osc_meas_res_t *ch2_meas, 
                        int *in_cha_signal, int *in_chb_signal, int dec_factor)
@@ -1376,106 +1299,10 @@ int rp_osc_meas_period(rp_osc_meas_res_t *ch1_meas, rp_osc_meas_res_t *ch2_meas,
     osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
 
     int min, max; // Ignored for measurement panel calculations
-    meas_period(ch1_meas, in_cha_signal, wr_ptr_trig, dec_factor, &min, &max);
-    meas_period(ch2_meas, in_chb_signal, wr_ptr_trig, dec_factor, &min, &max);
-
-    return 0;
-}
-
-/*----------------------------------------------------------------------------------*/
-int meas_period(rp_osc_meas_res_t *meas, int *in_signal, int wr_ptr_trig, int dec_factor,
-                int *min, int *max)
-{
-    const float c_meas_freq_thr = 100;
-    const int c_meas_time_thr = OSC_FPGA_SIG_LEN / 8;
-    const float c_min_period = 19.6e-9; // 51 MHz
-
-    float thr1, thr2, cen;
-    int state = 0;
-    int trig_t[2] = { 0, 0 };
-    int trig_cnt = 0;
-    int ix, ix_corr;
-
-    float acq_dur=(float)(OSC_FPGA_SIG_LEN)/((float) c_osc_fpga_smpl_freq) * (float) dec_factor;
-
-    cen = (meas->max + meas->min) / 2;
-
-    thr1 = cen + 0.2 * (meas->min - cen);
-    thr2 = cen + 0.2 * (meas->max - cen);
-
-    meas->period = 0;
-    *max = INT_MIN;
-    *min = INT_MAX;
-
-    for(ix = 0; ix < (OSC_FPGA_SIG_LEN); ix++) {
-        ix_corr = ix + wr_ptr_trig;
-
-        if (ix_corr >= OSC_FPGA_SIG_LEN) {
-            ix_corr %= OSC_FPGA_SIG_LEN;
-        }
-
-        int sa = rp_osc_adc_sign(in_signal[ix_corr]);
-
-        /* Another max, min calculation at lower rate to avoid evaluation errors on slower signals */
-        if (sa > *max)
-            *max = sa;
-        if (sa < *min)
-            *min = sa;
-
-        /* Lower transitions */
-        if((state == 0) && (ix_corr > 0) && (sa < thr1)) {
-            state = 1;
-        }
-
-        /* Upper transitions - count them & store edge times. */
-        if((state == 1) && (sa >= thr2) ) {
-            state = 0;
-            if (trig_cnt++ == 0) {
-                trig_t[0] = ix;
-            } else {
-                trig_t[1] = ix;
-            }
-        }
-
-        if ((trig_t[1] - trig_t[0]) > c_meas_time_thr) {
-            break;
-        }
-    }
-
-    /* Period calculation - taking into account at least meas_time_thr samples */
-    if(trig_cnt >= 2) {
-        meas->period = (trig_t[1] - trig_t[0]) /
-            ((float)c_osc_fpga_smpl_freq * (trig_cnt - 1)) * dec_factor;
-    }
-
-    if( ((thr2 - thr1) < c_meas_freq_thr) ||
-         (meas->period * 3 >= acq_dur)    ||
-         (meas->period < c_min_period) )
-    {
-        meas->period = 0;
-        meas->freq   = 0;
-    } else {
-        meas->freq = 1.0 / meas->period;
-    }
-
-    return 0;
-}
-
-
-/*----------------------------------------------------------------------------------*/
-inline float rp_osc_meas_cnv_cnt(float data, float adc_max_v)
-{
-    return (data * adc_max_v / (float)(1<<(c_osc_fpga_adc_bits-1)));
-}
-
-
-/*----------------------------------------------------------------------------------*/
-int rp_osc_meas_convert(rp_osc_meas_res_t *ch_meas, float adc_max_v, int32_t cal_dc_offs)
-{
-    ch_meas->min = rp_osc_meas_cnv_cnt(ch_meas->min+cal_dc_offs, adc_max_v);
-    ch_meas->max = rp_osc_meas_cnv_cnt(ch_meas->max+cal_dc_offs, adc_max_v);
-    ch_meas->amp = rp_osc_meas_cnv_cnt(ch_meas->amp, adc_max_v);
-    ch_meas->avg = rp_osc_meas_cnv_cnt(ch_meas->avg+cal_dc_offs, adc_max_v);
+    rp_acq_meas_period(ch1_meas, in_cha_signal, OSC_FPGA_SIG_LEN, wr_ptr_trig,
+                       c_osc_fpga_smpl_freq, dec_factor, &min, &max);
+    rp_acq_meas_period(ch2_meas, in_chb_signal, OSC_FPGA_SIG_LEN, wr_ptr_trig,
+                       c_osc_fpga_smpl_freq, dec_factor, &min, &max);
 
     return 0;
 }
@@ -0,0 +1,113 @@
+//-------------------------------------------------
+//      Redpitaya binary signal frames
+//
+//      Decodes the frames of the websocket server (rp_sdk/SignalFrame.h).
+//      Send {"signals_format": "f32"} ("f16", "i16", "delta") after the socket
+//      is opened, messages that are not frames are still gzipped JSON.
+//-------------------------------------------------
+
+(function(SignalFrame) {
+
+    var ENC_F32 = 0;
+    var ENC_I32 = 1;
+    var ENC_U8 = 2;
+    var ENC_F16 = 3;
+    var ENC_I16 = 4;
+    var ENC_DELTA = 5;
+
+    SignalFrame.isFrame = function(buffer) {
+        if (buffer.byteLength < 12)
+            return false;
+        var b = new Uint8Array(buffer, 0, 4);
+        return b[0] == 0x52 && b[1] == 0x50 && b[2] == 0x53 && b[3] == 0x47; // "RPSG"
+    };
+
+    function halfToFloat(h) {
+        var e = (h >> 10) & 0x1f;
+        var m = h & 0x3ff;
+        var v;
+        if (e == 0)
+            v = m * Math.pow(2, -24);
+        else if (e == 31)
+            v = m ? NaN : Infinity;
+        else
+            v = (1024 + m) * Math.pow(2, e - 25);
+        return (h & 0x8000) ? -v : v;
+    }
+
+    function decodeDelta(view, pos, size, scale, offset) {
+        var out = new Float32Array(size);
+        var q = 0;
+        for (var i = 0; i < size; i++) {
+            var d = view.getInt8(pos++);
+            if (d == -128) {
+                q = view.getInt16(pos, true);
+                pos += 2;
+            } else {
+                q += d;
+            }
+            out[i] = offset + q * scale;
+        }
+        return out;
+    }
+
+    // Returns {sequence, signals} with signals in the shape of the JSON messages: {name: {size, value}}
+    SignalFrame.decode = function(buffer) {
+        var view = new DataView(buffer);
+        var count = view.getUint16(6, true);
+        var result = {
+            sequence: view.getUint32(8, true),
+            signals: {}
+        };
+        var pos = 12;
+        for (var s = 0; s < count; s++) {
+            var nameSize = view.getUint16(pos, true);
+            var encoding = view.getUint8(pos + 2);
+            var size = view.getUint32(pos + 4, true);
+            var bytes = view.getUint32(pos + 8, true);
+            var scale = view.getFloat32(pos + 12, true);
+            var offset = view.getFloat32(pos + 16, true);
+            pos += 20;
+            var name = String.fromCharCode.apply(null, new Uint8Array(buffer, pos, nameSize));
+            pos += (nameSize + 3) & ~3;
+
+            var value;
+            switch (encoding) {
+                case ENC_F32:
+                    value = new Float32Array(buffer, pos, size);
+                    break;
+                case ENC_I32:
+                    value = new Int32Array(buffer, pos, size);
+                    break;
+                case ENC_U8:
+                    value = new Uint8Array(buffer, pos, size);
+                    break;
+                case ENC_F16:
+                    var half = new Uint16Array(buffer, pos, size);
+                    value = new Float32Array(size);
+                    for (var i = 0; i < size; i++)
+                        value[i] = halfToFloat(half[i]);
+                    break;
+                case ENC_I16:
+                    var q = new Int16Array(buffer, pos, size);
+                    value = new Float32Array(size);
+                    for (var i = 0; i < size; i++)
+                        value[i] = offset + q[i] * scale;
+                    break;
+                case ENC_DELTA:
+                    value = decodeDelta(view, pos, size, scale, offset);
+                    break;
+                default:
+                    console.log('Unknown signal encoding ' + encoding);
+                    value = [];
+            }
+            result.signals[name] = {
+                size: size,
+                value: value
+            };
+            pos += (bytes + 3) & ~3;
+        }
+        return result;
+    };
+
+}(window.SignalFrame = window.SignalFrame || {}));
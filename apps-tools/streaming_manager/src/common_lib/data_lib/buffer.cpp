@@ -137,6 +137,13 @@ auto CDataBuffer::recalcBufferLenght() -> void{
     m_lenght = m_samplesCount * m_bitBySample / 8;
 }
 
+// Reuses allocated memory for a different sample format. Size must fit into the allocated buffer
+auto CDataBuffer::setDataFormat(uint8_t bitsBySample,size_t samples) -> void{
+    m_bitBySample = bitsBySample;
+    m_samplesCount = samples;
+    recalcBufferLenght();
+}
+
 auto CDataBuffer::getBuffer() const -> std::shared_ptr<uint8_t[]>{
     return m_data;
 }
@@ -35,6 +35,7 @@ public:
     ~CDataBuffer();
 
     auto recalcBufferLenght() -> void;
+    auto setDataFormat(uint8_t bitsBySample,size_t samples) -> void;
     auto getBuffer() const -> std::shared_ptr<uint8_t[]>;
     auto getBufferLenght() const -> size_t;
     auto getBitBySample() const -> uint8_t;
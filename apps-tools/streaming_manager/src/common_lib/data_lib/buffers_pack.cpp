@@ -13,6 +13,7 @@ CDataBuffersPack::CDataBuffersPack():
      m_buffers()
     ,m_oscRate(0)
     ,m_adc_bits(0)
+    ,m_decimation(1)
 {
 }
 
@@ -50,6 +51,14 @@ auto CDataBuffersPack::getADCBits() -> uint8_t{
     return m_adc_bits;
 }
 
+auto CDataBuffersPack::setDecimation(uint32_t decimation) -> void{
+    m_decimation = decimation ? decimation : 1;
+}
+
+auto CDataBuffersPack::getDecimation() -> uint32_t{
+    return m_decimation;
+}
+
 auto CDataBuffersPack::checkBuffersEqual() -> bool{
     size_t size = 0;
     uint8_t bits = 0;
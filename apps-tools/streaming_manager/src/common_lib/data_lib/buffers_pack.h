@@ -33,6 +33,8 @@ public:
     auto getOSCRate() -> uint64_t;
     auto setADCBits(uint8_t bits) -> void;
     auto getADCBits() -> uint8_t;
+    auto setDecimation(uint32_t decimation) -> void;
+    auto getDecimation() -> uint32_t;
 
     auto checkBuffersEqual() -> bool;
     auto getBuffersLenght() -> size_t;
@@ -51,6 +53,7 @@ private:
     std::map<EDataBuffersPackChannel,CDataBuffer::Ptr> m_buffers;
     uint64_t m_oscRate; // Decimation
     uint8_t  m_adc_bits;
+    uint32_t m_decimation; // Software decimation applied on top of FPGA rate
 };
 
 }
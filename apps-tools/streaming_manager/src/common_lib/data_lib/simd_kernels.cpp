@@ -0,0 +1,675 @@
+#include <cmath>
+#include "simd_kernels.h"
+
+#if defined(ARCH_ARM) && defined(ARM_NEON)
+#define SIMD_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DataLib;
+
+// Each kernel runs the vector loop first and leaves the tail to the scalar loop from position i.
+
+namespace{
+
+template<typename T>
+auto interleave2Scalar(T *dst, const T *a, const T *b, size_t i, size_t n) -> void{
+    for(; i < n; i++){
+        dst[i * 2] = a[i];
+        dst[i * 2 + 1] = b[i];
+    }
+}
+
+template<typename T>
+auto interleave4Scalar(T *dst, const T *a, const T *b, const T *c, const T *d, size_t i, size_t n) -> void{
+    for(; i < n; i++){
+        dst[i * 4] = a[i];
+        dst[i * 4 + 1] = b[i];
+        dst[i * 4 + 2] = c[i];
+        dst[i * 4 + 3] = d[i];
+    }
+}
+
+template<typename T>
+auto deinterleave2Scalar(const T *src, T *a, T *b, size_t i, size_t n) -> void{
+    for(; i < n; i++){
+        a[i] = src[i * 2];
+        b[i] = src[i * 2 + 1];
+    }
+}
+
+template<typename T>
+auto deinterleave4Scalar(const T *src, T *a, T *b, T *c, T *d, size_t i, size_t n) -> void{
+    for(; i < n; i++){
+        a[i] = src[i * 4];
+        b[i] = src[i * 4 + 1];
+        c[i] = src[i * 4 + 2];
+        d[i] = src[i * 4 + 3];
+    }
+}
+
+template<typename T>
+auto toIntScalar(const float *src, T *dst, size_t i, size_t n, float scale, float lo, float hi) -> void{
+    for(; i < n; i++){
+        float v = src[i] * scale;
+        v = v > hi ? hi : v;
+        v = v < lo ? lo : v;
+        dst[i] = (T)lrintf(v);
+    }
+}
+
+template<typename T>
+auto minMaxScalar(const T *src, size_t i, size_t n, T *min, T *max) -> void{
+    for(; i < n; i++){
+        if (src[i] < *min) *min = src[i];
+        if (src[i] > *max) *max = src[i];
+    }
+}
+
+template<typename T>
+auto envelopeImpl(const T *src, size_t n, size_t bucketSize, T *min, T *max) -> size_t{
+    if (bucketSize == 0) return 0;
+    size_t count = 0;
+    for(size_t pos = 0; pos < n; pos += bucketSize, count++){
+        size_t len = n - pos < bucketSize ? n - pos : bucketSize;
+        DataLib::minMax(src + pos, len, &min[count], &max[count]);
+    }
+    return count;
+}
+
+#ifdef SIMD_SSE2
+
+inline auto load(const void *p) -> __m128i{
+    return _mm_loadu_si128((const __m128i*)p);
+}
+
+inline auto store(void *p, __m128i v) -> void{
+    _mm_storeu_si128((__m128i*)p, v);
+}
+
+// Even and odd elements of x:y
+inline auto deinterleave8(__m128i x, __m128i y, __m128i *even, __m128i *odd) -> void{
+    *even = _mm_packs_epi16(_mm_srai_epi16(_mm_slli_epi16(x, 8), 8), _mm_srai_epi16(_mm_slli_epi16(y, 8), 8));
+    *odd = _mm_packs_epi16(_mm_srai_epi16(x, 8), _mm_srai_epi16(y, 8));
+}
+
+inline auto deinterleave16(__m128i x, __m128i y, __m128i *even, __m128i *odd) -> void{
+    *even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(x, 16), 16), _mm_srai_epi32(_mm_slli_epi32(y, 16), 16));
+    *odd = _mm_packs_epi32(_mm_srai_epi32(x, 16), _mm_srai_epi32(y, 16));
+}
+
+// Sign extended halves of 8 int16 samples
+inline auto toFloat(__m128i v, __m128 scale, __m128 *lo, __m128 *hi) -> void{
+    *lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), scale);
+    *hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), scale);
+}
+
+// Default MXCSR rounding is to nearest even, same as lrintf
+inline auto toInt(const float *src, __m128 scale, __m128 lo, __m128 hi) -> __m128i{
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(src), scale);
+    v = _mm_max_ps(_mm_min_ps(v, hi), lo);
+    return _mm_cvtps_epi32(v);
+}
+
+#endif
+
+#ifdef SIMD_NEON
+
+inline auto toFloat(int16x8_t v, float scale, float32x4_t *lo, float32x4_t *hi) -> void{
+    *lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale);
+    *hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale);
+}
+
+// ARMv7 NEON converts with truncation. Adding and subtracting 1.5 * 2^23 rounds to nearest even first
+inline auto toInt(const float *src, float scale, float32x4_t lo, float32x4_t hi) -> int32x4_t{
+    const float32x4_t magic = vdupq_n_f32(12582912.0f);
+    float32x4_t v = vmulq_n_f32(vld1q_f32(src), scale);
+    v = vmaxq_f32(vminq_f32(v, hi), lo);
+    v = vsubq_f32(vaddq_f32(v, magic), magic);
+    return vcvtq_s32_f32(v);
+}
+
+#endif
+
+}
+
+auto DataLib::getSimdKernelsPath() -> const char*{
+#if defined(SIMD_NEON)
+    return "neon";
+#elif defined(SIMD_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+
+auto DataLib::interleave2(int8_t *dst, const int8_t *a, const int8_t *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 16 <= n; i += 16){
+        int8x16x2_t v = {{ vld1q_s8(a + i), vld1q_s8(b + i) }};
+        vst2q_s8(dst + i * 2, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 16 <= n; i += 16){
+        __m128i va = load(a + i);
+        __m128i vb = load(b + i);
+        store(dst + i * 2, _mm_unpacklo_epi8(va, vb));
+        store(dst + i * 2 + 16, _mm_unpackhi_epi8(va, vb));
+    }
+#endif
+    interleave2Scalar(dst, a, b, i, n);
+}
+
+auto DataLib::interleave2(int16_t *dst, const int16_t *a, const int16_t *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        int16x8x2_t v = {{ vld1q_s16(a + i), vld1q_s16(b + i) }};
+        vst2q_s16(dst + i * 2, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 8 <= n; i += 8){
+        __m128i va = load(a + i);
+        __m128i vb = load(b + i);
+        store(dst + i * 2, _mm_unpacklo_epi16(va, vb));
+        store(dst + i * 2 + 8, _mm_unpackhi_epi16(va, vb));
+    }
+#endif
+    interleave2Scalar(dst, a, b, i, n);
+}
+
+auto DataLib::interleave2(float *dst, const float *a, const float *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 4 <= n; i += 4){
+        float32x4x2_t v = {{ vld1q_f32(a + i), vld1q_f32(b + i) }};
+        vst2q_f32(dst + i * 2, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 4 <= n; i += 4){
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(va, vb));
+        _mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(va, vb));
+    }
+#endif
+    interleave2Scalar(dst, a, b, i, n);
+}
+
+auto DataLib::interleave4(int8_t *dst, const int8_t *a, const int8_t *b, const int8_t *c, const int8_t *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 16 <= n; i += 16){
+        int8x16x4_t v = {{ vld1q_s8(a + i), vld1q_s8(b + i), vld1q_s8(c + i), vld1q_s8(d + i) }};
+        vst4q_s8(dst + i * 4, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 16 <= n; i += 16){
+        __m128i va = load(a + i);
+        __m128i vb = load(b + i);
+        __m128i vc = load(c + i);
+        __m128i vd = load(d + i);
+        __m128i acLo = _mm_unpacklo_epi8(va, vc);
+        __m128i acHi = _mm_unpackhi_epi8(va, vc);
+        __m128i bdLo = _mm_unpacklo_epi8(vb, vd);
+        __m128i bdHi = _mm_unpackhi_epi8(vb, vd);
+        store(dst + i * 4,      _mm_unpacklo_epi8(acLo, bdLo));
+        store(dst + i * 4 + 16, _mm_unpackhi_epi8(acLo, bdLo));
+        store(dst + i * 4 + 32, _mm_unpacklo_epi8(acHi, bdHi));
+        store(dst + i * 4 + 48, _mm_unpackhi_epi8(acHi, bdHi));
+    }
+#endif
+    interleave4Scalar(dst, a, b, c, d, i, n);
+}
+
+auto DataLib::interleave4(int16_t *dst, const int16_t *a, const int16_t *b, const int16_t *c, const int16_t *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        int16x8x4_t v = {{ vld1q_s16(a + i), vld1q_s16(b + i), vld1q_s16(c + i), vld1q_s16(d + i) }};
+        vst4q_s16(dst + i * 4, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 8 <= n; i += 8){
+        __m128i va = load(a + i);
+        __m128i vb = load(b + i);
+        __m128i vc = load(c + i);
+        __m128i vd = load(d + i);
+        __m128i acLo = _mm_unpacklo_epi16(va, vc);
+        __m128i acHi = _mm_unpackhi_epi16(va, vc);
+        __m128i bdLo = _mm_unpacklo_epi16(vb, vd);
+        __m128i bdHi = _mm_unpackhi_epi16(vb, vd);
+        store(dst + i * 4,      _mm_unpacklo_epi16(acLo, bdLo));
+        store(dst + i * 4 + 8,  _mm_unpackhi_epi16(acLo, bdLo));
+        store(dst + i * 4 + 16, _mm_unpacklo_epi16(acHi, bdHi));
+        store(dst + i * 4 + 24, _mm_unpackhi_epi16(acHi, bdHi));
+    }
+#endif
+    interleave4Scalar(dst, a, b, c, d, i, n);
+}
+
+auto DataLib::interleave4(float *dst, const float *a, const float *b, const float *c, const float *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 4 <= n; i += 4){
+        float32x4x4_t v = {{ vld1q_f32(a + i), vld1q_f32(b + i), vld1q_f32(c + i), vld1q_f32(d + i) }};
+        vst4q_f32(dst + i * 4, v);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 4 <= n; i += 4){
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        __m128 vc = _mm_loadu_ps(c + i);
+        __m128 vd = _mm_loadu_ps(d + i);
+        _MM_TRANSPOSE4_PS(va, vb, vc, vd);
+        _mm_storeu_ps(dst + i * 4,      va);
+        _mm_storeu_ps(dst + i * 4 + 4,  vb);
+        _mm_storeu_ps(dst + i * 4 + 8,  vc);
+        _mm_storeu_ps(dst + i * 4 + 12, vd);
+    }
+#endif
+    interleave4Scalar(dst, a, b, c, d, i, n);
+}
+
+auto DataLib::deinterleave2(const int8_t *src, int8_t *a, int8_t *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 16 <= n; i += 16){
+        int8x16x2_t v = vld2q_s8(src + i * 2);
+        vst1q_s8(a + i, v.val[0]);
+        vst1q_s8(b + i, v.val[1]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 16 <= n; i += 16){
+        __m128i va, vb;
+        deinterleave8(load(src + i * 2), load(src + i * 2 + 16), &va, &vb);
+        store(a + i, va);
+        store(b + i, vb);
+    }
+#endif
+    deinterleave2Scalar(src, a, b, i, n);
+}
+
+auto DataLib::deinterleave2(const int16_t *src, int16_t *a, int16_t *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        int16x8x2_t v = vld2q_s16(src + i * 2);
+        vst1q_s16(a + i, v.val[0]);
+        vst1q_s16(b + i, v.val[1]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 8 <= n; i += 8){
+        __m128i va, vb;
+        deinterleave16(load(src + i * 2), load(src + i * 2 + 8), &va, &vb);
+        store(a + i, va);
+        store(b + i, vb);
+    }
+#endif
+    deinterleave2Scalar(src, a, b, i, n);
+}
+
+auto DataLib::deinterleave2(const float *src, float *a, float *b, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 4 <= n; i += 4){
+        float32x4x2_t v = vld2q_f32(src + i * 2);
+        vst1q_f32(a + i, v.val[0]);
+        vst1q_f32(b + i, v.val[1]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 4 <= n; i += 4){
+        __m128 x = _mm_loadu_ps(src + i * 2);
+        __m128 y = _mm_loadu_ps(src + i * 2 + 4);
+        _mm_storeu_ps(a + i, _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(b + i, _mm_shuffle_ps(x, y, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    deinterleave2Scalar(src, a, b, i, n);
+}
+
+auto DataLib::deinterleave4(const int8_t *src, int8_t *a, int8_t *b, int8_t *c, int8_t *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 16 <= n; i += 16){
+        int8x16x4_t v = vld4q_s8(src + i * 4);
+        vst1q_s8(a + i, v.val[0]);
+        vst1q_s8(b + i, v.val[1]);
+        vst1q_s8(c + i, v.val[2]);
+        vst1q_s8(d + i, v.val[3]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 16 <= n; i += 16){
+        __m128i ac0, bd0, ac1, bd1, va, vb, vc, vd;
+        deinterleave8(load(src + i * 4), load(src + i * 4 + 16), &ac0, &bd0);
+        deinterleave8(load(src + i * 4 + 32), load(src + i * 4 + 48), &ac1, &bd1);
+        deinterleave8(ac0, ac1, &va, &vc);
+        deinterleave8(bd0, bd1, &vb, &vd);
+        store(a + i, va);
+        store(b + i, vb);
+        store(c + i, vc);
+        store(d + i, vd);
+    }
+#endif
+    deinterleave4Scalar(src, a, b, c, d, i, n);
+}
+
+auto DataLib::deinterleave4(const int16_t *src, int16_t *a, int16_t *b, int16_t *c, int16_t *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        int16x8x4_t v = vld4q_s16(src + i * 4);
+        vst1q_s16(a + i, v.val[0]);
+        vst1q_s16(b + i, v.val[1]);
+        vst1q_s16(c + i, v.val[2]);
+        vst1q_s16(d + i, v.val[3]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 8 <= n; i += 8){
+        __m128i ac0, bd0, ac1, bd1, va, vb, vc, vd;
+        deinterleave16(load(src + i * 4), load(src + i * 4 + 8), &ac0, &bd0);
+        deinterleave16(load(src + i * 4 + 16), load(src + i * 4 + 24), &ac1, &bd1);
+        deinterleave16(ac0, ac1, &va, &vc);
+        deinterleave16(bd0, bd1, &vb, &vd);
+        store(a + i, va);
+        store(b + i, vb);
+        store(c + i, vc);
+        store(d + i, vd);
+    }
+#endif
+    deinterleave4Scalar(src, a, b, c, d, i, n);
+}
+
+auto DataLib::deinterleave4(const float *src, float *a, float *b, float *c, float *d, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 4 <= n; i += 4){
+        float32x4x4_t v = vld4q_f32(src + i * 4);
+        vst1q_f32(a + i, v.val[0]);
+        vst1q_f32(b + i, v.val[1]);
+        vst1q_f32(c + i, v.val[2]);
+        vst1q_f32(d + i, v.val[3]);
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 4 <= n; i += 4){
+        __m128 va = _mm_loadu_ps(src + i * 4);
+        __m128 vb = _mm_loadu_ps(src + i * 4 + 4);
+        __m128 vc = _mm_loadu_ps(src + i * 4 + 8);
+        __m128 vd = _mm_loadu_ps(src + i * 4 + 12);
+        _MM_TRANSPOSE4_PS(va, vb, vc, vd);
+        _mm_storeu_ps(a + i, va);
+        _mm_storeu_ps(b + i, vb);
+        _mm_storeu_ps(c + i, vc);
+        _mm_storeu_ps(d + i, vd);
+    }
+#endif
+    deinterleave4Scalar(src, a, b, c, d, i, n);
+}
+
+auto DataLib::convert(const int8_t *src, int16_t *dst, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        vst1q_s16(dst + i, vshll_n_s8(vld1_s8(src + i), 8));
+    }
+#elif defined(SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= n; i += 16){
+        __m128i v = load(src + i);
+        store(dst + i, _mm_unpacklo_epi8(zero, v));
+        store(dst + i + 8, _mm_unpackhi_epi8(zero, v));
+    }
+#endif
+    for(; i < n; i++){
+        dst[i] = src[i] * 256;
+    }
+}
+
+auto DataLib::convert(const int16_t *src, int8_t *dst, size_t n) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        vst1_s8(dst + i, vshrn_n_s16(vld1q_s16(src + i), 8));
+    }
+#elif defined(SIMD_SSE2)
+    for(; i + 16 <= n; i += 16){
+        store(dst + i, _mm_packs_epi16(_mm_srai_epi16(load(src + i), 8), _mm_srai_epi16(load(src + i + 8), 8)));
+    }
+#endif
+    for(; i < n; i++){
+        dst[i] = src[i] >> 8;
+    }
+}
+
+auto DataLib::convert(const int8_t *src, float *dst, size_t n, float scale) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        float32x4_t lo, hi;
+        toFloat(vmovl_s8(vld1_s8(src + i)), scale, &lo, &hi);
+        vst1q_f32(dst + i, lo);
+        vst1q_f32(dst + i + 4, hi);
+    }
+#elif defined(SIMD_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for(; i + 16 <= n; i += 16){
+        __m128i v = load(src + i);
+        __m128 f0, f1, f2, f3;
+        toFloat(_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8), vscale, &f0, &f1);
+        toFloat(_mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8), vscale, &f2, &f3);
+        _mm_storeu_ps(dst + i, f0);
+        _mm_storeu_ps(dst + i + 4, f1);
+        _mm_storeu_ps(dst + i + 8, f2);
+        _mm_storeu_ps(dst + i + 12, f3);
+    }
+#endif
+    for(; i < n; i++){
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+auto DataLib::convert(const int16_t *src, float *dst, size_t n, float scale) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    for(; i + 8 <= n; i += 8){
+        float32x4_t lo, hi;
+        toFloat(vld1q_s16(src + i), scale, &lo, &hi);
+        vst1q_f32(dst + i, lo);
+        vst1q_f32(dst + i + 4, hi);
+    }
+#elif defined(SIMD_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for(; i + 8 <= n; i += 8){
+        __m128 lo, hi;
+        toFloat(load(src + i), vscale, &lo, &hi);
+        _mm_storeu_ps(dst + i, lo);
+        _mm_storeu_ps(dst + i + 4, hi);
+    }
+#endif
+    for(; i < n; i++){
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+auto DataLib::convert(const float *src, int8_t *dst, size_t n, float scale) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    const float32x4_t lo = vdupq_n_f32(-128.0f);
+    const float32x4_t hi = vdupq_n_f32(127.0f);
+    for(; i + 8 <= n; i += 8){
+        int16x8_t v = vcombine_s16(vqmovn_s32(toInt(src + i, scale, lo, hi)), vqmovn_s32(toInt(src + i + 4, scale, lo, hi)));
+        vst1_s8(dst + i, vqmovn_s16(v));
+    }
+#elif defined(SIMD_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps(-128.0f);
+    const __m128 hi = _mm_set1_ps(127.0f);
+    for(; i + 16 <= n; i += 16){
+        __m128i v0 = _mm_packs_epi32(toInt(src + i, vscale, lo, hi), toInt(src + i + 4, vscale, lo, hi));
+        __m128i v1 = _mm_packs_epi32(toInt(src + i + 8, vscale, lo, hi), toInt(src + i + 12, vscale, lo, hi));
+        store(dst + i, _mm_packs_epi16(v0, v1));
+    }
+#endif
+    toIntScalar(src, dst, i, n, scale, -128.0f, 127.0f);
+}
+
+auto DataLib::convert(const float *src, int16_t *dst, size_t n, float scale) -> void{
+    size_t i = 0;
+#if defined(SIMD_NEON)
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    for(; i + 8 <= n; i += 8){
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(toInt(src + i, scale, lo, hi)), vqmovn_s32(toInt(src + i + 4, scale, lo, hi))));
+    }
+#elif defined(SIMD_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    for(; i + 8 <= n; i += 8){
+        store(dst + i, _mm_packs_epi32(toInt(src + i, vscale, lo, hi), toInt(src + i + 4, vscale, lo, hi)));
+    }
+#endif
+    toIntScalar(src, dst, i, n, scale, -32768.0f, 32767.0f);
+}
+
+auto DataLib::minMax(const int8_t *src, size_t n, int8_t *min, int8_t *max) -> void{
+    size_t i = 0;
+    *min = *max = src[0];
+#if defined(SIMD_NEON)
+    if (n >= 16){
+        int8x16_t vmin = vld1q_s8(src);
+        int8x16_t vmax = vmin;
+        for(i = 16; i + 16 <= n; i += 16){
+            int8x16_t v = vld1q_s8(src + i);
+            vmin = vminq_s8(vmin, v);
+            vmax = vmaxq_s8(vmax, v);
+        }
+        int8_t lo[16], hi[16];
+        vst1q_s8(lo, vmin);
+        vst1q_s8(hi, vmax);
+        for(int j = 0; j < 16; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#elif defined(SIMD_SSE2)
+    if (n >= 16){
+        // SSE2 has only unsigned byte min/max. Flipping the sign bit keeps the order
+        const __m128i sign = _mm_set1_epi8((char)0x80);
+        __m128i vmin = _mm_xor_si128(load(src), sign);
+        __m128i vmax = vmin;
+        for(i = 16; i + 16 <= n; i += 16){
+            __m128i v = _mm_xor_si128(load(src + i), sign);
+            vmin = _mm_min_epu8(vmin, v);
+            vmax = _mm_max_epu8(vmax, v);
+        }
+        int8_t lo[16], hi[16];
+        store(lo, _mm_xor_si128(vmin, sign));
+        store(hi, _mm_xor_si128(vmax, sign));
+        for(int j = 0; j < 16; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#endif
+    minMaxScalar(src, i, n, min, max);
+}
+
+auto DataLib::minMax(const int16_t *src, size_t n, int16_t *min, int16_t *max) -> void{
+    size_t i = 0;
+    *min = *max = src[0];
+#if defined(SIMD_NEON)
+    if (n >= 8){
+        int16x8_t vmin = vld1q_s16(src);
+        int16x8_t vmax = vmin;
+        for(i = 8; i + 8 <= n; i += 8){
+            int16x8_t v = vld1q_s16(src + i);
+            vmin = vminq_s16(vmin, v);
+            vmax = vmaxq_s16(vmax, v);
+        }
+        int16_t lo[8], hi[8];
+        vst1q_s16(lo, vmin);
+        vst1q_s16(hi, vmax);
+        for(int j = 0; j < 8; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#elif defined(SIMD_SSE2)
+    if (n >= 8){
+        __m128i vmin = load(src);
+        __m128i vmax = vmin;
+        for(i = 8; i + 8 <= n; i += 8){
+            __m128i v = load(src + i);
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+        }
+        int16_t lo[8], hi[8];
+        store(lo, vmin);
+        store(hi, vmax);
+        for(int j = 0; j < 8; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#endif
+    minMaxScalar(src, i, n, min, max);
+}
+
+auto DataLib::minMax(const float *src, size_t n, float *min, float *max) -> void{
+    size_t i = 0;
+    *min = *max = src[0];
+#if defined(SIMD_NEON)
+    if (n >= 4){
+        float32x4_t vmin = vld1q_f32(src);
+        float32x4_t vmax = vmin;
+        for(i = 4; i + 4 <= n; i += 4){
+            float32x4_t v = vld1q_f32(src + i);
+            vmin = vminq_f32(vmin, v);
+            vmax = vmaxq_f32(vmax, v);
+        }
+        float lo[4], hi[4];
+        vst1q_f32(lo, vmin);
+        vst1q_f32(hi, vmax);
+        for(int j = 0; j < 4; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#elif defined(SIMD_SSE2)
+    if (n >= 4){
+        __m128 vmin = _mm_loadu_ps(src);
+        __m128 vmax = vmin;
+        for(i = 4; i + 4 <= n; i += 4){
+            __m128 v = _mm_loadu_ps(src + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        float lo[4], hi[4];
+        _mm_storeu_ps(lo, vmin);
+        _mm_storeu_ps(hi, vmax);
+        for(int j = 0; j < 4; j++){
+            if (lo[j] < *min) *min = lo[j];
+            if (hi[j] > *max) *max = hi[j];
+        }
+    }
+#endif
+    minMaxScalar(src, i, n, min, max);
+}
+
+auto DataLib::envelope(const int8_t *src, size_t n, size_t bucketSize, int8_t *min, int8_t *max) -> size_t{
+    return envelopeImpl(src, n, bucketSize, min, max);
+}
+
+auto DataLib::envelope(const int16_t *src, size_t n, size_t bucketSize, int16_t *min, int16_t *max) -> size_t{
+    return envelopeImpl(src, n, bucketSize, min, max);
+}
+
+auto DataLib::envelope(const float *src, size_t n, size_t bucketSize, float *min, float *max) -> size_t{
+    return envelopeImpl(src, n, bucketSize, min, max);
+}
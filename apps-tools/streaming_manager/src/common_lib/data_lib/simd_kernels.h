@@ -0,0 +1,64 @@
+#ifndef DATA_LIB_SIMD_KERNELS_H
+#define DATA_LIB_SIMD_KERNELS_H
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * Channel kernels for sample buffers. The NEON path is used on ARM, SSE2 on x86.
+ * Other platforms use the scalar path. All paths give the same results.
+ * Pointers do not need to be aligned. Source and destination must not overlap.
+ *
+ * Sample format matches the FPGA data: 16-bit samples are signed,
+ * 8-bit samples are the high byte of the 16-bit sample.
+ */
+
+namespace DataLib {
+
+// dst = a0 b0 a1 b1 ...  n - samples per channel
+auto interleave2(int8_t  *dst, const int8_t  *a, const int8_t  *b, size_t n) -> void;
+auto interleave2(int16_t *dst, const int16_t *a, const int16_t *b, size_t n) -> void;
+auto interleave2(float   *dst, const float   *a, const float   *b, size_t n) -> void;
+
+// dst = a0 b0 c0 d0 a1 b1 c1 d1 ...
+auto interleave4(int8_t  *dst, const int8_t  *a, const int8_t  *b, const int8_t  *c, const int8_t  *d, size_t n) -> void;
+auto interleave4(int16_t *dst, const int16_t *a, const int16_t *b, const int16_t *c, const int16_t *d, size_t n) -> void;
+auto interleave4(float   *dst, const float   *a, const float   *b, const float   *c, const float   *d, size_t n) -> void;
+
+auto deinterleave2(const int8_t  *src, int8_t  *a, int8_t  *b, size_t n) -> void;
+auto deinterleave2(const int16_t *src, int16_t *a, int16_t *b, size_t n) -> void;
+auto deinterleave2(const float   *src, float   *a, float   *b, size_t n) -> void;
+
+auto deinterleave4(const int8_t  *src, int8_t  *a, int8_t  *b, int8_t  *c, int8_t  *d, size_t n) -> void;
+auto deinterleave4(const int16_t *src, int16_t *a, int16_t *b, int16_t *c, int16_t *d, size_t n) -> void;
+auto deinterleave4(const float   *src, float   *a, float   *b, float   *c, float   *d, size_t n) -> void;
+
+// 8-bit <-> 16-bit keeps the scale: the 8-bit sample is the high byte
+auto convert(const int8_t  *src, int16_t *dst, size_t n) -> void;
+auto convert(const int16_t *src, int8_t  *dst, size_t n) -> void;
+
+// Integer to float: dst = src * scale
+auto convert(const int8_t  *src, float *dst, size_t n, float scale) -> void;
+auto convert(const int16_t *src, float *dst, size_t n, float scale) -> void;
+
+// Float to integer: dst = src * scale, rounded to nearest and saturated
+auto convert(const float *src, int8_t  *dst, size_t n, float scale) -> void;
+auto convert(const float *src, int16_t *dst, size_t n, float scale) -> void;
+
+// Min and max of n samples. n must be above 0
+auto minMax(const int8_t  *src, size_t n, int8_t  *min, int8_t  *max) -> void;
+auto minMax(const int16_t *src, size_t n, int16_t *min, int16_t *max) -> void;
+auto minMax(const float   *src, size_t n, float   *min, float   *max) -> void;
+
+// Min/max envelope over buckets of bucketSize samples. The last bucket may be shorter.
+// Returns the number of buckets written to min and max
+auto envelope(const int8_t  *src, size_t n, size_t bucketSize, int8_t  *min, int8_t  *max) -> size_t;
+auto envelope(const int16_t *src, size_t n, size_t bucketSize, int16_t *min, int16_t *max) -> size_t;
+auto envelope(const float   *src, size_t n, size_t bucketSize, float   *min, float   *max) -> size_t;
+
+// Name of the compiled path: "neon", "sse2" or "scalar"
+auto getSimdKernelsPath() -> const char*;
+
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include "thread_sched.h"
+#include "thread_cout.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <alloca.h>
+#endif
+
+using namespace DataLib;
+
+namespace{
+    std::mutex   g_schedMtx;
+    SThreadSched g_sched[TR_COUNT];
+}
+
+auto DataLib::getThreadRoleName(EThreadRole role) -> const char*{
+    switch (role)
+    {
+        case TR_FPGA: return "fpga";
+        case TR_NET:  return "net";
+        case TR_ASIO: return "asio";
+        case TR_FILE: return "file";
+        default:      return "unknown";
+    }
+}
+
+auto DataLib::setThreadSched(EThreadRole role,const SThreadSched &sched) -> void{
+    if (role >= TR_COUNT) return;
+    std::lock_guard<std::mutex> lock(g_schedMtx);
+    g_sched[role] = sched;
+}
+
+auto DataLib::getThreadSched(EThreadRole role) -> SThreadSched{
+    if (role >= TR_COUNT) return SThreadSched();
+    std::lock_guard<std::mutex> lock(g_schedMtx);
+    return g_sched[role];
+}
+
+#ifdef __linux__
+static auto prefaultStack(int32_t sizeKb) -> void{
+    if (sizeKb <= 0) return;
+    size_t size = (size_t)sizeKb * 1024;
+    volatile uint8_t *stack = (volatile uint8_t*)alloca(size);
+    for(size_t i = 0; i < size; i += 4096){
+        stack[i] = 0;
+    }
+}
+#endif
+
+auto DataLib::applyThreadSched(EThreadRole role) -> bool{
+    auto sched = getThreadSched(role);
+    bool ret = true;
+#ifdef __linux__
+    if (sched.cpu >= 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(sched.cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0){
+            aprintf(stderr,"[Sched] Can't set cpu %d for %s thread: %s\n",sched.cpu,getThreadRoleName(role),strerror(err));
+            ret = false;
+        }
+    }
+    if (sched.priority > 0){
+        sched_param param;
+        param.sched_priority = sched.priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0){
+            aprintf(stderr,"[Sched] Can't set SCHED_FIFO %d for %s thread: %s\n",sched.priority,getThreadRoleName(role),strerror(err));
+            ret = false;
+        }
+    }
+    prefaultStack(sched.prefaultStackKb);
+#else
+    if (sched.cpu >= 0 || sched.priority > 0){
+        aprintf(stderr,"[Sched] Thread scheduling profile is not supported on this platform\n");
+        ret = false;
+    }
+#endif
+    return ret;
+}
+
+auto DataLib::lockProcessMemory() -> bool{
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0){
+        aprintf(stderr,"[Sched] mlockall failed: %s\n",strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto DataLib::steerIrq(const std::string &name, int32_t cpu) -> bool{
+#ifdef __linux__
+    if (name == "" || cpu < 0) return false;
+    std::ifstream interrupts("/proc/interrupts");
+    if (!interrupts.is_open()){
+        aprintf(stderr,"[Sched] Can't open /proc/interrupts\n");
+        return false;
+    }
+    bool found = false;
+    std::string line;
+    while(std::getline(interrupts,line)){
+        if (line.find(name) == std::string::npos) continue;
+        std::istringstream ss(line);
+        uint32_t irq = 0;
+        if (!(ss >> irq)) continue;
+        std::ofstream mask("/proc/irq/" + std::to_string(irq) + "/smp_affinity");
+        if (!mask.is_open()){
+            aprintf(stderr,"[Sched] Can't open smp_affinity for irq %d\n",irq);
+            continue;
+        }
+        mask << std::hex << (1u << cpu) << std::endl;
+        if (mask.fail()){
+            aprintf(stderr,"[Sched] Can't move irq %d to cpu %d\n",irq,cpu);
+            continue;
+        }
+        found = true;
+    }
+    if (!found){
+        aprintf(stderr,"[Sched] Irq %s not steered\n",name.c_str());
+    }
+    return found;
+#else
+    (void)name;
+    (void)cpu;
+    return false;
+#endif
+}
+
+
+CSchedStats::CSchedStats():
+    m_count(0),
+    m_sum(0),
+    m_max(0),
+    m_missed(0)
+{}
+
+auto CSchedStats::addLatency(uint64_t ns) -> void{
+    m_count++;
+    m_sum += ns;
+    auto max = m_max.load();
+    while(ns > max && !m_max.compare_exchange_weak(max,ns)){}
+}
+
+auto CSchedStats::addDeadline(uint64_t ns,uint64_t deadlineNs) -> void{
+    addLatency(ns);
+    if (ns > deadlineNs){
+        m_missed++;
+    }
+}
+
+auto CSchedStats::addMissed() -> void{
+    m_missed++;
+}
+
+auto CSchedStats::reset() -> void{
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+    m_missed = 0;
+}
+
+auto CSchedStats::getCount() -> uint64_t{
+    return m_count;
+}
+
+auto CSchedStats::getMaxLatency() -> uint64_t{
+    return m_max;
+}
+
+auto CSchedStats::getAvgLatency() -> uint64_t{
+    uint64_t count = m_count;
+    return count ? m_sum / count : 0;
+}
+
+auto CSchedStats::getMissed() -> uint64_t{
+    return m_missed;
+}
+
+auto CSchedStats::String() -> std::string{
+    std::stringstream ss;
+    ss << "count: " << getCount()
+       << " avg: " << getAvgLatency() / 1000 << " us"
+       << " max: " << getMaxLatency() / 1000 << " us"
+       << " missed: " << getMissed();
+    return ss.str();
+}
+
+
+CSchedLatencyProbe::CSchedLatencyProbe(EThreadRole role,uint32_t intervalUs):
+    m_role(role),
+    m_intervalUs(intervalUs),
+    m_thread(),
+    m_run(false),
+    m_stats()
+{}
+
+CSchedLatencyProbe::~CSchedLatencyProbe(){
+    stop();
+}
+
+auto CSchedLatencyProbe::start() -> void{
+    if (m_run) return;
+    m_stats.reset();
+    m_run = true;
+    m_thread = std::thread(&CSchedLatencyProbe::task, this);
+}
+
+auto CSchedLatencyProbe::stop() -> void{
+    m_run = false;
+    if (m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+auto CSchedLatencyProbe::getStats() -> CSchedStats&{
+    return m_stats;
+}
+
+auto CSchedLatencyProbe::task() -> void{
+    applyThreadSched(m_role);
+#ifdef __linux__
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while(m_run){
+        next.tv_nsec += m_intervalUs * 1000;
+        while(next.tv_nsec >= 1000000000){
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t late = (int64_t)(now.tv_sec - next.tv_sec) * 1000000000 + (now.tv_nsec - next.tv_nsec);
+        m_stats.addLatency(late > 0 ? late : 0);
+    }
+#else
+    auto next = std::chrono::steady_clock::now();
+    while(m_run){
+        next += std::chrono::microseconds(m_intervalUs);
+        std::this_thread::sleep_until(next);
+        auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - next).count();
+        m_stats.addLatency(late > 0 ? late : 0);
+    }
+#endif
+}
@@ -0,0 +1,97 @@
+#ifndef DATA_LIB_THREAD_SCHED_H
+#define DATA_LIB_THREAD_SCHED_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Scheduling profile of the streaming pipeline threads.
+ * The profile is set once by the application. Each pipeline thread applies
+ * its own entry when it starts, so libraries do not need to expose their threads.
+ * Without a profile the threads keep the default policy.
+ */
+
+namespace DataLib {
+
+enum EThreadRole{
+    TR_FPGA  = 0,   // ADC/DAC DMA worker
+    TR_NET   = 1,   // Pack sender
+    TR_ASIO  = 2,   // asio io_service
+    TR_FILE  = 3,   // File writer
+    TR_COUNT = 4
+};
+
+struct SThreadSched{
+    int32_t cpu = -1;               // CPU core. -1 = any core
+    int32_t priority = 0;           // SCHED_FIFO priority 1..99. 0 = SCHED_OTHER
+    int32_t prefaultStackKb = 0;    // Stack touched in advance, for use with lockProcessMemory
+};
+
+auto setThreadSched(EThreadRole role,const SThreadSched &sched) -> void;
+auto getThreadSched(EThreadRole role) -> SThreadSched;
+auto applyThreadSched(EThreadRole role) -> bool; // Apply to calling thread
+auto lockProcessMemory() -> bool;
+auto steerIrq(const std::string &name, int32_t cpu) -> bool;
+auto getThreadRoleName(EThreadRole role) -> const char*;
+
+
+/**
+ * Latency and deadline counters. Writers and readers may be on different threads.
+ */
+class CSchedStats final{
+
+public:
+    CSchedStats();
+
+    auto addLatency(uint64_t ns) -> void;
+    auto addDeadline(uint64_t ns,uint64_t deadlineNs) -> void;
+    auto addMissed() -> void;
+    auto reset() -> void;
+    auto String() -> std::string;
+
+    auto getCount() -> uint64_t;
+    auto getMaxLatency() -> uint64_t;
+    auto getAvgLatency() -> uint64_t;
+    auto getMissed() -> uint64_t;
+
+private:
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+    std::atomic<uint64_t> m_missed;
+};
+
+/**
+ * Measures scheduling latency like cyclictest: a thread with the profile of
+ * the given role wakes up on an absolute timer and records how late it runs.
+ */
+class CSchedLatencyProbe final{
+
+public:
+    CSchedLatencyProbe(EThreadRole role,uint32_t intervalUs = 1000);
+    ~CSchedLatencyProbe();
+
+    auto start() -> void;
+    auto stop() -> void;
+    auto getStats() -> CSchedStats&;
+
+private:
+    CSchedLatencyProbe(const CSchedLatencyProbe &) = delete;
+    CSchedLatencyProbe(CSchedLatencyProbe &&) = delete;
+    CSchedLatencyProbe& operator=(const CSchedLatencyProbe&) =delete;
+    CSchedLatencyProbe& operator=(const CSchedLatencyProbe&&) =delete;
+
+    auto task() -> void;
+
+    EThreadRole      m_role;
+    uint32_t         m_intervalUs;
+    std::thread      m_thread;
+    std::atomic_bool m_run;
+    CSchedStats      m_stats;
+};
+
+}
+
+#endif
@@ -93,9 +93,12 @@ auto CFileLogger::addMetric(DataLib::CDataBuffersPack::Ptr pack) -> void {
             auto buff = pack->getBuffer(ch);
             if (buff){                
                 m_fileLost << getName(ch) << ": Pos " << m_current_sample[ch] << " Get: " << buff->getSamplesCount() << " (" << buff->getLostSamplesAll() << ")\t";
-                m_current_sample[ch] += buff->getSamplesWithLost();
+                m_current_sample[ch] += buff->getSamplesWithLost() * pack->getDecimation();
             }
         }
+        if (pack->getDecimation() > 1){
+            m_fileLost << "Dec: " << pack->getDecimation();
+        }
         m_fileLost << "\n";
     }
 }
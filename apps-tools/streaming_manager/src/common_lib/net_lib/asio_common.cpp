@@ -43,8 +43,9 @@ auto createBeginPack(uint64_t _id,DataLib::CDataBuffersPack::Ptr pack) -> AsioBu
         uint64_t oscRate = pack->getOSCRate();
         uint64_t adcBits = pack->getADCBits();
         uint64_t buffersSize = pack->getLenghtAllBuffers();
+        uint64_t decimation = pack->getDecimation();
 
-        buffer_lenght += sizeof(uint64_t) * 5;
+        buffer_lenght += sizeof(uint64_t) * 6;
         // auto buff = std::shared_ptr<uint8_t[]>(new uint8_t[buffer_lenght]);
         // memcpy_neon(buff.get() ,net_lib::ID_PACK,16);
         memcpy_neon(bh.header,net_lib::ID_PACK,16);
@@ -53,7 +54,8 @@ auto createBeginPack(uint64_t _id,DataLib::CDataBuffersPack::Ptr pack) -> AsioBu
         buff64[3] = packId;
         buff64[4] = oscRate;
         buff64[5] = adcBits;
-        buff64[6] = buffersSize;          
+        buff64[6] = buffersSize;
+        buff64[7] = decimation;
         bh.headerLen = buffer_lenght;
         return bh;
     } catch (const std::bad_alloc& e) {
@@ -81,10 +83,13 @@ auto net_lib::extractBeginPack(uint8_t* _buffer,size_t _length,uint64_t *_id,siz
     uint64_t oscRate      = buff64[4];
     uint64_t adcBits      = buff64[5];
     uint64_t buffersSize  = buff64[6];
+    // Older servers do not send decimation
+    uint64_t decimation   = buff_size >= sizeof(int8_t) * 16 + sizeof(uint64_t) * 6 ? buff64[7] : 1;
 
     auto pack = DataLib::CDataBuffersPack::Create();
     pack->setADCBits(adcBits);
     pack->setOSCRate(oscRate);
+    pack->setDecimation(decimation);
 
     *_id = packId;
     *_allBuffersSize = buffersSize;
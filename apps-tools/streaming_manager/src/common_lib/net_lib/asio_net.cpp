@@ -46,6 +46,13 @@ auto CAsioNet::isConnected() -> bool{
     return  m_IsRun && m_server->isConnected();
 }
 
+auto CAsioNet::getSendQueueSize() -> int64_t{
+    if (m_server){
+        return m_server->getSendQueueSize();
+    }
+    return -1;
+}
+
 auto CAsioNet::start() -> void {
     if (m_IsRun)
         return;
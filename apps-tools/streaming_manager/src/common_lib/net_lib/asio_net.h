@@ -43,6 +43,7 @@ public:
     auto sendSyncData(AsioBufferNolder &_buffer) -> bool;
     auto getProtocol() -> net_lib::EProtocol;
     auto isConnected() -> bool;
+    auto getSendQueueSize() -> int64_t;
 
     sigslot::signal<string&>    serverConnectNotify;
     sigslot::signal<string&>    serverDisconnectNotify;
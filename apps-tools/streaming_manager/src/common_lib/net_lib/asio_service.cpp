@@ -1,6 +1,7 @@
  #include <functional>
 #include "asio_service.h"
 #include "data_lib/thread_cout.h"
+#include "data_lib/thread_sched.h"
 
 using namespace net_lib;
 
@@ -14,7 +15,10 @@ CAsioService::CAsioService():
     m_Ios(),
     m_Work(m_Ios),
     m_asio_th(nullptr){
-    auto func = std::bind(static_cast<size_t (asio::io_service::*)()>(&asio::io_service::run), &(m_Ios));
+    auto func = [this](){
+        DataLib::applyThreadSched(DataLib::TR_ASIO);
+        m_Ios.run();
+    };
     m_asio_th = new asio::thread(func);
 }
 
@@ -2,6 +2,11 @@
 #include "asio_socket.h"
 #include "data_lib/thread_cout.h"
 
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#endif
+
 #define UNUSED(x) [&x]{}()
 
 using namespace net_lib;
@@ -238,6 +243,21 @@ auto CAsioSocket::isConnected() -> bool{
     return false;
 }
 
+// Bytes written to the socket and not yet acknowledged by the peer. -1 if unknown
+auto CAsioSocket::getSendQueueSize() -> int64_t{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(m_mtx);
+    int value = 0;
+    if (m_tcp_socket && m_tcp_socket->is_open()) {
+        if (ioctl(m_tcp_socket->native_handle(), SIOCOUTQ, &value) == 0) return value;
+    }
+    if (m_udp_socket && m_udp_socket->is_open()) {
+        if (ioctl(m_udp_socket->native_handle(), SIOCOUTQ, &value) == 0) return value;
+    }
+#endif
+    return -1;
+}
+
 auto CAsioSocket::handlerAcceptFromClient(const asio::error_code &_error) -> void {
     if (!_error){
         connectServerNotify(m_tcp_endpoint.address().to_string());
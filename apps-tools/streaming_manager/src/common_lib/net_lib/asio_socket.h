@@ -38,6 +38,7 @@ public:
     auto initClient() -> void;
     auto closeSocket() -> void;
     auto isConnected() -> bool;
+    auto getSendQueueSize() -> int64_t;
     auto sendBuffer(net_buffer _buffer, size_t _size) -> void;
     auto sendBuffer(bool async,net_buffer _buffer, size_t _size) -> bool;
     auto sendSyncBuffer(AsioBufferNolder &_buffer) -> bool;
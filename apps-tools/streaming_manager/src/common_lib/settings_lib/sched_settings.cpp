@@ -0,0 +1,95 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include "sched_settings.h"
+#include "json/json.h"
+
+using namespace std;
+
+static auto readThread(const Json::Value &root,const char *name,SchedSettings::Thread *thread) -> void{
+    if (!root.isMember(name)) return;
+    auto obj = root[name];
+    if (!obj.isObject()){
+        std::cerr << "[SchedSettings] Can't parse " << name << " value: " << obj.toStyledString() << std::endl;
+        return;
+    }
+
+    if (obj.isMember("cpu")){
+        if (obj["cpu"].isInt()){
+            thread->cpu = obj["cpu"].asInt();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse " << name << ".cpu value: " << obj["cpu"].toStyledString() << std::endl;
+        }
+    }
+
+    if (obj.isMember("priority")){
+        if (obj["priority"].isInt() && obj["priority"].asInt() >= 0 && obj["priority"].asInt() <= 99){
+            thread->priority = obj["priority"].asInt();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse " << name << ".priority value: " << obj["priority"].toStyledString() << std::endl;
+        }
+    }
+}
+
+auto SchedSettings::readFromFile(string _filename,SchedSettings *settings) -> bool {
+    Json::Value root;
+    std::ifstream file(_filename , 	ios::in);
+    if (!file.is_open()) {
+        std::cerr << "file "<< _filename.c_str() <<" read failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    JSONCPP_STRING errs;
+    if (!parseFromStream(builder, file, &root, &errs)) {
+        std::cerr << "[SchedSettings] Error parse json" << errs << std::endl;
+        return false;
+    }
+
+    readThread(root,"fpga",&settings->fpga);
+    readThread(root,"net",&settings->net);
+    readThread(root,"asio",&settings->asio);
+    readThread(root,"file",&settings->file);
+
+    if (root.isMember("lock_memory")){
+        if (root["lock_memory"].isBool()){
+            settings->lock_memory = root["lock_memory"].asBool();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse lock_memory value: " << root["lock_memory"].toStyledString() << std::endl;
+        }
+    }
+
+    if (root.isMember("prefault_stack_kb")){
+        if (root["prefault_stack_kb"].isInt()){
+            settings->prefault_stack_kb = root["prefault_stack_kb"].asInt();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse prefault_stack_kb value: " << root["prefault_stack_kb"].toStyledString() << std::endl;
+        }
+    }
+
+    if (root.isMember("irq_cpu")){
+        if (root["irq_cpu"].isInt()){
+            settings->irq_cpu = root["irq_cpu"].asInt();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse irq_cpu value: " << root["irq_cpu"].toStyledString() << std::endl;
+        }
+    }
+
+    if (root.isMember("irq_name")){
+        if (root["irq_name"].isString()){
+            settings->irq_name = root["irq_name"].asString();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse irq_name value: " << root["irq_name"].toStyledString() << std::endl;
+        }
+    }
+
+    if (root.isMember("diagnostics")){
+        if (root["diagnostics"].isBool()){
+            settings->diagnostics = root["diagnostics"].asBool();
+        }else{
+            std::cerr << "[SchedSettings] Can't parse diagnostics value: " << root["diagnostics"].toStyledString() << std::endl;
+        }
+    }
+    return true;
+}
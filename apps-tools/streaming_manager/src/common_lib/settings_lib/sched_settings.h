@@ -0,0 +1,32 @@
+#ifndef SETTINGS_LIB_SCHEDSETTINGS_H
+#define SETTINGS_LIB_SCHEDSETTINGS_H
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * Real-time profile of the streaming server. It is kept apart from
+ * CStreamSettings because it is local to the board and is never sent to clients.
+ */
+
+struct SchedSettings {
+
+    struct Thread {
+        int32_t cpu = -1;
+        int32_t priority = 0;
+    };
+
+    Thread      fpga;
+    Thread      net;
+    Thread      asio;
+    Thread      file;
+    bool        lock_memory = false;
+    int32_t     prefault_stack_kb = 0;
+    int32_t     irq_cpu = -1;
+    std::string irq_name = "rp_oscilloscope";
+    bool        diagnostics = false;
+
+    static auto readFromFile(std::string _filename,SchedSettings *settings) -> bool;
+};
+
+#endif
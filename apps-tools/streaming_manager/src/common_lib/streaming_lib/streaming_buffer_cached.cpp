@@ -16,6 +16,9 @@ auto CStreamingBufferCached::create(uint32_t maxRamSize) -> CStreamingBufferCach
 
 CStreamingBufferCached::CStreamingBufferCached(uint32_t maxRamSize) :
     m_buffers(),
+    m_ringStart(0),
+    m_ringEnd(0),
+    m_ringSize(0),
     m_maxRamSize(0),
 //    m_currentRamSize(0),
     m_needDestroy(false),
@@ -79,11 +82,13 @@ auto CStreamingBufferCached::isWaitToDestory() -> bool{
 }
 
 inline auto CStreamingBufferCached::getFreeSize() -> uint32_t{
-    return m_ringSize - (m_ringEnd < m_ringStart ? ((m_ringEnd + m_ringSize) - m_ringStart) : (m_ringEnd - m_ringSize));
+    return m_ringSize - (m_ringEnd < m_ringStart ? ((m_ringEnd + m_ringSize) - m_ringStart) : (m_ringEnd - m_ringStart));
 }
 
 auto CStreamingBufferCached::fullPercent() -> float{
-    auto usedBuff = (m_ringEnd < m_ringStart ? ((m_ringEnd + m_ringSize) - m_ringStart) : (m_ringEnd - m_ringSize));
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_ringSize == 0) return 0;
+    auto usedBuff = (m_ringEnd < m_ringStart ? ((m_ringEnd + m_ringSize) - m_ringStart) : (m_ringEnd - m_ringStart));
     return (float)usedBuff / (float)m_ringSize;
 }
 
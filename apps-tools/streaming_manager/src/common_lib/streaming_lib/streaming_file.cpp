@@ -78,6 +78,7 @@ CStreamingFile::CStreamingFile(CStreamSettings::DataFormat _fileType,std::string
     m_file_out(""),
     m_samples(_samples),
     m_passSizeSamples(),
+    m_streamBits(),
     m_testMode(testMode),
     m_volt_mode(_v_mode),
     m_disableNotify(false),
@@ -158,6 +159,65 @@ auto CStreamingFile::stop() -> void {
     stop(CStreamingFile::NORMAL);
 }
 
+template<typename S,typename D>
+static auto expandSamples(D *dst,const S *src,size_t samples,uint32_t decimation,int shift) -> void{
+    for(size_t i = 0; i < samples; i++){
+        D value = (D)(src[i] * (1 << shift));
+        for(uint32_t j = 0; j < decimation; j++){
+            *dst++ = value;
+        }
+    }
+}
+
+// Packs reduced by server flow control are returned to the format of the stream start.
+// Samples are repeated and 8-bit samples are shifted to 16 bit, so files keep one rate and sample size.
+auto CStreamingFile::restorePack(DataLib::CDataBuffersPack::Ptr pack) -> DataLib::CDataBuffersPack::Ptr{
+    uint32_t decimation = pack->getDecimation();
+    bool needRestore = decimation > 1;
+    for(auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++){
+        DataLib::EDataBuffersPackChannel ch = (DataLib::EDataBuffersPackChannel)i;
+        auto buff = pack->getBuffer(ch);
+        if (!buff) continue;
+        if (m_streamBits.find(ch) == m_streamBits.end()){
+            m_streamBits[ch] = buff->getBitBySample();
+        }
+        if (m_streamBits[ch] != buff->getBitBySample()){
+            needRestore = true;
+        }
+    }
+    if (!needRestore) return pack;
+
+    auto newPack = DataLib::CDataBuffersPack::Create();
+    newPack->setOSCRate(pack->getOSCRate() * decimation);
+    newPack->setADCBits(pack->getADCBits());
+    for(auto i = (int)DataLib::CH1; i <= (int)DataLib::CH4; i++){
+        DataLib::EDataBuffersPackChannel ch = (DataLib::EDataBuffersPackChannel)i;
+        auto buff = pack->getBuffer(ch);
+        if (!buff) continue;
+        auto srcBits = buff->getBitBySample();
+        auto dstBits = m_streamBits[ch];
+        auto samples = buff->getSamplesCount();
+        auto destSize = samples * decimation * (dstBits / 8);
+        auto dest = net_lib::createBuffer(destSize);
+        if (!dest) return pack;
+        auto src = buff->getBuffer().get();
+        int shift = dstBits > srcBits ? dstBits - srcBits : 0;
+        if (srcBits == 8 && dstBits == 8){
+            expandSamples((int8_t*)dest.get(),(const int8_t*)src,samples,decimation,0);
+        }else if (srcBits == 8){
+            expandSamples((int16_t*)dest.get(),(const int8_t*)src,samples,decimation,shift);
+        }else{
+            expandSamples((int16_t*)dest.get(),(const int16_t*)src,samples,decimation,0);
+        }
+        auto newBuff = DataLib::CDataBuffer::Create(dest,destSize,dstBits);
+        newBuff->setADCMode(buff->getADCMode());
+        newBuff->setLostSamples(DataLib::FPGA,buff->getLostSamples(DataLib::FPGA) * decimation);
+        newBuff->setLostSamples(DataLib::RP_INTERNAL_BUFFER,buff->getLostSamples(DataLib::RP_INTERNAL_BUFFER) * decimation);
+        newPack->addBuffer(ch,newBuff);
+    }
+    return newPack;
+}
+
 auto CStreamingFile::convertBuffers(DataLib::CDataBuffersPack::Ptr pack, DataLib::EDataBuffersPackChannel channel,bool lockADCTo1V) -> SBuffPass {
     auto src_buff = pack->getBuffer(channel);
     if (!src_buff){
@@ -248,6 +308,8 @@ auto CStreamingFile::getCSVFileName() -> std::string{
 
 auto CStreamingFile::passBuffers(DataLib::CDataBuffersPack::Ptr pack) -> int {
     if (!pack) return 0;
+    auto receivedPack = pack;
+    pack = restorePack(pack);
     if (m_fileType == CStreamSettings::TDMS) {
         // _adc_mode = 0 for 1:1 and 1 for 1:20 mode
 
@@ -373,7 +435,7 @@ auto CStreamingFile::passBuffers(DataLib::CDataBuffersPack::Ptr pack) -> int {
         }
     }
     m_fileLogger->addMetric(CFileLogger::EMetric::OSC_RATE,pack->getOSCRate());
-    m_fileLogger->addMetric(pack);
+    m_fileLogger->addMetric(receivedPack);
 
     if (m_samples){
         bool reachLimits = true;
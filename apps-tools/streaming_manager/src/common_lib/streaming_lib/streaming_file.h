@@ -76,6 +76,7 @@ private:
     uint64_t          m_samples;
     std::mutex        m_stopMtx;
     std::map<DataLib::EDataBuffersPackChannel,uint64_t> m_passSizeSamples;
+    std::map<DataLib::EDataBuffersPackChannel,uint8_t>  m_streamBits;
     
     bool m_testMode;
     bool m_volt_mode;
@@ -84,6 +85,7 @@ private:
     CStreamSettings::DataFormat m_fileType;
 
     auto stop(EStopReason reason) -> void;
+    auto restorePack(DataLib::CDataBuffersPack::Ptr pack) -> DataLib::CDataBuffersPack::Ptr;
     auto convertBuffers(DataLib::CDataBuffersPack::Ptr pack, DataLib::EDataBuffersPackChannel channel,bool lockADCTo1V) -> SBuffPass;
 };
 
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include "streaming_flow_control.h"
+
+using namespace streaming_lib;
+
+#define FC_FILL_HIGH        0.5f
+#define FC_FILL_CONGESTED   0.25f
+#define FC_FILL_LOW         0.05f
+#define FC_SEND_QUEUE_HIGH  (256 * 1024)
+#define FC_SEND_QUEUE_LOW   (32 * 1024)
+#define FC_RATE_PERIOD_MS   250
+#define FC_STEP_UP_MS       250
+#define FC_HOLD_MIN_MS      2000
+#define FC_HOLD_MAX_MS      60000
+
+auto CStreamingFlowControl::create(EPolicy policy,uint8_t bitsBySample,uint32_t maxDecimation) -> CStreamingFlowControl::Ptr{
+
+    return std::make_shared<CStreamingFlowControl>(policy,bitsBySample,maxDecimation);
+}
+
+CStreamingFlowControl::CStreamingFlowControl(EPolicy policy,uint8_t bitsBySample,uint32_t maxDecimation):
+    m_policy(policy),
+    m_bits(bitsBySample),
+    m_maxLevel(0),
+    m_level(0),
+    m_drainRate(0),
+    m_mtx(),
+    m_sentBytes(0),
+    m_holdTime(FC_HOLD_MIN_MS),
+    m_rateTime(std::chrono::steady_clock::now()),
+    m_levelTime(m_rateTime),
+    m_stepDown(false)
+{
+    uint32_t decimationSteps = 0;
+    for(uint32_t d = 2; d <= maxDecimation; d *= 2){
+        decimationSteps++;
+    }
+    bool canPack = m_bits == 16;
+
+    switch (m_policy)
+    {
+        case FC_8BIT:
+            m_maxLevel = canPack ? 1 : 0;
+            break;
+        case FC_DECIMATE:
+            m_maxLevel = decimationSteps;
+            break;
+        case FC_AUTO:
+            m_maxLevel = decimationSteps + (canPack ? 1 : 0);
+            break;
+        default:
+            m_maxLevel = 0;
+            break;
+    }
+}
+
+CStreamingFlowControl::~CStreamingFlowControl(){
+}
+
+auto CStreamingFlowControl::getPolicy() -> EPolicy{
+    return m_policy;
+}
+
+auto CStreamingFlowControl::getLevel() -> uint32_t{
+    return m_level;
+}
+
+auto CStreamingFlowControl::getDrainRate() -> uint64_t{
+    return m_drainRate;
+}
+
+auto CStreamingFlowControl::levelToFormat(uint32_t level,uint8_t *bitsBySample,uint32_t *decimation) -> void{
+    *bitsBySample = m_bits;
+    *decimation = 1;
+    if (level == 0) return;
+
+    // 8-bit packing is the first step, because it halves the traffic and keeps the bandwidth
+    if ((m_policy == FC_8BIT || m_policy == FC_AUTO) && m_bits == 16){
+        *bitsBySample = 8;
+        level--;
+    }
+
+    if (m_policy == FC_DECIMATE || m_policy == FC_AUTO){
+        *decimation = 1u << level;
+    }
+}
+
+auto CStreamingFlowControl::getFormat(uint8_t *bitsBySample,uint32_t *decimation) -> void{
+    levelToFormat(m_level,bitsBySample,decimation);
+}
+
+auto CStreamingFlowControl::setLevel(uint32_t level) -> void{
+    m_level = level;
+    uint8_t  bits = 0;
+    uint32_t decimation = 0;
+    levelToFormat(level,&bits,&decimation);
+    levelChangedNotify(level,bits,decimation);
+}
+
+auto CStreamingFlowControl::update(float bufferFill,uint64_t sentBytes,int64_t sendQueue) -> void{
+    if (m_maxLevel == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto now = std::chrono::steady_clock::now();
+
+    m_sentBytes += sentBytes;
+    auto ratePeriod = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_rateTime).count();
+    if (ratePeriod >= FC_RATE_PERIOD_MS){
+        m_drainRate = m_sentBytes * 1000 / ratePeriod;
+        m_sentBytes = 0;
+        m_rateTime = now;
+    }
+
+    // Send queue is -1 when the platform does not report it
+    bool queueFull = sendQueue >= FC_SEND_QUEUE_HIGH;
+    bool queueEmpty = sendQueue < FC_SEND_QUEUE_LOW;
+    bool congested = bufferFill >= FC_FILL_HIGH || (bufferFill >= FC_FILL_CONGESTED && queueFull);
+    bool idle = bufferFill <= FC_FILL_LOW && queueEmpty;
+
+    auto sinceChange = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_levelTime);
+    uint32_t level = m_level;
+
+    if (congested && level < m_maxLevel && sinceChange.count() >= FC_STEP_UP_MS){
+        // Client did not keep up with the previous step down. Wait longer before next try
+        if (m_stepDown && sinceChange < m_holdTime * 2){
+            m_holdTime = std::min(m_holdTime * 2,std::chrono::milliseconds(FC_HOLD_MAX_MS));
+        }
+        m_stepDown = false;
+        m_levelTime = now;
+        setLevel(level + 1);
+        return;
+    }
+
+    if (idle && level > 0 && sinceChange >= m_holdTime){
+        if (m_stepDown){
+            // Previous step down was stable
+            m_holdTime = std::chrono::milliseconds(FC_HOLD_MIN_MS);
+        }
+        m_stepDown = true;
+        m_levelTime = now;
+        setLevel(level - 1);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef STREAMING_LIB_STREAMING_FLOW_CONTROL_H
+#define STREAMING_LIB_STREAMING_FLOW_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "data_lib/signal.hpp"
+
+namespace streaming_lib {
+
+/**
+ * Congestion control between the FPGA producer and a slow network client.
+ * The sender reports the cached buffer fill, the bytes it has drained and the
+ * socket send queue. The controller then moves along a ladder of reduced
+ * formats: 8-bit packing, then software decimation by 2, 4, 8 and so on.
+ * The producer reads the current format for every pack. The pack metadata
+ * records the format, so the capture loses resolution or bandwidth instead
+ * of whole packs.
+ */
+
+class CStreamingFlowControl
+{
+public:
+
+    enum EPolicy{
+        FC_OFF      = 0,
+        FC_8BIT     = 1,
+        FC_DECIMATE = 2,
+        FC_AUTO     = 3
+    };
+
+    using Ptr = std::shared_ptr<CStreamingFlowControl>;
+
+    static auto create(EPolicy policy,uint8_t bitsBySample,uint32_t maxDecimation = 64) -> Ptr;
+
+    CStreamingFlowControl(EPolicy policy,uint8_t bitsBySample,uint32_t maxDecimation);
+    ~CStreamingFlowControl();
+
+    auto update(float bufferFill,uint64_t sentBytes,int64_t sendQueue) -> void;
+    auto getFormat(uint8_t *bitsBySample,uint32_t *decimation) -> void;
+    auto getLevel() -> uint32_t;
+    auto getDrainRate() -> uint64_t;
+    auto getPolicy() -> EPolicy;
+
+    sigslot::signal<uint32_t,uint8_t,uint32_t> levelChangedNotify; // level, bits, decimation
+
+private:
+
+    CStreamingFlowControl(const CStreamingFlowControl &) = delete;
+    CStreamingFlowControl(CStreamingFlowControl &&) = delete;
+    CStreamingFlowControl& operator=(const CStreamingFlowControl&) =delete;
+    CStreamingFlowControl& operator=(const CStreamingFlowControl&&) =delete;
+
+    auto levelToFormat(uint32_t level,uint8_t *bitsBySample,uint32_t *decimation) -> void;
+    auto setLevel(uint32_t level) -> void;
+
+    EPolicy  m_policy;
+    uint8_t  m_bits;
+    uint32_t m_maxLevel;
+    std::atomic<uint32_t> m_level;
+    std::atomic<uint64_t> m_drainRate;
+
+    std::mutex m_mtx;
+    uint64_t   m_sentBytes;
+    std::chrono::milliseconds m_holdTime;
+    std::chrono::steady_clock::time_point m_rateTime;
+    std::chrono::steady_clock::time_point m_levelTime;
+    bool       m_stepDown;
+};
+
+}
+
+#endif
@@ -25,7 +25,9 @@ CStreamingFPGA::CStreamingFPGA(uio_lib::COscilloscope::Ptr _osc, uint8_t _adc_bi
     m_testMode(false),
     m_verbMode(false),
     m_printDebugBuffer(false),
-    m_adcSettings()
+    m_adcSettings(),
+    m_schedStats(),
+    m_flowControl(nullptr)
 {
     m_passRate = 0;
     m_OscThreadRun = false;
@@ -53,18 +55,6 @@ auto CStreamingFPGA::runNonBlock() -> void {
         m_OscThreadRun = true;
         setIsRun(true);
         m_OscThread = std::thread(&CStreamingFPGA::oscWorker, this);
-
-#ifdef RP_PLATFORM
-        pthread_attr_t thAttr;
-        int policy = 0;
-        int max_prio_for_policy = 0;
-        pthread_attr_init(&thAttr);
-        pthread_attr_getschedpolicy(&thAttr, &policy);
-        max_prio_for_policy = sched_get_priority_max(policy);
-        pthread_setschedprio(m_OscThread.native_handle(), max_prio_for_policy);
-        pthread_attr_destroy(&thAttr);
-#endif
-
     }
     catch (const std::system_error &e)
     {
@@ -83,6 +73,15 @@ auto CStreamingFPGA::stop() -> bool {
     return true;
 }
 
+auto CStreamingFPGA::getSchedStats() -> DataLib::CSchedStats& {
+    return m_schedStats;
+}
+
+auto CStreamingFPGA::setFlowControl(CStreamingFlowControl::Ptr flowControl) -> void {
+    std::lock_guard<std::mutex> lock(mtx);
+    m_flowControl = flowControl;
+}
+
 auto CStreamingFPGA::setIsRun(bool state) -> void {
     if (m_isRun != state){
         m_isRun = state;
@@ -100,6 +99,9 @@ auto CStreamingFPGA::addChannel(DataLib::EDataBuffersPackChannel _channel,DataLi
 
 void CStreamingFPGA::oscWorker(){
 
+    DataLib::applyThreadSched(DataLib::TR_FPGA);
+    m_schedStats.reset();
+
     auto timeNow = std::chrono::system_clock::now();
     auto curTime = std::chrono::time_point_cast<std::chrono::milliseconds >(timeNow);
     auto value = curTime.time_since_epoch();
@@ -117,6 +119,14 @@ void CStreamingFPGA::oscWorker(){
     }
     m_Osc_ch->prepare();
 
+    // The next DMA buffer is filled while the current one is processed.
+    // Without a known rate there is no deadline, then only the latency is counted
+    auto getDeadlineNs = [this]() -> uint64_t {
+        uint64_t oscRate = m_Osc_ch->getOSCRate();
+        return oscRate ? (uint64_t)(uio_lib::osc_buf_size / sizeof(uint16_t)) * 1000000000ull / oscRate : 0;
+    };
+    uint64_t deadlineNs = getDeadlineNs();
+
     try{
 
         uint64_t dataSize = 0;
@@ -128,7 +138,7 @@ void CStreamingFPGA::oscWorker(){
             DataLib::CDataBuffersPack::Ptr pack(nullptr);
 
             state = m_Osc_ch->wait();
-            // auto timeNowW = std::chrono::system_clock::now();
+            auto timeWait = std::chrono::steady_clock::now();
             if (state){
                 pack = this->passCh();
                 m_passRate++;
@@ -140,9 +150,21 @@ void CStreamingFPGA::oscWorker(){
                  usleep(3000);
 #endif
                 oscNotify(pack);
+                auto processNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeWait).count();
+                if (!deadlineNs){
+                    deadlineNs = getDeadlineNs();
+                }
+                if (deadlineNs){
+                    m_schedStats.addDeadline(processNs,deadlineNs);
+                }else{
+                    m_schedStats.addLatency(processNs);
+                }
                 if (pack){
                     dataSize += pack->getLenghtAllBuffers();
                     lostSize += pack->getLostAllBuffers();
+                    if (deadlineNs && pack->getLostAllBuffers() && processNs <= (int64_t)deadlineNs){
+                        m_schedStats.addMissed();
+                    }
                 }
                 // auto timeNowS = std::chrono::system_clock::now();
                 if (m_verbMode){
@@ -152,6 +174,7 @@ void CStreamingFPGA::oscWorker(){
 
                     if ((value.count() - timeBegin) >= 5000) {
                         aprintf(stdout,"Pass buffers: %d\n", m_passRate);
+                        aprintf(stdout,"FPGA deadline %lld us %s\n", (long long)deadlineNs / 1000, m_schedStats.String().c_str());
                         m_passRate = 0;
                         timeBegin = value.count();
                     }
@@ -175,6 +198,7 @@ void CStreamingFPGA::oscWorker(){
         auto p1 = std::chrono::time_point_cast<std::chrono::milliseconds>(timeNow).time_since_epoch();
         auto p2 = std::chrono::time_point_cast<std::chrono::milliseconds>(timeNowEnd).time_since_epoch();
         aprintf(stderr,"Loop %lld size %lld lost: %lld\n",p2.count() - p1.count(),dataSize,lostSize);
+        aprintf(stderr,"FPGA deadline %lld us %s\n", (long long)deadlineNs / 1000, m_schedStats.String().c_str());
 
     }
     catch (std::exception& e)
@@ -185,6 +209,41 @@ void CStreamingFPGA::oscWorker(){
 }
 
 
+// Boxcar average of every "decimation" samples. When packing to 8 bit only the high byte is kept
+template<typename T>
+static auto reduceSamples(uint8_t *dst,const uint8_t *src,size_t samples,uint32_t decimation,bool to8Bit) -> size_t{
+    auto in = reinterpret_cast<const T*>(src);
+    size_t outSamples = samples / decimation;
+    for(size_t i = 0; i < outSamples; i++, in += decimation){
+        int32_t sum = 0;
+        for(uint32_t j = 0; j < decimation; j++){
+            sum += in[j];
+        }
+        int32_t value = sum / (int32_t)decimation;
+        if (to8Bit){
+            dst[i] = (uint8_t)(value >> 8);
+        }else{
+            reinterpret_cast<T*>(dst)[i] = (T)value;
+        }
+    }
+    return outSamples;
+}
+
+static auto copyChannel(DataLib::CDataBuffer::Ptr buff,uint8_t *src,size_t size,uint8_t srcBits,uint8_t dstBits,uint32_t decimation) -> void{
+    if (dstBits == srcBits && decimation == 1){
+        buff->setDataFormat(srcBits,size / (srcBits / 8));
+        memcpy_neon(buff->getBuffer().get(),src,size);
+        return;
+    }
+    size_t samples = 0;
+    if (srcBits == 16){
+        samples = reduceSamples<int16_t>(buff->getBuffer().get(),src,size / 2,decimation,dstBits == 8);
+    }else{
+        samples = reduceSamples<int8_t>(buff->getBuffer().get(),src,size,decimation,false);
+    }
+    buff->setDataFormat(dstBits,samples);
+}
+
  auto CStreamingFPGA::passCh() -> DataLib::CDataBuffersPack::Ptr {
     uint8_t *buffer_ch1 = nullptr;
     uint8_t *buffer_ch2 = nullptr;
@@ -221,16 +280,28 @@ void CStreamingFPGA::oscWorker(){
     auto pack = getBuffF(overFlow);
 
     if (pack){
-        pack->setOSCRate(m_Osc_ch->getOSCRate());
+        uint8_t  fcBits = 0;
+        uint32_t decimation = 1;
+        if (m_flowControl){
+            m_flowControl->getFormat(&fcBits,&decimation);
+        }
+        pack->setOSCRate(m_Osc_ch->getOSCRate() / decimation);
         pack->setADCBits(m_adc_bits);
+        pack->setDecimation(decimation);
+        // Lost samples are counted at the rate of the pack
+        uint32_t lost = (overFlow + decimation - 1) / decimation;
 
         if (m_adcSettings.find(DataLib::EDataBuffersPackChannel::CH1) != m_adcSettings.end()){
             auto settings = m_adcSettings.at(DataLib::EDataBuffersPackChannel::CH1);
             auto bCh1 = pack->getBuffer(DataLib::CH1);
             if (bCh1){
                 bCh1->setADCMode(settings.m_mode);
-                bCh1->setLostSamples(DataLib::FPGA,overFlow);
-                memcpy_neon(bCh1->getBuffer().get(),buffer_ch1,size);
+                bCh1->setLostSamples(DataLib::FPGA,lost);
+                if (m_flowControl){
+                    copyChannel(bCh1,buffer_ch1,size,settings.m_bits,fcBits ? fcBits : settings.m_bits,decimation);
+                }else{
+                    memcpy_neon(bCh1->getBuffer().get(),buffer_ch1,size);
+                }
             }
         }
 
@@ -240,8 +311,12 @@ void CStreamingFPGA::oscWorker(){
             auto bCh2 = pack->getBuffer(DataLib::CH2);
             if (bCh2){
                 bCh2->setADCMode(settings.m_mode);
-                bCh2->setLostSamples(DataLib::FPGA,overFlow);
-                memcpy_neon(bCh2->getBuffer().get(),buffer_ch2,size);
+                bCh2->setLostSamples(DataLib::FPGA,lost);
+                if (m_flowControl){
+                    copyChannel(bCh2,buffer_ch2,size,settings.m_bits,fcBits ? fcBits : settings.m_bits,decimation);
+                }else{
+                    memcpy_neon(bCh2->getBuffer().get(),buffer_ch2,size);
+                }
             }
         }
         unlockBuffF();
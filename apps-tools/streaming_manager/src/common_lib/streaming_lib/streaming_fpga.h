@@ -13,6 +13,8 @@
 #include "data_lib/buffer.h"
 #include "data_lib/buffers_pack.h"
 #include "data_lib/thread_cout.h"
+#include "data_lib/thread_sched.h"
+#include "streaming_flow_control.h"
 
 namespace streaming_lib {
 
@@ -37,6 +39,8 @@ public:
     auto setTestMode(bool mode) -> void;
     auto setVerbousMode(bool mode) -> void;
     auto setPrintDebugBuffer(bool mode) -> void;
+    auto getSchedStats() -> DataLib::CSchedStats&;
+    auto setFlowControl(CStreamingFlowControl::Ptr flowControl) -> void;
 
     sigslot::signal<DataLib::CDataBuffersPack::Ptr> oscNotify;
     sigslot::signal<bool> isRunNotify;
@@ -73,6 +77,8 @@ private:
     bool             m_printDebugBuffer;
 
     std::map<DataLib::EDataBuffersPackChannel,SADCsettings> m_adcSettings;
+    DataLib::CSchedStats m_schedStats;
+    CStreamingFlowControl::Ptr m_flowControl;
 
     auto oscWorker() -> void;
     auto passCh() -> DataLib::CDataBuffersPack::Ptr;
@@ -9,6 +9,7 @@
 #include "streaming_net.h"
 #include "data_lib/thread_cout.h"
 #include "data_lib/neon_asm.h"
+#include "data_lib/thread_sched.h"
 
 using namespace streaming_lib;
 
@@ -23,10 +24,12 @@ CStreamingNet::CStreamingNet(std::string &_host, std::string &_port, net_lib::EP
         m_asionet(nullptr),
         m_index_of_message(0),
         m_thread(),
-        m_mtx()
+        m_mtx(),
+        m_flowControl(nullptr)
 {
     getBuffer = nullptr;
     unlockBufferF = nullptr;
+    getBufferFill = nullptr;
 }
 
 CStreamingNet::~CStreamingNet() {
@@ -92,28 +95,41 @@ auto CStreamingNet::getProtocol() -> net_lib::EProtocol{
 }
 
 auto CStreamingNet::task() -> void{
+    DataLib::applyThreadSched(DataLib::TR_NET);
     while(m_threadRun){
         if (getBuffer && unlockBufferF){
             auto pack = getBuffer();
-            sendBuffers(pack);
+            auto sent = sendBuffers(pack);
             if (pack)
                 unlockBufferF();
+            if (m_flowControl && getBufferFill){
+                m_flowControl->update(getBufferFill(),sent,m_asionet ? m_asionet->getSendQueueSize() : -1);
+            }
             usleep(100);
         }
     }
 }
 
 
-auto CStreamingNet::sendBuffers(DataLib::CDataBuffersPack::Ptr pack) -> void {
+auto CStreamingNet::setFlowControl(CStreamingFlowControl::Ptr flowControl) -> void{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_flowControl = flowControl;
+}
+
+auto CStreamingNet::sendBuffers(DataLib::CDataBuffersPack::Ptr pack) -> uint64_t {
+    uint64_t sent = 0;
     if (m_asionet && pack){
         if (m_asionet->isConnected()) {
             uint32_t split_size = (getProtocol() == net_lib::EProtocol::P_TCP ? TCP_BUFFER_LIMIT : UDP_BUFFER_LIMIT);
             auto packs = net_lib::buildPack(m_index_of_message++,pack,split_size);            
             for(auto &buff : packs){
-                m_asionet->sendSyncData(buff);
+                if (m_asionet->sendSyncData(buff)){
+                    sent += buff.headerLen + buff.dataLen;
+                }
             }
         }
     }
+    return sent;
 }
 
 
@@ -9,6 +9,7 @@
 
 #include "data_lib/signal.hpp"
 #include "data_lib/buffers_pack.h"
+#include "streaming_flow_control.h"
 
 #include "net_lib/asio_common.h"
 #include "net_lib/asio_net.h"
@@ -34,6 +35,7 @@ public:
     using Ptr = std::shared_ptr<CStreamingNet>;
     typedef std::function<DataLib::CDataBuffersPack::Ptr()> getBufferFunc;
     typedef std::function<void()> unlockBufferFunc;
+    typedef std::function<float()> getBufferFillFunc;
 
     static auto create(std::string &_host, std::string &_port, net_lib::EProtocol _protocol) -> Ptr;
 
@@ -45,10 +47,12 @@ public:
     auto runNonThread() -> void;
     auto stop() -> void;
     auto getProtocol() -> net_lib::EProtocol;
-    auto sendBuffers(DataLib::CDataBuffersPack::Ptr pack) -> void;
+    auto sendBuffers(DataLib::CDataBuffersPack::Ptr pack) -> uint64_t;
+    auto setFlowControl(CStreamingFlowControl::Ptr flowControl) -> void;
 
     getBufferFunc getBuffer;
     unlockBufferFunc unlockBufferF;
+    getBufferFillFunc getBufferFill;
 
 private:
 
@@ -67,6 +71,7 @@ private:
     std::thread         m_thread;
     std::atomic_bool    m_threadRun;
     std::mutex          m_mtx;
+    CStreamingFlowControl::Ptr m_flowControl;
 
     auto startServer() -> void;
     auto stopServer() -> void;
@@ -14,6 +14,8 @@ constexpr uint32_t gen0_event_id = 0x1;
 constexpr uint32_t gen1_event_id = 0x2;
 constexpr uint32_t dac_buf_size = (65536)/2;
 
+class CSimDma;
+
 
 struct GeneratorMapT
 {
@@ -88,6 +90,7 @@ private:
     uint32_t     m_calib_gain_ch2;
     uint32_t     m_maxDacSpeedHz;
     uint32_t     m_dacSpeedHz;
+    std::shared_ptr<CSimDma> m_sim;     // Only without RP_PLATFORM
 };
 
 }
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <fcntl.h>
 #include <unistd.h>
 #include "generator.h"
+#include "sim_backend.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -26,7 +28,8 @@ CGenerator::CGenerator(bool _channel1Enable, bool _channel2Enable, int _fd, void
     m_Buffer2(nullptr),
     m_waitLock(),
     m_maxDacSpeedHz(maxDacHz),
-    m_dacSpeedHz(dacHz)
+    m_dacSpeedHz(dacHz),
+    m_sim(std::make_shared<CSimDma>(dacHz))
 {}
 
 CGenerator::~CGenerator()
@@ -39,6 +42,7 @@ auto CGenerator::getDacHz() -> uint32_t{
 auto CGenerator::setDacHz(uint32_t hz) -> bool{
     if (((double)hz / (double)m_maxDacSpeedHz) * (1<<16) < 1) return false;
     m_dacSpeedHz = hz;
+    m_sim->setRate(hz);
     return true;
 }
 
@@ -74,8 +78,13 @@ auto CGenerator::initSecond(uint8_t *_buffer1,uint8_t *_buffer2, size_t, size_t)
     return ret;
 }
 
-auto CGenerator::write(uint8_t *,uint8_t *, size_t, size_t) -> bool {
+auto CGenerator::write(uint8_t *,uint8_t *, size_t _size_ch1, size_t _size_ch2) -> bool {
     bool ret = false;
+    // Waits until the DAC has played the half buffer that is written next
+    uint32_t underrun = 0;
+    if (!m_sim->wait(std::max(_size_ch1,_size_ch2) / sizeof(int16_t),&underrun)){
+        return false;
+    }
     const std::lock_guard<std::mutex> lock(m_waitLock);
     if (m_BufferNumber[0] == 0){
         m_BufferNumber[0] = 1;
@@ -88,7 +97,9 @@ auto CGenerator::write(uint8_t *,uint8_t *, size_t, size_t) -> bool {
 }
 
 
-auto CGenerator::start() -> void {}
+auto CGenerator::start() -> void {
+    m_sim->restart();
+}
 
 auto CGenerator::stop() -> void {}
 
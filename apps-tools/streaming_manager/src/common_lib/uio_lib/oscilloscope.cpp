@@ -91,7 +91,8 @@ COscilloscope::COscilloscope(int _fd, void *_regset, size_t _regsetSize, void *_
     m_filterBypass(true),
     m_isMaster(_isMaster),
     m_adcMaxSpeed(_adcMaxSpeed),
-    m_isADCFilterPresent(_isADCFilterPresent)
+    m_isADCFilterPresent(_isADCFilterPresent),
+    m_simLost(0)
 {
     m_calib_offset_ch1 = 0;
     m_calib_gain_ch1 = 0x8000;
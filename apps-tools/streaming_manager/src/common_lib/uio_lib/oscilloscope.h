@@ -69,6 +69,8 @@ struct OscilloscopeMapT
     uint32_t mode_slave_sts;          // 256  - offset 0x100
 };
 
+class CSimDma;
+
 enum BoardMode {
     UNKNOWN,
     MASTER,
@@ -140,6 +142,8 @@ private:
     bool         m_is8BitMode;
     uint32_t     m_adcMaxSpeed;
     bool         m_isADCFilterPresent;
+    std::shared_ptr<CSimDma> m_sim;     // Only without RP_PLATFORM
+    uint32_t     m_simLost;
 };
 
 }
@@ -3,6 +3,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include "oscilloscope.h"
+#include "sim_backend.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -26,8 +27,11 @@ COscilloscope::COscilloscope(int _fd, void *_regset, size_t _regsetSize, void *_
     m_dec_factor(_dec_factor),
     m_filterBypass(true),
     m_isMaster(_isMaster),
+    m_is8BitMode(false),
     m_adcMaxSpeed(_adcMaxSpeed),
-    m_isADCFilterPresent(_isADCFilterPresent)
+    m_isADCFilterPresent(_isADCFilterPresent),
+    m_sim(std::make_shared<CSimDma>(getOSCRate())),
+    m_simLost(0)
 {
     m_OscBuffer1 = new uint8_t[osc_buf_size];
     m_OscBuffer2 = new uint8_t[osc_buf_size];
@@ -50,14 +54,21 @@ void COscilloscope::setFilterCalibrationCh2(int32_t ,int32_t , int32_t , int32_t
 
 void COscilloscope::setFilterBypass(bool){}
 
-auto COscilloscope::prepare() -> void{}
+auto COscilloscope::prepare() -> void{
+    m_sim->setRate(getOSCRate());
+    m_simLost = 0;
+}
 
 auto COscilloscope::setCalibration(int32_t,float, int32_t, float) -> void{}
 
 auto COscilloscope::next(uint8_t *&_buffer1,uint8_t *&_buffer2, size_t &_size,uint32_t &_overFlow) -> bool {
+    auto config = getSimConfig();
+    uint32_t samples = m_is8BitMode ? osc_buf_size : osc_buf_size / 2;
+    simFill(config.channel[0],m_sim->getPosition(),samples,getOSCRate(),m_is8BitMode,m_OscBuffer1);
+    simFill(config.channel[1],m_sim->getPosition(),samples,getOSCRate(),m_is8BitMode,m_OscBuffer2);
     _buffer1 = m_OscBuffer1;
     _buffer2 = m_OscBuffer2;
-    _overFlow = 0;
+    _overFlow = m_simLost;
     _size = osc_buf_size;
     return true;
 }
@@ -67,7 +78,8 @@ auto COscilloscope::getDecimation() -> uint32_t {
 }
 
 auto COscilloscope::getOSCRate() -> uint32_t{
-    return m_dec_factor;
+    if (m_dec_factor == 0) return 0;
+    return m_adcMaxSpeed / m_dec_factor;
 }
 
 auto COscilloscope::clearBuffer() -> bool{
@@ -75,14 +87,14 @@ auto COscilloscope::clearBuffer() -> bool{
 }
 
 auto COscilloscope::wait() -> bool{
-    return true;
+    return m_sim->wait(m_is8BitMode ? osc_buf_size : osc_buf_size / 2,&m_simLost);
 }
 
 auto COscilloscope::clearInterrupt() -> bool{
     return true;
 }
 
-auto isMaster() -> BoardMode{
+auto COscilloscope::isMaster() -> BoardMode{
     return BoardMode::UNKNOWN;
 }
 
@@ -90,4 +102,6 @@ auto COscilloscope::stop() -> void{}
 
 auto COscilloscope::printReg() -> void{}
 
-auto COscilloscope::set8BitMode(bool) -> void{}
+auto COscilloscope::set8BitMode(bool mode) -> void{
+    m_is8BitMode = mode;
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include "sim_backend.h"
+
+using namespace uio_lib;
+
+namespace {
+    std::mutex g_simLock;
+    SimConfig  g_simConfig;
+    uint32_t   g_noiseState = 1;
+
+    auto noise() -> float{
+        g_noiseState = g_noiseState * 1664525u + 1013904223u;
+        return (float)(g_noiseState >> 8) / (float)(1 << 23) - 1.f;
+    }
+}
+
+auto uio_lib::setSimConfig(const SimConfig &config) -> void{
+    const std::lock_guard<std::mutex> lock(g_simLock);
+    g_simConfig = config;
+}
+
+auto uio_lib::getSimConfig() -> SimConfig{
+    const std::lock_guard<std::mutex> lock(g_simLock);
+    return g_simConfig;
+}
+
+auto uio_lib::simFill(const SimSource &source,uint64_t first,uint32_t samples,double rate,bool is8Bit,uint8_t *buffer) -> void{
+    // The pattern is written once by the owner of the buffer
+    if (source.type == SimSignal::PATTERN) return;
+
+    auto i8 = reinterpret_cast<int8_t*>(buffer);
+    auto i16 = reinterpret_cast<int16_t*>(buffer);
+    for(uint32_t i = 0; i < samples; i++){
+        float v = 0;
+        double t = rate > 0 ? (first + i) / rate : 0;
+        double x = std::fmod(t * source.frequency,1.0);
+        switch (source.type) {
+            case SimSignal::DC:     v = source.offset; break;
+            case SimSignal::SINE:   v = source.offset + source.amplitude * std::sin(2 * M_PI * x); break;
+            case SimSignal::SQUARE: v = source.offset + (x < 0.5 ? source.amplitude : -source.amplitude); break;
+            case SimSignal::RAMP:   v = source.offset + source.amplitude * (2 * x - 1); break;
+            case SimSignal::NOISE:  v = source.offset + source.amplitude * noise(); break;
+            default: break;
+        }
+        if (source.noise != 0){
+            v += source.noise * noise();
+        }
+        v = std::fmax(-1.f,std::fmin(v,1.f));
+        if (is8Bit){
+            i8[i] = (int8_t)std::lround(v * 127);
+        }else{
+            i16[i] = (int16_t)std::lround(v * 32767);
+        }
+    }
+}
+
+CSimDma::CSimDma(double rate) :
+    m_rate(rate),
+    m_position(0),
+    m_next(0),
+    m_dropped(0),
+    m_offset{0,0,0},
+    m_start(std::chrono::steady_clock::now())
+{}
+
+auto CSimDma::restart() -> void{
+    m_position = 0;
+    m_next = 0;
+    m_dropped = 0;
+    m_offset[0] = m_offset[1] = m_offset[2] = 0;
+    m_start = std::chrono::steady_clock::now();
+}
+
+auto CSimDma::setRate(double rate) -> void{
+    m_rate = rate;
+    restart();
+}
+
+auto CSimDma::getPosition() -> uint64_t{
+    return m_position + m_offset[0];
+}
+
+auto CSimDma::wait(uint32_t samples,uint32_t *lost) -> bool{
+    *lost = 0;
+    double scale = getSimConfig().timeScale;
+    if (scale > 0 && m_rate > 0){
+        double speed = m_rate * scale;
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        double produced = elapsed * speed - m_dropped;
+        double ready = (double)(m_next + samples);
+        if (produced < ready){
+            double sleep = (ready - produced) / speed;
+            if (sleep > 1.0){
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(sleep));
+        }
+        // Both halves are full, the DMA drops samples until the consumer releases one
+        double limit = (double)(m_next + 2 * (uint64_t)samples);
+        if (produced > limit){
+            uint64_t extra = (uint64_t)(produced - limit);
+            m_dropped += extra;
+            *lost = (uint32_t)std::min<uint64_t>(extra,UINT32_MAX);
+        }
+    }
+    m_position = m_next;
+    m_next += samples;
+    m_offset[0] = m_offset[1];
+    m_offset[1] = m_offset[2];
+    m_offset[2] = m_dropped;
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef UIO_LIB_SIM_BACKEND_H
+#define UIO_LIB_SIM_BACKEND_H
+
+#include <cstdint>
+#include <chrono>
+#include <memory>
+
+namespace uio_lib {
+
+/**
+ * Simulated DMA of the streaming FPGA, used by the dummy oscilloscope and generator
+ * when the library is built without RP_PLATFORM.
+ * The ADC channels are filled from configurable sources. With a nonzero time scale the
+ * half buffer events follow the sample rate, and samples are counted as lost when the
+ * consumer comes back later than the DMA needs the half buffer again.
+ * With the default time scale of 0 the events are ready at once and the sources keep
+ * the static test pattern of the previous dummy implementation.
+ */
+
+enum class SimSignal {
+    PATTERN,    // Static bytes of the previous dummy, the same in every buffer
+    ZERO,
+    DC,
+    SINE,
+    SQUARE,
+    RAMP,
+    NOISE
+};
+
+struct SimSource{
+    SimSignal type = SimSignal::PATTERN;
+    float amplitude = 0;    // Part of the ADC full scale
+    float offset = 0;       // Part of the ADC full scale
+    float frequency = 0;    // Hz
+    float noise = 0;        // Part of the ADC full scale, uniform noise added to the signal
+};
+
+struct SimConfig{
+    SimSource channel[2];
+    double timeScale = 0;   // Speed of the simulated DMA relative to the wall clock
+};
+
+auto setSimConfig(const SimConfig &config) -> void;
+auto getSimConfig() -> SimConfig;
+
+// Writes "samples" values of the source, starting from sample "first" of the stream, as int16 or int8.
+// The buffer is left as is for PATTERN
+auto simFill(const SimSource &source,uint64_t first,uint32_t samples,double rate,bool is8Bit,uint8_t *buffer) -> void;
+
+class CSimDma
+{
+public:
+    using Ptr = std::shared_ptr<CSimDma>;
+
+    CSimDma(double rate);
+
+    auto restart() -> void;
+    // Waits for the next half buffer of "samples". Returns false on the 1 s timeout like the UIO wait
+    auto wait(uint32_t samples,uint32_t *lost) -> bool;
+    // First sample of the last half buffer
+    auto getPosition() -> uint64_t;
+    auto setRate(double rate) -> void;
+
+private:
+
+    CSimDma(const CSimDma &) = delete;
+    CSimDma(CSimDma &&) = delete;
+    CSimDma& operator=(const CSimDma&) =delete;
+    CSimDma& operator=(const CSimDma&&) =delete;
+
+    double   m_rate;
+    uint64_t m_position;     // Stream sample of the last half buffer
+    uint64_t m_next;         // Stream sample of the next half buffer
+    uint64_t m_dropped;      // Samples lost since restart
+    uint64_t m_offset[3];    // Lost samples before the last, next and second next half buffer
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef WAV_LIB_WAVHEADER_H
+#define WAV_LIB_WAVHEADER_H
+
+#include <stdint.h>
+
+/**
+ * Layout of the header written by CWaveWriter.
+ * The JUNK chunk reserves room for a ds64 chunk, so the file can be promoted
+ * to RF64 in place when the data chunk grows past 4 GB (EBU Tech 3306).
+ *
+ *  0  "RIFF"/"RF64"   4  riff size      8  "WAVE"
+ * 12  "JUNK"/"ds64"  16  28            20  riff size 64   28  data size 64
+ * 36  sample count 64                  44  table length
+ * 48  "fmt "         52  16            56  format ... 70  bits per sample
+ * 72  "data"         76  data size     80  samples
+ */
+
+namespace WavLib {
+
+constexpr uint32_t WAV_RIFF_SIZE_OFFSET     = 4;
+constexpr uint32_t WAV_DS64_OFFSET          = 12;
+constexpr uint32_t WAV_DS64_SIZE            = 28;
+constexpr uint32_t WAV_DS64_RIFF_OFFSET     = 20;
+constexpr uint32_t WAV_DS64_DATA_OFFSET     = 28;
+constexpr uint32_t WAV_DS64_SAMPLES_OFFSET  = 36;
+constexpr uint32_t WAV_FMT_OFFSET           = 48;
+constexpr uint32_t WAV_BLOCK_ALIGN_OFFSET   = 68;
+constexpr uint32_t WAV_DATA_SIZE_OFFSET     = 76;
+constexpr uint32_t WAV_HEADER_SIZE          = 80;
+
+constexpr uint64_t WAV_MAX_CHUNK_SIZE       = 0xFFFFFFFF; // Size value that marks RF64 chunks
+
+}
+
+#endif
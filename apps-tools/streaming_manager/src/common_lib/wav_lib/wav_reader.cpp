@@ -2,100 +2,216 @@
 #include <sstream>
 #include <cstring>
 #include "wav_reader.h"
+#include "data_lib/simd_kernels.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-CWaveReader::CWaveReader(){
-    m_dataSize = 0;
+constexpr size_t g_max_samples = 16 * 1024;
+
+template<typename T>
+static auto readValue(const uint8_t *pos) -> T{
+    T value;
+    memcpy(&value,pos,sizeof(T));
+    return value;
+}
+
+CWaveReader::CWaveReader():
+    m_map(nullptr),
+    m_mapSize(0),
+    m_data(nullptr),
+    m_dataSize(0),
+    m_readPos(0),
+    m_rf64(false)
+#ifdef _WIN32
+    ,m_file(INVALID_HANDLE_VALUE)
+    ,m_mapping(NULL)
+#else
+    ,m_fd(-1)
+#endif
+{
     std::memset(&m_header,0,sizeof (m_header));
 }
 
 CWaveReader::~CWaveReader(){
-    if (m_read_fs.is_open())
-        m_read_fs.close();
+    closeFile();
+}
+
+auto CWaveReader::closeFile() -> void{
+#ifdef _WIN32
+    if (m_map) UnmapViewOfFile((LPCVOID)m_map);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_map) munmap((void*)m_map, m_mapSize);
+    if (m_fd >= 0) close(m_fd);
+    m_fd = -1;
+#endif
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_data = nullptr;
+    m_dataSize = 0;
+    m_readPos = 0;
+    m_rf64 = false;
 }
 
 auto CWaveReader::openFile(string fileName) -> bool{
-    if (m_read_fs.is_open())
-        m_read_fs.close();
-    m_read_fs.open(fileName, ios::binary | std::ifstream::in );
-    if (m_read_fs.fail()) {
+    closeFile();
+    std::memset(&m_header,0,sizeof (m_header));
+#ifdef _WIN32
+    m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        cout << "File " << fileName << " not exist" << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0){
+        closeFile();
+        return false;
+    }
+    m_mapSize = size.QuadPart;
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping){
+        m_map = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    m_fd = open(fileName.c_str(), O_RDONLY);
+    if (m_fd < 0) {
         cout << "File " << fileName << " not exist" << std::endl;
         return false;
     }
-    m_read_fs.seekg (0, m_read_fs.end);
-    uint64_t length = m_read_fs.tellg();
-    m_read_fs.seekg (0, m_read_fs.beg);
-    m_dataSize = length - sizeof(WavHeader_t);
-    m_read_fs.read((char*)&m_header, sizeof(WavHeader_t));
-    if (m_read_fs){
-        return true;
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0){
+        closeFile();
+        return false;
+    }
+    m_mapSize = st.st_size;
+    auto map = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (map != MAP_FAILED){
+        m_map = (const uint8_t*)map;
+        madvise(map, m_mapSize, MADV_SEQUENTIAL);
+    }
+#endif
+    if (!m_map || !parseChunks()){
+        cout << "File " << fileName << " is not a WAV file" << std::endl;
+        closeFile();
+        return false;
+    }
+    return true;
+}
+
+auto CWaveReader::parseChunks() -> bool{
+    if (m_mapSize < 12) return false;
+    if (memcmp(m_map,"RIFF",4) == 0){
+        m_rf64 = false;
+    }else if (memcmp(m_map,"RF64",4) == 0){
+        m_rf64 = true;
     }else{
-        m_read_fs.close();
         return false;
     }
+    if (memcmp(m_map + 8,"WAVE",4) != 0) return false;
+
+    memcpy(m_header.RIFF, m_map, 4);
+    memcpy(m_header.WAVE, m_map + 8, 4);
+    m_header.fileSize = readValue<uint32_t>(m_map + 4);
+
+    uint64_t ds64DataSize = 0;
+    bool     fmtFound = false;
+    uint64_t pos = 12;
+    while(pos + 8 <= m_mapSize){
+        auto id = m_map + pos;
+        uint64_t size = readValue<uint32_t>(m_map + pos + 4);
+        auto body = m_map + pos + 8;
+        uint64_t left = m_mapSize - pos - 8;
+
+        if (memcmp(id,"ds64",4) == 0 && size >= 16 && left >= 16){
+            ds64DataSize = readValue<uint64_t>(body + 8);
+        }
+
+        if (memcmp(id,"fmt ",4) == 0 && size >= 16 && left >= 16){
+            memcpy(m_header.fmt, id, 4);
+            m_header.Subchunk1Size = size;
+            m_header.AudioFormat   = readValue<uint16_t>(body);
+            m_header.NumOfChan     = readValue<uint16_t>(body + 2);
+            m_header.SamplesPerSec = readValue<uint32_t>(body + 4);
+            m_header.bytesPerSec   = readValue<uint32_t>(body + 8);
+            m_header.blockAlign    = readValue<uint16_t>(body + 12);
+            m_header.bitsPerSample = readValue<uint16_t>(body + 14);
+            fmtFound = true;
+        }
+
+        if (memcmp(id,"data",4) == 0){
+            memcpy(m_header.Subchunk2ID, id, 4);
+            m_header.Subchunk2Size = size;
+            if (m_rf64 && size == 0xFFFFFFFF){
+                size = ds64DataSize;
+            }
+            // Size is not finalized if recording was interrupted. Data takes rest of file
+            if (size == 0 || size > left){
+                size = left;
+            }
+            m_data = body;
+            m_dataSize = size;
+            break;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return fmtFound && m_data;
 }
 
 auto CWaveReader::getHeader() -> WavHeader_t{
     return m_header;
 }
 
+auto CWaveReader::getData() -> const uint8_t*{
+    return m_data;
+}
+
+auto CWaveReader::isRF64() -> bool{
+    return m_rf64;
+}
+
 auto CWaveReader::getBuffers(uint8_t **ch1,size_t *size_ch1, uint8_t **ch2,size_t *size_ch2) -> bool{
-    auto delFunc = [=](){
-        if (*size_ch1 == 0){
-            if (*ch1) delete[] *ch1;
-            *ch1 = nullptr;
-        }
-        if (*size_ch2 == 0){
-            if (*ch2) delete[] *ch2;
-            *ch2 = nullptr;
-        }
-    };
     *size_ch1 = 0;
     *size_ch2 = 0;
-    if (strncmp((const char*)m_header.RIFF,"RIFF",4) == 0){
-        if (m_header.AudioFormat != 1) return false;
-        int channels = m_header.NumOfChan;
-        int dataBitSize = m_header.bitsPerSample;
-        if (dataBitSize != 16) return false;
-        if (channels == 1 || channels == 2){
-            *ch1 = new uint8_t[32 * 1024];
-        }
-        if (channels == 2){
-            *ch2 = new uint8_t[32 * 1024];
-        }
-        int size = 16 * 1024;
-        for(int i = 0 ; i < size; i++){
-            uint16_t  value = 0;
-            m_read_fs.read((char*)&value,sizeof(value));
-            if (!m_read_fs){
-                delFunc();
-                return true;
-            }
-            if (*ch1){
-                ((uint16_t*)*ch1)[i] = value;
-                *size_ch1 += 2;
-            }
+    if (!m_data) return false;
+    if (m_header.AudioFormat != 1) return false;
+    int channels = m_header.NumOfChan;
+    int dataBitSize = m_header.bitsPerSample;
+    if (dataBitSize != 16) return false;
+    if (channels != 1 && channels != 2) return false;
 
-            if (channels == 2){
-                value = 0;
-                m_read_fs.read((char*)&value,sizeof(value));
-                if (!m_read_fs){
-                    delFunc();
-                    return true;
-                }
-                if (*ch2){
-                    ((uint16_t*)*ch2)[i] = value;
-                    *size_ch2 += 2;
-                }
-            }
-        }
-        delFunc();
-        return true;
+    size_t frameSize = channels * sizeof(uint16_t);
+    size_t samples = (m_dataSize - m_readPos) / frameSize;
+    if (samples > g_max_samples) samples = g_max_samples;
+    if (samples == 0) return true;
+
+    auto src = m_data + m_readPos;
+    if (channels == 1){
+        *ch1 = new uint8_t[g_max_samples * sizeof(uint16_t)];
+        // Data chunk in mapped file is not always word aligned
+        memcpy(*ch1, src, samples * sizeof(uint16_t));
+    }else{
+        *ch1 = new uint8_t[g_max_samples * sizeof(uint16_t)];
+        *ch2 = new uint8_t[g_max_samples * sizeof(uint16_t)];
+        DataLib::deinterleave2((const int16_t*)src, (int16_t*)*ch1, (int16_t*)*ch2, samples);
+        *size_ch2 = samples * sizeof(uint16_t);
     }
-    return false;
+    *size_ch1 = samples * sizeof(uint16_t);
+    m_readPos += samples * frameSize;
+    return true;
 }
 
 auto CWaveReader::getDataSize() -> uint64_t {
     return m_dataSize;
-}
\ No newline at end of file
+}
@@ -6,6 +6,11 @@
 
 using namespace std;
 
+/**
+ * WAV/RF64 reader. The file is memory mapped and the sample data is
+ * accessed in place, without reading it through a stream.
+ */
+
 class CWaveReader
 {
     typedef struct  WavHeader
@@ -31,13 +36,28 @@ public:
     ~CWaveReader();
 
     auto openFile(string fileName) -> bool;
+    auto closeFile() -> void;
     auto getHeader() -> WavHeader_t;
     auto getDataSize() -> uint64_t;
+    auto getData() -> const uint8_t*;
+    auto isRF64() -> bool;
     auto getBuffers(uint8_t **ch1,size_t *size_ch1, uint8_t **ch2,size_t *size_ch2) -> bool;
 private:
-    std::fstream m_read_fs;
-    WavHeader_t  m_header;
-    uint64_t     m_dataSize;
+    auto parseChunks() -> bool;
+
+    WavHeader_t    m_header;
+    const uint8_t *m_map;
+    uint64_t       m_mapSize;
+    const uint8_t *m_data;
+    uint64_t       m_dataSize;
+    uint64_t       m_readPos;
+    bool           m_rf64;
+#ifdef _WIN32
+    void          *m_file;      // HANDLE
+    void          *m_mapping;   // HANDLE
+#else
+    int            m_fd;
+#endif
 };
 
 #endif
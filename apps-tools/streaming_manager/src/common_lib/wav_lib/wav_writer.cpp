@@ -1,7 +1,71 @@
+#include <algorithm>
 #include <cassert>
-#include <sstream>
+#include <cstring>
 #include <vector>
 #include "wav_writer.h"
+#include "wav_header.h"
+#include "writer_lib/w_memory_stream.h"
+#include "data_lib/neon_asm.h"
+#include "data_lib/simd_kernels.h"
+
+// Channel conversion to the output format of the file. 8-bit data is stored as is.
+static auto convertChannel(const uint8_t *src, uint8_t, int8_t *dst, size_t n) -> void{
+    memcpy(dst, src, n);
+}
+
+static auto convertChannel(const uint8_t *src, uint8_t bits, int16_t *dst, size_t n) -> void{
+    if (bits == 8){
+        DataLib::convert(reinterpret_cast<const int8_t*>(src), dst, n);
+    }else{
+        memcpy(dst, src, n * sizeof(int16_t));
+    }
+}
+
+static auto convertChannel(const uint8_t *src, uint8_t bits, float *dst, size_t n) -> void{
+    if (bits == 8){
+        DataLib::convert(reinterpret_cast<const int8_t*>(src), dst, n, 1.0f / (float)0x7F);
+    }else if (bits == 16){
+        DataLib::convert(reinterpret_cast<const int16_t*>(src), dst, n, 1.0f / (float)0x7FFF);
+    }else{
+        memcpy(dst, src, n * sizeof(float));
+    }
+}
+
+// Channels in the output format are interleaved straight from the channel buffers.
+// Others are converted first. Shorter channels are padded with zeros.
+template<typename T>
+static auto interleaveChannels(uint8_t *dst, std::vector<net_lib::net_buffer> &channels, std::vector<uint8_t> &channelsBits, std::vector<size_t> &channelsSamples, size_t samples) -> void{
+    std::vector<std::vector<T>> converted(channels.size());
+    std::vector<const T*> ch(channels.size());
+    for(size_t i = 0; i < channels.size(); i++){
+        if (channelsBits[i] == sizeof(T) * 8 && channelsSamples[i] == samples){
+            ch[i] = reinterpret_cast<const T*>(channels[i].get());
+        }else{
+            converted[i].resize(samples, 0);
+            convertChannel(channels[i].get(), channelsBits[i], converted[i].data(), std::min(channelsSamples[i], samples));
+            ch[i] = converted[i].data();
+        }
+    }
+
+    auto out = reinterpret_cast<T*>(dst);
+    switch (ch.size()) {
+        case 1:
+            memcpy_neon(out, ch[0], samples * sizeof(T));
+            break;
+        case 2:
+            DataLib::interleave2(out, ch[0], ch[1], samples);
+            break;
+        case 4:
+            DataLib::interleave4(out, ch[0], ch[1], ch[2], ch[3], samples);
+            break;
+        default:
+            for(size_t i = 0; i < samples; i++){
+                for(size_t c = 0; c < ch.size(); c++){
+                    out[i * ch.size() + c] = ch[c][i];
+                }
+            }
+    }
+}
 
 CWaveWriter::CWaveWriter(){
     resetHeaderInit();
@@ -14,11 +78,6 @@ auto CWaveWriter::resetHeaderInit() -> void{
 
 auto CWaveWriter::BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel,SBuffPass> new_buffs) -> std::iostream *{
 
-    auto ch1 = new_buffs[DataLib::CH1];
-    auto ch2 = new_buffs[DataLib::CH2];
-    auto ch3 = new_buffs[DataLib::CH3];
-    auto ch4 = new_buffs[DataLib::CH4];
-
     // IF resolution = 32bit this FLOAT type data
     // Init variables
 
@@ -30,185 +89,92 @@ auto CWaveWriter::BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel,SBuff
     std::vector<uint8_t>  channelsBits;
     std::vector<size_t>   channelsSamples;
 
-
-    if (ch1.buffer) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch1.samplesCount ? ch1.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch1.bitsBySample ? ch1.bitsBySample : maxBitBySample;
-        OSCRate = ch1.adcSpeed;
-        channels.push_back(ch1.buffer);
-        channelsBits.push_back(ch1.bitsBySample);
-        channelsSamples.push_back(ch1.samplesCount);
-    }
-
-    if (ch2.buffer) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch2.samplesCount ? ch2.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch2.bitsBySample ? ch2.bitsBySample : maxBitBySample;
-        OSCRate = ch2.adcSpeed;
-        channels.push_back(ch2.buffer);
-        channelsBits.push_back(ch2.bitsBySample);
-        channelsSamples.push_back(ch2.samplesCount);
-    }
-
-    if (ch3.buffer) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch3.samplesCount ? ch3.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch3.bitsBySample ? ch3.bitsBySample : maxBitBySample;
-        OSCRate = ch3.adcSpeed;
-        channels.push_back(ch3.buffer);
-        channelsBits.push_back(ch3.bitsBySample);
-        channelsSamples.push_back(ch3.samplesCount);
-    }
-
-    if (ch4.buffer) {
-        m_numChannels++;
-        maxSamples = maxSamples < ch4.samplesCount ? ch4.samplesCount : maxSamples;
-        maxBitBySample = maxBitBySample < ch4.bitsBySample ? ch4.bitsBySample : maxBitBySample;
-        OSCRate = ch4.adcSpeed;
-        channels.push_back(ch4.buffer);
-        channelsBits.push_back(ch4.bitsBySample);
-        channelsSamples.push_back(ch4.samplesCount);
+    for(auto ch : {DataLib::CH1, DataLib::CH2, DataLib::CH3, DataLib::CH4}){
+        auto &buff = new_buffs[ch];
+        if (buff.buffer) {
+            m_numChannels++;
+            maxSamples = maxSamples < buff.samplesCount ? buff.samplesCount : maxSamples;
+            maxBitBySample = maxBitBySample < buff.bitsBySample ? buff.bitsBySample : maxBitBySample;
+            OSCRate = buff.adcSpeed;
+            channels.push_back(buff.buffer);
+            channelsBits.push_back(buff.bitsBySample);
+            channelsSamples.push_back(buff.samplesCount);
+        }
     }
 
     m_samplesPerChannel = maxSamples;
     m_bitDepth = maxBitBySample;
     m_OSCRate = OSCRate;
 
-    std::stringstream *memory = new std::stringstream(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
-    if (m_headerInit)
-    {
-        BuildHeader(memory);
-        m_headerInit = false;
-    }
-
-    auto get16Bit = [&](uint8_t ch,size_t pos) -> uint16_t{
-        if (channelsBits[ch] == 8){
-            if (channelsSamples[ch] > pos){
-                return (uint16_t)channels[ch].get()[pos] << 8;
-            }
-        }
-
-        if (channelsBits[ch] == 16){
-            if (channelsSamples[ch] > pos){
-                return ((uint16_t*)channels[ch].get())[pos];
-            }
-        }
-        return 0;
-    };
-
-    auto get32Bit = [&](uint8_t ch,size_t pos) -> float{
-        if (channelsBits[ch] == 8){
-            if (channelsSamples[ch] > pos){
-                auto b = (int8_t*)channels[ch].get(); // keep sign
-                return ((float)b[pos]) / (float)0x7F;
-            }
-        }
-
-        if (channelsBits[ch] == 16){
-            if (channelsSamples[ch] > pos){
-                auto b = (int16_t*)channels[ch].get(); // keep sign
-                return ((float)b[pos]) / (float)0x7FFF;
-            }
-        }
-
-        if (channelsBits[ch] == 32){
-            if (channelsSamples[ch] > pos){
-                return ((float*)channels[ch].get())[pos];
-            }
-        }
-
-        return 0;
-    };
-
+    size_t headerLen = m_headerInit ? WavLib::WAV_HEADER_SIZE : 0;
     size_t buffLen = m_numChannels * maxSamples * (maxBitBySample / 8);
     try{
-        uint8_t* cross_buff = new uint8_t[buffLen];
-
-        for(size_t i = 0; i < maxSamples; i++){
-            for(uint8_t ch = 0; ch < m_numChannels; ch++){
-                if (m_bitDepth == 8){
-                    if (channelsSamples[ch] > i){
-                        cross_buff[i * m_numChannels + ch] = channels[ch].get()[i];
-                    }else{
-                        cross_buff[i * m_numChannels + ch] = 0;
-                    }
-                }
-
-                if (m_bitDepth == 16){
-                    auto cross_buff16 = (uint16_t*)cross_buff;
-                    if (channelsSamples[ch] > i){
-                        cross_buff16[i * m_numChannels + ch] = get16Bit(ch,i);
-                    }else{
-                        cross_buff16[i * m_numChannels + ch] = 0;
-                    }
-                }
-
-                if (m_bitDepth == 32){
-                    auto cross_buff32 = (float*)cross_buff;
-                    if (channelsSamples[ch] > i){
-                        cross_buff32[i * m_numChannels + ch] = get32Bit(ch,i);
-                    }else{
-                        cross_buff32[i * m_numChannels + ch] = 0;
-                    }
-                }
-            }
+        auto memory = new CMemoryStream(headerLen + buffLen);
+        if (m_headerInit)
+        {
+            BuildHeader(memory->data());
+            m_headerInit = false;
         }
-        memory->write((const char*)cross_buff, buffLen);
-        delete [] cross_buff;
+        uint8_t* cross_buff = memory->data() + headerLen;
+
+        if (m_bitDepth == 8)  interleaveChannels<int8_t>(cross_buff, channels, channelsBits, channelsSamples, maxSamples);
+        if (m_bitDepth == 16) interleaveChannels<int16_t>(cross_buff, channels, channelsBits, channelsSamples, maxSamples);
+        if (m_bitDepth == 32) interleaveChannels<float>(cross_buff, channels, channelsBits, channelsSamples, maxSamples);
         return memory;
     }catch(std::exception &e){
-        fprintf(stderr,"[ERROR] CDataBuffer: %s\n",e.what());
+        fprintf(stderr,"[ERROR] CWaveWriter: %s\n",e.what());
     }
-    delete memory;
     return nullptr;
 }
 
-auto CWaveWriter::BuildHeader(std::stringstream *memory) -> void{
+auto CWaveWriter::BuildHeader(uint8_t *memory) -> void{
 
-    int sampleRate = 44100;
-    int32_t dataChunkSize = m_samplesPerChannel * m_numChannels * (m_bitDepth / 8);
-    int16_t data_format = m_bitDepth == 32 ? 0x0003: 0x0001; 
-    addStringToFileData(memory,"RIFF");
-    
-    int32_t fileSizeInBytes = 4 + 24 + 8 + dataChunkSize;
-    addInt32ToFileData (memory, fileSizeInBytes);
-    addStringToFileData(memory,"WAVE");
-    
+    // Sizes are zero until FileQueueManager::updateWavFile finalizes them
+    int16_t data_format = m_bitDepth == 32 ? 0x0003: 0x0001;
+    addStringToFileData(&memory,"RIFF");
+    addInt32ToFileData (&memory, WavLib::WAV_HEADER_SIZE - 8);
+    addStringToFileData(&memory,"WAVE");
+
+    // -----------------------------------------------------------
+    // JUNK CHUNK. Placeholder for ds64 chunk of RF64 format
+    addStringToFileData(&memory,"JUNK");
+    addInt32ToFileData (&memory, WavLib::WAV_DS64_SIZE);
+    memset(memory, 0, WavLib::WAV_DS64_SIZE);
+    memory += WavLib::WAV_DS64_SIZE;
 
     // -----------------------------------------------------------
     // FORMAT CHUNK
-    addStringToFileData(memory,"fmt ");
-    addInt32ToFileData (memory, 16); // format chunk size (16 for PCM)
-    addInt16ToFileData (memory, data_format); // audio format = 1
-    addInt16ToFileData (memory, (int16_t)m_numChannels); // num channels
-    addInt32ToFileData (memory, (int32_t)m_OSCRate); // sample rate
-    
-    int32_t numBytesPerSecond = (int32_t) ((m_numChannels * sampleRate * m_bitDepth) / 8);
-    addInt32ToFileData (memory, numBytesPerSecond);
-    
+    addStringToFileData(&memory,"fmt ");
+    addInt32ToFileData (&memory, 16); // format chunk size (16 for PCM)
+    addInt16ToFileData (&memory, data_format); // audio format = 1
+    addInt16ToFileData (&memory, (int16_t)m_numChannels); // num channels
+    addInt32ToFileData (&memory, (int32_t)m_OSCRate); // sample rate
+
+    int32_t numBytesPerSecond = (int32_t) ((m_numChannels * m_OSCRate * m_bitDepth) / 8);
+    addInt32ToFileData (&memory, numBytesPerSecond);
+
     int16_t numBytesPerBlock = m_numChannels * (m_bitDepth / 8);
-    addInt16ToFileData (memory, numBytesPerBlock);
-    
-    addInt16ToFileData (memory, (int16_t)m_bitDepth);
-    
+    addInt16ToFileData (&memory, numBytesPerBlock);
+
+    addInt16ToFileData (&memory, (int16_t)m_bitDepth);
+
     // -----------------------------------------------------------
-    memory->write("data",4);
-    addInt32ToFileData (memory, dataChunkSize);
-//    std::cout << "BuildHeader: dataChunkSize " << dataChunkSize << "\n";
+    addStringToFileData(&memory,"data");
+    addInt32ToFileData (&memory, 0);
 }
 
 
-auto CWaveWriter::addStringToFileData (std::stringstream *memory, std::string s) -> void
+auto CWaveWriter::addStringToFileData (uint8_t **memory, std::string s) -> void
 {
-    memory->write(s.data(),s.size());
+    memcpy(*memory,s.data(),s.size());
+    *memory += s.size();
 }
 
 
-void CWaveWriter::addInt32ToFileData (std::stringstream *memory, int32_t i)
+void CWaveWriter::addInt32ToFileData (uint8_t **memory, int32_t i)
 {
-    char bytes[4];
-    
+    uint8_t *bytes = *memory;
+
     if (m_endianness == Endianness::LittleEndian)
     {
         bytes[3] = (i >> 24) & 0xFF;
@@ -223,14 +189,13 @@ void CWaveWriter::addInt32ToFileData (std::stringstream *memory, int32_t i)
         bytes[2] = (i >> 8) & 0xFF;
         bytes[3] = i & 0xFF;
     }
-    memory->write(bytes,4);
-    
+    *memory += 4;
 }
 
-void CWaveWriter::addInt16ToFileData (std::stringstream *memory, int16_t i)
+void CWaveWriter::addInt16ToFileData (uint8_t **memory, int16_t i)
 {
-    char bytes[2];
-    
+    uint8_t *bytes = *memory;
+
     if (m_endianness == Endianness::LittleEndian)
     {
         bytes[1] = (i >> 8) & 0xFF;
@@ -241,7 +206,6 @@ void CWaveWriter::addInt16ToFileData (std::stringstream *memory, int16_t i)
         bytes[0] = (i >> 8) & 0xFF;
         bytes[1] = i & 0xFF;
     }
-    
-    memory->write(bytes,2);
-}
 
+    *memory += 2;
+}
@@ -5,6 +5,13 @@
 #include <iostream>
 #include "writer_lib/file_helper.h"
 
+/**
+ * Builds WAV (PCM 8/16 bit or float) sections for the file queue.
+ * Only the first section carries the header. Chunk sizes in the header are
+ * left empty and filled by FileQueueManager::updateWavFile while streaming,
+ * which also promotes the file to RF64 when it passes 4 GB.
+ */
+
 class CWaveWriter
 {
     enum class Endianness
@@ -19,10 +26,10 @@ public:
     auto BuildWAVStream(std::map<DataLib::EDataBuffersPackChannel,SBuffPass> new_buffs) -> std::iostream *;
 
 private:
-    auto addInt32ToFileData (std::stringstream *memory, int32_t i) -> void;
-    auto addInt16ToFileData (std::stringstream *memory, int16_t i) -> void;
-    auto addStringToFileData (std::stringstream *memory, std::string s) -> void;
-    auto BuildHeader(std::stringstream *memory) -> void;
+    auto addInt32ToFileData (uint8_t **memory, int32_t i) -> void;
+    auto addInt16ToFileData (uint8_t **memory, int16_t i) -> void;
+    auto addStringToFileData (uint8_t **memory, std::string s) -> void;
+    auto BuildHeader(uint8_t *memory) -> void;
 
     bool m_headerInit;
     uint32_t m_numChannels;
@@ -8,9 +8,11 @@
 #include <cstring>
 #include <limits>
 #include <sstream>
+#include <vector>
 
 #include "file_helper.h"
 #include "data_lib/thread_cout.h"
+#include "data_lib/simd_kernels.h"
 #include "tdms_lib/file.h"
 #include "w_binary.h"
 
@@ -221,6 +223,38 @@ auto buildBINStream(DataLib::CDataBuffersPack::Ptr buff_pack) -> std::iostream *
     return memory;
 }
 
+// Channels with the same integer format and without lost samples are interleaved into frames,
+// so rows are written from one buffer without checks per sample.
+template<typename T>
+static auto writeCSVFrames(std::stringstream *memory, std::vector<const char*> &buffers, size_t samples, uint64_t *samplePos) -> void{
+    auto channels = buffers.size();
+    auto ch = [&](size_t i) { return reinterpret_cast<const T*>(buffers[i]); };
+    std::vector<T> frames(samples * channels);
+    switch (channels) {
+        case 2:
+            DataLib::interleave2(frames.data(), ch(0), ch(1), samples);
+            break;
+        case 4:
+            DataLib::interleave4(frames.data(), ch(0), ch(1), ch(2), ch(3), samples);
+            break;
+        default:
+            for(size_t i = 0; i < samples; i++){
+                for(size_t c = 0; c < channels; c++){
+                    frames[i * channels + c] = ch(c)[i];
+                }
+            }
+    }
+    auto frame = frames.data();
+    for(size_t i = 0; i < samples; i++, frame += channels){
+        (*samplePos)++;
+        *memory << *samplePos;
+        for(size_t c = 0; c < channels; c++){
+            *memory << ',' << (int)frame[c];
+        }
+        *memory << '\n';
+    }
+}
+
 auto readCSV(std::iostream *buffer, int64_t *_position,int *_channels,uint64_t *samplePos,bool skipData) -> std::iostream*{
     uint32_t endSeg[] = { 0, 0 ,0};
     stringstream *memory = nullptr;
@@ -288,6 +322,28 @@ auto readCSV(std::iostream *buffer, int64_t *_position,int *_channels,uint64_t *
             max_size = max_size < (sample_ch3  + lost_ch3) ? sample_ch3 + lost_ch3 : max_size;
             max_size = max_size < (sample_ch4  + lost_ch4) ? sample_ch4 + lost_ch4 : max_size;
 
+            std::vector<const char*> frameBuffers;
+            bool sameFormat = true;
+            uint64_t frameSamples = 0;
+            uint32_t frameResolution = 0;
+            for(auto i = 0u; i < 4; i++){
+                if (header.sizeCh[i] == 0) continue;
+                if (frameBuffers.empty()){
+                    frameSamples = header.sampleCh[i];
+                    frameResolution = header.dataFormatSize[i] * 8;
+                }
+                sameFormat &= header.sampleCh[i] == frameSamples && header.dataFormatSize[i] * 8 == frameResolution;
+                frameBuffers.push_back(i == 0 ? buffer_ch1 : i == 1 ? buffer_ch2 : i == 2 ? buffer_ch3 : buffer_ch4);
+            }
+            sameFormat &= !frameBuffers.empty() && frameSamples > 0 && (frameResolution == 8 || frameResolution == 16);
+            sameFormat &= !lost_ch1 && !lost_ch2 && !lost_ch3 && !lost_ch4;
+
+            if (sameFormat){
+                if (frameResolution == 8)  writeCSVFrames<int8_t>(memory, frameBuffers, frameSamples, samplePos);
+                if (frameResolution == 16) writeCSVFrames<int16_t>(memory, frameBuffers, frameSamples, samplePos);
+                max_size = 0;
+            }
+
             auto print = [&](char *b,size_t pos,uint8_t res){
                 if (res == 8) {
                    *memory << (int)((int8_t*)b)[pos];
@@ -1,7 +1,12 @@
 #include <ctime>
 #include "file_queue_manager.h"
 #include "file_helper.h"
+#include "w_memory_stream.h"
 #include "data_lib/thread_cout.h"
+#include "data_lib/thread_sched.h"
+#include "wav_lib/wav_header.h"
+
+#define WAV_HEADER_UPDATE_STEP 1024 * 1024 * 16 // Keep the wav header valid every 16 Mb while streaming
 
 FileQueueManager::FileQueueManager(bool testMode):Queue(){
     m_threadWork = false;
@@ -80,7 +85,7 @@ auto FileQueueManager::startWrite(CStreamSettings::DataFormat _fileType) -> void
     m_ThreadRun = true;
     m_threadWork = true;
     m_fileType = _fileType;
-    m_firstSectionWrite = false;
+    m_wavHeaderUpdatePos = 0;
     m_waitAllWrite = true;
     m_hasErrorWrite = false;
     m_IsOutOfSpace = false;
@@ -108,6 +113,7 @@ auto FileQueueManager::stopWrite(bool waitAllWrite) -> void{
 }
 
 auto FileQueueManager::task() -> void{
+    DataLib::applyThreadSched(DataLib::TR_FILE);
     while (m_ThreadRun){
         writeToFile();
     }
@@ -121,6 +127,9 @@ auto FileQueueManager::task() -> void{
             bstream = popQueue();
         }
     }
+    if (m_fileType == CStreamSettings::DataFormat::WAV && !m_testMode){
+        updateWavFile();
+    }
     m_threadWork = false;
     m_waitLock.unlock();
 }
@@ -143,19 +152,21 @@ auto FileQueueManager::writeToFile() -> int{
         if (m_testMode) {
             fs.seekp(0);
         }
-        fs << bstream->rdbuf();
+        auto mstream = dynamic_cast<CMemoryStream*>(bstream);
+        if (mstream){
+            fs.write((const char*)mstream->data(), mstream->size());
+        }else{
+            fs << bstream->rdbuf();
+        }
         fs.flush();
 //        bstream->seekg(0, std::ios::end);
 //        auto Length = bstream->tellg();
         m_hasWriteSize += Length;
-    
-        if (m_fileType == CStreamSettings::DataFormat::WAV){
-            if (m_firstSectionWrite){
-                updateWavFile(Length);
-            }
 
-            if (m_firstSectionWrite == false){
-                m_firstSectionWrite = true;
+        if (m_fileType == CStreamSettings::DataFormat::WAV && !m_testMode){
+            if (m_hasWriteSize - m_wavHeaderUpdatePos >= WAV_HEADER_UPDATE_STEP){
+                updateWavFile();
+                m_wavHeaderUpdatePos = m_hasWriteSize;
             }
         }
 
@@ -186,28 +197,47 @@ auto FileQueueManager::outSpaceNotifyThread() -> void{
     }
 }
 
-auto FileQueueManager::updateWavFile(int _size) -> void{
-    int offset1 = 4;
-    int offset2 = 40;
-   
+auto FileQueueManager::updateWavFile() -> void{
+    // Sizes are taken from the file itself, so sections dropped on a write error are not counted
+    fs.clear();
     auto cur_p = fs.tellp();
-    auto cur_g = fs.tellg();
-
-    int32_t size1 = 0;
-    int32_t size2 = 0;
-    fs.seekg(offset1, fs.beg);
-    fs.read ((char*)&size1, sizeof(size1));
-    size1 += _size;
-    fs.seekp(offset1, fs.beg);
-    fs.write((char*)&size1, sizeof(size1));
-    fs.seekg(offset2, fs.beg);
-    fs.read ((char*)&size2, sizeof(size2));
-    size2 += _size;
-    fs.seekp(offset2, fs.beg);
-    fs.write((char*)&size2, sizeof(size2));
-
- 
+    fs.seekp(0, fs.end);
+    uint64_t fileSize = fs.tellp();
+    if (fileSize < WavLib::WAV_HEADER_SIZE){
+        fs.seekp(cur_p);
+        return;
+    }
+
+    uint64_t riffSize = fileSize - 8;
+    uint64_t dataSize = fileSize - WavLib::WAV_HEADER_SIZE;
+
+    if (riffSize < WavLib::WAV_MAX_CHUNK_SIZE){
+        uint32_t size1 = riffSize;
+        uint32_t size2 = dataSize;
+        fs.seekp(WavLib::WAV_RIFF_SIZE_OFFSET, fs.beg);
+        fs.write((char*)&size1, sizeof(size1));
+        fs.seekp(WavLib::WAV_DATA_SIZE_OFFSET, fs.beg);
+        fs.write((char*)&size2, sizeof(size2));
+    }else{
+        // Promote to RF64. Real sizes are stored in ds64 chunk, which replaces the JUNK placeholder
+        uint16_t blockAlign = 0;
+        fs.seekg(WavLib::WAV_BLOCK_ALIGN_OFFSET, fs.beg);
+        fs.read((char*)&blockAlign, sizeof(blockAlign));
+        uint64_t samples = blockAlign ? dataSize / blockAlign : 0;
+        uint32_t marker = WavLib::WAV_MAX_CHUNK_SIZE;
+
+        fs.seekp(0, fs.beg);
+        fs.write("RF64", 4);
+        fs.write((char*)&marker, sizeof(marker));
+        fs.seekp(WavLib::WAV_DS64_OFFSET, fs.beg);
+        fs.write("ds64", 4);
+        fs.seekp(WavLib::WAV_DS64_RIFF_OFFSET, fs.beg);
+        fs.write((char*)&riffSize, sizeof(riffSize));
+        fs.write((char*)&dataSize, sizeof(dataSize));
+        fs.write((char*)&samples, sizeof(samples));
+        fs.seekp(WavLib::WAV_DATA_SIZE_OFFSET, fs.beg);
+        fs.write((char*)&marker, sizeof(marker));
+    }
+    fs.flush();
     fs.seekp(cur_p);
-    fs.seekg(cur_g);
 }
-
@@ -27,7 +27,7 @@ class FileQueueManager:public Queue{
         auto openFile(std::string FileName,bool append) -> void;
         auto startWrite(CStreamSettings::DataFormat _fileType) -> void;
         auto stopWrite(bool waitAllWrite) -> void;
-        auto updateWavFile(int _size) -> void;
+        auto updateWavFile() -> void;
         auto writeToFile() -> int;
         auto deleteFile() -> void;
 
@@ -48,7 +48,7 @@ class FileQueueManager:public Queue{
         std::mutex       m_threadControl;
         bool m_hasErrorWrite;
         CStreamSettings::DataFormat m_fileType;
-        bool m_firstSectionWrite; // Need for detect first section of wav file
+        uint64_t m_wavHeaderUpdatePos; // Written size at last update of wav header
         bool m_IsOutOfSpace;
         uint64_t m_freeSize;
         uint64_t m_hasWriteSize;
@@ -0,0 +1,61 @@
+#include "w_memory_stream.h"
+
+CMemoryStream::CBuffer::CBuffer(size_t size):
+    m_data(new char[size]),
+    m_size(size)
+{
+    setg(m_data.get(), m_data.get(), m_data.get() + m_size);
+    setp(m_data.get(), m_data.get() + m_size);
+}
+
+auto CMemoryStream::CBuffer::data() -> uint8_t*{
+    return reinterpret_cast<uint8_t*>(m_data.get());
+}
+
+auto CMemoryStream::CBuffer::size() const -> size_t{
+    return m_size;
+}
+
+auto CMemoryStream::CBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) -> pos_type{
+    off_type base = 0;
+    if (dir == std::ios_base::cur){
+        base = (which & std::ios_base::in) ? gptr() - eback() : pptr() - pbase();
+    }
+    if (dir == std::ios_base::end){
+        base = m_size;
+    }
+    off_type pos = base + off;
+    if (pos < 0 || pos > (off_type)m_size){
+        return pos_type(off_type(-1));
+    }
+    if (which & std::ios_base::in){
+        setg(eback(), eback() + pos, egptr());
+    }
+    if (which & std::ios_base::out){
+        setp(pbase(), epptr());
+        pbump(pos);
+    }
+    return pos_type(pos);
+}
+
+auto CMemoryStream::CBuffer::seekpos(pos_type pos, std::ios_base::openmode which) -> pos_type{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+CMemoryStream::CMemoryStream(size_t size):
+    std::iostream(nullptr),
+    m_buffer(size)
+{
+    rdbuf(&m_buffer);
+}
+
+CMemoryStream::~CMemoryStream(){
+}
+
+auto CMemoryStream::data() -> uint8_t*{
+    return m_buffer.data();
+}
+
+auto CMemoryStream::size() const -> size_t{
+    return m_buffer.size();
+}
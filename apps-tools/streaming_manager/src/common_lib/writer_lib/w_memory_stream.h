@@ -0,0 +1,50 @@
+#ifndef WRITER_LIB_WMEMORYSTREAM_H
+#define WRITER_LIB_WMEMORYSTREAM_H
+
+#include <stdint.h>
+#include <iostream>
+#include <memory>
+
+/**
+ * Fixed size in-memory stream for the file queue.
+ * Unlike std::stringstream it exposes its storage, so writers can fill
+ * the data in place and the queue does not pay for an extra copy.
+ */
+
+class CMemoryStream : public std::iostream
+{
+public:
+    CMemoryStream(size_t size);
+    ~CMemoryStream();
+
+    auto data() -> uint8_t*;
+    auto size() const -> size_t;
+
+private:
+
+    class CBuffer : public std::streambuf
+    {
+    public:
+        CBuffer(size_t size);
+
+        auto data() -> uint8_t*;
+        auto size() const -> size_t;
+
+    protected:
+        auto seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) -> pos_type override;
+        auto seekpos(pos_type pos, std::ios_base::openmode which) -> pos_type override;
+
+    private:
+        std::unique_ptr<char[]> m_data;
+        size_t m_size;
+    };
+
+    CMemoryStream(const CMemoryStream &) = delete;
+    CMemoryStream(CMemoryStream &&) = delete;
+    CMemoryStream& operator=(const CMemoryStream&) =delete;
+    CMemoryStream& operator=(const CMemoryStream&&) =delete;
+
+    CBuffer m_buffer;
+};
+
+#endif
@@ -254,6 +254,31 @@ Row {
                                 series("signal 2").useOpenGL = openGL;
                             }
 
+                            // Shown span in samples, 0 follows the last pack
+                            property real viewSpan: 0
+                            function applyView(){
+                                cdh.setChartView(board.ip,Math.max(1,Math.round(plotArea.width)),Math.round(viewSpan));
+                            }
+                            onPlotAreaChanged: applyView()
+                            Component.onCompleted: applyView()
+
+                            // Wheel zooms the span, down to one sample per pixel. Double click goes back to the last pack
+                            MouseArea {
+                                anchors.fill: parent
+                                acceptedButtons: Qt.LeftButton
+                                onWheel: {
+                                    var span = chartView.viewSpan > 0 ? chartView.viewSpan : cdh.getChartSpan(board.ip);
+                                    if (span <= 0) return;
+                                    span = wheel.angleDelta.y > 0 ? span / 1.25 : span * 1.25;
+                                    chartView.viewSpan = Math.max(chartView.plotArea.width,span);
+                                    chartView.applyView();
+                                }
+                                onDoubleClicked: {
+                                    chartView.viewSpan = 0;
+                                    chartView.applyView();
+                                }
+                            }
+
                             backgroundColor: baseBackGroundColor
 
                             ValueAxis {
@@ -299,14 +324,17 @@ Row {
                                             if (consoleChart == 1){
                                                 lineSeries1.clear();
                                                 let points = cdh.getChartSignal(board.ip,0);
-                                                for(var k in points){
-                                                    lineSeries1.append(k,points[k])
+                                                // One pair per pixel of the plot area
+                                                axisX.max = Math.max(1,Math.round(chartView.plotArea.width));
+                                                // Min/max pairs: one vertical segment per pixel
+                                                for(var k = 0; k < points.length; k++){
+                                                    lineSeries1.append(k >> 1,points[k])
                                                 }
 
                                                 lineSeries2.clear();
                                                 let points2 = cdh.getChartSignal(board.ip,1);
-                                                for(var k2 in points2){
-                                                    lineSeries2.append(k2,points2[k2])
+                                                for(var k2 = 0; k2 < points2.length; k2++){
+                                                    lineSeries2.append(k2 >> 1,points2[k2])
                                                 }
                                             }
                                             needreset = true
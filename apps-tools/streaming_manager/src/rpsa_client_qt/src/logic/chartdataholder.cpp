@@ -1,7 +1,9 @@
 #include <QQmlEngine>
-#include <QThread>
+#include <algorithm>
 #include "chartdataholder.h"
 
+#define CHART_WIDTH         1000
+#define CHART_REDRAW_MS     100
 
 ChartDataHolder * ChartDataHolder::instance()
 {
@@ -15,145 +17,115 @@ ChartDataHolder * ChartDataHolder::instance()
 ChartDataHolder::ChartDataHolder():QObject(nullptr)
 {
     QQmlEngine::setObjectOwnership(this,QQmlEngine::CppOwnership);
-    m_IsWorkThread = true;
-    m_chartThread = new std::thread(&ChartDataHolder::chartPackThread,this);
 }
 
 ChartDataHolder::~ChartDataHolder(){
-    m_IsWorkThread = false;
-    if (m_chartThread->joinable()){
-        m_chartThread->join();
-    }
 }
 
-auto ChartDataHolder::regRP(const QString &ip) -> void{
-    std::lock_guard<std::mutex> lock(m_add_mutex);
-    m_rp.append(ip);
-    m_packId[ip] = 0;
-    m_chartPoints[0][ip].clear();
-    m_chartPoints[1][ip].clear();
+auto ChartDataHolder::getBoard(const QString &ip) -> std::shared_ptr<BoardChart>{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_boards.value(ip,nullptr);
 }
 
-auto ChartDataHolder::removeRP(const QString &ip) -> void{
-    std::lock_guard<std::mutex> lock(m_add_mutex);
-    m_rp.removeAll(ip);
+auto ChartDataHolder::getView(const QString &ip) -> ChartView{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_views.value(ip,ChartView());
 }
 
-auto ChartDataHolder::addBuffer(DataLib::CDataBuffersPack::Ptr pack,uint64_t id,const QString &ip,bool skip) -> void{
-    std::lock_guard<std::mutex> lock(m_add_mutex);
-
-    // skip some
-    if (m_packId[ip] != 0) return;
-
-    uint64_t maxID = 0;
-    for(auto i:m_packId.keys()){
-        if (i != ip){
-             maxID = maxID < m_packId[i] ? m_packId[i] : maxID;
-        }
-    }
-    if (skip){
-        m_packId[ip] = maxID;
-        m_pack[ip] = nullptr;
-//        qDebug() << "Skip " << ip;
-        return;
-    }
-//    qDebug() << ip << "Max" << maxID << " id " << id;
-    if (maxID < id){
-        for(auto i:m_rp){
-            m_packId[i] = 0;
-            m_pack[i] = nullptr;
-        }
-//        qDebug() << "Reset all";
-    }
-//    qDebug() << "Set " << ip << id;
-    m_pack[ip] = pack;
-    m_packId[ip] = id;
-
+auto ChartDataHolder::regRP(const QString &ip) -> void{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_boards[ip] = std::make_shared<BoardChart>();
 }
 
-auto ChartDataHolder::chartPackThread() -> void{
-    while(m_IsWorkThread){
-        QMap<QString,DataLib::CDataBuffersPack::Ptr> packForWork;
-        m_add_mutex.lock();
-        auto chartWidth = 1000;
-        bool canGet = m_rp.size();
-        for(auto i:m_rp){
-            canGet &= m_packId[i] != 0;
-        }
-        if (canGet){
-            packForWork = m_pack;
-            for(auto i:m_packId.keys()){
-                m_packId[i] = 0;
-            }
-        }
-        m_add_mutex.unlock();
-
+auto ChartDataHolder::removeRP(const QString &ip) -> void{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_boards.remove(ip);
+}
 
-        auto pack = [&](const QString ip,int index,DataLib::CDataBuffer::Ptr buf){
-            if (!buf) return;
-            auto pointsCount = buf->getSamplesCount();
-            auto bitSize = buf->getBitBySample();
+auto ChartDataHolder::addBuffer(DataLib::CDataBuffersPack::Ptr pack,const QString &ip,bool skip) -> void{
+    if (skip || !pack) return;
+    auto board = getBoard(ip);
+    if (!board) return;
+
+    // Packs are folded into the pyramid on the network thread, so the chart never has to skip them
+    std::lock_guard<std::mutex> lock(board->mutex);
+    uint64_t packSamples = 0;
+    int index = 0;
+    for(auto ch : {DataLib::CH1, DataLib::CH2}){
+        auto buf = pack->getBuffer(ch);
+        if (buf){
+            auto count = buf->getSamplesCount();
             auto buffer = buf->getBuffer().get();
-            int step = buf->getSamplesCount() / chartWidth;
-            m_chartPoints[index][ip].resize(chartWidth);
-            if (step <= 1) {
-                for(auto i = 0u; i < pointsCount; i++){
-                    if (bitSize == 8){
-                        auto b = reinterpret_cast<int8_t*>(buffer);
-                        m_chartPoints[index][ip][i] = (float)b[i] / 128.0;
-                    }
-                    if (bitSize == 16){
-                        auto b = reinterpret_cast<int16_t*>(buffer);
-                        m_chartPoints[index][ip][i] = (float)b[i] / 32768.0;
-                    }
-                }
-            }else{
-                for(auto i = 1,w = 0; i < pointsCount - 1 && w < chartWidth; i+= step,w++){
-                    int64_t sum = 0;
-                    for(int j = 0u; j < step  && i + j < pointsCount;j++){
-                        if (bitSize == 8){
-                            auto b = reinterpret_cast<int8_t*>(buffer);
-                            sum += b[i + j] << 8;
-                        }
-                        if (bitSize == 16){
-                            auto b = reinterpret_cast<int16_t*>(buffer);
-                            sum += b[i + j];
-                        }
-                    }
-                    m_chartPoints[index][ip][w] = (float)(sum / step) / 32768.0;
-                }
+            if (buf->getBitBySample() == 8){
+                board->pyramid[index].append(reinterpret_cast<int8_t*>(buffer),count,1.0f / 128.0f);
             }
-        };
-
-        if (canGet){
-//            qDebug() << Q_FUNC_INFO;
-            m_chartGetPointMutex.lock();
-            if (m_chartNeedDraw.size() == 0){
-                for(auto i:packForWork.keys()){
-                    if (packForWork[i]){
-                        pack(i,0,packForWork[i]->getBuffer(DataLib::CH1));
-                        pack(i,1,packForWork[i]->getBuffer(DataLib::CH2));
-                        m_chartNeedDraw.append(i);
-                    }
-                }
+            if (buf->getBitBySample() == 16){
+                board->pyramid[index].append(reinterpret_cast<int16_t*>(buffer),count,1.0f / 32768.0f);
             }
-            m_chartGetPointMutex.unlock();
+            packSamples = std::max<uint64_t>(packSamples,count);
         }
-        QThread::usleep(1000 * 500);
+        index++;
+    }
+    board->packSamples = packSamples;
+    board->needDraw = true;
+}
+
+void ChartDataHolder::setChartView(QString ip,int pixels,qint64 span){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &view = m_views[ip];
+        view.width = pixels > 0 ? pixels : 0;
+        view.span = span > 0 ? span : 0;
     }
+    auto board = getBoard(ip);
+    if (!board) return;
+    // Redrawn at once, also when no data is coming
+    std::lock_guard<std::mutex> lock(board->mutex);
+    board->needDraw = true;
+}
+
+qint64 ChartDataHolder::getChartSpan(QString ip){
+    auto view = getView(ip);
+    if (view.span > 0) return view.span;
+    auto board = getBoard(ip);
+    if (!board) return 0;
+    std::lock_guard<std::mutex> lock(board->mutex);
+    return board->packSamples;
 }
 
 QVector<qreal> ChartDataHolder::getChartSignal(QString ip,int index){
-    std::lock_guard<std::mutex> lock(m_chartGetPointMutex);
-    return m_chartPoints[index][ip];
+    QVector<qreal> points;
+    auto board = getBoard(ip);
+    if (!board || index < 0 || index > 1) return points;
+
+    auto view = getView(ip);
+    std::vector<float> min;
+    std::vector<float> max;
+    {
+        std::lock_guard<std::mutex> lock(board->mutex);
+        uint64_t span = view.span > 0 ? view.span : board->packSamples;
+        board->pyramid[index].query(span,view.width > 0 ? view.width : CHART_WIDTH,&min,&max);
+    }
+    points.resize(min.size() * 2);
+    for(size_t i = 0; i < min.size(); i++){
+        points[i * 2] = min[i];
+        points[i * 2 + 1] = max[i];
+    }
+    return points;
 }
 
 bool ChartDataHolder::getChartNeedUpdate(QString ip){
-    std::lock_guard<std::mutex> lock(m_chartGetPointMutex);
-    return m_chartNeedDraw.contains(ip);
+    auto board = getBoard(ip);
+    if (!board) return false;
+    std::lock_guard<std::mutex> lock(board->mutex);
+    auto sinceDraw = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - board->lastDraw).count();
+    return board->needDraw && sinceDraw >= CHART_REDRAW_MS;
 }
 
 void ChartDataHolder::clearChartBuffer(QString ip){
-    std::lock_guard<std::mutex> lock(m_chartGetPointMutex);
-    m_chartNeedDraw.removeAll(ip);
+    auto board = getBoard(ip);
+    if (!board) return;
+    std::lock_guard<std::mutex> lock(board->mutex);
+    board->needDraw = false;
+    board->lastDraw = std::chrono::steady_clock::now();
 }
@@ -3,9 +3,11 @@
 
 #include <QObject>
 #include <QMap>
+#include <chrono>
+#include <memory>
 #include <mutex>
-#include <thread>
 #include "data_lib/buffers_pack.h"
+#include "minmax_pyramid.h"
 
 
 class ChartDataHolder:public QObject
@@ -20,32 +22,42 @@ public:
 
     auto regRP(const QString &ip) -> void;
     auto removeRP(const QString &ip) -> void;
-    auto addBuffer(DataLib::CDataBuffersPack::Ptr pack,uint64_t id,const QString &ip,bool skip) -> void;
+    auto addBuffer(DataLib::CDataBuffersPack::Ptr pack,const QString &ip,bool skip) -> void;
 
+    // Min/max pairs of the channel for the current view
     Q_INVOKABLE QVector<qreal> getChartSignal(QString ip,int index);
     Q_INVOKABLE bool getChartNeedUpdate(QString ip);
     Q_INVOKABLE void clearChartBuffer(QString ip);
+    // Chart width in pixels and the shown span in samples. Span 0 shows the last pack
+    Q_INVOKABLE void setChartView(QString ip,int pixels,qint64 span);
+    // Span in samples the chart shows now, the start point for zooming
+    Q_INVOKABLE qint64 getChartSpan(QString ip);
 
 public slots:
 
 
 private:
 
-    auto chartPackThread() -> void;
-
-    std::mutex m_add_mutex;
-    std::mutex m_chartGetPointMutex;
-    QList<QString> m_rp;
-    QMap<QString,DataLib::CDataBuffersPack::Ptr> m_pack;    
-    QMap<QString,uint64_t> m_packId;
-
-    std::thread *m_chartThread;
-    bool         m_IsWorkThread;
-    uint32_t     m_chartWidth;
-    QMap<QString,QVector<qreal>>  m_chartPoints[2];
-    QList<QString>  m_chartNeedDraw;
-
-
+    struct BoardChart{
+        std::mutex    mutex;
+        MinMaxPyramid pyramid[2];
+        uint64_t      packSamples = 0;
+        bool          needDraw = false;
+        std::chrono::steady_clock::time_point lastDraw;
+    };
+
+    // Set by the chart before streaming starts, so it outlives the board registration
+    struct ChartView{
+        int     width = 0;  // 0 is the default width
+        int64_t span = 0;
+    };
+
+    auto getBoard(const QString &ip) -> std::shared_ptr<BoardChart>;
+    auto getView(const QString &ip) -> ChartView;
+
+    std::mutex m_mutex;
+    QMap<QString,std::shared_ptr<BoardChart>> m_boards;
+    QMap<QString,ChartView> m_views;
 };
 
 #endif // CONSOLEMODEL_H
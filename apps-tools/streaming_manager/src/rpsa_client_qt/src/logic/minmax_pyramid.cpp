@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstring>
+#include "minmax_pyramid.h"
+#include "data_lib/simd_kernels.h"
+
+MinMaxPyramid::MinMaxPyramid(uint32_t capacity,uint32_t factor,uint32_t levels):
+    m_capacity(std::max(capacity,1u)),
+    m_factor(std::max(factor,2u)),
+    m_levels(std::max(levels,1u))
+{
+    for(size_t i = 0; i < m_levels.size(); i++){
+        m_levels[i].min.resize(m_capacity);
+        if (i > 0){
+            m_levels[i].max.resize(m_capacity);
+        }
+    }
+}
+
+auto MinMaxPyramid::clear() -> void{
+    for(auto &l : m_levels){
+        l.written = 0;
+        l.accCount = 0;
+    }
+}
+
+auto MinMaxPyramid::getTotalSamples() -> uint64_t{
+    return m_levels[0].written;
+}
+
+auto MinMaxPyramid::getCapacity(uint32_t level) -> uint64_t{
+    uint64_t scale = 1;
+    for(uint32_t i = 0; i < level; i++){
+        scale *= m_factor;
+    }
+    return scale * m_capacity;
+}
+
+auto MinMaxPyramid::append(const int8_t *samples,size_t count,float scale) -> void{
+    m_scratch.resize(count);
+    DataLib::convert(samples,m_scratch.data(),count,scale);
+    append(m_scratch.data(),count);
+}
+
+auto MinMaxPyramid::append(const int16_t *samples,size_t count,float scale) -> void{
+    m_scratch.resize(count);
+    DataLib::convert(samples,m_scratch.data(),count,scale);
+    append(m_scratch.data(),count);
+}
+
+auto MinMaxPyramid::append(const float *samples,size_t count) -> void{
+    auto &l0 = m_levels[0];
+    for(size_t pos = 0; pos < count;){
+        size_t index = l0.written % m_capacity;
+        size_t len = std::min<size_t>(m_capacity - index,count - pos);
+        memcpy(l0.min.data() + index,samples + pos,len * sizeof(float));
+        l0.written += len;
+        pos += len;
+    }
+
+    if (m_levels.size() < 2) return;
+
+    size_t pos = 0;
+    auto accumulate = [&](float value){
+        if (l0.accCount == 0){
+            l0.accMin = l0.accMax = value;
+        }else{
+            l0.accMin = std::min(l0.accMin,value);
+            l0.accMax = std::max(l0.accMax,value);
+        }
+        if (++l0.accCount == m_factor){
+            l0.accCount = 0;
+            push(1,l0.accMin,l0.accMax);
+        }
+    };
+
+    // Finish the entry left by the previous pack, then fold whole blocks with the SIMD envelope
+    while(l0.accCount != 0 && pos < count){
+        accumulate(samples[pos++]);
+    }
+    size_t blocks = (count - pos) / m_factor;
+    if (blocks){
+        m_envMin.resize(blocks);
+        m_envMax.resize(blocks);
+        DataLib::envelope(samples + pos,blocks * m_factor,m_factor,m_envMin.data(),m_envMax.data());
+        for(size_t i = 0; i < blocks; i++){
+            push(1,m_envMin[i],m_envMax[i]);
+        }
+        pos += blocks * m_factor;
+    }
+    while(pos < count){
+        accumulate(samples[pos++]);
+    }
+}
+
+auto MinMaxPyramid::push(uint32_t level,float min,float max) -> void{
+    auto &l = m_levels[level];
+    size_t index = l.written % m_capacity;
+    l.min[index] = min;
+    l.max[index] = max;
+    l.written++;
+
+    if (level + 1 >= m_levels.size()) return;
+
+    if (l.accCount == 0){
+        l.accMin = min;
+        l.accMax = max;
+    }else{
+        l.accMin = std::min(l.accMin,min);
+        l.accMax = std::max(l.accMax,max);
+    }
+    if (++l.accCount == m_factor){
+        l.accCount = 0;
+        push(level + 1,l.accMin,l.accMax);
+    }
+}
+
+auto MinMaxPyramid::entry(const Level &l,uint64_t index,float *min,float *max) -> void{
+    size_t i = index % m_capacity;
+    *min = l.min[i];
+    *max = l.max.empty() ? l.min[i] : l.max[i];
+}
+
+auto MinMaxPyramid::query(uint64_t span,uint32_t pixels,std::vector<float> *min,std::vector<float> *max) -> uint32_t{
+    min->clear();
+    max->clear();
+    span = std::min(span,getTotalSamples());
+    if (span == 0 || pixels == 0) return 0;
+
+    // Coarsest level with an entry per pixel, or a coarser one if the span is longer than its history.
+    // Samples not yet folded into the level (less than one entry) are not shown.
+    uint32_t level = 0;
+    uint64_t scale = 1;
+    while(level + 1 < m_levels.size() && span / (scale * m_factor) >= pixels){
+        level++;
+        scale *= m_factor;
+    }
+    while(level + 1 < m_levels.size() && getCapacity(level) < span){
+        level++;
+        scale *= m_factor;
+    }
+
+    auto &l = m_levels[level];
+    uint64_t entries = std::min<uint64_t>((span + scale - 1) / scale,std::min<uint64_t>(l.written,m_capacity));
+    if (entries == 0) return level;
+    uint64_t first = l.written - entries;
+    uint32_t points = (uint32_t)std::min<uint64_t>(pixels,entries);
+
+    min->resize(points);
+    max->resize(points);
+    for(uint32_t p = 0; p < points; p++){
+        uint64_t from = first + p * entries / points;
+        uint64_t to = first + (p + 1) * entries / points;
+        float pmin, pmax;
+        entry(l,from,&pmin,&pmax);
+        for(uint64_t i = from + 1; i < to; i++){
+            float emin, emax;
+            entry(l,i,&emin,&emax);
+            pmin = std::min(pmin,emin);
+            pmax = std::max(pmax,emax);
+        }
+        (*min)[p] = pmin;
+        (*max)[p] = pmax;
+    }
+    return level;
+}
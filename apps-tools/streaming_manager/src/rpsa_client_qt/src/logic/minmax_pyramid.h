@@ -0,0 +1,58 @@
+#ifndef MINMAX_PYRAMID_H
+#define MINMAX_PYRAMID_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Multi-resolution min/max history of one channel.
+ * Level 0 keeps the raw samples. Each next level keeps the min/max of
+ * "factor" entries of the previous one, so level k covers factor^k samples
+ * per entry. All levels have the same number of entries, so coarse levels
+ * reach further into the past.
+ * Samples are folded into the levels as they are appended. A query reads
+ * the coarsest level that still has at least one entry per pixel, so its cost
+ * depends on the number of pixels and not on the sample rate.
+ */
+
+class MinMaxPyramid
+{
+public:
+
+    MinMaxPyramid(uint32_t capacity = 65536,uint32_t factor = 8,uint32_t levels = 8);
+
+    auto append(const int8_t *samples,size_t count,float scale) -> void;
+    auto append(const int16_t *samples,size_t count,float scale) -> void;
+    auto append(const float *samples,size_t count) -> void;
+    auto clear() -> void;
+
+    // Envelope of the last "span" samples reduced to "pixels" min/max pairs.
+    // Fewer pairs are returned when there is less data than pixels. Returns the used level
+    auto query(uint64_t span,uint32_t pixels,std::vector<float> *min,std::vector<float> *max) -> uint32_t;
+    auto getTotalSamples() -> uint64_t;
+    auto getCapacity(uint32_t level) -> uint64_t; // Samples covered by the level
+
+private:
+
+    struct Level{
+        std::vector<float> min;
+        std::vector<float> max;  // Empty at level 0, where min holds the samples
+        uint64_t written = 0;    // Entries written since clear
+        float    accMin = 0;     // Entry of the next level in progress
+        float    accMax = 0;
+        uint32_t accCount = 0;
+    };
+
+    auto push(uint32_t level,float min,float max) -> void;
+    auto entry(const Level &l,uint64_t index,float *min,float *max) -> void;
+
+    uint32_t m_capacity;
+    uint32_t m_factor;
+    std::vector<Level> m_levels;
+    std::vector<float> m_scratch;
+    std::vector<float> m_envMin;
+    std::vector<float> m_envMax;
+};
+
+#endif // MINMAX_PYRAMID_H
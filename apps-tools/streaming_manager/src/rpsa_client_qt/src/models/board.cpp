@@ -213,7 +213,7 @@ auto CBoard::createStreaming(net_lib::EProtocol protocol) -> void{
                 Q_EMIT updateStatistic();
         }
 
-        ChartDataHolder::instance()->addBuffer(pack,id,m_ip,!m_chartEnable);
+        ChartDataHolder::instance()->addBuffer(pack,m_ip,!m_chartEnable);
 
     });
 
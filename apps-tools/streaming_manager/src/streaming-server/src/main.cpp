@@ -38,6 +38,8 @@
 #include "broadcast_lib/asio_broadcast_socket.h"
 #include "config_net_lib/server_net_config_manager.h"
 #include "data_lib/thread_cout.h"
+#include "data_lib/thread_sched.h"
+#include "settings_lib/sched_settings.h"
 #include "streaming_lib/streaming_file.h"
 
 #include "options.h"
@@ -105,6 +107,50 @@ std::string exec(const char* cmd) {
     return result;
 }
 
+static auto applySchedProfile(const std::string &fileName,bool verbMode) -> SchedSettings{
+    SchedSettings sched;
+    struct stat st;
+    if (stat(fileName.c_str(), &st) != 0){
+        if (verbMode){
+            printWithLog(LOG_INFO,stdout,"Scheduling profile %s not found. Default scheduling is used\n",fileName.c_str());
+        }
+        return sched;
+    }
+    if (!SchedSettings::readFromFile(fileName,&sched)){
+        printWithLog(LOG_ERR,stderr,"Can't read scheduling profile %s\n",fileName.c_str());
+        return sched;
+    }
+
+    auto toThread = [&sched](const SchedSettings::Thread &t) -> DataLib::SThreadSched{
+        DataLib::SThreadSched s;
+        s.cpu = t.cpu;
+        s.priority = t.priority;
+        s.prefaultStackKb = sched.lock_memory ? sched.prefault_stack_kb : 0;
+        return s;
+    };
+    DataLib::setThreadSched(DataLib::TR_FPGA,toThread(sched.fpga));
+    DataLib::setThreadSched(DataLib::TR_NET,toThread(sched.net));
+    DataLib::setThreadSched(DataLib::TR_ASIO,toThread(sched.asio));
+    DataLib::setThreadSched(DataLib::TR_FILE,toThread(sched.file));
+
+    if (sched.lock_memory && !DataLib::lockProcessMemory()){
+        printWithLog(LOG_ERR,stderr,"Can't lock process memory\n");
+    }
+
+    if (sched.irq_cpu >= 0 && !DataLib::steerIrq(sched.irq_name,sched.irq_cpu)){
+        printWithLog(LOG_ERR,stderr,"Can't move %s irq to cpu %d\n",sched.irq_name.c_str(),sched.irq_cpu);
+    }
+
+    if (verbMode){
+        for(int i = 0; i < DataLib::TR_COUNT; i++){
+            auto role = (DataLib::EThreadRole)i;
+            auto t = DataLib::getThreadSched(role);
+            printWithLog(LOG_INFO,stdout,"Thread %s: cpu %d priority %d\n",DataLib::getThreadRoleName(role),t.cpu,t.priority);
+        }
+    }
+    return sched;
+}
+
 int main(int argc, char *argv[])
 {
     uio_lib::BoardMode isMaster = uio_lib::BoardMode::UNKNOWN;
@@ -157,6 +203,14 @@ int main(int argc, char *argv[])
     }
 #endif
 
+    // Must be set before any pipeline thread is created
+    auto sched = applySchedProfile(opt.sched_file,verbMode);
+    std::unique_ptr<DataLib::CSchedLatencyProbe> latencyProbe;
+    if (sched.diagnostics){
+        latencyProbe = std::make_unique<DataLib::CSchedLatencyProbe>(DataLib::TR_FPGA);
+        latencyProbe->start();
+    }
+
     try{
 #ifdef RP_PLATFORM
         auto hosts = exec("ip addr show eth0 2> /dev/null");
@@ -192,6 +246,7 @@ int main(int argc, char *argv[])
 
 		con_server = std::make_shared<ServerNetConfigManager>(opt.conf_file,mode,"127.0.0.1",opt.config_port);
         setServer(con_server);
+        setFlowControlPolicy(opt.flow_control);
         setDACServer(con_server);
         con_server->startBroadcast(model, brchost,opt.broadcast_port);
         con_server->getNewSettingsNofiy.connect([verbMode](){
@@ -256,8 +311,17 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
 	}
 
+    uint32_t seconds = 0;
     while(g_run){
         sleep(1);
+        if (latencyProbe && verbMode && ++seconds % 5 == 0){
+            printWithLog(LOG_INFO,stdout,"Scheduling latency %s\n",latencyProbe->getStats().String().c_str());
+        }
+    }
+
+    if (latencyProbe){
+        latencyProbe->stop();
+        printWithLog(LOG_INFO,stdout,"Scheduling latency %s\n",latencyProbe->getStats().String().c_str());
     }
 
     try{
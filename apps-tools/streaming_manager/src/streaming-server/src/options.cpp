@@ -29,12 +29,14 @@ static struct option long_options[] = {
         {"file",             required_argument, 0, 'f'},
         {"port",             required_argument, 0, 'p'},
         {"search_port",      required_argument, 0, 's'},
+        {"sched",            required_argument, 0, 'r'},
+        {"flow_control",     required_argument, 0, 'c'},
         {"verbose",          no_argument, 0, 'v'},
         {"help",             no_argument, 0, 'h'},
         {0, 0, 0, 0}
 };
 
-static constexpr char optstring[] = "bf:p:s:hv";
+static constexpr char optstring[] = "bf:p:s:r:c:hv";
 
 std::vector<std::string> ClientOpt::split(const std::string& s, char seperator)
 {
@@ -241,21 +243,25 @@ auto ClientOpt::usage(char const* progName) -> void{
         name = arr[arr.size()-1];
     const char *format =
                 "Usage: \n"
-                "\t%s [-b] [-f PATH] [-p PORT] [-s PORT] [-v]\n"
-                "\t%s [--background] [--file=PATH] [--port=PORT] [--search_port=PORT] [--verbose]\n"
+                "\t%s [-b] [-f PATH] [-p PORT] [-s PORT] [-r PATH] [-c MODE] [-v]\n"
+                "\t%s [--background] [--file=PATH] [--port=PORT] [--search_port=PORT] [--sched=PATH] [--flow_control=MODE] [--verbose]\n"
                 "\n"
                 "\t--background          -b        Run service in background.\n"
                 "\t--file=PATH           -f FILE   Path to configuration file.\n"
                 "\t                                By default uses the config file /root/.config/redpitaya/apps/streaming/streaming_config.json.\n"
                 "\t--port=PORT           -p PORT   Port for configuration server (Default: 8901).\n"
                 "\t--search_port=PORT    -s PORT   Port for broadcast (Default: 8902).\n"
+                "\t--sched=PATH          -r PATH   Path to real-time scheduling profile (CPU affinity, priorities, IRQ).\n"
+                "\t                                By default uses the file /root/.config/redpitaya/apps/streaming/streaming_sched.json if it exists.\n"
+                "\t--flow_control=MODE   -c MODE   Reduce network stream when client is slower than ADC (Default: off).\n"
+                "\t                                Modes: off, 8bit, decimate, auto (8 bit, then software decimation).\n"
                 "\t--verbose             -v        Displays information.\n"
                 "\n"
                 "\t Example:\n"
                 "\t\t%s -b -f /root/.streaming_config_new.json\n";
 
     auto n = name.c_str();
-    printWithLog(LOG_INFO,stdout,format, n ,n);
+    printWithLog(LOG_INFO,stdout,format, n ,n ,n);
 }
 
 auto ClientOpt::parse(int argc, char* argv[]) -> ClientOpt::Options{
@@ -310,6 +316,32 @@ auto ClientOpt::parse(int argc, char* argv[]) -> ClientOpt::Options{
                 break;
             }
 
+            case 'c': {
+                if (strcmp(optarg, "off") == 0) {
+                    opt.flow_control = streaming_lib::CStreamingFlowControl::FC_OFF;
+                } else if (strcmp(optarg, "8bit") == 0) {
+                    opt.flow_control = streaming_lib::CStreamingFlowControl::FC_8BIT;
+                } else if (strcmp(optarg, "decimate") == 0) {
+                    opt.flow_control = streaming_lib::CStreamingFlowControl::FC_DECIMATE;
+                } else if (strcmp(optarg, "auto") == 0) {
+                    opt.flow_control = streaming_lib::CStreamingFlowControl::FC_AUTO;
+                } else {
+                    printWithLog(LOG_ERR,stderr,"[ERROR] key --flow_control: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+
+            case 'r': {
+                if (strcmp(optarg, "") != 0) {
+                    opt.sched_file = optarg;
+                } else {
+                    printWithLog(LOG_ERR,stderr,"[ERROR] key --sched: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+
             default: {
                 printWithLog(LOG_ERR,stderr,"[ERROR] Unknown parameter\n");
                 exit(EXIT_FAILURE);
@@ -5,6 +5,7 @@
 #include <vector>
 #include "data_lib/thread_cout.h"
 #include "broadcast_lib/asio_broadcast_socket.h"
+#include "streaming_lib/streaming_flow_control.h"
 
 #ifndef _WIN32
 #include <syslog.h>
@@ -34,6 +35,8 @@ namespace ClientOpt {
         std::string config_port;
         std::string broadcast_port;
         std::string conf_file;
+        std::string sched_file;
+        streaming_lib::CStreamingFlowControl::EPolicy flow_control;
         bool verbose;
 
         Options(){
@@ -42,6 +45,8 @@ namespace ClientOpt {
             config_port = std::string("8901");
             broadcast_port = std::string("8902");
             conf_file = std::string("/root/.config/redpitaya/apps/streaming/streaming_config.json");
+            sched_file = std::string("/root/.config/redpitaya/apps/streaming/streaming_sched.json");
+            flow_control = streaming_lib::CStreamingFlowControl::FC_OFF;
         };
     };
     auto split(const std::string& s, char seperator) ->  std::vector<std::string>;
@@ -32,6 +32,7 @@ CStreamingFPGA::Ptr         g_s_fpga = nullptr;
 CStreamingBufferCached::Ptr g_s_buffer = nullptr;
 CStreamingNet::Ptr          g_s_net = nullptr;
 CStreamingFile::Ptr         g_s_file = nullptr;
+CStreamingFlowControl::EPolicy g_flowPolicy = CStreamingFlowControl::FC_OFF;
 
 bool                                    g_verbMode = false;
 std::shared_ptr<ServerNetConfigManager> g_serverNetConfig = nullptr;
@@ -50,6 +51,10 @@ auto setServer(std::shared_ptr<ServerNetConfigManager> serverNetConfig) -> void{
 
 }
 
+auto setFlowControlPolicy(CStreamingFlowControl::EPolicy policy) -> void{
+    g_flowPolicy = policy;
+}
+
 auto startServer(bool verbMode,bool testMode,bool is_master) -> void{
 	// Search oscilloscope
     if (!g_serverNetConfig) return;
@@ -237,6 +242,24 @@ auto startServer(bool verbMode,bool testMode,bool is_master) -> void{
         g_s_fpga->setVerbousMode(g_verbMode);
         g_s_fpga->setTestMode(testMode);
 
+        if (g_s_net && g_flowPolicy != CStreamingFlowControl::FC_OFF){
+            auto flow = CStreamingFlowControl::create(g_flowPolicy,resolution_val);
+            flow->levelChangedNotify.connect([](uint32_t level,uint8_t bits,uint32_t decimation){
+                if (g_verbMode){
+                    printWithLog(LOG_INFO,stdout,"[Streaming] Flow control level %d: %d bit, decimation %d\n",level,bits,decimation);
+                }
+            });
+            g_s_net->getBufferFill = [g_s_buffer_w]() -> float{
+                auto obj = g_s_buffer_w.lock();
+                if (obj){
+                    return obj->fullPercent();
+                }
+                return 0;
+            };
+            g_s_net->setFlowControl(flow);
+            g_s_fpga->setFlowControl(flow);
+        }
+
         auto weak_obj = std::weak_ptr<CStreamingBufferCached>(g_s_buffer);
         g_s_fpga->getBuffF = [weak_obj](uint64_t lostFPGA) -> DataLib::CDataBuffersPack::Ptr {
             auto obj = weak_obj.lock();
@@ -3,11 +3,13 @@
 
 #include "options.h"
 #include "config_net_lib/server_net_config_manager.h"
+#include "streaming_lib/streaming_flow_control.h"
 
 auto startServer(bool verbMode,bool testMode,bool is_master) -> void;
 auto stopNonBlocking(ServerNetConfigManager::EStopReason x) -> void;
 auto stopServer(ServerNetConfigManager::EStopReason reason) -> void;
 auto setServer(std::shared_ptr<ServerNetConfigManager> serverNetConfig) -> void;
+auto setFlowControlPolicy(streaming_lib::CStreamingFlowControl::EPolicy policy) -> void;
 auto startADC() -> void;
 
 #endif
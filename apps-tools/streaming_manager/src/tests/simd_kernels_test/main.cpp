@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <random>
+#include <vector>
+
+#include "data_lib/simd_kernels.h"
+
+// Checks the compiled kernel path (NEON on ARM, SSE2 on x86) against plain loops.
+// Sizes cover empty buffers, tails shorter than a vector and unaligned pointers.
+
+static int g_failed = 0;
+static std::mt19937 g_rand(1234);
+
+static const size_t g_sizes[] = { 0, 1, 3, 7, 8, 15, 16, 17, 31, 33, 64, 100, 1003, 16384 };
+
+#define CHECK(cond, name, n) \
+    if (!(cond)) { printf("FAIL %s n=%zu\n", name, (size_t)(n)); g_failed++; }
+
+template<typename T>
+auto randomVector(size_t n) -> std::vector<T>{
+    std::vector<T> v(n + 1);
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+    for(auto &x : v){
+        int r = dist(g_rand);
+        if (sizeof(T) == 1) x = (T)(r >> 8);
+        else if (sizeof(T) == 2) x = (T)r;
+        else x = (T)r / 16384.0f;
+    }
+    return v;
+}
+
+template<typename T>
+auto testInterleave(const char *name) -> void{
+    for(auto n : g_sizes){
+        auto a = randomVector<T>(n);
+        auto b = randomVector<T>(n);
+        auto c = randomVector<T>(n);
+        auto d = randomVector<T>(n);
+
+        // Offset by one element to get unaligned pointers
+        std::vector<T> out2(n * 2 + 1), out4(n * 4 + 1);
+        DataLib::interleave2(out2.data() + 1, a.data() + 1, b.data() + 1, n);
+        DataLib::interleave4(out4.data() + 1, a.data() + 1, b.data() + 1, c.data() + 1, d.data() + 1, n);
+        bool ok2 = true, ok4 = true;
+        for(size_t i = 0; i < n; i++){
+            ok2 &= out2[1 + i * 2] == a[1 + i] && out2[1 + i * 2 + 1] == b[1 + i];
+            ok4 &= out4[1 + i * 4] == a[1 + i] && out4[1 + i * 4 + 1] == b[1 + i]
+                && out4[1 + i * 4 + 2] == c[1 + i] && out4[1 + i * 4 + 3] == d[1 + i];
+        }
+        CHECK(ok2, (std::string("interleave2 ") + name).c_str(), n);
+        CHECK(ok4, (std::string("interleave4 ") + name).c_str(), n);
+
+        std::vector<T> ra(n), rb(n), rc(n), rd(n);
+        DataLib::deinterleave2(out2.data() + 1, ra.data(), rb.data(), n);
+        CHECK(memcmp(ra.data(), a.data() + 1, n * sizeof(T)) == 0 && memcmp(rb.data(), b.data() + 1, n * sizeof(T)) == 0,
+              (std::string("deinterleave2 ") + name).c_str(), n);
+
+        DataLib::deinterleave4(out4.data() + 1, ra.data(), rb.data(), rc.data(), rd.data(), n);
+        CHECK(memcmp(ra.data(), a.data() + 1, n * sizeof(T)) == 0 && memcmp(rb.data(), b.data() + 1, n * sizeof(T)) == 0
+           && memcmp(rc.data(), c.data() + 1, n * sizeof(T)) == 0 && memcmp(rd.data(), d.data() + 1, n * sizeof(T)) == 0,
+              (std::string("deinterleave4 ") + name).c_str(), n);
+    }
+}
+
+template<typename T>
+auto toIntReference(float v, float scale, float lo, float hi) -> T{
+    v *= scale;
+    v = v > hi ? hi : v;
+    v = v < lo ? lo : v;
+    return (T)lrintf(v);
+}
+
+auto testConvert() -> void{
+    for(auto n : g_sizes){
+        auto s8 = randomVector<int8_t>(n);
+        auto s16 = randomVector<int16_t>(n);
+        auto f = randomVector<float>(n);
+        // Values outside the range and exact halves check saturation and rounding
+        if (n > 2){
+            f[1] = 3.0f;
+            f[2] = -2.5f / 32768.0f;
+        }
+
+        std::vector<int16_t> o16(n);
+        std::vector<int8_t>  o8(n);
+        std::vector<float>   of(n);
+        bool ok = true;
+
+        DataLib::convert(s8.data(), o16.data(), n);
+        for(size_t i = 0; i < n; i++) ok &= o16[i] == (int16_t)(s8[i] * 256);
+        CHECK(ok, "convert s8->s16", n);
+
+        ok = true;
+        DataLib::convert(s16.data(), o8.data(), n);
+        for(size_t i = 0; i < n; i++) ok &= o8[i] == (int8_t)(s16[i] >> 8);
+        CHECK(ok, "convert s16->s8", n);
+
+        ok = true;
+        DataLib::convert(s8.data(), of.data(), n, 1.0f / 128.0f);
+        for(size_t i = 0; i < n; i++) ok &= of[i] == (float)s8[i] * (1.0f / 128.0f);
+        CHECK(ok, "convert s8->float", n);
+
+        ok = true;
+        DataLib::convert(s16.data(), of.data(), n, 1.0f / 32768.0f);
+        for(size_t i = 0; i < n; i++) ok &= of[i] == (float)s16[i] * (1.0f / 32768.0f);
+        CHECK(ok, "convert s16->float", n);
+
+        ok = true;
+        DataLib::convert(f.data(), o16.data(), n, 32768.0f);
+        for(size_t i = 0; i < n; i++) ok &= o16[i] == toIntReference<int16_t>(f[i], 32768.0f, -32768.0f, 32767.0f);
+        CHECK(ok, "convert float->s16", n);
+
+        ok = true;
+        DataLib::convert(f.data(), o8.data(), n, 128.0f);
+        for(size_t i = 0; i < n; i++) ok &= o8[i] == toIntReference<int8_t>(f[i], 128.0f, -128.0f, 127.0f);
+        CHECK(ok, "convert float->s8", n);
+    }
+}
+
+template<typename T>
+auto testEnvelope(const char *name) -> void{
+    for(auto n : g_sizes){
+        if (n == 0) continue;
+        auto v = randomVector<T>(n);
+        T mn, mx;
+        DataLib::minMax(v.data() + 1, n, &mn, &mx);
+        T rmn = v[1], rmx = v[1];
+        for(size_t i = 1; i <= n; i++){
+            rmn = v[i] < rmn ? v[i] : rmn;
+            rmx = v[i] > rmx ? v[i] : rmx;
+        }
+        CHECK(mn == rmn && mx == rmx, (std::string("minMax ") + name).c_str(), n);
+
+        for(size_t bucket : { (size_t)1, (size_t)5, (size_t)16, (size_t)100 }){
+            std::vector<T> emn(n / bucket + 1), emx(n / bucket + 1);
+            auto count = DataLib::envelope(v.data(), n, bucket, emn.data(), emx.data());
+            bool ok = count == (n + bucket - 1) / bucket;
+            for(size_t b = 0; b < count && ok; b++){
+                T bmn = v[b * bucket], bmx = v[b * bucket];
+                for(size_t i = b * bucket; i < n && i < (b + 1) * bucket; i++){
+                    bmn = v[i] < bmn ? v[i] : bmn;
+                    bmx = v[i] > bmx ? v[i] : bmx;
+                }
+                ok &= emn[b] == bmn && emx[b] == bmx;
+            }
+            CHECK(ok, (std::string("envelope ") + name).c_str(), n);
+        }
+    }
+}
+
+int main(int, char**)
+{
+    printf("Kernels path: %s\n", DataLib::getSimdKernelsPath());
+    testInterleave<int8_t>("int8");
+    testInterleave<int16_t>("int16");
+    testInterleave<float>("float");
+    testConvert();
+    testEnvelope<int8_t>("int8");
+    testEnvelope<int16_t>("int16");
+    testEnvelope<float>("float");
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
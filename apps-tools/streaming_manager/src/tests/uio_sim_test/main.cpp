@@ -0,0 +1,120 @@
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+#include "uio_lib/oscilloscope.h"
+#include "uio_lib/generator.h"
+#include "uio_lib/sim_backend.h"
+
+// Checks the simulated DMA of the dummy uio_lib: the signal sources, the pacing of
+// the half buffer events and the lost samples of a late consumer. Runs on x86 only.
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+using namespace uio_lib;
+
+constexpr uint32_t g_adcSpeed = 125000000;
+constexpr uint32_t g_decimation = 1000;     // 125 kS/s, a half buffer is 131 ms
+constexpr uint32_t g_samples = osc_buf_size / 2;
+
+static auto now() -> double{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+auto testPattern() -> void{
+    setSimConfig(SimConfig());
+    auto osc = COscilloscope::create(UioT(),g_decimation,true,g_adcSpeed,false);
+    osc->prepare();
+    uint8_t *b1, *b2;
+    size_t size;
+    uint32_t lost;
+    CHECK(osc->wait(), "pattern wait");
+    CHECK(osc->next(b1,b2,size,lost), "pattern next");
+    CHECK(size == osc_buf_size && lost == 0 && b1[10] == 10 && b2[10] == 245, "pattern data");
+}
+
+auto testSine() -> void{
+    SimConfig config;
+    config.channel[0].type = SimSignal::SINE;
+    config.channel[0].amplitude = 0.5;
+    config.channel[0].frequency = 1000;
+    config.channel[1].type = SimSignal::DC;
+    config.channel[1].offset = -0.25;
+    setSimConfig(config);
+
+    auto osc = COscilloscope::create(UioT(),g_decimation,true,g_adcSpeed,false);
+    osc->prepare();
+    uint8_t *b1, *b2;
+    size_t size;
+    uint32_t lost;
+    bool ok = true;
+    for(uint64_t buffer = 0; buffer < 3; buffer++){
+        osc->wait();
+        osc->next(b1,b2,size,lost);
+        auto s1 = reinterpret_cast<int16_t*>(b1);
+        auto s2 = reinterpret_cast<int16_t*>(b2);
+        // Continuous over the buffers
+        for(uint32_t i = 0; i < g_samples; i++){
+            double t = (buffer * g_samples + i) / (double)(g_adcSpeed / g_decimation);
+            ok &= std::abs(s1[i] - 0.5 * 32767 * std::sin(2 * M_PI * 1000 * t)) <= 2;
+            ok &= std::abs(s2[i] + 0.25 * 32767) <= 1;
+        }
+    }
+    CHECK(ok, "sine data");
+}
+
+auto testPacing() -> void{
+    SimConfig config;
+    config.timeScale = 1;
+    setSimConfig(config);
+
+    auto osc = COscilloscope::create(UioT(),g_decimation,true,g_adcSpeed,false);
+    double period = g_samples / (double)(g_adcSpeed / g_decimation);
+    osc->prepare();
+    uint8_t *b1, *b2;
+    size_t size;
+    uint32_t lost;
+
+    double start = now();
+    uint32_t lostSum = 0;
+    for(int i = 0; i < 3; i++){
+        osc->wait();
+        osc->next(b1,b2,size,lost);
+        lostSum += lost;
+    }
+    double time = now() - start;
+    CHECK(time > 3 * period * 0.95 && time < 3 * period * 1.5, "pacing time");
+    CHECK(lostSum == 0, "pacing no lost");
+
+    // The consumer is late by several half buffers
+    std::this_thread::sleep_for(std::chrono::duration<double>(5 * period));
+    osc->wait();
+    osc->next(b1,b2,size,lost);
+    CHECK(lost > g_samples * 2 && lost < g_samples * 4, "late consumer lost");
+
+    auto gen = CGenerator::create(UioT(),true,true,g_adcSpeed / g_decimation,g_adcSpeed);
+    gen->start();
+    start = now();
+    for(int i = 0; i < 3; i++){
+        gen->write(nullptr,nullptr,dac_buf_size,dac_buf_size);
+    }
+    time = now() - start;
+    CHECK(time > 3 * period * 0.95 && time < 3 * period * 1.5, "generator pacing");
+}
+
+int main(int, char**)
+{
+    testPattern();
+    testSine();
+    testPacing();
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
@@ -24,7 +24,8 @@
 #include <map>
 
 #include "rp_dsp.h"
-#include "kiss_fftr.h"
+#include "rp_fft.h"
+#include "rp_zoom.h"
 
 #include "rp_math.h"
 
@@ -94,6 +95,12 @@ auto __zeroethOrderBessel( double x ) -> double {
 }
 
 struct CDSP::Impl {
+    // Frequency of the output bin, from the zoom window when it is set
+    auto binFrequency(uint32_t i,uint32_t out_len,float freq_smpl) -> float {
+        if (m_zoom) return m_zoom->getFrequency(i);
+        return (float)i / (float)out_len * freq_smpl / 2;
+    }
+
     uint32_t m_max_adc_buffer_size;
     uint32_t m_signal_length;
     uint32_t m_adc_max_speed;
@@ -104,8 +111,10 @@ struct CDSP::Impl {
     double*  m_window = NULL;
     bool     m_remove_DC = true;
     mode_t   m_mode = DBM;
-    kiss_fft_cpx** m_kiss_fft_out = NULL;
-    kiss_fftr_cfg  m_kiss_fft_cfg = NULL;
+    CFFTPlan::Ptr  m_fft_plan = nullptr;
+    float**  m_fft_re = NULL;
+    float**  m_fft_im = NULL;
+    CZoomFFT::Ptr  m_zoom = nullptr;
     std::mutex m_channelMutex;
     std::map<uint8_t,bool> m_channelState;
 };
@@ -123,8 +132,9 @@ CDSP::CDSP(uint8_t max_channels,uint32_t max_adc_buffer,uint32_t adc_max_speed)
     m_pimpl->m_window = NULL;
     m_pimpl->m_remove_DC = true;
     m_pimpl->m_mode = DBM;
-    m_pimpl->m_kiss_fft_out = NULL;
-    m_pimpl->m_kiss_fft_cfg = NULL;
+    m_pimpl->m_fft_plan = nullptr;
+    m_pimpl->m_fft_re = NULL;
+    m_pimpl->m_fft_im = NULL;
     for(uint8_t i = 0 ;i < max_channels; i++){
         m_pimpl->m_channelState[i] = true;
     }
@@ -182,93 +192,102 @@ auto CDSP::getSignalMaxLength() -> uint32_t {
 }
 
 
-int CDSP::window_init(CDSP::window_mode_t mode){
+auto CDSP::fillWindow(CDSP::window_mode_t mode,uint32_t length,double *window) -> double {
     uint32_t i;
-    m_pimpl->m_window_sum  = 0;
-    m_pimpl->m_window_mode = mode;
-    window_clean();
-    
-    try{
-        m_pimpl->m_window = new double[getSignalMaxLength()];
-    } catch (const std::bad_alloc& e) {
-        fprintf(stderr, "rp_spectr_window_init() can not allocate mem\n");
-        return -1;
-    }
-    
-    switch(m_pimpl->m_window_mode) {
+    double sum = 0;
+    switch(mode) {
         case HANNING:{
-            for(i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_SPECTR_HANN_AMP * 
-                (1 - cos(2*M_PI*i / (double)(getSignalLength()-1)));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for(i = 0; i < length; i++) {
+                window[i] = RP_SPECTR_HANN_AMP * 
+                (1 - cos(2*M_PI*i / (double)(length-1)));
+                sum += window[i];
             }
             break;
         }
         case RECTANGULAR:{
-           for(i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = 1;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+           for(i = 0; i < length; i++) {
+                window[i] = 1;
+                sum += window[i];
             }
             break;
         }
         case HAMMING:{
-            for(i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = 0.54 - 
-                0.46 * cos(2*M_PI*i / (double)(getSignalLength()-1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for(i = 0; i < length; i++) {
+                window[i] = 0.54 - 
+                0.46 * cos(2*M_PI*i / (double)(length-1));
+                sum += window[i];
             }
             break;
         }
         case BLACKMAN_HARRIS:{
-            for(i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_BLACKMAN_A0 - 
-                               RP_BLACKMAN_A1 * cos(2*M_PI*i / (double)(getSignalLength()-1)) +
-                               RP_BLACKMAN_A2 * cos(4*M_PI*i / (double)(getSignalLength()-1)) -
-                               RP_BLACKMAN_A3 * cos(6*M_PI*i / (double)(getSignalLength()-1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for(i = 0; i < length; i++) {
+                window[i] = RP_BLACKMAN_A0 - 
+                               RP_BLACKMAN_A1 * cos(2*M_PI*i / (double)(length-1)) +
+                               RP_BLACKMAN_A2 * cos(4*M_PI*i / (double)(length-1)) -
+                               RP_BLACKMAN_A3 * cos(6*M_PI*i / (double)(length-1));
+                sum += window[i];
             }
             break;
         }
         case FLAT_TOP:{
-            for(i = 0; i < getSignalLength(); i++) {
-                m_pimpl->m_window[i] = RP_FLATTOP_A0 - 
-                               RP_FLATTOP_A1 * cos(2*M_PI*i / (double)(getSignalLength()-1)) +
-                               RP_FLATTOP_A2 * cos(4*M_PI*i / (double)(getSignalLength()-1)) -
-                               RP_FLATTOP_A3 * cos(6*M_PI*i / (double)(getSignalLength()-1)) +
-                               RP_FLATTOP_A4 * cos(8*M_PI*i / (double)(getSignalLength()-1));
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+            for(i = 0; i < length; i++) {
+                window[i] = RP_FLATTOP_A0 - 
+                               RP_FLATTOP_A1 * cos(2*M_PI*i / (double)(length-1)) +
+                               RP_FLATTOP_A2 * cos(4*M_PI*i / (double)(length-1)) -
+                               RP_FLATTOP_A3 * cos(6*M_PI*i / (double)(length-1)) +
+                               RP_FLATTOP_A4 * cos(8*M_PI*i / (double)(length-1));
+                sum += window[i];
             }
             break;
         }
         case KAISER_4:{
             const double x = 1.0 / __zeroethOrderBessel(4);
-            const double y = (getSignalLength() - 1) / 2.0;
+            const double y = (length - 1) / 2.0;
 
-            for(i = 0; i < getSignalLength(); i++) {
+            for(i = 0; i < length; i++) {
                 const double K = (i - y) / y;
                 const double arg = sqrt( 1.0 - (K * K) );
-                m_pimpl->m_window[i] = __zeroethOrderBessel( 4 * arg ) * x;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+                window[i] = __zeroethOrderBessel( 4 * arg ) * x;
+                sum += window[i];
             }
             break;
         }
 
         case KAISER_8:{
             const double x = 1.0 / __zeroethOrderBessel(8);
-            const double y = (getSignalLength() - 1) / 2.0;
+            const double y = (length - 1) / 2.0;
 
-            for(i = 0; i < getSignalLength(); i++) {
+            for(i = 0; i < length; i++) {
                 const double K = (i - y) / y;
                 const double arg = sqrt( 1.0 - (K * K) );
-                m_pimpl->m_window[i] = __zeroethOrderBessel( 8 * arg ) * x;
-                m_pimpl->m_window_sum += m_pimpl->m_window[i];
+                window[i] = __zeroethOrderBessel( 8 * arg ) * x;
+                sum += window[i];
             }
             break;
         }
         default:
-            window_clean();
             return -1;
     }
+    return sum;
+}
+
+int CDSP::window_init(CDSP::window_mode_t mode){
+    m_pimpl->m_window_sum  = 0;
+    m_pimpl->m_window_mode = mode;
+    window_clean();
+    
+    try{
+        m_pimpl->m_window = new double[getSignalMaxLength()];
+    } catch (const std::bad_alloc& e) {
+        fprintf(stderr, "rp_spectr_window_init() can not allocate mem\n");
+        return -1;
+    }
+    
+    m_pimpl->m_window_sum = fillWindow(mode,getSignalLength(),m_pimpl->m_window);
+    if (m_pimpl->m_window_sum < 0){
+        window_clean();
+        return -1;
+    }
     return 0;
 }
 
@@ -312,6 +331,10 @@ auto CDSP::prepareFreqVector(data_t *data, double f_s, float decimation) -> int
     //float unit_div = 1e6;
     
     for(i = 0; i < getOutSignalLength(); i++) {
+        if (m_pimpl->m_zoom){
+            data->freq_vector[i] = m_pimpl->m_zoom->getFrequency(i);
+            continue;
+        }
         /* We use full FPGA signal length range for this calculation, eventhough
          * the output vector is smaller. */
         data->freq_vector[i] = (float)i / (float)getSignalLength() * freq_smpl;
@@ -338,35 +361,66 @@ auto CDSP::windowFilter(data_t *data) -> int {
 }
 
 auto CDSP::fftInit() -> int {
-    if(m_pimpl->m_kiss_fft_out || m_pimpl->m_kiss_fft_cfg) {
+    if(m_pimpl->m_fft_re || m_pimpl->m_fft_im || m_pimpl->m_fft_plan) {
         fftClean();
     }
 
-    m_pimpl->m_kiss_fft_out  = new kiss_fft_cpx*[m_pimpl->m_max_channels];
-    for(uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-        m_pimpl->m_kiss_fft_out[j] = new kiss_fft_cpx[getSignalLength()];
+    // Bins for the longest signal, so a new signal length only needs another plan
+    m_pimpl->m_fft_re = createArray<float>(m_pimpl->m_max_channels,getSignalMaxLength() / 2 + 1);
+    m_pimpl->m_fft_im = createArray<float>(m_pimpl->m_max_channels,getSignalMaxLength() / 2 + 1);
+    m_pimpl->m_fft_plan = CFFTPlan::get(getSignalLength(),FFT_SINGLE);
+    if (!m_pimpl->m_fft_re || !m_pimpl->m_fft_im || !m_pimpl->m_fft_plan){
+        fftClean();
+        return -1;
     }
-
-    m_pimpl->m_kiss_fft_cfg = kiss_fftr_alloc(getSignalLength(), 0, NULL, NULL);
     return 0;
 }
 
 
 auto CDSP::fftClean() -> int {
-    kiss_fft_cleanup();
-    
-    if(m_pimpl->m_kiss_fft_out) {    
-        for(uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
-            if (m_pimpl->m_kiss_fft_out[j])
-                delete[] m_pimpl->m_kiss_fft_out[j];
-        }
-        delete[] m_pimpl->m_kiss_fft_out;
-        m_pimpl->m_kiss_fft_out = NULL;
+    deleteArray(m_pimpl->m_max_channels,m_pimpl->m_fft_re);
+    deleteArray(m_pimpl->m_max_channels,m_pimpl->m_fft_im);
+    m_pimpl->m_fft_re = NULL;
+    m_pimpl->m_fft_im = NULL;
+    m_pimpl->m_fft_plan = nullptr;
+    m_pimpl->m_zoom = nullptr;
+    return 0;
+}
+
+auto CDSP::zoomInit(double f1,double f2,double f_s) -> int {
+    if (!m_pimpl->m_fft_re || !m_pimpl->m_fft_im){
+        if (fftInit()) return -1;
+    }
+    m_pimpl->m_zoom = CZoomFFT::create(getSignalLength(),getOutSignalLength(),f1,f2,f_s);
+    return m_pimpl->m_zoom ? 0 : -1;
+}
+
+auto CDSP::zoomClean() -> int {
+    m_pimpl->m_zoom = nullptr;
+    return 0;
+}
 
+auto CDSP::zoom(data_t *data) -> int {
+    if (!data || !data->in || !data->filtred || !data->fft){
+        fprintf(stderr, "zoom() data not initialized\n");
+        return -1;
+    }
+
+    if (!m_pimpl->m_zoom || !m_pimpl->m_fft_re || !m_pimpl->m_fft_im) {
+        fprintf(stderr, "zoom() not initialized\n");
+        return -1;
     }
-    if(m_pimpl->m_kiss_fft_cfg) {
-        free(m_pimpl->m_kiss_fft_cfg);
-        m_pimpl->m_kiss_fft_cfg = NULL;
+
+    if (m_pimpl->m_zoom->getLength() != getSignalLength() || m_pimpl->m_zoom->getBins() != getOutSignalLength()){
+        fprintf(stderr, "zoom() initialized for another signal length\n");
+        return -1;
+    }
+
+    auto _in = data->is_data_filtred ? data->filtred : data->in;
+    for(uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
+        if (!m_pimpl->m_channelState[j]) continue;
+        m_pimpl->m_zoom->transform(_in[j],m_pimpl->m_fft_re[j],m_pimpl->m_fft_im[j]);
+        fftSpectrum(m_pimpl->m_fft_re[j],m_pimpl->m_fft_im[j],getOutSignalLength(),1,false,data->fft[j]);
     }
     return 0;
 }
@@ -379,23 +433,36 @@ auto CDSP::fft(data_t *data) -> int {
         return -1;
     }
 
-    if(!m_pimpl->m_kiss_fft_out  || !m_pimpl->m_kiss_fft_cfg) {
+    if(!m_pimpl->m_fft_re || !m_pimpl->m_fft_im || !m_pimpl->m_fft_plan) {
         fprintf(stderr, "rp_spect_fft not initialized");
         return -1;
     }
 
+    if (m_pimpl->m_fft_plan->length() != getSignalLength()){
+        auto plan = CFFTPlan::get(getSignalLength(),FFT_SINGLE);
+        if (!plan) return -1;
+        m_pimpl->m_fft_plan = plan;
+    }
+
+    // All enabled channels go through the stages together
     auto _in = data->is_data_filtred ? data->filtred : data->in;
+    const double *in[UINT8_MAX];
+    float *re[UINT8_MAX];
+    float *im[UINT8_MAX];
+    uint32_t count = 0;
     for(uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
         if (!m_pimpl->m_channelState[j]) continue;
-        kiss_fftr(m_pimpl->m_kiss_fft_cfg, (kiss_fft_scalar *)_in[j], m_pimpl->m_kiss_fft_out[j]);
+        in[count] = _in[j];
+        re[count] = m_pimpl->m_fft_re[j];
+        im[count] = m_pimpl->m_fft_im[j];
+        count++;
     }
+    m_pimpl->m_fft_plan->forwardBatch(in,re,im,count);
 
     for(uint32_t j = 0; j < m_pimpl->m_max_channels; j++) {
         if (!m_pimpl->m_channelState[j]) continue;
-        for(uint32_t i = 0; i < getOutSignalLength(); i++) {                     // FFT limited to fs/2, specter of amplitudes            
-            data->fft[j][i] = sqrtf_neon(pow(m_pimpl->m_kiss_fft_out[j][i].r, 2) +
-                            pow(m_pimpl->m_kiss_fft_out[j][i].i, 2));
-        }
+        // FFT limited to fs/2, specter of amplitudes
+        fftSpectrum(m_pimpl->m_fft_re[j],m_pimpl->m_fft_im[j],getOutSignalLength(),1,false,data->fft[j]);
     }
     return 0;
 }
@@ -497,7 +564,7 @@ auto CDSP::cnvToDBM(data_t *data,uint32_t  decimation) -> int {
             }
         }
         data->peak_power[c] = max_pw[c];
-        data->peak_freq[c] = ((float)max_pw_idx[c] / (float)getOutSignalLength() * freq_smpl  / 2);
+        data->peak_freq[c] = m_pimpl->binFrequency(max_pw_idx[c],getOutSignalLength(),freq_smpl);
     }
 
     delete[] max_pw;
@@ -538,7 +605,7 @@ auto CDSP::cnvToDBMMaxValueRanged(data_t *data,uint32_t  decimation,uint32_t min
             else	
                 data->converted[c][i] = 10 * log10f_neon(1.0e-12);
             
-            auto currentFreq = ((float)i / (float)getOutSignalLength() * freq_smpl  / 2);
+            auto currentFreq = m_pimpl->binFrequency(i,getOutSignalLength(),freq_smpl);
             if (currentFreq < minFreq || currentFreq > maxFreq) continue;
           
             /* Find peaks */
@@ -548,7 +615,7 @@ auto CDSP::cnvToDBMMaxValueRanged(data_t *data,uint32_t  decimation,uint32_t min
             }
         }
         data->peak_power[c] = max_pw[c];
-        data->peak_freq[c] = ((float)max_pw_idx[c] / (float)getOutSignalLength() * freq_smpl  / 2) ;
+        data->peak_freq[c] = m_pimpl->binFrequency(max_pw_idx[c],getOutSignalLength(),freq_smpl);
     }
     delete[] max_pw;
     delete[] max_pw_idx;
@@ -612,7 +679,7 @@ auto CDSP::cnvToMetric(data_t *data,uint32_t  decimation) -> int{
 
 
         data->peak_power[c] = max_pw[c];
-        data->peak_freq[c] = ((float)max_pw_idx[c] / (float)getOutSignalLength() * freq_smpl  / 2) ;
+        data->peak_freq[c] = m_pimpl->binFrequency(max_pw_idx[c],getOutSignalLength(),freq_smpl);
     }
 
     delete[] max_pw;
@@ -71,6 +71,8 @@ public:
     auto window_init(window_mode_t mode) -> int;
     auto window_clean() -> int;
     auto getCurrentWindowMode() -> CDSP::window_mode_t;
+    // Fills "length" coefficients of the window, returns their sum or -1 for an unknown mode
+    static auto fillWindow(window_mode_t mode,uint32_t length,double *window) -> double;
 
     auto setImpedance(double value) -> void;
     auto getImpedance() -> double;
@@ -88,6 +90,14 @@ public:
     auto fftInit() -> int;
     auto fftClean() -> int;
     auto fft(data_t *data) -> int;
+    /**
+     * Zoom spectrum: getOutSignalLength() bins from f1 to f2 for the sample rate f_s (ADC rate / decimation),
+     * written to data->fft in place of fft(). The following decimate() and cnvTo*() steps are the same,
+     * prepareFreqVector() and the peak frequencies use the zoom window until zoomClean().
+     */
+    auto zoomInit(double f1,double f2,double f_s) -> int;
+    auto zoomClean() -> int;
+    auto zoom(data_t *data) -> int;
     auto decimate(data_t *data,uint32_t in_len, uint32_t out_len) -> int;
     auto cnvToDBM(data_t *data,uint32_t  decimation) -> int;
     auto cnvToDBMMaxValueRanged(data_t *data,uint32_t  decimation,uint32_t minFreq,uint32_t maxFreq) -> int;
@@ -0,0 +1,593 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya real FFT engine with cached plans.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "rp_fft.h"
+#include "kiss_fftr.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+using namespace rp_dsp_api;
+
+namespace {
+
+// GCC vector extensions, NEON q registers on the board and SSE on x86
+typedef float   v4sf __attribute__((vector_size(16)));
+typedef int32_t v4si __attribute__((vector_size(16)));
+
+inline auto ld(const float *p) -> v4sf { v4sf v; memcpy(&v,p,sizeof(v)); return v; }
+inline auto st(float *p,v4sf v) -> void { memcpy(p,&v,sizeof(v)); }
+inline auto splat(float x) -> v4sf { return v4sf{x,x,x,x}; }
+inline auto reverse(v4sf v) -> v4sf { return __builtin_shuffle(v,v4si{3,2,1,0}); }
+
+inline auto transpose(v4sf &a,v4sf &b,v4sf &c,v4sf &d) -> void {
+    v4sf ab_lo = __builtin_shuffle(a,b,v4si{0,4,1,5});
+    v4sf ab_hi = __builtin_shuffle(a,b,v4si{2,6,3,7});
+    v4sf cd_lo = __builtin_shuffle(c,d,v4si{0,4,1,5});
+    v4sf cd_hi = __builtin_shuffle(c,d,v4si{2,6,3,7});
+    a = __builtin_shuffle(ab_lo,cd_lo,v4si{0,1,4,5});
+    b = __builtin_shuffle(ab_lo,cd_lo,v4si{2,3,6,7});
+    c = __builtin_shuffle(ab_hi,cd_hi,v4si{0,1,4,5});
+    d = __builtin_shuffle(ab_hi,cd_hi,v4si{2,3,6,7});
+}
+
+// Forward radix 4 butterfly, V is float or v4sf. w1..w3 are the twiddles of the outputs 1..3
+template<typename V>
+inline auto butterfly4(const V *xr,const V *xi,const V *wr,const V *wi,V *yr,V *yi) -> void {
+    V apcr = xr[0] + xr[2], apci = xi[0] + xi[2];
+    V amcr = xr[0] - xr[2], amci = xi[0] - xi[2];
+    V bpdr = xr[1] + xr[3], bpdi = xi[1] + xi[3];
+    // j * (b - d)
+    V jbmdr = xi[3] - xi[1], jbmdi = xr[1] - xr[3];
+    V t1r = amcr - jbmdr, t1i = amci - jbmdi;
+    V t2r = apcr - bpdr,  t2i = apci - bpdi;
+    V t3r = amcr + jbmdr, t3i = amci + jbmdi;
+    yr[0] = apcr + bpdr;
+    yi[0] = apci + bpdi;
+    yr[1] = t1r * wr[0] - t1i * wi[0];
+    yi[1] = t1r * wi[0] + t1i * wr[0];
+    yr[2] = t2r * wr[1] - t2i * wi[1];
+    yi[2] = t2r * wi[1] + t2i * wr[1];
+    yr[3] = t3r * wr[2] - t3i * wi[2];
+    yi[3] = t3r * wi[2] + t3i * wr[2];
+}
+
+// Scratch of the calling thread, reused between the transforms
+auto scratch(size_t size) -> float* {
+    thread_local std::vector<float> buffer;
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
+
+auto isPowerOf2(uint32_t x) -> bool {
+    return x && !(x & (x - 1));
+}
+
+/**
+ * Complex FFT as a Stockham autosort transform: radix 4 stages and one radix 2 stage
+ * when log2(N) is odd, so there is no bit reversal pass. Data is kept as separate
+ * real and imaginary planes, the first stage is vectorized over the butterflies with
+ * a 4x4 transpose and the others over the stride.
+ */
+class CStockham {
+public:
+    CStockham(uint32_t length);
+
+    /**
+     * Transforms "count" sequences, sequence c starts at buffer + 4 * length * c with the
+     * real and imaginary planes followed by the same space for the ping pong.
+     * Returns true when the results are in the second half.
+     */
+    auto run(float *buffer,uint32_t count) const -> bool;
+
+private:
+
+    struct stage_t {
+        uint32_t radix;
+        uint32_t n;             // Length of the sub transforms
+        uint32_t s;             // Stride, number of the sub transforms
+        std::vector<float> w;   // n/radix twiddles per output 1..radix-1, real and imaginary planes
+    };
+
+    auto radix4(const stage_t &stage,const float *xr,const float *xi,float *yr,float *yi) const -> void;
+    auto radix2(const stage_t &stage,const float *xr,const float *xi,float *yr,float *yi) const -> void;
+
+    uint32_t             m_length;
+    std::vector<stage_t> m_stages;
+};
+
+/**
+ * Real FFT of length N as a complex FFT of N/2 points on the even and odd samples,
+ * followed by the split of the two interleaved spectra.
+ */
+class CSimdPlan : public CFFTPlan {
+public:
+    CSimdPlan(uint32_t length);
+
+    auto forward(const float *in,float *re,float *im) const -> void override;
+    auto forward(const double *in,float *re,float *im) const -> void override;
+    auto forwardBatch(const double * const *in,float * const *re,float * const *im,uint32_t count) const -> void override;
+    auto forwardBatch(const float * const *in,float * const *re,float * const *im,uint32_t count) const -> void override;
+
+private:
+
+    template<typename T>
+    auto run(const T * const *in,float * const *re,float * const *im,uint32_t count) const -> void;
+    template<typename T>
+    auto load(const T *in,float *zr,float *zi) const -> void;
+    auto unpack(const float *zr,const float *zi,float *re,float *im) const -> void;
+
+    uint32_t             m_half;
+    CStockham            m_core;
+    std::vector<float>   m_post_r;
+    std::vector<float>   m_post_i;
+};
+
+class CSimdComplexPlan : public CFFTComplexPlan {
+public:
+    CSimdComplexPlan(uint32_t length);
+
+    auto forward(const float *inRe,const float *inIm,float *outRe,float *outIm) const -> void override;
+
+private:
+
+    CStockham m_core;
+};
+
+CStockham::CStockham(uint32_t length) :
+    m_length(length)
+{
+    uint32_t n = length;
+    uint32_t s = 1;
+    while(n > 1){
+        stage_t stage;
+        stage.radix = n >= 4 ? 4 : 2;
+        stage.n = n;
+        stage.s = s;
+        uint32_t m = n / stage.radix;
+        stage.w.resize(2 * (stage.radix - 1) * m);
+        for(uint32_t k = 1; k < stage.radix; k++){
+            float *wr = stage.w.data() + 2 * (k - 1) * m;
+            float *wi = wr + m;
+            for(uint32_t p = 0; p < m; p++){
+                double a = -2.0 * M_PI * k * p / n;
+                wr[p] = cos(a);
+                wi[p] = sin(a);
+            }
+        }
+        n /= stage.radix;
+        s *= stage.radix;
+        m_stages.push_back(std::move(stage));
+    }
+}
+
+auto CStockham::run(float *buffer,uint32_t count) const -> bool {
+    const uint32_t m = m_length;
+    bool swapped = false;
+    for(const auto &stage : m_stages){
+        for(uint32_t c = 0; c < count; c++){
+            float *x = buffer + 4 * (size_t)m * c;
+            float *y = x + 2 * m;
+            if (swapped) std::swap(x,y);
+            if (stage.radix == 4){
+                radix4(stage,x,x + m,y,y + m);
+            }else{
+                radix2(stage,x,x + m,y,y + m);
+            }
+        }
+        swapped = !swapped;
+    }
+    return swapped;
+}
+
+CSimdPlan::CSimdPlan(uint32_t length) : CFFTPlan(length,FFT_SINGLE),
+    m_half(length / 2),
+    m_core(length / 2)
+{
+    m_post_r.resize(m_half);
+    m_post_i.resize(m_half);
+    for(uint32_t k = 0; k < m_half; k++){
+        double a = -2.0 * M_PI * k / length;
+        m_post_r[k] = cos(a);
+        m_post_i[k] = sin(a);
+    }
+}
+
+template<>
+auto CSimdPlan::load(const float *in,float *zr,float *zi) const -> void {
+    uint32_t k = 0;
+    for(; k + 4 <= m_half; k += 4){
+        v4sf a = ld(in + 2 * k);
+        v4sf b = ld(in + 2 * k + 4);
+        st(zr + k,__builtin_shuffle(a,b,v4si{0,2,4,6}));
+        st(zi + k,__builtin_shuffle(a,b,v4si{1,3,5,7}));
+    }
+    for(; k < m_half; k++){
+        zr[k] = in[2 * k];
+        zi[k] = in[2 * k + 1];
+    }
+}
+
+template<>
+auto CSimdPlan::load(const double *in,float *zr,float *zi) const -> void {
+    for(uint32_t k = 0; k < m_half; k++){
+        zr[k] = in[2 * k];
+        zi[k] = in[2 * k + 1];
+    }
+}
+
+auto CStockham::radix4(const stage_t &stage,const float *xr,const float *xi,float *yr,float *yi) const -> void {
+    const uint32_t s = stage.s;
+    const uint32_t m = stage.n / 4;
+    const float *w = stage.w.data();
+
+    if (s == 1 && m % 4 == 0){
+        for(uint32_t p = 0; p < m; p += 4){
+            v4sf ar[4], ai[4], wr[3], wi[3], br[4], bi[4];
+            for(int k = 0; k < 4; k++){
+                ar[k] = ld(xr + p + k * m);
+                ai[k] = ld(xi + p + k * m);
+            }
+            for(int k = 0; k < 3; k++){
+                wr[k] = ld(w + 2 * k * m + p);
+                wi[k] = ld(w + (2 * k + 1) * m + p);
+            }
+            butterfly4(ar,ai,wr,wi,br,bi);
+            // Output k of butterfly p goes to 4 * p + k
+            transpose(br[0],br[1],br[2],br[3]);
+            transpose(bi[0],bi[1],bi[2],bi[3]);
+            for(int k = 0; k < 4; k++){
+                st(yr + 4 * (p + k),br[k]);
+                st(yi + 4 * (p + k),bi[k]);
+            }
+        }
+        return;
+    }
+
+    for(uint32_t p = 0; p < m; p++){
+        float wr[3], wi[3];
+        for(int k = 0; k < 3; k++){
+            wr[k] = w[2 * k * m + p];
+            wi[k] = w[(2 * k + 1) * m + p];
+        }
+        uint32_t q = 0;
+        if (s % 4 == 0){
+            v4sf vwr[3] = {splat(wr[0]),splat(wr[1]),splat(wr[2])};
+            v4sf vwi[3] = {splat(wi[0]),splat(wi[1]),splat(wi[2])};
+            for(; q < s; q += 4){
+                v4sf ar[4], ai[4], br[4], bi[4];
+                for(int k = 0; k < 4; k++){
+                    ar[k] = ld(xr + q + s * (p + k * m));
+                    ai[k] = ld(xi + q + s * (p + k * m));
+                }
+                butterfly4(ar,ai,vwr,vwi,br,bi);
+                for(int k = 0; k < 4; k++){
+                    st(yr + q + s * (4 * p + k),br[k]);
+                    st(yi + q + s * (4 * p + k),bi[k]);
+                }
+            }
+        }
+        for(; q < s; q++){
+            float ar[4], ai[4], br[4], bi[4];
+            for(int k = 0; k < 4; k++){
+                ar[k] = xr[q + s * (p + k * m)];
+                ai[k] = xi[q + s * (p + k * m)];
+            }
+            butterfly4(ar,ai,wr,wi,br,bi);
+            for(int k = 0; k < 4; k++){
+                yr[q + s * (4 * p + k)] = br[k];
+                yi[q + s * (4 * p + k)] = bi[k];
+            }
+        }
+    }
+}
+
+// The last stage of an odd log2(N/2), a single butterfly with unit twiddle per stride
+auto CStockham::radix2(const stage_t &stage,const float *xr,const float *xi,float *yr,float *yi) const -> void {
+    const uint32_t s = stage.s;
+    uint32_t q = 0;
+    for(; q + 4 <= s; q += 4){
+        v4sf ar = ld(xr + q), ai = ld(xi + q);
+        v4sf br = ld(xr + q + s), bi = ld(xi + q + s);
+        st(yr + q,ar + br);
+        st(yi + q,ai + bi);
+        st(yr + q + s,ar - br);
+        st(yi + q + s,ai - bi);
+    }
+    for(; q < s; q++){
+        float ar = xr[q], ai = xi[q];
+        float br = xr[q + s], bi = xi[q + s];
+        yr[q] = ar + br;
+        yi[q] = ai + bi;
+        yr[q + s] = ar - br;
+        yi[q + s] = ai - bi;
+    }
+}
+
+// X[k] = (Z[k] + Z*[M-k]) / 2 - j W^k (Z[k] - Z*[M-k]) / 2
+auto CSimdPlan::unpack(const float *zr,const float *zi,float *re,float *im) const -> void {
+    const uint32_t m = m_half;
+    re[0] = zr[0] + zi[0];
+    im[0] = 0;
+    re[m] = zr[0] - zi[0];
+    im[m] = 0;
+
+    uint32_t k = 1;
+    const v4sf half = splat(0.5f);
+    for(; k + 4 <= m; k += 4){
+        v4sf ar = ld(zr + k), ai = ld(zi + k);
+        v4sf br = reverse(ld(zr + m - k - 3));
+        v4sf bi = -reverse(ld(zi + m - k - 3));
+        v4sf wr = ld(m_post_r.data() + k), wi = ld(m_post_i.data() + k);
+        v4sf er = (ar + br) * half, ei = (ai + bi) * half;
+        v4sf or_ = (ar - br) * half, oi = (ai - bi) * half;
+        v4sf pr = wr * or_ - wi * oi;
+        v4sf pi = wr * oi + wi * or_;
+        st(re + k,er + pi);
+        st(im + k,ei - pr);
+    }
+    for(; k < m; k++){
+        float ar = zr[k], ai = zi[k];
+        float br = zr[m - k], bi = -zi[m - k];
+        float er = (ar + br) * 0.5f, ei = (ai + bi) * 0.5f;
+        float or_ = (ar - br) * 0.5f, oi = (ai - bi) * 0.5f;
+        float pr = m_post_r[k] * or_ - m_post_i[k] * oi;
+        float pi = m_post_r[k] * oi + m_post_i[k] * or_;
+        re[k] = er + pi;
+        im[k] = ei - pr;
+    }
+}
+
+template<typename T>
+auto CSimdPlan::run(const T * const *in,float * const *re,float * const *im,uint32_t count) const -> void {
+    const uint32_t m = m_half;
+    float *buffer = scratch(4 * (size_t)m * count);
+    for(uint32_t c = 0; c < count; c++){
+        float *x = buffer + 4 * (size_t)m * c;
+        load(in[c],x,x + m);
+    }
+
+    bool swapped = m_core.run(buffer,count);
+
+    for(uint32_t c = 0; c < count; c++){
+        float *z = buffer + 4 * (size_t)m * c + (swapped ? 2 * m : 0);
+        unpack(z,z + m,re[c],im[c]);
+    }
+}
+
+auto CSimdPlan::forward(const float *in,float *re,float *im) const -> void {
+    run(&in,&re,&im,1);
+}
+
+auto CSimdPlan::forward(const double *in,float *re,float *im) const -> void {
+    run(&in,&re,&im,1);
+}
+
+auto CSimdPlan::forwardBatch(const double * const *in,float * const *re,float * const *im,uint32_t count) const -> void {
+    run(in,re,im,count);
+}
+
+auto CSimdPlan::forwardBatch(const float * const *in,float * const *re,float * const *im,uint32_t count) const -> void {
+    run(in,re,im,count);
+}
+
+CSimdComplexPlan::CSimdComplexPlan(uint32_t length) : CFFTComplexPlan(length),
+    m_core(length)
+{}
+
+auto CSimdComplexPlan::forward(const float *inRe,const float *inIm,float *outRe,float *outIm) const -> void {
+    const uint32_t n = length();
+    float *buffer = scratch(4 * (size_t)n);
+    memcpy(buffer,inRe,n * sizeof(float));
+    memcpy(buffer + n,inIm,n * sizeof(float));
+    float *z = buffer + (m_core.run(buffer,1) ? 2 * n : 0);
+    memcpy(outRe,z,n * sizeof(float));
+    memcpy(outIm,z + n,n * sizeof(float));
+}
+
+/**
+ * kiss_fftr in double precision. The configuration holds the work buffer of kiss_fftr,
+ * so the transforms of one plan are serialized.
+ */
+class CKissPlan : public CFFTPlan {
+public:
+    CKissPlan(uint32_t length);
+    ~CKissPlan();
+
+    auto forward(const float *in,float *re,float *im) const -> void override;
+    auto forward(const double *in,float *re,float *im) const -> void override;
+
+private:
+
+    kiss_fftr_cfg      m_cfg;
+    mutable std::mutex m_mutex;
+};
+
+CKissPlan::CKissPlan(uint32_t length) : CFFTPlan(length,FFT_DOUBLE),
+    m_cfg(kiss_fftr_alloc(length,0,NULL,NULL))
+{
+    if (!m_cfg) throw std::bad_alloc();
+}
+
+CKissPlan::~CKissPlan(){
+    kiss_fftr_free(m_cfg);
+}
+
+auto CKissPlan::forward(const float *in,float *re,float *im) const -> void {
+    thread_local std::vector<double> buffer;
+    buffer.assign(in,in + length());
+    forward(buffer.data(),re,im);
+}
+
+auto CKissPlan::forward(const double *in,float *re,float *im) const -> void {
+    thread_local std::vector<kiss_fft_scalar> input;
+    thread_local std::vector<kiss_fft_cpx> output;
+    const kiss_fft_scalar *data = reinterpret_cast<const kiss_fft_scalar*>(in);
+    if (!std::is_same<kiss_fft_scalar,double>::value){
+        input.assign(in,in + length());
+        data = input.data();
+    }
+    output.resize(length() / 2 + 1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        kiss_fftr(m_cfg,data,output.data());
+    }
+    for(uint32_t i = 0; i <= length() / 2; i++){
+        re[i] = output[i].r;
+        im[i] = output[i].i;
+    }
+}
+
+std::mutex g_cache_mutex;
+std::map<std::pair<uint32_t,fft_precision_t>,CFFTPlan::Ptr> g_cache;
+std::map<uint32_t,CFFTComplexPlan::Ptr> g_complex_cache;
+
+}
+
+CFFTPlan::CFFTPlan(uint32_t length,fft_precision_t precision) :
+    m_length(length),
+    m_precision(precision)
+{}
+
+auto CFFTPlan::get(uint32_t length,fft_precision_t precision) -> Ptr {
+    if (!isPowerOf2(length) || length < 4){
+        fprintf(stderr,"[Error:CFFTPlan::get] Length %u is not a power of 2\n",length);
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    auto key = std::make_pair(length,precision);
+    auto it = g_cache.find(key);
+    if (it != g_cache.end()){
+        return it->second;
+    }
+    try{
+        Ptr plan;
+        if (precision == FFT_DOUBLE){
+            plan = std::make_shared<CKissPlan>(length);
+        }else{
+            plan = std::make_shared<CSimdPlan>(length);
+        }
+        g_cache[key] = plan;
+        return plan;
+    }catch (const std::bad_alloc &) {
+        fprintf(stderr,"[Error:CFFTPlan::get] Can not allocate plan of length %u\n",length);
+        return nullptr;
+    }
+}
+
+auto CFFTPlan::clearCache() -> void {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    g_cache.clear();
+    g_complex_cache.clear();
+}
+
+auto CFFTPlan::forwardBatch(const double * const *in,float * const *re,float * const *im,uint32_t count) const -> void {
+    for(uint32_t c = 0; c < count; c++){
+        forward(in[c],re[c],im[c]);
+    }
+}
+
+auto CFFTPlan::forwardBatch(const float * const *in,float * const *re,float * const *im,uint32_t count) const -> void {
+    for(uint32_t c = 0; c < count; c++){
+        forward(in[c],re[c],im[c]);
+    }
+}
+
+CFFTComplexPlan::CFFTComplexPlan(uint32_t length) :
+    m_length(length)
+{}
+
+auto CFFTComplexPlan::get(uint32_t length) -> Ptr {
+    if (!isPowerOf2(length) || length < 2){
+        fprintf(stderr,"[Error:CFFTComplexPlan::get] Length %u is not a power of 2\n",length);
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    auto it = g_complex_cache.find(length);
+    if (it != g_complex_cache.end()){
+        return it->second;
+    }
+    try{
+        Ptr plan = std::make_shared<CSimdComplexPlan>(length);
+        g_complex_cache[length] = plan;
+        return plan;
+    }catch (const std::bad_alloc &) {
+        fprintf(stderr,"[Error:CFFTComplexPlan::get] Can not allocate plan of length %u\n",length);
+        return nullptr;
+    }
+}
+
+auto CFFTComplexPlan::inverse(const float *inRe,const float *inIm,float *outRe,float *outIm) const -> void {
+    // IDFT(x) is the DFT with the real and imaginary parts swapped on both sides
+    forward(inIm,inRe,outIm,outRe);
+}
+
+auto rp_dsp_api::fftSpectrum(const float *re,const float *im,uint32_t size,float scale,bool power,double *out) -> void {
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t zero = vdupq_n_f32(0);
+    for(; i + 4 <= size; i += 4){
+        float32x4_t r = vld1q_f32(re + i);
+        float32x4_t m = vld1q_f32(im + i);
+        float32x4_t p = vmlaq_f32(vmulq_f32(r,r),m,m);
+        if (!power){
+            // Reciprocal square root estimate with two Newton steps, rsqrt(0) is inf so empty bins are masked
+            float32x4_t e = vrsqrteq_f32(p);
+            e = vmulq_f32(e,vrsqrtsq_f32(vmulq_f32(p,e),e));
+            e = vmulq_f32(e,vrsqrtsq_f32(vmulq_f32(p,e),e));
+            p = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(p,e)),vcgtq_f32(p,zero)));
+        }
+        float v[4];
+        vst1q_f32(v,vmulq_f32(p,vscale));
+        out[i] = v[0];
+        out[i + 1] = v[1];
+        out[i + 2] = v[2];
+        out[i + 3] = v[3];
+    }
+#elif defined(__SSE__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for(; i + 4 <= size; i += 4){
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        __m128 p = _mm_add_ps(_mm_mul_ps(r,r),_mm_mul_ps(m,m));
+        if (!power){
+            p = _mm_sqrt_ps(p);
+        }
+        float v[4];
+        _mm_storeu_ps(v,_mm_mul_ps(p,vscale));
+        out[i] = v[0];
+        out[i + 1] = v[1];
+        out[i + 2] = v[2];
+        out[i + 3] = v[3];
+    }
+#endif
+    for(; i < size; i++){
+        float p = re[i] * re[i] + im[i] * im[i];
+        out[i] = scale * (power ? p : sqrtf(p));
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya real FFT engine with cached plans.
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#ifndef __RP_FFT_H__
+#define __RP_FFT_H__
+
+#include <stdint.h>
+#include <memory>
+
+namespace rp_dsp_api {
+
+/**
+ * Precision of the transform. SINGLE is the SIMD radix 4 engine (NEON on the board,
+ * SSE on x86 through the GCC vector extensions), DOUBLE is kiss_fft, kept as the reference.
+ */
+typedef enum {
+    FFT_SINGLE = 0,
+    FFT_DOUBLE = 1
+} fft_precision_t;
+
+/**
+ * Forward real FFT of a fixed power of 2 length.
+ * The output has length()/2 + 1 bins as separate real and imaginary arrays, not normalized like kiss_fftr.
+ * Plans are immutable and shared, the scratch memory is per thread.
+ */
+class CFFTPlan {
+public:
+    using Ptr = std::shared_ptr<CFFTPlan>;
+
+    /**
+     * Returns the cached plan for the length and precision, it is built on the first request.
+     * Length must be a power of 2 and at least 4.
+     */
+    static auto get(uint32_t length,fft_precision_t precision) -> Ptr;
+    // Drops the real and the complex plans
+    static auto clearCache() -> void;
+
+    virtual ~CFFTPlan() = default;
+
+    auto length() const -> uint32_t { return m_length; }
+    auto precision() const -> fft_precision_t { return m_precision; }
+
+    virtual auto forward(const float *in,float *re,float *im) const -> void = 0;
+    virtual auto forward(const double *in,float *re,float *im) const -> void = 0;
+
+    /**
+     * Transforms "count" channels in one pass. The stages run over all channels
+     * before the next stage, so the twiddles are loaded once per stage.
+     */
+    virtual auto forwardBatch(const double * const *in,float * const *re,float * const *im,uint32_t count) const -> void;
+    virtual auto forwardBatch(const float * const *in,float * const *re,float * const *im,uint32_t count) const -> void;
+
+protected:
+
+    CFFTPlan(uint32_t length,fft_precision_t precision);
+
+private:
+
+    CFFTPlan(const CFFTPlan &) = delete;
+    CFFTPlan(CFFTPlan &&) = delete;
+    CFFTPlan& operator=(const CFFTPlan&) =delete;
+    CFFTPlan& operator=(const CFFTPlan&&) =delete;
+
+    uint32_t        m_length;
+    fft_precision_t m_precision;
+};
+
+/**
+ * Complex FFT of a power of 2 length on separate real and imaginary planes, single precision.
+ * Input and output may be the same arrays. Neither direction is normalized.
+ */
+class CFFTComplexPlan {
+public:
+    using Ptr = std::shared_ptr<CFFTComplexPlan>;
+
+    // Returns the cached plan for the length, it is built on the first request
+    static auto get(uint32_t length) -> Ptr;
+
+    virtual ~CFFTComplexPlan() = default;
+
+    auto length() const -> uint32_t { return m_length; }
+
+    virtual auto forward(const float *inRe,const float *inIm,float *outRe,float *outIm) const -> void = 0;
+    auto inverse(const float *inRe,const float *inIm,float *outRe,float *outIm) const -> void;
+
+protected:
+
+    CFFTComplexPlan(uint32_t length);
+
+private:
+
+    CFFTComplexPlan(const CFFTComplexPlan &) = delete;
+    CFFTComplexPlan(CFFTComplexPlan &&) = delete;
+    CFFTComplexPlan& operator=(const CFFTComplexPlan&) =delete;
+    CFFTComplexPlan& operator=(const CFFTComplexPlan&&) =delete;
+
+    uint32_t m_length;
+};
+
+/**
+ * Fused spectrum kernel over "size" bins: out = scale * |X| or, with power, out = scale * |X|^2.
+ */
+auto fftSpectrum(const float *re,const float *im,uint32_t size,float scale,bool power,double *out) -> void;
+
+}
+
+#endif
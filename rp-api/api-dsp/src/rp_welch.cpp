@@ -0,0 +1,244 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya streaming spectral estimator (Welch method).
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "rp_welch.h"
+#include "rp_fft.h"
+
+using namespace rp_dsp_api;
+
+auto CWelch::create(uint8_t channels,uint32_t segment,CDSP::window_mode_t window,double overlap) -> Ptr {
+    if (channels == 0 || overlap < 0 || overlap >= 1){
+        fprintf(stderr,"[Error:CWelch::create] Wrong channels %d or overlap %f\n",channels,overlap);
+        return nullptr;
+    }
+    auto plan = CFFTPlan::get(segment,FFT_SINGLE);
+    if (!plan) return nullptr;
+    uint32_t hop = std::max<uint32_t>(1,segment - (uint32_t)(overlap * segment));
+    try{
+        auto welch = std::make_shared<CWelch>(channels,segment,hop,plan);
+        if (welch->setWindow(window)) return nullptr;
+        return welch;
+    }catch (const std::bad_alloc &) {
+        fprintf(stderr,"[Error:CWelch::create] Can not allocate mem\n");
+        return nullptr;
+    }
+}
+
+CWelch::CWelch(uint8_t channels,uint32_t segment,uint32_t hop,std::shared_ptr<CFFTPlan> plan) :
+    m_channels(channels),
+    m_segment(segment),
+    m_hop(hop),
+    m_bins(segment / 2 + 1),
+    m_fill(0),
+    m_scale(0),
+    m_enbw(1),
+    m_plan(plan),
+    m_mode(AVG_EXPONENTIAL),
+    m_avgCount(10),
+    m_peakHold(false),
+    m_segments(0),
+    m_blockCount(0),
+    m_window(segment,1.f),
+    m_buffer(channels,std::vector<float>(segment)),
+    m_windowed(channels,std::vector<float>(segment)),
+    m_re(channels,std::vector<float>(m_bins)),
+    m_im(channels,std::vector<float>(m_bins)),
+    m_segmentPower(m_bins),
+    m_power(channels,std::vector<double>(m_bins)),
+    m_sum(channels,std::vector<double>(m_bins)),
+    m_peak(channels,std::vector<double>(m_bins))
+{}
+
+CWelch::~CWelch(){}
+
+auto CWelch::setWindow(CDSP::window_mode_t window) -> int {
+    std::vector<double> w(m_segment);
+    double sum = CDSP::fillWindow(window,m_segment,w.data());
+    if (sum <= 0){
+        fprintf(stderr,"[Error:CWelch::setWindow] Unknown window %d\n",window);
+        return -1;
+    }
+    double sum2 = 0;
+    for(auto x : w) sum2 += x * x;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::copy(w.begin(),w.end(),m_window.begin());
+    // Single sided, a sine of amplitude A gives |X| = A * sum / 2 at its bin
+    m_scale = 2.0 / (sum * sum);
+    m_enbw = m_segment * sum2 / (sum * sum);
+    return 0;
+}
+
+auto CWelch::setAveraging(average_mode_t mode,uint32_t count) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mode = mode;
+    m_avgCount = std::max<uint32_t>(1,count);
+    m_blockCount = 0;
+    for(auto &s : m_sum) std::fill(s.begin(),s.end(),0);
+}
+
+auto CWelch::setPeakHold(bool enable) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_peakHold = enable;
+    for(auto &p : m_peak) std::fill(p.begin(),p.end(),0);
+}
+
+auto CWelch::reset() -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fill = 0;
+    m_segments = 0;
+    m_blockCount = 0;
+    for(uint8_t c = 0; c < m_channels; c++){
+        std::fill(m_power[c].begin(),m_power[c].end(),0);
+        std::fill(m_sum[c].begin(),m_sum[c].end(),0);
+        std::fill(m_peak[c].begin(),m_peak[c].end(),0);
+    }
+}
+
+auto CWelch::getBins() -> uint32_t {
+    return m_bins;
+}
+
+auto CWelch::getSegments() -> uint64_t {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_segments;
+}
+
+auto CWelch::getENBW() -> double {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_enbw;
+}
+
+auto CWelch::getPower(uint8_t channel,double *out) -> int {
+    if (channel >= m_channels || !out){
+        fprintf(stderr,"[Error:CWelch::getPower] Wrong channel %d\n",channel);
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::copy(m_power[channel].begin(),m_power[channel].end(),out);
+    return 0;
+}
+
+auto CWelch::getPeakHold(uint8_t channel,double *out) -> int {
+    if (channel >= m_channels || !out){
+        fprintf(stderr,"[Error:CWelch::getPeakHold] Wrong channel %d\n",channel);
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::copy(m_peak[channel].begin(),m_peak[channel].end(),out);
+    return 0;
+}
+
+auto CWelch::push(const float * const *in,uint32_t size) -> uint32_t {
+    return pushSamples(in,size);
+}
+
+auto CWelch::push(const double * const *in,uint32_t size) -> uint32_t {
+    return pushSamples(in,size);
+}
+
+template<typename T>
+auto CWelch::pushSamples(const T * const *in,uint32_t size) -> uint32_t {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t done = 0;
+    uint32_t pos = 0;
+    while(pos < size){
+        uint32_t n = std::min(size - pos,m_segment - m_fill);
+        for(uint8_t c = 0; c < m_channels; c++){
+            std::copy(in[c] + pos,in[c] + pos + n,m_buffer[c].begin() + m_fill);
+        }
+        m_fill += n;
+        pos += n;
+        if (m_fill == m_segment){
+            processSegment();
+            done++;
+            // The overlap stays at the start of the buffer for the next segment
+            uint32_t keep = m_segment - m_hop;
+            for(uint8_t c = 0; c < m_channels; c++){
+                memmove(m_buffer[c].data(),m_buffer[c].data() + m_hop,keep * sizeof(float));
+            }
+            m_fill = keep;
+        }
+    }
+    return done;
+}
+
+auto CWelch::processSegment() -> void {
+    const float *in[UINT8_MAX];
+    float *re[UINT8_MAX];
+    float *im[UINT8_MAX];
+    for(uint8_t c = 0; c < m_channels; c++){
+        const float *x = m_buffer[c].data();
+        float *y = m_windowed[c].data();
+        for(uint32_t i = 0; i < m_segment; i++){
+            y[i] = x[i] * m_window[i];
+        }
+        in[c] = y;
+        re[c] = m_re[c].data();
+        im[c] = m_im[c].data();
+    }
+    m_plan->forwardBatch(in,re,im,m_channels);
+
+    // Exponential average starts as a running mean, so the first N segments weigh the same
+    double alpha = 1.0 / std::min<uint64_t>(m_segments + 1,m_avgCount);
+    m_blockCount++;
+    bool blockDone = m_blockCount == m_avgCount;
+    for(uint8_t c = 0; c < m_channels; c++){
+        double *p = m_segmentPower.data();
+        fftSpectrum(re[c],im[c],m_bins,m_scale,true,p);
+        // DC and Nyquist have no mirror bin
+        p[0] *= 0.5;
+        p[m_bins - 1] *= 0.5;
+
+        auto &power = m_power[c];
+        auto &sum = m_sum[c];
+        switch (m_mode) {
+            case AVG_NONE:
+                std::copy(p,p + m_bins,power.begin());
+                break;
+            case AVG_EXPONENTIAL:
+                for(uint32_t i = 0; i < m_bins; i++){
+                    power[i] += (p[i] - power[i]) * alpha;
+                }
+                break;
+            case AVG_BLOCK:
+                for(uint32_t i = 0; i < m_bins; i++){
+                    sum[i] += p[i];
+                }
+                // Running mean until the first block is complete
+                if (blockDone || m_segments < m_avgCount){
+                    for(uint32_t i = 0; i < m_bins; i++){
+                        power[i] = sum[i] / m_blockCount;
+                    }
+                }
+                if (blockDone){
+                    std::fill(sum.begin(),sum.end(),0);
+                }
+                break;
+        }
+
+        if (m_peakHold){
+            auto &peak = m_peak[c];
+            for(uint32_t i = 0; i < m_bins; i++){
+                peak[i] = std::max(peak[i],p[i]);
+            }
+        }
+    }
+    if (blockDone){
+        m_blockCount = 0;
+    }
+    m_segments++;
+}
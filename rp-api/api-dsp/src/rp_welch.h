@@ -0,0 +1,112 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya streaming spectral estimator (Welch method).
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#ifndef __RP_WELCH_H__
+#define __RP_WELCH_H__
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rp_dsp.h"
+
+namespace rp_dsp_api{
+
+class CFFTPlan;
+
+/**
+ * Accepts sample chunks of any size and cuts them into overlapped, windowed segments.
+ * The power spectra of the segments are averaged in linear power, and the peak hold
+ * keeps the maximum of every bin. The window is computed once and the FFT plan comes
+ * from the shared plan cache.
+ * All channels are pushed together with the same number of samples.
+ */
+class CWelch{
+
+public:
+
+    using Ptr = std::shared_ptr<CWelch>;
+
+    typedef enum{
+        AVG_NONE        = 0,    // Last segment only
+        AVG_EXPONENTIAL = 1,    // Mean of the first N segments, then weight 1/N for each new segment
+        AVG_BLOCK       = 2     // Mean of N segments, the result is kept until the next N are complete
+    } average_mode_t;
+
+    /**
+     * Segment is a power of 2, overlap is the part of the segment shared with the next one, from 0 to 1 (excluded).
+     * Returns nullptr for invalid arguments.
+     */
+    static auto create(uint8_t channels,uint32_t segment,CDSP::window_mode_t window,double overlap) -> Ptr;
+
+    CWelch(uint8_t channels,uint32_t segment,uint32_t hop,std::shared_ptr<CFFTPlan> plan);
+    ~CWelch();
+
+    auto setWindow(CDSP::window_mode_t window) -> int;
+    auto setAveraging(average_mode_t mode,uint32_t count) -> void;
+    auto setPeakHold(bool enable) -> void;
+    // Drops the averages, the peak hold and the samples of the unfinished segment
+    auto reset() -> void;
+
+    // Adds "size" samples of every channel, returns the number of the completed segments
+    auto push(const float * const *in,uint32_t size) -> uint32_t;
+    auto push(const double * const *in,uint32_t size) -> uint32_t;
+
+    auto getBins() -> uint32_t;
+    auto getSegments() -> uint64_t;
+    // Equivalent noise bandwidth of the window in bins. The noise density is power / (enbw * fs / segment)
+    auto getENBW() -> double;
+
+    // Power spectrum in V^2 rms per bin, getBins() values. A sine of amplitude A gives A^2/2 at its bin
+    auto getPower(uint8_t channel,double *out) -> int;
+    auto getPeakHold(uint8_t channel,double *out) -> int;
+
+private:
+
+    CWelch(const CWelch &) = delete;
+    CWelch(CWelch &&) = delete;
+    CWelch& operator=(const CWelch&) =delete;
+    CWelch& operator=(const CWelch&&) =delete;
+
+    template<typename T>
+    auto pushSamples(const T * const *in,uint32_t size) -> uint32_t;
+    auto processSegment() -> void;
+
+    uint8_t   m_channels;
+    uint32_t  m_segment;
+    uint32_t  m_hop;
+    uint32_t  m_bins;
+    uint32_t  m_fill;
+    double    m_scale;
+    double    m_enbw;
+    std::shared_ptr<CFFTPlan> m_plan;
+
+    average_mode_t m_mode;
+    uint32_t  m_avgCount;
+    bool      m_peakHold;
+    uint64_t  m_segments;   // Segments since reset
+    uint32_t  m_blockCount; // Segments in the current block
+
+    std::vector<float>  m_window;
+    std::vector<std::vector<float>>  m_buffer;
+    std::vector<std::vector<float>>  m_windowed;
+    std::vector<std::vector<float>>  m_re;
+    std::vector<std::vector<float>>  m_im;
+    std::vector<double> m_segmentPower;
+    std::vector<std::vector<double>> m_power;
+    std::vector<std::vector<double>> m_sum;
+    std::vector<std::vector<double>> m_peak;
+    std::mutex m_mutex;
+};
+
+}
+
+#endif
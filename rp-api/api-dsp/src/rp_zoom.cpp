@@ -0,0 +1,142 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya zoom spectrum (chirp-z transform).
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#include <new>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "rp_zoom.h"
+#include "rp_fft.h"
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+using namespace rp_dsp_api;
+
+namespace {
+
+// exp(-j 2 pi cycles), reduced in double before the conversion to float
+auto phasor(double cycles,float &re,float &im) -> void {
+    double a = -2.0 * M_PI * (cycles - floor(cycles));
+    re = cos(a);
+    im = sin(a);
+}
+
+}
+
+auto CZoomFFT::create(uint32_t length,uint32_t bins,double f1,double f2,double fs) -> Ptr {
+    if (length == 0 || bins == 0 || fs <= 0 || f2 < f1){
+        fprintf(stderr,"[Error:CZoomFFT::create] Wrong arguments length %u bins %u f1 %f f2 %f fs %f\n",length,bins,f1,f2,fs);
+        return nullptr;
+    }
+    uint32_t n = 2;
+    while(n < length + bins - 1) n <<= 1;
+    auto plan = CFFTComplexPlan::get(n);
+    if (!plan) return nullptr;
+    try{
+        return std::make_shared<CZoomFFT>(length,bins,f1,f2,fs,plan);
+    }catch (const std::bad_alloc &) {
+        fprintf(stderr,"[Error:CZoomFFT::create] Can not allocate mem\n");
+        return nullptr;
+    }
+}
+
+/**
+ * X[k] = sum x[n] A^-n W^nk with A = exp(j 2 pi f1 / fs) and W = exp(-j 2 pi step / fs).
+ * With nk = (n^2 + k^2 - (k - n)^2) / 2 the sum is a convolution of x[n] A^-n W^(n^2/2)
+ * with W^(-m^2/2), followed by the multiplication with W^(k^2/2).
+ */
+CZoomFFT::CZoomFFT(uint32_t length,uint32_t bins,double f1,double f2,double fs,std::shared_ptr<CFFTComplexPlan> plan) :
+    m_length(length),
+    m_bins(bins),
+    m_f1(f1),
+    m_step(bins > 1 ? (f2 - f1) / (bins - 1) : 0),
+    m_plan(plan),
+    m_preRe(length),
+    m_preIm(length),
+    m_postRe(bins),
+    m_postIm(bins),
+    m_filterRe(plan->length(),0),
+    m_filterIm(plan->length(),0),
+    m_workRe(plan->length()),
+    m_workIm(plan->length())
+{
+    const uint32_t n = plan->length();
+    const double step = m_step / fs;
+    for(uint32_t i = 0; i < length; i++){
+        phasor(f1 / fs * i + step * i * (double)i / 2,m_preRe[i],m_preIm[i]);
+    }
+    for(uint32_t k = 0; k < bins; k++){
+        phasor(step * k * (double)k / 2,m_postRe[k],m_postIm[k]);
+    }
+    // W^(-m^2/2) for m from -(length - 1) to bins - 1, the negative part wraps to the end
+    for(uint32_t k = 0; k < bins; k++){
+        phasor(-step * k * (double)k / 2,m_filterRe[k],m_filterIm[k]);
+    }
+    for(uint32_t i = 1; i < length; i++){
+        phasor(-step * i * (double)i / 2,m_filterRe[n - i],m_filterIm[n - i]);
+    }
+    plan->forward(m_filterRe.data(),m_filterIm.data(),m_filterRe.data(),m_filterIm.data());
+    for(uint32_t i = 0; i < n; i++){
+        m_filterRe[i] /= n;
+        m_filterIm[i] /= n;
+    }
+}
+
+CZoomFFT::~CZoomFFT(){}
+
+auto CZoomFFT::getLength() -> uint32_t {
+    return m_length;
+}
+
+auto CZoomFFT::getBins() -> uint32_t {
+    return m_bins;
+}
+
+auto CZoomFFT::getFrequency(uint32_t bin) -> double {
+    return m_f1 + m_step * bin;
+}
+
+auto CZoomFFT::transform(const double *in,float *re,float *im) -> void {
+    run(in,re,im);
+}
+
+auto CZoomFFT::transform(const float *in,float *re,float *im) -> void {
+    run(in,re,im);
+}
+
+template<typename T>
+auto CZoomFFT::run(const T *in,float *re,float *im) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint32_t n = m_plan->length();
+    float *yr = m_workRe.data();
+    float *yi = m_workIm.data();
+    for(uint32_t i = 0; i < m_length; i++){
+        yr[i] = in[i] * m_preRe[i];
+        yi[i] = in[i] * m_preIm[i];
+    }
+    std::fill(yr + m_length,yr + n,0.f);
+    std::fill(yi + m_length,yi + n,0.f);
+
+    m_plan->forward(yr,yi,yr,yi);
+    for(uint32_t i = 0; i < n; i++){
+        float a = yr[i], b = yi[i];
+        yr[i] = a * m_filterRe[i] - b * m_filterIm[i];
+        yi[i] = a * m_filterIm[i] + b * m_filterRe[i];
+    }
+    m_plan->inverse(yr,yi,yr,yi);
+
+    for(uint32_t k = 0; k < m_bins; k++){
+        re[k] = yr[k] * m_postRe[k] - yi[k] * m_postIm[k];
+        im[k] = yr[k] * m_postIm[k] + yi[k] * m_postRe[k];
+    }
+}
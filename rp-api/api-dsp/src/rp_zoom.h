@@ -0,0 +1,80 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya zoom spectrum (chirp-z transform).
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ */
+
+#ifndef __RP_ZOOM_H__
+#define __RP_ZOOM_H__
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rp_dsp_api{
+
+class CFFTComplexPlan;
+
+/**
+ * Spectrum of "length" real samples at "bins" equally spaced frequencies from f1 to f2,
+ * computed as a chirp-z transform with Bluestein's method: two complex FFTs of the next
+ * power of 2 above length + bins - 1 from the shared plan cache.
+ * The bins have the scale of the DFT bins, so they go through the same magnitude and
+ * conversion steps as the full band FFT. With one bin it is the DFT at a single frequency.
+ * The bins sample the spectrum of the record more densely, the separation of two tones
+ * is still limited by the record length and the window.
+ */
+class CZoomFFT{
+
+public:
+
+    using Ptr = std::shared_ptr<CZoomFFT>;
+
+    // Returns nullptr for invalid arguments. Frequencies are in Hz for the sample rate fs.
+    static auto create(uint32_t length,uint32_t bins,double f1,double f2,double fs) -> Ptr;
+
+    CZoomFFT(uint32_t length,uint32_t bins,double f1,double f2,double fs,std::shared_ptr<CFFTComplexPlan> plan);
+    ~CZoomFFT();
+
+    auto transform(const double *in,float *re,float *im) -> void;
+    auto transform(const float *in,float *re,float *im) -> void;
+
+    auto getLength() -> uint32_t;
+    auto getBins() -> uint32_t;
+    auto getFrequency(uint32_t bin) -> double;
+
+private:
+
+    CZoomFFT(const CZoomFFT &) = delete;
+    CZoomFFT(CZoomFFT &&) = delete;
+    CZoomFFT& operator=(const CZoomFFT&) =delete;
+    CZoomFFT& operator=(const CZoomFFT&&) =delete;
+
+    template<typename T>
+    auto run(const T *in,float *re,float *im) -> void;
+
+    uint32_t m_length;
+    uint32_t m_bins;
+    double   m_f1;
+    double   m_step;
+    std::shared_ptr<CFFTComplexPlan> m_plan;
+
+    std::vector<float> m_preRe;      // Input chirp, length
+    std::vector<float> m_preIm;
+    std::vector<float> m_postRe;     // Output chirp, bins
+    std::vector<float> m_postIm;
+    std::vector<float> m_filterRe;   // Spectrum of the chirp filter, normalized for the inverse FFT
+    std::vector<float> m_filterIm;
+    std::vector<float> m_workRe;
+    std::vector<float> m_workIm;
+    std::mutex m_mutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @brief Test of the SIMD real FFT against the kiss_fft reference
+ *
+ * Builds on the board with -DBUILD_TEST=ON (NEON path) or on x86 with -DBUILD_SIM=ON -DBUILD_TEST=ON (SSE path).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+#include "rp_fft.h"
+
+using namespace rp_dsp_api;
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+static auto now() -> double {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static auto signal(uint32_t n, std::vector<double> &x) -> void {
+    x.resize(n);
+    for (uint32_t i = 0; i < n; i++){
+        x[i] = 0.7 * sin(2 * M_PI * 37.3 * i / n) + 0.2 * cos(2 * M_PI * 5 * i / n) + 0.05 * (rand() / (double)RAND_MAX - 0.5);
+    }
+}
+
+/* Largest bin error relative to the largest bin of the reference */
+static auto compare(uint32_t n, const std::vector<float> &re, const std::vector<float> &im,
+                    const std::vector<float> &rre, const std::vector<float> &rim) -> double {
+    double err = 0, max = 0;
+    for (uint32_t i = 0; i <= n / 2; i++){
+        err = fmax(err, hypot(re[i] - rre[i], im[i] - rim[i]));
+        max = fmax(max, hypot(rre[i], rim[i]));
+    }
+    return err / max;
+}
+
+static auto testAccuracy() -> void {
+    std::vector<double> x;
+    for (uint32_t n = 4; n <= 65536; n *= 2){
+        auto plan = CFFTPlan::get(n, FFT_SINGLE);
+        auto ref = CFFTPlan::get(n, FFT_DOUBLE);
+        CHECK(plan && ref, "plan");
+        if (!plan || !ref) return;
+        signal(n, x);
+        std::vector<float> re(n / 2 + 1), im(n / 2 + 1), rre(n / 2 + 1), rim(n / 2 + 1);
+        plan->forward(x.data(), re.data(), im.data());
+        ref->forward(x.data(), rre.data(), rim.data());
+        double err = compare(n, re, im, rre, rim);
+        if (err > 1e-5){
+            printf("FAIL accuracy n=%u err=%g\n", n, err);
+            g_failed++;
+        }
+
+        std::vector<float> xf(x.begin(), x.end());
+        plan->forward(xf.data(), re.data(), im.data());
+        CHECK(compare(n, re, im, rre, rim) < 1e-5, "float input");
+    }
+}
+
+static auto testBatch() -> void {
+    const uint32_t n = 16384;
+    auto plan = CFFTPlan::get(n, FFT_SINGLE);
+    std::vector<double> x[2];
+    std::vector<float> re[2], im[2], rre(n / 2 + 1), rim(n / 2 + 1);
+    for (int c = 0; c < 2; c++){
+        signal(n, x[c]);
+        re[c].resize(n / 2 + 1);
+        im[c].resize(n / 2 + 1);
+    }
+    const double *in[2] = {x[0].data(), x[1].data()};
+    float *pre[2] = {re[0].data(), re[1].data()};
+    float *pim[2] = {im[0].data(), im[1].data()};
+    plan->forwardBatch(in, pre, pim, 2);
+    for (int c = 0; c < 2; c++){
+        plan->forward(in[c], rre.data(), rim.data());
+        CHECK(re[c] == rre && im[c] == rim, "batch");
+    }
+    CHECK(CFFTPlan::get(n, FFT_SINGLE) == plan, "cached plan");
+}
+
+static auto testSpectrum() -> void {
+    float re[7] = {3, 0, -1, 5, 0.5f, 2, 0};
+    float im[7] = {4, 0, 0, 12, 0.5f, -2, 1};
+    double mag[7], pow[7];
+    fftSpectrum(re, im, 7, 2, false, mag);
+    fftSpectrum(re, im, 7, 2, true, pow);
+    bool ok = true;
+    for (int i = 0; i < 7; i++){
+        double p = re[i] * re[i] + im[i] * im[i];
+        ok &= fabs(mag[i] - 2 * sqrt(p)) < 1e-5 * (1 + mag[i]);
+        ok &= fabs(pow[i] - 2 * p) < 1e-5 * (1 + pow[i]);
+    }
+    CHECK(ok, "spectrum");
+}
+
+static auto bench() -> void {
+    const uint32_t n = 16384;
+    const int loops = 200;
+    std::vector<double> x;
+    signal(n, x);
+    std::vector<float> re(n / 2 + 1), im(n / 2 + 1);
+    for (auto precision : {FFT_DOUBLE, FFT_SINGLE}){
+        auto plan = CFFTPlan::get(n, precision);
+        double start = now();
+        for (int i = 0; i < loops; i++){
+            plan->forward(x.data(), re.data(), im.data());
+        }
+        printf("%s n=%u: %.1f us\n", precision == FFT_DOUBLE ? "kiss_fft" : "simd    ", n, (now() - start) / loops * 1e6);
+    }
+}
+
+int main(){
+    testAccuracy();
+    testBatch();
+    testSpectrum();
+    bench();
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
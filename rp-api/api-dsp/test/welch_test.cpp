@@ -0,0 +1,140 @@
+/**
+ * @brief Test of the streaming Welch estimator
+ *
+ * Builds on the board with -DBUILD_TEST=ON or on x86 with -DBUILD_SIM=ON -DBUILD_TEST=ON.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include "rp_welch.h"
+
+using namespace rp_dsp_api;
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+const uint32_t g_segment = 1024;
+const uint32_t g_tone_bin = 100;
+const double   g_amp = 0.5;
+const double   g_noise = 0.1;   // Uniform noise from -g_noise to g_noise, variance g_noise^2 / 3
+
+static auto signal(uint32_t size, uint64_t first, std::vector<float> &x) -> void {
+    x.resize(size);
+    for (uint32_t i = 0; i < size; i++){
+        double n = g_noise * (2.0 * rand() / RAND_MAX - 1);
+        x[i] = g_amp * sin(2 * M_PI * g_tone_bin * (first + i) / g_segment) + n;
+    }
+}
+
+/* Mean and relative deviation of the bins away from the tone */
+static auto noiseFloor(const std::vector<double> &p, double &mean, double &dev) -> void {
+    double s = 0, s2 = 0;
+    uint32_t n = 0;
+    for (uint32_t i = 10; i < p.size() - 10; i++){
+        if (i > g_tone_bin - 10 && i < g_tone_bin + 10) continue;
+        s += p[i];
+        s2 += p[i] * p[i];
+        n++;
+    }
+    mean = s / n;
+    dev = sqrt(s2 / n - mean * mean) / mean;
+}
+
+static auto testAverage() -> void {
+    auto welch = CWelch::create(1, g_segment, CDSP::HANNING, 0.5);
+    CHECK(welch, "create");
+    if (!welch) return;
+    welch->setAveraging(CWelch::AVG_EXPONENTIAL, 200);
+    welch->setPeakHold(true);
+
+    // Chunks that do not match the segment or the hop
+    std::vector<float> x;
+    uint64_t first = 0;
+    uint32_t segments = 0;
+    while (segments < 200){
+        uint32_t size = 100 + rand() % 900;
+        signal(size, first, x);
+        const float *in[1] = {x.data()};
+        segments += welch->push(in, size);
+        first += size;
+    }
+    CHECK(welch->getSegments() == segments, "segments");
+    CHECK(first / (g_segment / 2) - 1 == segments, "overlap hop");
+
+    std::vector<double> p(welch->getBins()), peak(welch->getBins());
+    welch->getPower(0, p.data());
+    welch->getPeakHold(0, peak.data());
+    double tone = g_amp * g_amp / 2;
+    if (fabs(p[g_tone_bin] - tone) > 0.01 * tone){
+        printf("FAIL tone power %g expected %g\n", p[g_tone_bin], tone);
+        g_failed++;
+    }
+
+    // The noise power over all bins is the variance times the ENBW
+    double mean, dev;
+    noiseFloor(p, mean, dev);
+    double variance = mean * g_segment / 2 / welch->getENBW();
+    if (fabs(variance - g_noise * g_noise / 3) > 0.05 * g_noise * g_noise / 3){
+        printf("FAIL noise variance %g expected %g\n", variance, g_noise * g_noise / 3);
+        g_failed++;
+    }
+    CHECK(dev < 0.2, "averaged floor is flat");
+
+    bool ok = true;
+    for (uint32_t i = 0; i < p.size(); i++) ok &= peak[i] >= p[i];
+    CHECK(ok, "peak hold above average");
+}
+
+static auto testNone() -> void {
+    auto welch = CWelch::create(2, g_segment, CDSP::HANNING, 0);
+    welch->setAveraging(CWelch::AVG_NONE, 1);
+    std::vector<float> x, y(g_segment, 0);
+    signal(g_segment, 0, x);
+    const float *in[2] = {x.data(), y.data()};
+    CHECK(welch->push(in, g_segment) == 1, "one segment");
+    std::vector<double> p(welch->getBins()), p2(welch->getBins());
+    welch->getPower(0, p.data());
+    welch->getPower(1, p2.data());
+    double mean, dev;
+    noiseFloor(p, mean, dev);
+    CHECK(dev > 0.5, "single segment floor is noisy");
+    CHECK(p2[g_tone_bin] == 0, "second channel");
+}
+
+static auto testBlock() -> void {
+    auto welch = CWelch::create(1, g_segment, CDSP::FLAT_TOP, 0.75);
+    welch->setAveraging(CWelch::AVG_BLOCK, 8);
+    std::vector<float> x;
+    signal(g_segment * 4, 0, x);
+    const float *in[1] = {x.data()};
+    CHECK(welch->push(in, g_segment * 4) == 13, "block segments");
+    std::vector<double> p(welch->getBins());
+    welch->getPower(0, p.data());
+    double tone = g_amp * g_amp / 2;
+    // The symmetric window of CDSP is off the periodic one by about 0.06 dB
+    CHECK(fabs(p[g_tone_bin] - tone) < 0.03 * tone, "flat top tone power");
+    welch->reset();
+    welch->getPower(0, p.data());
+    CHECK(p[g_tone_bin] == 0 && welch->getSegments() == 0, "reset");
+}
+
+int main(){
+    srand(1);
+    testAverage();
+    testNone();
+    testBlock();
+    CHECK(!CWelch::create(1, 1000, CDSP::HANNING, 0.5), "segment not power of 2");
+    CHECK(!CWelch::create(1, 1024, CDSP::HANNING, 1), "overlap 1");
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @brief Test of the chirp-z zoom spectrum against the direct DFT
+ *
+ * Builds on the board with -DBUILD_TEST=ON or on x86 with -DBUILD_SIM=ON -DBUILD_TEST=ON.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex>
+#include <vector>
+
+#include "rp_dsp.h"
+#include "rp_zoom.h"
+
+using namespace rp_dsp_api;
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+const double g_fs = 125e6 / 64;
+
+static auto signal(uint32_t n, double f1, double f2, std::vector<double> &x) -> void {
+    x.resize(n);
+    for (uint32_t i = 0; i < n; i++){
+        x[i] = 0.5 * sin(2 * M_PI * f1 * i / g_fs) + 0.1 * sin(2 * M_PI * f2 * i / g_fs + 1);
+    }
+}
+
+static auto testDFT(uint32_t n, uint32_t bins, double f1, double f2) -> void {
+    auto zoom = CZoomFFT::create(n, bins, f1, f2, g_fs);
+    CHECK(zoom, "create");
+    if (!zoom) return;
+    std::vector<double> x;
+    signal(n, 100e3, 100.5e3, x);
+    std::vector<float> re(bins), im(bins);
+    zoom->transform(x.data(), re.data(), im.data());
+
+    double err = 0, max = 0;
+    for (uint32_t k = 0; k < bins; k++){
+        std::complex<double> ref = 0;
+        double f = zoom->getFrequency(k);
+        for (uint32_t i = 0; i < n; i++){
+            ref += x[i] * std::polar(1.0, -2 * M_PI * f * i / g_fs);
+        }
+        err = fmax(err, std::abs(ref - std::complex<double>(re[k], im[k])));
+        max = fmax(max, std::abs(ref));
+    }
+    if (err > 1e-4 * max){
+        printf("FAIL dft n=%u bins=%u err=%g\n", n, bins, err / max);
+        g_failed++;
+    }
+}
+
+/* The full band peak is on the 477 Hz grid of the 4096 point FFT, the zoom bins are 3.4 Hz apart */
+static auto testCDSP() -> void {
+    const uint32_t n = 4096;
+    const double tone = 100.2e3;
+    CDSP dsp(1, n, 125e6);
+    dsp.setChannel(0, true);
+    dsp.setSignalLength(n);
+    dsp.window_init(CDSP::HANNING);
+    CHECK(dsp.fftInit() == 0, "fft init");
+    auto data = dsp.createData();
+    std::vector<double> x;
+    signal(n, tone, 103e3, x);
+    std::copy(x.begin(), x.end(), data->in[0]);
+
+    dsp.windowFilter(data);
+    dsp.fft(data);
+    dsp.decimate(data, dsp.getOutSignalLength(), dsp.getOutSignalLength());
+    dsp.cnvToDBM(data, 64);
+    float full = data->peak_freq[0];
+    float fullPower = data->peak_power[0];
+
+    CHECK(dsp.zoomInit(98e3, 105e3, g_fs) == 0, "zoom init");
+    CHECK(dsp.zoom(data) == 0, "zoom");
+    dsp.decimate(data, dsp.getOutSignalLength(), dsp.getOutSignalLength());
+    dsp.cnvToDBM(data, 64);
+    CHECK(fabs(data->peak_freq[0] - tone) < 5 && fabs(data->peak_freq[0] - tone) < fabs(full - tone), "zoom peak frequency");
+    // Between the full band bins the Hann window loses up to 1.4 dB
+    CHECK(data->peak_power[0] >= fullPower - 0.01, "zoom peak power");
+
+    dsp.prepareFreqVector(data, 125e6, 64);
+    CHECK(fabs(data->freq_vector[0] - 98e3) < 1e-3 && fabs(data->freq_vector[n / 2 - 1] - 105e3) < 1e-2, "zoom frequencies");
+    dsp.zoomClean();
+    dsp.prepareFreqVector(data, 125e6, 64);
+    CHECK(data->freq_vector[1] > 400 && data->freq_vector[1] < 500, "full band after clean");
+    dsp.deleteData(data);
+}
+
+int main(){
+    testDFT(1024, 256, 99e3, 102e3);
+    testDFT(1000, 100, 0, 500e3);
+    testDFT(4096, 1, 100e3, 100e3);
+    testCDSP();
+    CHECK(!CZoomFFT::create(1024, 10, 2e3, 1e3, g_fs), "f2 below f1");
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
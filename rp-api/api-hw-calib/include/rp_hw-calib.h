@@ -157,6 +157,14 @@ int rp_CalibInitSpecific(rp_HPeModels_t model);
  */
 rp_calib_params_t rp_GetCalibrationSettings();
 
+/**
+ * Returns the version of the calibration settings.
+ * The version changes each time the settings are loaded, set or reset,
+ * so cached values derived from the calibration can be checked for validity.
+ * @return Calibration version
+ */
+uint32_t rp_GetCalibrationVersion();
+
 /**
 * Returns default calibration settings.
 * These calibration settings are populated only once from EEPROM at rp_Init().
@@ -16,13 +16,41 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "calib.h"
 
+/* The parameters are read much more often than changed. Readers copy them without a lock
+ * and retry when a writer published new parameters during the copy. Writers are serialised
+ * by g_calib_write_lock and make the sequence odd while they change g_calib.
+ * The version is increased with every change, after the new parameters are visible. */
 static rp_calib_params_t g_calib;
+static atomic_uint g_calib_seq = 0;
+static pthread_mutex_t g_calib_write_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool g_model_loaded = false;
 static rp_HPeModels_t g_model = STEM_125_10_v1_0;
+static atomic_uint g_calib_version = 0;
+
+static void readCalib(rp_calib_params_t *out){
+    unsigned seq;
+    do {
+        while ((seq = atomic_load_explicit(&g_calib_seq, memory_order_acquire)) & 1);
+        *out = g_calib;
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&g_calib_seq, memory_order_relaxed) != seq);
+}
 
-int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
+/* Must be called with g_calib_write_lock held */
+static void publishCalib(const rp_calib_params_t *calib){
+    unsigned seq = atomic_load_explicit(&g_calib_seq, memory_order_relaxed);
+    atomic_store_explicit(&g_calib_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    g_calib = *calib;
+    atomic_store_explicit(&g_calib_seq, seq + 2, memory_order_release);
+    atomic_fetch_add_explicit(&g_calib_version, 1, memory_order_release);
+}
+
+static int loadModel(rp_HPeModels_t model,bool use_factory_zone,rp_calib_params_t *calib){
     switch (model)
     {
         case STEM_125_10_v1_0:
@@ -36,12 +64,12 @@ int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
             if (buffer && size == sizeof(rp_calib_params_v1_t)){
                 rp_calib_params_v1_t calib_v1;
                 memcpy(&calib_v1,buffer,size);
-                g_calib = convertV1toCommon(&calib_v1);
+                *calib = convertV1toCommon(&calib_v1);
                 if (buffer) free(buffer);
 
             }else{
                 if (buffer) free(buffer);
-                g_calib = getDefault(model);
+                *calib = getDefault(model);
                 fprintf(stderr,"[Error:calib_InitModel] Cann't load calibration v1. Set by default.\n");
                 return RP_HW_CALIB_ERE;
             }
@@ -55,12 +83,12 @@ int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
             if (buffer && size == sizeof(rp_calib_params_v1_t)){
                 rp_calib_params_v1_t calib_v1;
                 memcpy(&calib_v1,buffer,size);
-                g_calib = convertV1toCommon(&calib_v1);
+                *calib = convertV1toCommon(&calib_v1);
                 if (buffer) free(buffer);
 
             }else{
                 if (buffer) free(buffer);
-                g_calib = getDefault(model);
+                *calib = getDefault(model);
                 fprintf(stderr,"[Error:calib_InitModel] Cann't load calibration v1. Set by default.\n");
                 return RP_HW_CALIB_ERE;
             }
@@ -75,10 +103,10 @@ int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
             if (buffer && size == sizeof(rp_calib_params_v2_t)){
                 rp_calib_params_v2_t calib_v2;
                 memcpy(&calib_v2,buffer,size);
-                g_calib = convertV2toCommon(&calib_v2);
+                *calib = convertV2toCommon(&calib_v2);
 
             }else{
-                g_calib = getDefault(model);
+                *calib = getDefault(model);
                 fprintf(stderr,"[Error:calib_InitModel] Cann't load calibration v2. Set by default.\n");
                 return RP_HW_CALIB_ERE;
             }
@@ -94,12 +122,12 @@ int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
             if (buffer && size == sizeof(rp_calib_params_v3_t)){
                 rp_calib_params_v3_t calib_v3;
                 memcpy(&calib_v3,buffer,size);
-                g_calib = convertV3toCommon(&calib_v3);
+                *calib = convertV3toCommon(&calib_v3);
                 if (buffer) free(buffer);
 
             }else{
                 if (buffer) free(buffer);
-                g_calib = getDefault(model);
+                *calib = getDefault(model);
                 fprintf(stderr,"[Error:calib_InitModel] Cann't load calibration v3. Set by default.\n");
                 return RP_HW_CALIB_ERE;
             }
@@ -109,12 +137,23 @@ int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
             fprintf(stderr,"[Error:calib_InitModel] Unknown model: %d.\n",model);
             break;
     }
-    if (!recalculateGain(&g_calib)){
+    if (!recalculateGain(calib)){
         fprintf(stderr,"[Error:calib_InitModel] Cannot correctly recalculate gain on calibration.\n");
     }
     return RP_HW_CALIB_OK;
 }
 
+int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone){
+    // The parameters are replaced on every path, including the default one on errors
+    pthread_mutex_lock(&g_calib_write_lock);
+    rp_calib_params_t calib;
+    readCalib(&calib);
+    int ret = loadModel(model,use_factory_zone,&calib);
+    publishCalib(&calib);
+    pthread_mutex_unlock(&g_calib_write_lock);
+    return ret;
+}
+
 int calib_Init(bool use_factory_zone){
     rp_HPeModels_t model = STEM_125_14_v1_1; // Default model
     int res = rp_HPGetModel(&model);
@@ -261,7 +300,14 @@ int calib_WriteParams(rp_HPeModels_t model, rp_calib_params_t *calib_params,bool
 
 rp_calib_params_t calib_GetParams()
 {
-    return g_calib;
+    rp_calib_params_t calib;
+    readCalib(&calib);
+    return calib;
+}
+
+uint32_t calib_GetVersion()
+{
+    return atomic_load_explicit(&g_calib_version, memory_order_acquire);
 }
 
 rp_calib_params_t calib_GetDefaultCalib(){
@@ -292,16 +338,24 @@ int calib_WriteDirectlyParams(rp_calib_params_t *calib_params,bool use_factory_z
 }
 
 void calib_SetToZero() {
-    g_calib = calib_GetDefaultCalib();
+    rp_calib_params_t calib = calib_GetDefaultCalib();
+    pthread_mutex_lock(&g_calib_write_lock);
+    publishCalib(&calib);
+    pthread_mutex_unlock(&g_calib_write_lock);
 }
 
 int calib_Reset(bool use_factory_zone) {
     if (g_model_loaded){
-        rp_calib_params_t calib = g_calib;
+        rp_calib_params_t calib;
+        readCalib(&calib);
         calib_SetToZero();
-        int res = calib_WriteParams(g_model,&g_calib,use_factory_zone);
+        rp_calib_params_t zero;
+        readCalib(&zero);
+        int res = calib_WriteParams(g_model,&zero,use_factory_zone);
         if (res != RP_HW_CALIB_OK){
-            g_calib = calib;
+            pthread_mutex_lock(&g_calib_write_lock);
+            publishCalib(&calib);
+            pthread_mutex_unlock(&g_calib_write_lock);
             return res;
         }
         return calib_Init(use_factory_zone);
@@ -383,7 +437,9 @@ int calib_LoadFromFactoryZone(){
 }
 
 int calib_SetParams(rp_calib_params_t *calib_params){
-    g_calib = *calib_params;
+    pthread_mutex_lock(&g_calib_write_lock);
+    publishCalib(calib_params);
+    pthread_mutex_unlock(&g_calib_write_lock);
     //calib_PrintEx(stderr,&g_calib);
     return RP_HW_CALIB_OK;
 }
@@ -401,6 +457,8 @@ int calib_GetEEPROM(rp_eepromWpData_t *calib_params,bool use_factory_zone){
         model = g_model;
     }
     uint16_t size = 0;
+    rp_calib_params_t calib;
+    readCalib(&calib);
     switch (model)
     {
         case STEM_125_10_v1_0:
@@ -411,7 +469,7 @@ int calib_GetEEPROM(rp_eepromWpData_t *calib_params,bool use_factory_zone){
         case STEM_125_14_Z7020_LN_v1_1:{
             size = sizeof(rp_calib_params_v1_t);
             rp_calib_params_v1_t p_v1;
-            if (!convertV1(&g_calib,&p_v1)){
+            if (!convertV1(&calib,&p_v1)){
                 fprintf(stderr,"[Error:calib_GetEEPROM] Error converting calibration parameters.\n");
             }
             memcpy(calib_params,&p_v1,size);
@@ -422,7 +480,7 @@ int calib_GetEEPROM(rp_eepromWpData_t *calib_params,bool use_factory_zone){
         case STEM_122_16SDR_v1_1:{
             size = sizeof(rp_calib_params_v1_t);
             rp_calib_params_v1_t p_v1;
-            if (!convertV1(&g_calib,&p_v1)){
+            if (!convertV1(&calib,&p_v1)){
                 fprintf(stderr,"[Error:calib_GetEEPROM] Error converting calibration parameters.\n");
             }
             memcpy(calib_params,&p_v1,size);
@@ -434,7 +492,7 @@ int calib_GetEEPROM(rp_eepromWpData_t *calib_params,bool use_factory_zone){
         case STEM_125_14_Z7020_4IN_v1_3:{
             size = sizeof(rp_calib_params_v2_t);
             rp_calib_params_v2_t p_v2;
-            if (!convertV2(&g_calib,&p_v2)){
+            if (!convertV2(&calib,&p_v2)){
                 fprintf(stderr,"[Error:calib_GetEEPROM] Error converting calibration parameters.\n");
             }
             memcpy(calib_params,&p_v2,size);
@@ -447,7 +505,7 @@ int calib_GetEEPROM(rp_eepromWpData_t *calib_params,bool use_factory_zone){
         case STEM_250_12_120:{
             size = sizeof(rp_calib_params_v3_t);
             rp_calib_params_v3_t p_v3;
-            if (!convertV3(&g_calib,&p_v3)){
+            if (!convertV3(&calib,&p_v3)){
                 fprintf(stderr,"[Error:calib_GetEEPROM] Error converting calibration parameters.\n");
             }
             memcpy(calib_params,&p_v3,size);
@@ -606,12 +664,15 @@ int calib_GetFastADCFilter(rp_channel_calib_t channel,channel_filter_t *out){
         }
     }
 
-    if (g_calib.fast_adc_count_1_1 <= channel){
+    rp_calib_params_t params;
+    readCalib(&params);
+
+    if (params.fast_adc_count_1_1 <= channel){
         fprintf(stderr,"[Error:calib_GetFastADCFilter] Wrong channel: %d\n",channel);
         return RP_HW_CALIB_ECH;
     }
 
-    *out = g_calib.fast_adc_filter_1_1[channel];
+    *out = params.fast_adc_filter_1_1[channel];
     return RP_HW_CALIB_OK;
 }
 
@@ -624,12 +685,15 @@ int calib_GetFastADCFilter_1_20(rp_channel_calib_t channel,channel_filter_t *out
         }
     }
 
-    if (g_calib.fast_adc_count_1_20 <= channel){
+    rp_calib_params_t params;
+    readCalib(&params);
+
+    if (params.fast_adc_count_1_20 <= channel){
         fprintf(stderr,"[Error:calib_GetFastADCFilter] Wrong channel: %d\n",channel);
         return RP_HW_CALIB_ECH;
     }
 
-    *out = g_calib.fast_adc_filter_1_20[channel];
+    *out = params.fast_adc_filter_1_20[channel];
     return RP_HW_CALIB_OK;
 }
 
@@ -642,28 +706,31 @@ int calib_GetFastADCCalibValue(rp_channel_calib_t channel,rp_acq_ac_dc_mode_cali
         }
     }
 
-    if (g_calib.fast_adc_count_1_1 <= channel && mode == RP_DC_CALIB){
+    rp_calib_params_t params;
+    readCalib(&params);
+
+    if (params.fast_adc_count_1_1 <= channel && mode == RP_DC_CALIB){
         fprintf(stderr,"[Error:calib_GetFastADCCalibValue] Wrong channel: %d in DC mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
 
-    if (g_calib.fast_adc_count_1_1_ac <= channel && mode == RP_AC_CALIB){
+    if (params.fast_adc_count_1_1_ac <= channel && mode == RP_AC_CALIB){
         fprintf(stderr,"[Error:calib_GetFastADCCalibValue] Wrong channel: %d in AC mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
     switch (mode)
     {
         case RP_DC_CALIB:{
-            *gain = g_calib.fast_adc_1_1[channel].gainCalc;
-            *offset = g_calib.fast_adc_1_1[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_adc_1_1[channel],15);
+            *gain = params.fast_adc_1_1[channel].gainCalc;
+            *offset = params.fast_adc_1_1[channel].offset;
+            *calib = convertFloatToInt(&params.fast_adc_1_1[channel],15);
             break;
         }
 
         case RP_AC_CALIB:{
-            *gain = g_calib.fast_adc_1_1_ac[channel].gainCalc;
-            *offset = g_calib.fast_adc_1_1_ac[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_adc_1_1_ac[channel],15);
+            *gain = params.fast_adc_1_1_ac[channel].gainCalc;
+            *offset = params.fast_adc_1_1_ac[channel].offset;
+            *calib = convertFloatToInt(&params.fast_adc_1_1_ac[channel],15);
             break;
         }
 
@@ -683,28 +750,31 @@ int calib_GetFastADCCalibValue_1_20(rp_channel_calib_t channel,rp_acq_ac_dc_mode
         }
     }
 
-    if (g_calib.fast_adc_count_1_1 <= channel && mode == RP_DC_CALIB){
+    rp_calib_params_t params;
+    readCalib(&params);
+
+    if (params.fast_adc_count_1_1 <= channel && mode == RP_DC_CALIB){
         fprintf(stderr,"[Error:calib_GetFastADCCalibValue] Wrong channel: %d in DC mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
 
-    if (g_calib.fast_adc_count_1_1_ac <= channel && mode == RP_AC_CALIB){
+    if (params.fast_adc_count_1_1_ac <= channel && mode == RP_AC_CALIB){
         fprintf(stderr,"[Error:calib_GetFastADCCalibValue] Wrong channel: %d in AC mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
     switch (mode)
     {
         case RP_DC_CALIB:{
-            *gain = g_calib.fast_adc_1_20[channel].gainCalc;
-            *offset = g_calib.fast_adc_1_20[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_adc_1_20[channel],15);
+            *gain = params.fast_adc_1_20[channel].gainCalc;
+            *offset = params.fast_adc_1_20[channel].offset;
+            *calib = convertFloatToInt(&params.fast_adc_1_20[channel],15);
             break;
         }
 
         case RP_AC_CALIB:{
-            *gain = g_calib.fast_adc_1_20_ac[channel].gainCalc;
-            *offset = g_calib.fast_adc_1_20_ac[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_adc_1_20_ac[channel],15);
+            *gain = params.fast_adc_1_20_ac[channel].gainCalc;
+            *offset = params.fast_adc_1_20_ac[channel].offset;
+            *calib = convertFloatToInt(&params.fast_adc_1_20_ac[channel],15);
             break;
         }
 
@@ -725,12 +795,15 @@ int calib_GetFastDACCalibValue(rp_channel_calib_t channel,rp_gen_gain_calib_t mo
         }
     }
 
-    if (g_calib.fast_dac_count_x1 <= channel && mode == RP_GAIN_CALIB_1X){
+    rp_calib_params_t params;
+    readCalib(&params);
+
+    if (params.fast_dac_count_x1 <= channel && mode == RP_GAIN_CALIB_1X){
         fprintf(stderr,"[Error:calib_GetFastDACCalibValue] Wrong channel: %d in x1 mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
 
-    if (g_calib.fast_dac_count_x5 <= channel && mode == RP_GAIN_CALIB_5X){
+    if (params.fast_dac_count_x5 <= channel && mode == RP_GAIN_CALIB_5X){
         fprintf(stderr,"[Error:calib_GetFastDACCalibValue] Wrong channel: %d in x5 mode\n",channel);
         return RP_HW_CALIB_ECH;
     }
@@ -738,16 +811,16 @@ int calib_GetFastDACCalibValue(rp_channel_calib_t channel,rp_gen_gain_calib_t mo
     switch (mode)
     {
         case RP_GAIN_CALIB_1X:{
-            *gain = g_calib.fast_dac_x1[channel].gainCalc;
-            *offset = g_calib.fast_dac_x1[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_dac_x1[channel],15);
+            *gain = params.fast_dac_x1[channel].gainCalc;
+            *offset = params.fast_dac_x1[channel].offset;
+            *calib = convertFloatToInt(&params.fast_dac_x1[channel],15);
             break;
         }
 
         case RP_GAIN_CALIB_5X:{
-            *gain = g_calib.fast_dac_x5[channel].gainCalc;
-            *offset = g_calib.fast_dac_x5[channel].offset;
-            *calib = convertFloatToInt(&g_calib.fast_dac_x5[channel],15);
+            *gain = params.fast_dac_x5[channel].gainCalc;
+            *offset = params.fast_dac_x5[channel].offset;
+            *calib = convertFloatToInt(&params.fast_dac_x5[channel],15);
             break;
         }
 
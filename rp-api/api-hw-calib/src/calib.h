@@ -24,6 +24,7 @@ int calib_Init(bool use_factory_zone);
 int calib_InitModel(rp_HPeModels_t model,bool use_factory_zone);
 
 rp_calib_params_t calib_GetParams();
+uint32_t calib_GetVersion();
 rp_calib_params_t calib_GetDefaultCalib();
 
 int calib_WriteParams(rp_HPeModels_t model, rp_calib_params_t *calib_params,bool use_factory_zone);
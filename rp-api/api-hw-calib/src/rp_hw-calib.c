@@ -31,6 +31,10 @@ rp_calib_params_t rp_GetCalibrationSettings(){
     return calib_GetParams();
 }
 
+uint32_t rp_GetCalibrationVersion(){
+    return calib_GetVersion();
+}
+
 rp_calib_params_t rp_GetDefaultCalibrationSettings(){
     return calib_GetDefaultCalib();
 }
@@ -224,6 +224,23 @@ int hp_cmn_Init(){
     char *model = NULL;
     char *eth_mac = NULL;
 
+	// Board model override for hosts without the EEPROM, e.g. the simulated backend
+	char *env_model = getenv("RP_HW_PROFILE_MODEL");
+#ifdef RP_SIM
+	// The host has no EEPROM at all
+	if (!env_model)
+		env_model = "STEM_125-14_v1.1";
+#endif
+	if (env_model && strlen(env_model) + 1 < 255){
+		model = (char*)malloc(strlen(env_model)+1);
+		if (!model)
+			return RP_HP_EAL;
+		strcpy(model,env_model);
+		hp_checkModel(model,NULL);
+		free(model);
+		return RP_HP_OK;
+	}
+
 	FILE *fp = fopen("/sys/bus/i2c/devices/0-0050/eeprom", "r");
 	if (!fp)
 		return RP_HP_ERE;
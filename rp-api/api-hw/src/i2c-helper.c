@@ -3,7 +3,9 @@
 
 #include <linux/i2c-dev.h>
 #include <linux/i2c.h>
+#ifndef RP_SIM
 #include <i2c/smbus.h>
+#endif
 
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -19,6 +21,24 @@
 
 pthread_mutex_t i2c_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+#ifdef RP_SIM
+/* The simulator has no I2C bus and no libi2c. openDevice() already fails, these only have to link */
+static __s32 i2c_smbus_fail(int file){
+	(void)file;
+	errno = ENODEV;
+	return -1;
+}
+
+static __s32 i2c_smbus_write_byte(int file, __u8 value){ (void)value; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_read_byte(int file){ return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_write_byte_data(int file, __u8 command, __u8 value){ (void)command; (void)value; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_read_byte_data(int file, __u8 command){ (void)command; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_write_word_data(int file, __u8 command, __u16 value){ (void)command; (void)value; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_read_word_data(int file, __u8 command){ (void)command; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_write_block_data(int file, __u8 command, __u8 length, const __u8 *values){ (void)command; (void)length; (void)values; return i2c_smbus_fail(file); }
+static __s32 i2c_smbus_read_i2c_block_data(int file, __u8 command, __u8 length, __u8 *values){ (void)command; (void)length; (void)values; return i2c_smbus_fail(file); }
+#endif
+
 
 int openDevice(const char* i2c_dev_node_path,uint8_t i2c_dev_address, bool force,int *i2c_dev_node){
 	int ret_val = 0;
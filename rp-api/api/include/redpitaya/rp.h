@@ -235,6 +235,44 @@ typedef struct
     float    *ch_f[4];
 } buffers_t;
 
+/**
+ * Unread part of the ADC buffer returned by the rp_AcqStream* functions.
+ */
+typedef struct
+{
+    uint32_t pos;       //!< Buffer position of the oldest unread sample
+    uint32_t size;      //!< Number of unread samples from pos. The span wraps around the end of the buffer
+    bool     overrun;   //!< Samples were overwritten before they were read since the previous span
+    uint64_t lost;      //!< Number of samples lost since rp_AcqStreamStart
+} rp_acq_stream_span_t;
+
+/**
+ * Record of the segmented acquisition.
+ */
+typedef struct
+{
+    uint64_t timestamp_ns;  //!< Trigger time in CLOCK_MONOTONIC nanoseconds, the first one estimated from the write pointer, the others from the sample distance to it
+    uint32_t trig_pos;      //!< Write pointer at the trigger
+    uint32_t pre_valid;     //!< Pre trigger samples written after the trigger was armed or after the previous record. Older ones belong to the previous record
+    bool     valid;         //!< False if the writer could reach the record before it was copied
+} rp_acq_segment_info_t;
+
+/**
+ * Measurements of a part of the ADC buffer returned by rp_AcqGetMeasurements.
+ */
+typedef struct
+{
+    float    min;           //!< Minimum in Volt
+    float    max;           //!< Maximum in Volt
+    float    mean;          //!< Mean in Volt
+    float    rms;           //!< Root mean square in Volt, including the mean
+    float    period;        //!< Mean period between the rising edges in seconds, 0 with less than two edges
+    float    frequency;     //!< 1 / period, 0 with less than two edges
+    uint32_t rising;        //!< Number of rising edges
+    uint32_t falling;       //!< Number of falling edges
+    float    first_rising;  //!< Position of the first rising edge in samples from pos, interpolated to the level
+} rp_acq_signal_meas_t;
+
 
 /**
  * Type representing decimation used at acquiring signal.
@@ -299,6 +337,11 @@ typedef enum {
 
 /**
  * Initializes the library. It must be called first, before any other library method.
+ * After the initialization the library methods can be called from several threads.
+ * Settings of one generator or acquisition channel are applied one at a time, and
+ * data reads do not wait for settings changes. rp_Init and rp_Release must not
+ * be called concurrently with other methods. The rp_AcqStream* and rp_AcqSegmented*
+ * readers are meant for one consumer thread.
  * @return If the function is successful, the return value is RP_OK.
  * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
  */
@@ -1041,6 +1084,154 @@ int rp_AcqGetDataV2(uint32_t pos, buffers_t *out);
  */
 int rp_AcqGetDataV2D(uint32_t pos, buffers_t *out);
 
+/**
+ * Starts tracking of the continuous acquisition. Only samples written after this call are returned.
+ * The acquisition itself is started with rp_AcqStart(). Samples are written continuously
+ * until a trigger is received, with arm keep they are written also after the trigger.
+ * The stream functions are not thread safe.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamStart();
+
+/**
+ * Stops tracking of the continuous acquisition.
+ * @return If the function is successful, the return value is RP_OK.
+ */
+int rp_AcqStreamStop();
+
+/**
+ * Returns the samples written since the last released ones.
+ * If the samples were not read in time, span.overrun is set and the span starts at the oldest sample
+ * that can still be read. Whole laps of the buffer between two calls are estimated from the elapsed time
+ * and the sampling rate.
+ * @param min_samples Waits until at least this many samples are unread. 0 returns immediately.
+ * @param timeout_ms Maximum wait time. On timeout the span has less than min_samples samples.
+ * @param span Unread samples. They stay unread until rp_AcqStreamRelease is called.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamGetSpan(uint32_t min_samples, uint32_t timeout_ms, rp_acq_stream_span_t *span);
+
+/**
+ * Returns the span of one channel directly in the ADC buffer memory, without copy.
+ * The span is split at the end of the buffer into two parts, the second one can be empty.
+ * Each word holds the raw ADC counts in the lower bits, as returned by rp_HPGetFastADCBits.
+ * @param channel Channel of the ADC buffer.
+ * @param span Span returned by rp_AcqStreamGetSpan.
+ * @param first First part of the span.
+ * @param first_size Number of samples in the first part.
+ * @param second Second part of the span, starting at the beginning of the buffer.
+ * @param second_size Number of samples in the second part.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamGetView(rp_channel_t channel, const rp_acq_stream_span_t *span, const volatile uint32_t **first, uint32_t *first_size, const volatile uint32_t **second, uint32_t *second_size);
+
+/**
+ * Marks the oldest unread samples as read.
+ * @param count Number of samples read from the start of the last span.
+ * @param overwritten Optional. Set if the writer reached the released samples while they were read, then their data is not valid.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamRelease(uint32_t count, bool *overwritten);
+
+/**
+ * Reads and releases the unread samples of all channels reported by the board.
+ * For each channel the first not NULL buffer of ch_f, ch_d and ch_i is filled, in Volt or raw units.
+ * Channels without a buffer are skipped.
+ * @param min_samples Waits until at least this many samples are unread. 0 returns immediately.
+ * @param timeout_ms Maximum wait time.
+ * @param out Output buffers. out->size is the buffer length and returns the number of read samples.
+ * @param span Read samples. span.overrun is also set if the samples were overwritten while they were read.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamRead(uint32_t min_samples, uint32_t timeout_ms, buffers_t *out, rp_acq_stream_span_t *span);
+
+/**
+ * Allocates the store of the segmented acquisition for all channels reported by the board.
+ * Each record holds pre_samples samples before the trigger and post_samples samples from the trigger on.
+ * @param segments Number of records in the store.
+ * @param pre_samples Samples before the trigger.
+ * @param post_samples Samples from the trigger on, at least 1. pre_samples + post_samples must not exceed half of ADC_BUFFER_SIZE.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSegmentedInit(uint32_t segments, uint32_t pre_samples, uint32_t post_samples);
+
+/**
+ * Frees the store of the segmented acquisition.
+ * @return If the function is successful, the return value is RP_OK.
+ */
+int rp_AcqSegmentedRelease();
+
+/**
+ * Captures records back to back into the store, starting from the first record.
+ * The trigger source, level and decimation are set up before with the rp_Acq* functions.
+ * The acquisition is armed once and the writing continues after the triggers (arm keep).
+ * The FPGA detects the first trigger. The following channel level triggers are detected by the CPU
+ * in the written samples with the same level and hysteresis, searched from the end of the previous record.
+ * With RP_TRIG_SRC_NOW the records follow each other without a gap.
+ * External triggers are not visible in the samples, for them the trigger is armed again after each record
+ * and triggers arriving before that are not captured.
+ * @param count Number of records to capture, limited by the store size.
+ * @param timeout_ms Maximum time for the whole capture.
+ * @param captured Number of captured records. Less than count on timeout.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSegmentedCapture(uint32_t count, uint32_t timeout_ms, uint32_t *captured);
+
+/**
+ * Returns the trigger information of captured records.
+ * @param first First record.
+ * @param count Number of records.
+ * @param info Output array, at least count long.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSegmentedGetInfo(uint32_t first, uint32_t count, rp_acq_segment_info_t *info);
+
+/**
+ * Returns captured records in raw units, one after another.
+ * @param channel Channel of the records.
+ * @param first First record.
+ * @param count Number of records.
+ * @param buffer Output buffer, at least count * (pre_samples + post_samples) long.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSegmentedGetDataRaw(rp_channel_t channel, uint32_t first, uint32_t count, int16_t* buffer);
+
+/**
+ * Returns captured records in Volt units, one after another.
+ * The current gain and calibration are used, so they should not change between the capture and the read.
+ * @param channel Channel of the records.
+ * @param first First record.
+ * @param count Number of records.
+ * @param buffer Output buffer, at least count * (pre_samples + post_samples) long.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSegmentedGetDataV(rp_channel_t channel, uint32_t first, uint32_t count, float* buffer);
+
+/**
+ * Measures a part of the ADC buffer in one pass, without copying the samples out.
+ * Edges are detected with a Schmitt trigger: a rising edge passes level - hyst / 2 and
+ * then level + hyst / 2, a falling edge the opposite.
+ * @param channel Channel A or B to measure.
+ * @param pos Starting position in the ADC buffer.
+ * @param size Number of samples to measure, at most the buffer size.
+ * @param level Edge level in Volt.
+ * @param hyst Hysteresis around the level in Volt. Negative values disable the edge detection.
+ * @param meas Returns the measurements.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetMeasurements(rp_channel_t channel, uint32_t pos, uint32_t size, float level, float hyst, rp_acq_signal_meas_t *meas);
+
 /**
  * Returns the ADC buffer in Volt units from the oldest sample to the newest one.
  * Output buffer must be at least 'size' long.
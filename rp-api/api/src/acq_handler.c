@@ -18,11 +18,20 @@
 #include <math.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
 
 #include "common.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
 #include "neon_asm.h"
+#include "acq_kernels.h"
+#include "acq_stream.h"
+#include "acq_measure.h"
+#ifdef RP_SIM
+#include "sim_backend.h"
+#endif
 
 #include "rp-i2c-mcp47x6-c.h"
 #include "rp-i2c-max7311-c.h"
@@ -50,6 +59,72 @@ static rp_pinState_t gain_ch[4] = {RP_LOW,RP_LOW,RP_LOW,RP_LOW};
 /* @brief Currently set AC/DC state */
 static rp_acq_ac_dc_mode_t power_mode_ch[4] = {RP_DC,RP_DC,RP_DC,RP_DC};
 
+/* @brief Settings shared by all channels are changed under the core lock, per-channel settings
+ * under the lock of the channel. See the locking model in common.h */
+static pthread_mutex_t acq_core_lock;
+static pthread_mutex_t acq_lock[4];
+static pthread_once_t acq_lock_once = PTHREAD_ONCE_INIT;
+
+static void initLocks(){
+    cmn_InitRecursiveLocks(&acq_core_lock, 1);
+    cmn_InitRecursiveLocks(acq_lock, 4);
+}
+
+static pthread_mutex_t* acqCoreLock(){
+    pthread_once(&acq_lock_once, initLocks);
+    return &acq_core_lock;
+}
+
+/* Invalid channels are not locked, they are reported by the called function */
+static pthread_mutex_t* acqChannelLock(rp_channel_t channel){
+    pthread_once(&acq_lock_once, initLocks);
+    return (uint32_t)channel < 4 ? &acq_lock[channel] : NULL;
+}
+
+#define LOCK_CORE() CMN_SCOPED_LOCK(acqCoreLock())
+#define LOCK_CHANNEL(X) CMN_SCOPED_LOCK(acqChannelLock(X))
+
+/* @brief Per-channel snapshot of everything needed to convert ADC counts.
+ * Rebuilt on first use after the gain, AC/DC mode or calibration changed. */
+typedef struct {
+    uint32_t          version;         // acq_context_version of the channel when built
+    uint32_t          calib_version;   // rp_GetCalibrationVersion() when built
+    uint8_t           bits;
+    bool              is_sign;
+    float             fullScale;
+    double            gain;
+    int32_t           offset;
+    uint_gain_calib_t calib;
+} acq_context_t;
+
+/* @brief Changed on every gain or AC/DC change of the channel. Starts from 1, so zeroed contexts are never valid */
+static atomic_uint acq_context_version[4] = {1,1,1,1};
+
+/* @brief Published context of a channel. Readers copy it without a lock and retry when the
+ * sequence changed during the copy, the writer holds the channel lock and makes the sequence odd */
+typedef struct {
+    atomic_uint   seq;
+    acq_context_t ctx;
+} acq_context_slot_t;
+
+static acq_context_slot_t acq_context[4];
+
+/* @brief Read cursor of the rp_AcqStream* API */
+static acq_stream_t acq_stream;
+static bool acq_stream_started = false;
+
+/* @brief Preallocated records of the segmented acquisition */
+typedef struct {
+    uint32_t segments;
+    uint32_t pre;
+    uint32_t post;
+    uint32_t captured;
+    uint32_t *data[4];                  // Raw ADC words, segments * (pre + post) per channel
+    rp_acq_segment_info_t *info;
+} acq_segment_store_t;
+
+static acq_segment_store_t acq_segments;
+
 /* @brief Determines whether TriggerDelay was set in time or sample units */
 static bool triggerDelayInNs = false;
 
@@ -170,6 +245,7 @@ int acq_GetADCSamplePeriod(double *value){
 }
 
 int acq_SetArmKeep(bool enable) {
+    LOCK_CORE();
     return osc_SetArmKeep(enable);
 }
 
@@ -181,7 +257,93 @@ int acq_GetBufferFillState(bool* state){
     return osc_GetBufferFillState(state);
 }
 
+static int buildContext(rp_channel_t channel, uint32_t calib_version, acq_context_t *ctx){
+
+    CHECK_CHANNEL("buildContext")
+
+    /* The version is read first, a change during the build makes the context stale at once */
+    uint32_t version = atomic_load_explicit(&acq_context_version[channel], memory_order_acquire);
+    rp_pinState_t mode = gain_ch[channel];
+    rp_acq_ac_dc_mode_t power_mode = power_mode_ch[channel];
+    acq_context_t c;
+    int ret = 0;
+    switch (mode)
+    {
+        case RP_LOW:
+            ret = rp_HPGetFastADCFullScale(channel,&c.fullScale);
+            ret |= rp_HPGetFastADCBits(channel,&c.bits);
+            ret |= rp_HPGetFastADCIsSigned(channel,&c.is_sign);
+            ret |= rp_CalibGetFastADCCalibValue(convertCh(channel),convertPower(power_mode),&c.gain,&c.offset);
+            ret |= rp_CalibGetFastADCCalibValueI(convertCh(channel),convertPower(power_mode),&c.calib);
+            break;
+
+        case RP_HIGH:
+            ret = rp_HPGetFastADCFullScale_1_20(channel,&c.fullScale);
+            ret |= rp_HPGetFastADCBits_1_20(channel,&c.bits);
+            ret |= rp_HPGetFastADCIsSigned_1_20(channel,&c.is_sign);
+            ret |= rp_CalibGetFastADCCalibValue_1_20(convertCh(channel),convertPower(power_mode),&c.gain,&c.offset);
+            ret |= rp_CalibGetFastADCCalibValue_1_20I(convertCh(channel),convertPower(power_mode),&c.calib);
+            break;
+
+        default:
+            fprintf(stderr,"[Error:buildContext] Unknown mode: %d\n",mode);
+            return RP_EOOR;
+            break;
+    }
+
+    if (ret != RP_HW_CALIB_OK){
+        fprintf(stderr,"[Error:buildContext] Error get calibaration: %d\n",ret);
+        return RP_EOOR;
+    }
+    c.version = version;
+    c.calib_version = calib_version;
+    *ctx = c;
+    return RP_OK;
+}
+
+static bool readContext(acq_context_slot_t *slot, acq_context_t *ctx){
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq & 1){
+        return false;
+    }
+    *ctx = slot->ctx;
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq;
+}
+
+static void publishContext(acq_context_slot_t *slot, const acq_context_t *ctx){
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->ctx = *ctx;
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+/* Returns a copy of the channel context. Readers of a valid context take no lock,
+ * a stale one is rebuilt under the channel lock */
+static int getContext(rp_channel_t channel, acq_context_t *ctx){
+    if ((uint32_t)channel >= 4){
+        fprintf(stderr,"[Error:getContext] Channel is larger than allowed\n");
+        return RP_NOTS;
+    }
+    acq_context_slot_t *slot = &acq_context[channel];
+    uint32_t calib_version = rp_GetCalibrationVersion();
+    if (readContext(slot,ctx)
+        && ctx->version == atomic_load_explicit(&acq_context_version[channel], memory_order_acquire)
+        && ctx->calib_version == calib_version){
+        return RP_OK;
+    }
+    LOCK_CHANNEL(channel);
+    int ret = buildContext(channel,calib_version,ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
+    publishContext(slot,ctx);
+    return RP_OK;
+}
+
 int acq_SetGain(rp_channel_t channel, rp_pinState_t state){
+    LOCK_CHANNEL(channel);
 
     CHECK_CHANNEL("acq_SetGain")
 
@@ -219,6 +381,7 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state){
     if (status == RP_OK) {
         // Now update the gain
         *gain = state;
+        atomic_fetch_add_explicit(&acq_context_version[channel], 1, memory_order_release);
     }
 
     // And recalculate new values...
@@ -230,6 +393,7 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state){
     // In case of an error, put old values back and report the error
     if (status != RP_OK) {
         *gain = old_gain;
+        atomic_fetch_add_explicit(&acq_context_version[channel], 1, memory_order_release);
         if (acq_SetChannelThreshold(channel, ch_thr) != RP_OK){
             fprintf(stderr,"[Error:acq_SetGain] Error setting threshold\n");
         }
@@ -266,6 +430,7 @@ int acq_GetGainV(rp_channel_t channel, float* voltage){
 }
 
 int acq_SetDecimation(rp_acq_decimation_t decimation){
+    LOCK_CORE();
     int64_t time_ns = 0;
 
     if (triggerDelayInNs) {
@@ -290,6 +455,7 @@ int acq_GetDecimation(rp_acq_decimation_t* decimation){
 }
 
 int acq_SetDecimationFactor(uint32_t decimation){
+    LOCK_CORE();
     int64_t time_ns = 0;
 
     if (triggerDelayInNs) {
@@ -400,6 +566,7 @@ int acq_GetSamplingRateHz(float* sampling_rate){
 }
 
 int acq_SetAveraging(bool enable){
+    LOCK_CORE();
     return osc_SetAveraging(enable);
 }
 
@@ -408,6 +575,7 @@ int acq_GetAveraging(bool* enable){
 }
 
 int acq_SetTriggerSrc(rp_acq_trig_src_t source){
+    LOCK_CORE();
     last_trig_src = source;
     return osc_SetTriggerSource(source);
 }
@@ -424,6 +592,7 @@ int acq_GetTriggerState(rp_acq_trig_state_t* state){
 }
 
 int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue){
+    LOCK_CORE();
     (void)(updateMaxValue);
     int32_t trig_dly;
     if(decimated_data_num < -TRIG_DELAY_ZERO_OFFSET){
@@ -439,6 +608,7 @@ int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue){
 }
 
 int acq_SetTriggerDelayNs(int64_t time_ns, bool updateMaxValue){
+    LOCK_CORE();
     int32_t samples = cnvTimeToSmpls(time_ns);
     acq_SetTriggerDelay(samples, updateMaxValue);
     triggerDelayInNs = true;
@@ -536,61 +706,19 @@ int acq_GetTriggerLevel(rp_channel_trigger_t channel,float *voltage){
 }
 
 int acq_SetChannelThreshold(rp_channel_t channel, float voltage){
+    LOCK_CHANNEL(channel);
 
-    CHECK_CHANNEL("acq_SetChannelThreshold")
-
-    float fullScale;
-    rp_pinState_t mode;
-
-    if (acq_GetGainV(channel, &fullScale) != RP_OK){
-        return RP_EOOR;
-    }
-
-    if (acq_GetGain(channel, &mode) != RP_OK){
-        return RP_EOOR;
-    }
-
-    rp_acq_ac_dc_mode_t power_mode;
-    if (acq_GetAC_DC(channel,&power_mode) != RP_OK){
-        return RP_EOOR;
-    }
-
-    double gain = 1;
-    int32_t offset = 0;
-    uint8_t bits = 0;
-    bool is_sign = true;
-
-    int ret = 0;
-
-    switch (mode)
-    {
-        case RP_LOW:
-            ret = rp_CalibGetFastADCCalibValue(convertCh(channel),convertPower(power_mode),&gain,&offset);
-            ret |= rp_HPGetFastADCBits(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned(channel,&is_sign);
-            break;
-
-        case RP_HIGH:
-            ret = rp_CalibGetFastADCCalibValue_1_20(convertCh(channel),convertPower(power_mode),&gain,&offset);
-            ret |= rp_HPGetFastADCBits_1_20(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned_1_20(channel,&is_sign);
-            break;
-
-        default:
-            fprintf(stderr,"[Error:acq_SetChannelThreshold] Unknown mode: %d\n",mode);
-            return RP_EOOR;
-            break;
-    }
-
-    if (ret != RP_HW_CALIB_OK){
-        fprintf(stderr,"[Error:acq_SetChannelThreshold] Error get calibaration: %d\n",ret);
-        return RP_EOOR;
+    acq_context_t ctx;
+    int ret = getContext(channel,&ctx);
+    if (ret != RP_OK){
+        return ret;
     }
 
+    float fullScale = ctx.fullScale;
     if (voltage > fullScale) {
         voltage = fullScale;
     }
-    if (is_sign){
+    if (ctx.is_sign){
         if (voltage < -fullScale) {
             voltage = -fullScale;
         }
@@ -599,7 +727,7 @@ int acq_SetChannelThreshold(rp_channel_t channel, float voltage){
             voltage = 0;
         }
     }
-    uint32_t cnt = cmn_convertToCnt(voltage,bits,fullScale,is_sign,gain,offset);
+    uint32_t cnt = cmn_convertToCnt(voltage,ctx.bits,fullScale,ctx.is_sign,ctx.gain,ctx.offset);
     ch_trash[channel] = voltage;
 
     if (channel == RP_CH_1) {
@@ -652,63 +780,19 @@ int acq_GetTriggerHyst(float *voltage){
 
 
 int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage){
+    LOCK_CHANNEL(channel);
 
-    CHECK_CHANNEL("acq_SetChannelThresholdHyst")
-
-    float fullScale;
-    rp_pinState_t mode;
-
-    if (acq_GetGainV(channel, &fullScale) != RP_OK){
-        return RP_EOOR;
-    }
-
-    if (acq_GetGain(channel, &mode) != RP_OK){
-        return RP_EOOR;
-    }
-
-    if (fabs(voltage) - fabs(fullScale) > FLOAT_EPS) {
-        return RP_EOOR;
-    }
-
-    rp_acq_ac_dc_mode_t power_mode;
-    if (acq_GetAC_DC(channel,&power_mode) != RP_OK){
-        return RP_EOOR;
-    }
-
-    double gain = 1;
-    int32_t offset = 0;
-    uint8_t bits = 0;
-    bool is_sign = true;
-
-    int ret = 0;
-
-    switch (mode)
-    {
-        case RP_LOW:
-            ret = rp_CalibGetFastADCCalibValue(convertCh(channel),convertPower(power_mode),&gain,&offset);
-            ret |= rp_HPGetFastADCBits(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned(channel,&is_sign);
-            break;
-
-        case RP_HIGH:
-            ret = rp_CalibGetFastADCCalibValue_1_20(convertCh(channel),convertPower(power_mode),&gain,&offset);
-            ret |= rp_HPGetFastADCBits_1_20(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned_1_20(channel,&is_sign);
-            break;
-
-        default:
-            fprintf(stderr,"[Error:acq_SetChannelThreshold] Unknown mode: %d\n",mode);
-            return RP_EOOR;
-            break;
+    acq_context_t ctx;
+    int ret = getContext(channel,&ctx);
+    if (ret != RP_OK){
+        return ret;
     }
 
-    if (ret != RP_HW_CALIB_OK){
-        fprintf(stderr,"[Error:acq_SetChannelThreshold] Error get calibaration: %d\n",ret);
+    if (fabs(voltage) - fabs(ctx.fullScale) > FLOAT_EPS) {
         return RP_EOOR;
     }
 
-
-    uint32_t cnt = cmn_convertToCnt(voltage,bits,fullScale,is_sign,gain,offset);
+    uint32_t cnt = cmn_convertToCnt(voltage,ctx.bits,ctx.fullScale,ctx.is_sign,ctx.gain,ctx.offset);
     ch_hyst[channel] = voltage;
 
     if (channel == RP_CH_1) {
@@ -739,35 +823,30 @@ int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage){
 }
 
 int acq_Start(){
+    LOCK_CORE();
     osc_WriteDataIntoMemory(true);
     return RP_OK;
 }
 
 int acq_Stop(){
+    LOCK_CORE();
     return osc_WriteDataIntoMemory(false);
 }
 
 int acq_Reset(){
+    LOCK_CORE();
     acq_SetDefault();
     return osc_ResetWriteStateMachine();
 }
 
 int acq_ResetFpga(){
+    LOCK_CORE();
     return osc_ResetWriteStateMachine();
 }
 
+/* The channel is checked by getContext */
 static const volatile uint32_t* getRawBuffer(rp_channel_t channel){
 
-    uint8_t channels = 0;
-    if (rp_HPGetFastADCChannelsCount(&channels) != RP_HP_OK){
-        fprintf(stderr,"[Error:getRawBuffer] Can't get fast ADC channels count\n");
-        return NULL;
-    }
-    if (channel >= channels){
-        fprintf(stderr,"[Error:getRawBuffer] Channel is larger than allowed\n");
-        return NULL;
-    }
-
     if (channel == RP_CH_1) {
         return osc_GetDataBufferChA();
     }
@@ -804,7 +883,11 @@ uint32_t acq_GetNormalizedDataPos(uint32_t pos){
 
 int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer){
 
-    CHECK_CHANNEL("acq_GetDataRaw")
+    acq_context_t ctx;
+    int ret = getContext(channel,&ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
@@ -814,48 +897,7 @@ int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t*
         return RP_EOOR;
     }
 
-    rp_pinState_t mode;
-
-    if (acq_GetGain(channel, &mode) != RP_OK){
-        return RP_EOOR;
-    }
-
-    uint8_t bits = 0;
-    int ret = 0;
-    bool is_sign = false;
-    switch (mode)
-    {
-        case RP_LOW:
-            ret = rp_HPGetFastADCBits(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned(channel,&is_sign);
-            break;
-
-        case RP_HIGH:
-            ret = rp_HPGetFastADCBits_1_20(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned_1_20(channel,&is_sign);
-            break;
-
-        default:
-            fprintf(stderr,"[Error:acq_GetDataRaw] Unknown mode: %d\n",mode);
-            return RP_EOOR;
-            break;
-    }
-
-    if (ret != RP_HW_CALIB_OK){
-        fprintf(stderr,"[Error:acq_GetDataRaw] Error get calibaration: %d\n",ret);
-        return RP_EOOR;
-    }
-
-
-    uint32_t mask = ((uint64_t)1 << bits) - 1;
-
-    for (uint32_t i = 0; i < (*size); ++i) {
-        uint32_t cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & mask;
-        if (is_sign)
-            buffer[i] = cmn_CalibCntsSigned(cnts,bits,1,1,0);
-        else
-            buffer[i] = cmn_CalibCntsUnsigned(cnts,bits,1,1,0);
-    }
+    acq_ReadRawCnts(raw_buffer, ADC_BUFFER_SIZE, pos, *size, ctx.bits, ctx.is_sign, buffer);
 
     return RP_OK;
 }
@@ -974,75 +1016,94 @@ int acq_GetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 
 int acq_GetDataVEx(rp_channel_t channel,  uint32_t pos, uint32_t* size, void* in_buffer,bool is_float){
 
-    CHECK_CHANNEL("acq_GetDataVEx")
+    acq_context_t ctx;
+    int ret = getContext(channel,&ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
 
-    float fullScale;
-    rp_pinState_t mode;
-
-    if (acq_GetGainV(channel, &fullScale) != RP_OK){
+    if (!raw_buffer) {
         return RP_EOOR;
     }
 
-    if (acq_GetGain(channel, &mode) != RP_OK){
-        return RP_EOOR;
-    }
+    float *buffer_f = is_float ? (float*)in_buffer: NULL;
+    double *buffer_d = !is_float ? (double*)in_buffer: NULL;
+    acq_volt_param_t param;
+    param.bits = ctx.bits;
+    param.gain = ctx.calib.gain;
+    param.base = ctx.calib.base;
+    param.offset = ctx.calib.offset;
+    param.fullScale = ctx.fullScale;
+    acq_ReadVolts(raw_buffer, ADC_BUFFER_SIZE, pos, *size, &param, buffer_f, buffer_d);
 
-    rp_acq_ac_dc_mode_t power_mode;
-    if (acq_GetAC_DC(channel,&power_mode) != RP_OK){
-        return RP_EOOR;
-    }
+    return RP_OK;
+}
 
-    uint8_t bits = 0;
-    uint_gain_calib_t calib;
-    bool is_sign = true;
+int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buffer){
+    return acq_GetDataVEx(channel,pos,size,buffer,true);
+}
 
-    int ret = 0;
-    switch (mode)
-    {
-        case RP_LOW:
-            ret = rp_CalibGetFastADCCalibValueI(convertCh(channel),convertPower(power_mode),&calib);
-            ret |= rp_HPGetFastADCBits(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned(channel,&is_sign);
-            break;
+int acq_GetMeasurements(rp_channel_t channel, uint32_t pos, uint32_t size, float level, float hyst, rp_acq_signal_meas_t *meas){
 
-        case RP_HIGH:
-            ret = rp_CalibGetFastADCCalibValue_1_20I(convertCh(channel),convertPower(power_mode),&calib);
-            ret |= rp_HPGetFastADCBits_1_20(channel,&bits);
-            ret |= rp_HPGetFastADCIsSigned_1_20(channel,&is_sign);
-            break;
+    acq_context_t ctx;
+    int ret = getContext(channel,&ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
 
-        default:
-            fprintf(stderr,"[Error:acq_GetDataVEx] Unknown mode: %d\n",mode);
-            return RP_EOOR;
-            break;
+    if (!meas || size == 0) {
+        return RP_EOOR;
     }
 
-    if (ret != RP_HW_CALIB_OK){
-        fprintf(stderr,"[Error:acq_GetDataVEx] Error get calibaration: %d\n",ret);
+    size = MIN(size, ADC_BUFFER_SIZE);
+
+    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+
+    if (!raw_buffer) {
         return RP_EOOR;
     }
 
-    float *buffer_f = is_float ? (float*)in_buffer: NULL;
-    double *buffer_d = !is_float ? (double*)in_buffer: NULL;
-    uint32_t cnts;
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = raw_buffer[(pos + i) % ADC_BUFFER_SIZE];
-        float value = cmn_convertToVoltSigned(cnts,bits,fullScale,calib.gain,calib.base,calib.offset);
-        if (buffer_f) buffer_f[i] = value;
-        if (buffer_d) buffer_d[i] = value;
+    float rate;
+    ret = acq_GetSamplingRateHz(&rate);
+    if (ret != RP_OK){
+        return ret;
     }
 
+    // Volts are linear in the counts, v = a * (cnts - offset), as in acq_ReadVolts without the clamping
+    double a = (double)ctx.calib.gain / (double)ctx.calib.base * ctx.fullScale / (double)(1 << (ctx.bits - 1));
+    double b = -(double)ctx.calib.offset * a;
+    int32_t low = 1;
+    int32_t high = 0;
+    if (hyst >= 0 && a > 0) {
+        low = ceil((level - hyst / 2) / a + ctx.calib.offset);
+        high = ceil((level + hyst / 2) / a + ctx.calib.offset);
+    }
+
+    acq_meas_t m;
+    acq_MeasureCnts(raw_buffer, ADC_BUFFER_SIZE, pos, size, ctx.bits, ctx.is_sign, low, high, &m);
+
+    double mean_cnts = (double)m.sum / size;
+    double sq_cnts = (double)m.sum_sq / size;
+    meas->min = a * m.min + b;
+    meas->max = a * m.max + b;
+    meas->mean = a * mean_cnts + b;
+    meas->rms = sqrt(MAX(a * a * sq_cnts + 2 * a * b * mean_cnts + b * b, 0));
+    meas->rising = m.rising;
+    meas->falling = m.falling;
+    meas->first_rising = m.first_rising;
+    meas->period = 0;
+    meas->frequency = 0;
+    if (m.rising > 1 && m.last_rising > m.first_rising) {
+        meas->period = (m.last_rising - m.first_rising) / (m.rising - 1) / rate;
+        meas->frequency = 1.0f / meas->period;
+    }
     return RP_OK;
 }
 
-int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buffer){
-    return acq_GetDataVEx(channel,pos,size,buffer,true);
-}
-
 
 int acq_GetDataV2(uint32_t pos, buffers_t *out)
 {
@@ -1218,6 +1279,532 @@ int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 }
 
 
+static double getStreamTime(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Time base of the lap estimation. The simulator falls behind the wall clock on a slow host,
+ * there the laps follow its ADC clock */
+static double getWriterTime(){
+#ifdef RP_SIM
+    return sim_GetTime();
+#else
+    return getStreamTime();
+#endif
+}
+
+/* Sampling rate used to estimate whole laps of the ring. The writing stops after the trigger
+ * unless arm keep is set, then there are no laps to estimate */
+static double getStreamRate(){
+    bool triggered = false;
+    bool keep = false;
+    osc_GetTriggerState(&triggered);
+    osc_GetArmKeep(&keep);
+    if (triggered && !keep){
+        return 0;
+    }
+    float rate = 0;
+    if (acq_GetSamplingRateHz(&rate) != RP_OK){
+        return 0;
+    }
+    return rate;
+}
+
+static int pollStream(uint32_t *dropped){
+    uint32_t wp = 0;
+    if (acq_GetWritePointer(&wp) != RP_OK){
+        return RP_EOOR;
+    }
+    uint32_t d = acq_stream_Update(&acq_stream, wp, getWriterTime(), getStreamRate());
+    if (dropped){
+        *dropped = d;
+    }
+    return RP_OK;
+}
+
+int acq_StreamStart(){
+    LOCK_CORE();
+    uint32_t wp = 0;
+    if (acq_GetWritePointer(&wp) != RP_OK){
+        return RP_EOOR;
+    }
+    acq_stream_Reset(&acq_stream, ADC_BUFFER_SIZE, wp, getWriterTime());
+    acq_stream_started = true;
+    return RP_OK;
+}
+
+int acq_StreamStop(){
+    LOCK_CORE();
+    acq_stream_started = false;
+    return RP_OK;
+}
+
+int acq_StreamGetSpan(uint32_t min_samples, uint32_t timeout_ms, rp_acq_stream_span_t *span){
+    if (!acq_stream_started){
+        fprintf(stderr,"[Error:acq_StreamGetSpan] Stream is not started\n");
+        return RP_EOOR;
+    }
+    if (min_samples > ADC_BUFFER_SIZE){
+        fprintf(stderr,"[Error:acq_StreamGetSpan] Requested more samples than the buffer holds\n");
+        return RP_EOOR;
+    }
+
+    double deadline = getStreamTime() + timeout_ms / 1000.0;
+    while(true){
+        if (pollStream(NULL) != RP_OK){
+            return RP_EOOR;
+        }
+        double now = getStreamTime();
+        if (acq_stream.unread >= min_samples || now >= deadline){
+            break;
+        }
+        // Sleep until the missing samples should be there, but wake up at least every 10 ms
+        double rate = getStreamRate();
+        double wait = rate > 0 ? (min_samples - acq_stream.unread) / rate : 0.001;
+        wait = MIN(wait, deadline - now);
+        wait = MIN(wait, 0.01);
+        usleep(MAX((useconds_t)(wait * 1e6), 20));
+    }
+
+    span->pos = acq_stream.read_pos;
+    span->size = acq_stream.unread;
+    span->overrun = acq_stream.overrun;
+    span->lost = acq_stream.lost;
+    acq_stream.overrun = false;
+    return RP_OK;
+}
+
+int acq_StreamGetView(rp_channel_t channel, const rp_acq_stream_span_t *span, const volatile uint32_t **first, uint32_t *first_size, const volatile uint32_t **second, uint32_t *second_size){
+
+    CHECK_CHANNEL("acq_StreamGetView")
+
+    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+    if (!raw_buffer) {
+        return RP_EOOR;
+    }
+
+    uint32_t pos = acq_GetNormalizedDataPos(span->pos);
+    uint32_t size = MIN(span->size, ADC_BUFFER_SIZE);
+    *first = raw_buffer + pos;
+    *first_size = MIN(size, ADC_BUFFER_SIZE - pos);
+    *second = raw_buffer;
+    *second_size = size - *first_size;
+    return RP_OK;
+}
+
+int acq_StreamRelease(uint32_t count, bool *overwritten){
+    if (!acq_stream_started){
+        fprintf(stderr,"[Error:acq_StreamRelease] Stream is not started\n");
+        return RP_EOOR;
+    }
+    // The oldest unread samples are the ones just read, if the writer got to them the data is damaged
+    uint32_t dropped = 0;
+    if (pollStream(&dropped) != RP_OK){
+        return RP_EOOR;
+    }
+    if (overwritten){
+        *overwritten = dropped > 0 && count > 0;
+    }
+    acq_stream_Consume(&acq_stream, count > dropped ? count - dropped : 0);
+    return RP_OK;
+}
+
+int acq_StreamRead(uint32_t min_samples, uint32_t timeout_ms, buffers_t *out, rp_acq_stream_span_t *span){
+    int ret = acq_StreamGetSpan(min_samples, timeout_ms, span);
+    if (ret != RP_OK){
+        return ret;
+    }
+
+    uint8_t channels = 0;
+    if (rp_HPGetFastADCChannelsCount(&channels) != RP_HP_OK){
+        fprintf(stderr,"[Error:acq_StreamRead] Can't get fast ADC channels count\n");
+        return RP_NOTS;
+    }
+
+    uint32_t size = MIN(out->size, span->size);
+    for(uint8_t ch = 0; ch < channels && ch < 4; ch++){
+        uint32_t s = size;
+        if (out->ch_f[ch]){
+            ret = acq_GetDataVEx((rp_channel_t)ch, span->pos, &s, out->ch_f[ch], true);
+        }else if (out->ch_d[ch]){
+            ret = acq_GetDataVEx((rp_channel_t)ch, span->pos, &s, out->ch_d[ch], false);
+        }else if (out->ch_i[ch]){
+            ret = acq_GetDataRaw((rp_channel_t)ch, span->pos, &s, out->ch_i[ch]);
+        }
+        if (ret != RP_OK){
+            return ret;
+        }
+    }
+    out->size = size;
+    span->size = size;
+
+    bool overwritten = false;
+    ret = acq_StreamRelease(size, &overwritten);
+    span->overrun |= overwritten;
+    return ret;
+}
+
+int acq_SegmentedRelease(){
+    LOCK_CORE();
+    for(int i = 0; i < 4; i++){
+        free(acq_segments.data[i]);
+    }
+    free(acq_segments.info);
+    memset(&acq_segments, 0, sizeof(acq_segments));
+    return RP_OK;
+}
+
+int acq_SegmentedInit(uint32_t segments, uint32_t pre_samples, uint32_t post_samples){
+    LOCK_CORE();
+    // A record must be copied before the writer gets back to it, so it takes at most half of the buffer
+    if (segments == 0 || post_samples == 0 || pre_samples + post_samples > ADC_BUFFER_SIZE / 2){
+        fprintf(stderr,"[Error:acq_SegmentedInit] Invalid segment size\n");
+        return RP_EOOR;
+    }
+
+    uint8_t channels = 0;
+    if (rp_HPGetFastADCChannelsCount(&channels) != RP_HP_OK){
+        fprintf(stderr,"[Error:acq_SegmentedInit] Can't get fast ADC channels count\n");
+        return RP_NOTS;
+    }
+
+    acq_SegmentedRelease();
+    size_t words = (size_t)segments * (pre_samples + post_samples);
+    for(uint8_t ch = 0; ch < channels && ch < 4; ch++){
+        acq_segments.data[ch] = malloc(words * sizeof(uint32_t));
+        if (!acq_segments.data[ch]){
+            acq_SegmentedRelease();
+            fprintf(stderr,"[Error:acq_SegmentedInit] Can't allocate %u segments\n",segments);
+            return RP_EOOR;
+        }
+    }
+    acq_segments.info = calloc(segments, sizeof(rp_acq_segment_info_t));
+    if (!acq_segments.info){
+        acq_SegmentedRelease();
+        fprintf(stderr,"[Error:acq_SegmentedInit] Can't allocate %u segments\n",segments);
+        return RP_EOOR;
+    }
+    acq_segments.segments = segments;
+    acq_segments.pre = pre_samples;
+    acq_segments.post = post_samples;
+    return RP_OK;
+}
+
+/* Level trigger of the segmented capture after the first record. The CPU applies it to the written
+ * samples like the comparator does, so the FPGA trigger is armed only once: it is primed when the
+ * signal leaves the hysteresis band on the far side of the level and fires on the next crossing */
+typedef struct {
+    const volatile uint32_t *ring;
+    uint32_t mask;
+    int32_t  shift;
+    int32_t  thr;
+    int32_t  hyst;
+    bool     positive;
+    bool     primed;
+} acq_segment_trig_t;
+
+/* Fails for the sources that are not visible in the samples */
+static int segmentTrigInit(rp_acq_trig_src_t source, acq_segment_trig_t *trig){
+    rp_channel_t channel;
+    switch(source){
+        case RP_TRIG_SRC_CHA_PE: channel = RP_CH_1; trig->positive = true;  break;
+        case RP_TRIG_SRC_CHA_NE: channel = RP_CH_1; trig->positive = false; break;
+        case RP_TRIG_SRC_CHB_PE: channel = RP_CH_2; trig->positive = true;  break;
+        case RP_TRIG_SRC_CHB_NE: channel = RP_CH_2; trig->positive = false; break;
+        case RP_TRIG_SRC_CHC_PE: channel = RP_CH_3; trig->positive = true;  break;
+        case RP_TRIG_SRC_CHC_NE: channel = RP_CH_3; trig->positive = false; break;
+        case RP_TRIG_SRC_CHD_PE: channel = RP_CH_4; trig->positive = true;  break;
+        case RP_TRIG_SRC_CHD_NE: channel = RP_CH_4; trig->positive = false; break;
+        default:
+            return RP_EOOR;
+    }
+    acq_context_t ctx;
+    int ret = getContext(channel, &ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
+    uint32_t thr = 0, hyst = 0;
+    switch(channel){
+        case RP_CH_1: osc_GetThresholdChA(&thr); osc_GetHysteresisChA(&hyst); break;
+        case RP_CH_2: osc_GetThresholdChB(&thr); osc_GetHysteresisChB(&hyst); break;
+        case RP_CH_3: osc_GetThresholdChC(&thr); osc_GetHysteresisChC(&hyst); break;
+        case RP_CH_4: osc_GetThresholdChD(&thr); osc_GetHysteresisChD(&hyst); break;
+    }
+    trig->ring = getRawBuffer(channel);
+    trig->mask = ((uint64_t)1 << ctx.bits) - 1;
+    trig->shift = ctx.is_sign ? 32 - ctx.bits : 0;
+    trig->thr = (int32_t)((thr & trig->mask) << trig->shift) >> trig->shift;
+    trig->hyst = hyst;
+    trig->primed = false;
+    return RP_OK;
+}
+
+/* Returns the offset of the first trigger in size samples from pos, or size without one */
+static uint32_t segmentTrigScan(acq_segment_trig_t *trig, uint32_t pos, uint32_t size){
+    uint32_t buf[1024];
+    for(uint32_t done = 0; done < size;){
+        uint32_t n = MIN(size - done, 1024);
+        acq_ReadWords(trig->ring, ADC_BUFFER_SIZE, (pos + done) % ADC_BUFFER_SIZE, n, buf);
+        for(uint32_t i = 0; i < n; i++){
+            int32_t x = (int32_t)((buf[i] & trig->mask) << trig->shift) >> trig->shift;
+            if (trig->positive ? x < trig->thr - trig->hyst : x > trig->thr + trig->hyst){
+                trig->primed = true;
+            }else if (trig->primed && (trig->positive ? x >= trig->thr : x <= trig->thr)){
+                trig->primed = false;
+                return done + i;
+            }
+        }
+        done += n;
+    }
+    return size;
+}
+
+/* Spins until the armed trigger fired, the FPGA clears the trigger source then */
+static bool waitSegmentTrigger(double deadline){
+    while(true){
+        uint32_t source = 0;
+        bool triggered = false;
+        osc_GetTriggerSource(&source);
+        osc_GetTriggerState(&triggered);
+        if (source == 0 && triggered){
+            return true;
+        }
+        if (getStreamTime() >= deadline){
+            return false;
+        }
+    }
+}
+
+/* Follows the writer, returns true when it overtook the cursor */
+static bool pollSegments(acq_stream_t *cur, double rate){
+    uint32_t wp = 0;
+    osc_GetWritePointer(&wp);
+    acq_stream_Update(cur, wp, getWriterTime(), rate);
+    bool overrun = cur->overrun;
+    cur->overrun = false;
+    return overrun;
+}
+
+int acq_SegmentedCapture(uint32_t count, uint32_t timeout_ms, uint32_t *captured){
+    LOCK_CORE();
+    *captured = 0;
+    if (!acq_segments.info){
+        fprintf(stderr,"[Error:acq_SegmentedCapture] Segment store is not initialized\n");
+        return RP_EOOR;
+    }
+    rp_acq_trig_src_t source = last_trig_src;
+    if (source == RP_TRIG_SRC_DISABLED){
+        fprintf(stderr,"[Error:acq_SegmentedCapture] Trigger source is not set\n");
+        return RP_EOOR;
+    }
+    float rate = 0;
+    if (acq_GetSamplingRateHz(&rate) != RP_OK || rate <= 0){
+        return RP_EOOR;
+    }
+
+    // External triggers are not in the samples, for them the FPGA trigger is armed again for each record
+    acq_segment_trig_t trig;
+    memset(&trig, 0, sizeof(trig));
+    bool rearm = source != RP_TRIG_SRC_NOW && segmentTrigInit(source, &trig) != RP_OK;
+
+    bool arm_keep = false;
+    acq_GetArmKeep(&arm_keep);
+    // Writing goes on after the trigger, the cursor follows it and the records are taken from the ring
+    acq_SetArmKeep(true);
+
+    count = MIN(count, acq_segments.segments);
+    uint32_t pre = acq_segments.pre;
+    uint32_t post = acq_segments.post;
+    uint32_t len = pre + post;
+    double deadline = getStreamTime() + timeout_ms / 1000.0;
+
+    acq_stream_t cur;
+    uint32_t wp = 0;
+    osc_GetWritePointer(&wp);
+    acq_stream_Reset(&cur, ADC_BUFFER_SIZE, wp, getWriterTime());
+    acq_Start();
+    acq_SetTriggerSrc(source);
+
+    uint64_t consumed = 0;      // Samples released from the cursor, with cur.lost the position of cur.read_pos
+    uint64_t first_pos = 0;
+    double first_time = 0;
+    uint32_t searched = 0;      // Samples searched since the last record, they are valid pre trigger samples
+    bool armed = true;          // The FPGA trigger is armed and its trigger not used yet
+    uint32_t done = 0;
+    bool timeout = false;
+    while(done < count && !timeout){
+        uint32_t offset = 0;    // Trigger from cur.read_pos
+        uint32_t pre_valid = pre;
+        if (done == 0 || rearm){
+            if (!armed){
+                acq_SetTriggerSrc(source);
+            }
+            armed = false;
+            if (!waitSegmentTrigger(deadline)){
+                break;
+            }
+            uint32_t tp = 0, pre_cnt = 0;
+            osc_GetWritePointerAtTrig(&tp);
+            osc_GetPreTriggerCounter(&pre_cnt);
+            pollSegments(&cur, rate);
+            offset = (tp + ADC_BUFFER_SIZE - cur.read_pos) % ADC_BUFFER_SIZE;
+            if (offset >= cur.unread){
+                // Already overwritten
+                continue;
+            }
+            pre_valid = MIN(pre_cnt, pre);
+        }else if (source == RP_TRIG_SRC_NOW){
+            // The records follow each other without a gap
+            offset = pre;
+        }else{
+            while(true){
+                if (pollSegments(&cur, rate)){
+                    searched = 0;
+                    trig.primed = false;
+                }
+                offset = segmentTrigScan(&trig, cur.read_pos, cur.unread);
+                acq_stream_Consume(&cur, offset);
+                consumed += offset;
+                searched = MIN((uint64_t)searched + offset, pre);
+                if (cur.unread > 0){
+                    break;
+                }
+                if (getStreamTime() >= deadline){
+                    timeout = true;
+                    break;
+                }
+            }
+            if (timeout){
+                break;
+            }
+            offset = 0;
+            pre_valid = searched;
+        }
+
+        // Wait until the last post trigger sample is written
+        bool lost = false;
+        while(cur.unread < offset + post){
+            if (getStreamTime() >= deadline){
+                timeout = true;
+                break;
+            }
+            if (pollSegments(&cur, rate)){
+                lost = true;
+                break;
+            }
+        }
+        if (timeout){
+            break;
+        }
+        if (lost){
+            searched = 0;
+            trig.primed = false;
+            continue;
+        }
+        acq_stream_Consume(&cur, offset);
+        consumed += offset;
+
+        uint32_t tp = cur.read_pos;
+        uint64_t pos = consumed + cur.lost;
+        if (done == 0){
+            // The last written sample is the one at the last update
+            first_pos = pos;
+            first_time = getStreamTime() - (double)(cur.unread - 1) / rate;
+        }
+        uint32_t start = (tp + ADC_BUFFER_SIZE - pre) % ADC_BUFFER_SIZE;
+        for(int ch = 0; ch < 4; ch++){
+            if (acq_segments.data[ch]){
+                acq_ReadWords(getRawBuffer((rp_channel_t)ch), ADC_BUFFER_SIZE, start, len, acq_segments.data[ch] + (size_t)done * len);
+            }
+        }
+
+        // The oldest sample of the record is overwritten once the writer is a whole buffer ahead of it
+        bool overrun = pollSegments(&cur, rate);
+        rp_acq_segment_info_t *info = &acq_segments.info[done];
+        info->timestamp_ns = (uint64_t)((first_time + (double)(pos - first_pos) / rate) * 1e9);
+        info->trig_pos = tp;
+        info->pre_valid = pre_valid;
+        info->valid = !overrun && cur.unread + pre <= ADC_BUFFER_SIZE;
+        done++;
+
+        // The next trigger is searched from the end of the record
+        if (!overrun){
+            acq_stream_Consume(&cur, post);
+            consumed += post;
+        }
+        searched = 0;
+        trig.primed = false;
+    }
+
+    acq_SetArmKeep(arm_keep);
+    acq_segments.captured = done;
+    *captured = done;
+    return RP_OK;
+}
+
+int acq_SegmentedGetInfo(uint32_t first, uint32_t count, rp_acq_segment_info_t *info){
+    if (first + count > acq_segments.captured || first + count < first){
+        fprintf(stderr,"[Error:acq_SegmentedGetInfo] Segments out of range\n");
+        return RP_EOOR;
+    }
+    memcpy(info, acq_segments.info + first, count * sizeof(rp_acq_segment_info_t));
+    return RP_OK;
+}
+
+static int getSegmentData(rp_channel_t channel, uint32_t first, uint32_t count, acq_context_t *ctx, const uint32_t **data){
+    int ret = getContext(channel,ctx);
+    if (ret != RP_OK){
+        return ret;
+    }
+    if (first + count > acq_segments.captured || first + count < first){
+        fprintf(stderr,"[Error:getSegmentData] Segments out of range\n");
+        return RP_EOOR;
+    }
+    if (!acq_segments.data[channel]){
+        return RP_EOOR;
+    }
+    *data = acq_segments.data[channel] + (size_t)first * (acq_segments.pre + acq_segments.post);
+    return RP_OK;
+}
+
+int acq_SegmentedGetDataRaw(rp_channel_t channel, uint32_t first, uint32_t count, int16_t* buffer){
+    acq_context_t ctx;
+    const uint32_t *data = NULL;
+    int ret = getSegmentData(channel, first, count, &ctx, &data);
+    if (ret != RP_OK){
+        return ret;
+    }
+    uint32_t size = count * (acq_segments.pre + acq_segments.post);
+    if (size == 0){
+        return RP_OK;
+    }
+    acq_ReadRawCnts(data, size, 0, size, ctx.bits, ctx.is_sign, buffer);
+    return RP_OK;
+}
+
+int acq_SegmentedGetDataV(rp_channel_t channel, uint32_t first, uint32_t count, float* buffer){
+    acq_context_t ctx;
+    const uint32_t *data = NULL;
+    int ret = getSegmentData(channel, first, count, &ctx, &data);
+    if (ret != RP_OK){
+        return ret;
+    }
+    acq_volt_param_t param;
+    param.bits = ctx.bits;
+    param.gain = ctx.calib.gain;
+    param.base = ctx.calib.base;
+    param.offset = ctx.calib.offset;
+    param.fullScale = ctx.fullScale;
+    uint32_t size = count * (acq_segments.pre + acq_segments.post);
+    if (size == 0){
+        return RP_OK;
+    }
+    acq_ReadVolts(data, size, 0, size, &param, buffer, NULL);
+    return RP_OK;
+}
+
 int acq_GetBufferSize(uint32_t *size) {
     *size = ADC_BUFFER_SIZE;
     return RP_OK;
@@ -1228,6 +1815,7 @@ int acq_GetBufferSize(uint32_t *size) {
  * @return
  */
 int acq_SetDefault() {
+    LOCK_CORE();
     acq_SetChannelThreshold(RP_CH_1, 0.0);
     acq_SetChannelThreshold(RP_CH_2, 0.0);
     acq_SetChannelThresholdHyst(RP_CH_1, 0.005);
@@ -1266,6 +1854,7 @@ int acq_SetDefault() {
 
 
 int acq_SetAC_DC(rp_channel_t channel,rp_acq_ac_dc_mode_t mode){
+    LOCK_CHANNEL(channel);
 
     uint8_t channels = 0;
     if (rp_HPGetFastADCChannelsCount(&channels) != RP_HP_OK){
@@ -1293,6 +1882,7 @@ int acq_SetAC_DC(rp_channel_t channel,rp_acq_ac_dc_mode_t mode){
     }
 
     *power_mode = status == RP_OK ? mode : RP_DC;
+    atomic_fetch_add_explicit(&acq_context_version[channel], 1, memory_order_release);
 
     return status;
 }
@@ -1307,6 +1897,7 @@ int acq_GetAC_DC(rp_channel_t channel,rp_acq_ac_dc_mode_t *status){
 
 
 int acq_UpdateAcqFilter(rp_channel_t channel){
+    LOCK_CHANNEL(channel);
     return setEqFilters(channel);
 }
 
@@ -1331,6 +1922,7 @@ int acq_GetFilterCalibValue(rp_channel_t channel,uint32_t* coef_aa, uint32_t* co
 
 
 int acq_SetExtTriggerDebouncerUs(double value){
+    LOCK_CORE();
     if (value < 0)
         return RP_EIPV;
 
@@ -72,6 +72,21 @@ int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
+
+int acq_StreamStart();
+int acq_StreamStop();
+int acq_StreamGetSpan(uint32_t min_samples, uint32_t timeout_ms, rp_acq_stream_span_t *span);
+int acq_StreamGetView(rp_channel_t channel, const rp_acq_stream_span_t *span, const volatile uint32_t **first, uint32_t *first_size, const volatile uint32_t **second, uint32_t *second_size);
+int acq_StreamRelease(uint32_t count, bool *overwritten);
+int acq_StreamRead(uint32_t min_samples, uint32_t timeout_ms, buffers_t *out, rp_acq_stream_span_t *span);
+
+int acq_SegmentedInit(uint32_t segments, uint32_t pre_samples, uint32_t post_samples);
+int acq_SegmentedRelease();
+int acq_SegmentedCapture(uint32_t count, uint32_t timeout_ms, uint32_t *captured);
+int acq_SegmentedGetInfo(uint32_t first, uint32_t count, rp_acq_segment_info_t *info);
+int acq_SegmentedGetDataRaw(rp_channel_t channel, uint32_t first, uint32_t count, int16_t* buffer);
+int acq_SegmentedGetDataV(rp_channel_t channel, uint32_t first, uint32_t count, float* buffer);
+int acq_GetMeasurements(rp_channel_t channel, uint32_t pos, uint32_t size, float level, float hyst, rp_acq_signal_meas_t *meas);
 int acq_SetDefault();
 
 uint32_t acq_GetNormalizedDataPos(uint32_t pos);
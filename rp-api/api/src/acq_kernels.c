@@ -0,0 +1,182 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library ADC buffer readout kernels implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stddef.h>
+#include "acq_kernels.h"
+#include "neon_asm.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
+/* Words staged from device memory at once before the NEON conversion */
+#define ACQ_CHUNK 1024
+
+/* Device memory is read in 64 byte bursts, the rest word by word */
+static void copyWords(uint32_t *dst, const volatile uint32_t *src, uint32_t n){
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    i = n & ~15u;
+    if (i){
+        memcpy_neon(dst, src, i * sizeof(uint32_t));
+    }
+#endif
+    for (; i < n; i++){
+        dst[i] = src[i];
+    }
+}
+
+static inline int32_t signExtend(uint32_t cnts, int32_t shift){
+    return (int32_t)(cnts << shift) >> shift;
+}
+
+/* On ARM the input is the staging buffer filled by copyWords, otherwise the ring itself */
+static void convertRaw(const volatile uint32_t *in, uint32_t n, uint8_t bits, bool is_signed, int16_t *out){
+    uint32_t mask = ((uint64_t)1 << bits) - 1;
+    int32_t shift = is_signed ? 32 - bits : 0;
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    const uint32_t *tmp = (const uint32_t *)in;
+    uint32x4_t vmask = vdupq_n_u32(mask);
+    int32x4_t vshl = vdupq_n_s32(shift);
+    int32x4_t vshr = vdupq_n_s32(-shift);
+    for (; i + 8 <= n; i += 8){
+        int32x4_t a = vreinterpretq_s32_u32(vandq_u32(vld1q_u32(tmp + i), vmask));
+        int32x4_t b = vreinterpretq_s32_u32(vandq_u32(vld1q_u32(tmp + i + 4), vmask));
+        a = vshlq_s32(vshlq_s32(a, vshl), vshr);
+        b = vshlq_s32(vshlq_s32(b, vshl), vshr);
+        vst1q_s16(out + i, vcombine_s16(vmovn_s32(a), vmovn_s32(b)));
+    }
+#endif
+    for (; i < n; i++){
+        out[i] = signExtend(in[i] & mask, shift);
+    }
+}
+
+/* One of out_f and out_d is written. The NEON path only handles out_f */
+static void convertVolts(const volatile uint32_t *in, uint32_t n, const acq_volt_param_t *param, float *out_f, double *out_d){
+    uint32_t mask = ((uint64_t)1 << param->bits) - 1;
+    int32_t shift = 32 - param->bits;
+    int32_t limit = 1 << (param->bits - 1);
+    float scale = param->fullScale / (float)limit;
+    /* Division by base is a shift when base is a power of 2, as set by the calibration */
+    int32_t precision = __builtin_ctz(param->base | 0x80000000);
+    bool pow2 = param->base == (1u << precision);
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    if (pow2 && out_f){
+        const uint32_t *tmp = (const uint32_t *)in;
+        uint32x4_t vmask = vdupq_n_u32(mask);
+        int32x4_t vshl = vdupq_n_s32(shift);
+        int32x4_t vshr = vdupq_n_s32(-shift);
+        int32x4_t voffset = vdupq_n_s32(param->offset);
+        int32x4_t vgain = vdupq_n_s32((int32_t)param->gain);
+        int32x4_t vround = vdupq_n_s32((int32_t)param->base - 1);
+        int32x4_t vprecision = vdupq_n_s32(-precision);
+        int32x4_t vmin = vdupq_n_s32(-limit);
+        int32x4_t vmax = vdupq_n_s32(limit);
+        for (; i + 4 <= n; i += 4){
+            int32x4_t m = vreinterpretq_s32_u32(vandq_u32(vld1q_u32(tmp + i), vmask));
+            m = vshlq_s32(vshlq_s32(m, vshl), vshr);
+            m = vmulq_s32(vsubq_s32(m, voffset), vgain);
+            /* Round towards zero like the integer division */
+            m = vaddq_s32(m, vandq_s32(vshrq_n_s32(m, 31), vround));
+            m = vshlq_s32(m, vprecision);
+            m = vminq_s32(vmaxq_s32(m, vmin), vmax);
+            vst1q_f32(out_f + i, vmulq_n_f32(vcvtq_f32_s32(m), scale));
+        }
+    }
+#endif
+    for (; i < n; i++){
+        int32_t m = signExtend(in[i] & mask, shift);
+        m = ((int32_t)param->gain * (m - param->offset));
+        if (pow2){
+            m = (m + ((m >> 31) & ((int32_t)param->base - 1))) >> precision;
+        }else{
+            m /= (int32_t)param->base;
+        }
+        if (m < -limit)
+            m = -limit;
+        else if (m > limit)
+            m = limit;
+        float v = (float)m * scale;
+        if (out_f)
+            out_f[i] = v;
+        else
+            out_d[i] = v;
+    }
+}
+
+void acq_ReadWords(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint32_t *out){
+    uint32_t done = 0;
+    pos %= ring_size;
+    while (done < size){
+        uint32_t start = (pos + done) % ring_size;
+        uint32_t len = size - done;
+        if (len > ring_size - start) len = ring_size - start;
+        copyWords(out + done, ring + start, len);
+        done += len;
+    }
+}
+
+void acq_ReadRawCnts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint8_t bits, bool is_signed, int16_t *out){
+#ifdef ARCH_ARM
+    uint32_t tmp[ACQ_CHUNK];
+#endif
+    uint32_t done = 0;
+    pos %= ring_size;
+    while (done < size){
+        uint32_t start = (pos + done) % ring_size;
+        uint32_t len = size - done;
+        if (len > ring_size - start) len = ring_size - start;
+#ifdef ARCH_ARM
+        if (len > ACQ_CHUNK) len = ACQ_CHUNK;
+        copyWords(tmp, ring + start, len);
+        convertRaw(tmp, len, bits, is_signed, out + done);
+#else
+        convertRaw(ring + start, len, bits, is_signed, out + done);
+#endif
+        done += len;
+    }
+}
+
+void acq_ReadVolts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, const acq_volt_param_t *param, float *out_f, double *out_d){
+#ifdef ARCH_ARM
+    uint32_t tmp[ACQ_CHUNK];
+    float volts[ACQ_CHUNK];
+#endif
+    uint32_t done = 0;
+    pos %= ring_size;
+    while (done < size){
+        uint32_t start = (pos + done) % ring_size;
+        uint32_t len = size - done;
+        if (len > ring_size - start) len = ring_size - start;
+#ifdef ARCH_ARM
+        if (len > ACQ_CHUNK) len = ACQ_CHUNK;
+        copyWords(tmp, ring + start, len);
+        if (out_f){
+            convertVolts(tmp, len, param, out_f + done, NULL);
+        }else{
+            /* Same float values as the single precision read */
+            convertVolts(tmp, len, param, volts, NULL);
+            for (uint32_t i = 0; i < len; i++){
+                out_d[done + i] = volts[i];
+            }
+        }
+#else
+        convertVolts(ring + start, len, param, out_f ? out_f + done : NULL, out_d ? out_d + done : NULL);
+#endif
+        done += len;
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library ADC buffer readout kernels
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef ACQ_KERNELS_H_
+#define ACQ_KERNELS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Reads from the circular ADC buffer. A read is split into at most two contiguous
+ * spans. On ARM they are copied from device memory in bursts and converted with NEON,
+ * otherwise each sample is converted straight from the buffer. Both give the same
+ * results as cmn_CalibCntsSigned, cmn_CalibCntsUnsigned and cmn_convertToVoltSigned.
+ */
+
+/* Calibration of signed counts: ((cnts - offset) * gain) / base, limited to +-2^(bits-1) */
+typedef struct {
+    uint8_t  bits;
+    uint32_t gain;
+    uint32_t base;
+    int32_t  offset;
+    float    fullScale;
+} acq_volt_param_t;
+
+/* Unconverted ADC words */
+void acq_ReadWords(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint32_t *out);
+
+/* Masked counts, sign extended when is_signed */
+void acq_ReadRawCnts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint8_t bits, bool is_signed, int16_t *out);
+
+/* Calibrated volts. One of out_f and out_d is used */
+void acq_ReadVolts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, const acq_volt_param_t *param, float *out_f, double *out_d);
+
+#endif /* ACQ_KERNELS_H_ */
@@ -0,0 +1,278 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library single pass signal measurement kernel implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stddef.h>
+#include <limits.h>
+#include "acq_measure.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
+/* Words copied from device memory at once */
+#define MEAS_CHUNK 1024
+
+typedef enum {
+    EDGE_NONE,  /* Neither threshold reached yet */
+    EDGE_LOW,
+    EDGE_HIGH
+} edge_state_t;
+
+typedef struct {
+    int32_t      low;
+    int32_t      high;
+    float        level;     /* Middle level, crossings are interpolated to it */
+    int32_t      level_i;   /* Smallest count at or above level */
+    edge_state_t state;
+    int32_t      prev;
+    uint32_t     idx;       /* Position of the next sample */
+    float        cross;     /* Last crossing of level in the direction of the next edge */
+} edge_t;
+
+static inline int32_t signExtend(uint32_t cnts, int32_t shift){
+    return (int32_t)(cnts << shift) >> shift;
+}
+
+static inline void edgeSample(edge_t *e, int32_t x, acq_meas_t *out){
+    uint32_t i = e->idx++;
+    if (e->state == EDGE_HIGH){
+        if (e->prev >= e->level_i && x < e->level_i){
+            e->cross = (float)(i - 1) + (e->level - e->prev) / (float)(x - e->prev);
+        }
+        if (x < e->low){
+            if (out->falling++ == 0){
+                out->first_falling = e->cross;
+            }
+            out->last_falling = e->cross;
+            e->state = EDGE_LOW;
+        }
+    } else {
+        if (e->prev < e->level_i && x >= e->level_i){
+            e->cross = (float)(i - 1) + (e->level - e->prev) / (float)(x - e->prev);
+        }
+        if (x >= e->high){
+            /* From EDGE_NONE the signal was never below low, so it is not an edge */
+            if (e->state == EDGE_LOW){
+                if (out->rising++ == 0){
+                    out->first_rising = e->cross;
+                }
+                out->last_rising = e->cross;
+            }
+            e->state = EDGE_HIGH;
+        } else if (x < e->low){
+            e->state = EDGE_LOW;
+        }
+    }
+    e->prev = x;
+}
+
+static void measureChunk(const uint32_t *in, uint32_t n, uint8_t bits, bool is_signed, edge_t *e, acq_meas_t *out){
+    uint32_t mask = ((uint64_t)1 << bits) - 1;
+    int32_t shift = is_signed ? 32 - bits : 0;
+    int32_t min = out->min;
+    int32_t max = out->max;
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    /* Counts must fit int16, the level only decides which blocks are skipped and may be clamped */
+    bool fits = is_signed ? bits <= 16 : bits < 16;
+    int32_t level = e ? e->level_i : 0;
+    level = level > INT16_MAX ? INT16_MAX : (level < INT16_MIN ? INT16_MIN : level);
+    uint32x4_t vmask = vdupq_n_u32(mask);
+    int32x4_t vshl = vdupq_n_s32(shift);
+    int32x4_t vshr = vdupq_n_s32(-shift);
+    int16x8_t vlevel = vdupq_n_s16(level);
+    int16x8_t vmin = vdupq_n_s16(INT16_MAX);
+    int16x8_t vmax = vdupq_n_s16(INT16_MIN);
+    int32x4_t vsum = vdupq_n_s32(0);
+    uint64x2_t vsq = vdupq_n_u64(0);
+    for (; fits && i + 8 <= n; i += 8){
+        int32x4_t a = vreinterpretq_s32_u32(vandq_u32(vld1q_u32(in + i), vmask));
+        int32x4_t b = vreinterpretq_s32_u32(vandq_u32(vld1q_u32(in + i + 4), vmask));
+        a = vshlq_s32(vshlq_s32(a, vshl), vshr);
+        b = vshlq_s32(vshlq_s32(b, vshl), vshr);
+        int16x8_t v = vcombine_s16(vmovn_s32(a), vmovn_s32(b));
+
+        vmin = vminq_s16(vmin, v);
+        vmax = vmaxq_s16(vmax, v);
+        vsum = vpadalq_s16(vsum, v);
+        vsq = vpadalq_u32(vsq, vreinterpretq_u32_s32(vmull_s16(vget_low_s16(v), vget_low_s16(v))));
+        vsq = vpadalq_u32(vsq, vreinterpretq_u32_s32(vmull_s16(vget_high_s16(v), vget_high_s16(v))));
+
+        if (!e){
+            continue;
+        }
+        /* Below the level nothing happens until the next rising edge, above it until the next falling one */
+        uint16x8_t pending;
+        if (e->state == EDGE_HIGH){
+            pending = vcltq_s16(v, vlevel);
+        } else if (e->state == EDGE_LOW){
+            pending = vcgeq_s16(v, vlevel);
+        } else {
+            pending = vdupq_n_u16(1);
+        }
+        uint64x2_t p = vreinterpretq_u64_u16(pending);
+        if ((vgetq_lane_u64(p, 0) | vgetq_lane_u64(p, 1)) == 0){
+            e->prev = vgetq_lane_s16(v, 7);
+            e->idx += 8;
+            continue;
+        }
+        int16_t s[8];
+        vst1q_s16(s, v);
+        for (int k = 0; k < 8; k++){
+            edgeSample(e, s[k], out);
+        }
+    }
+    int16_t vmin_s[8], vmax_s[8];
+    int32_t vsum_s[4];
+    vst1q_s16(vmin_s, vmin);
+    vst1q_s16(vmax_s, vmax);
+    vst1q_s32(vsum_s, vsum);
+    for (int k = 0; k < 8; k++){
+        if (vmin_s[k] < min) min = vmin_s[k];
+        if (vmax_s[k] > max) max = vmax_s[k];
+    }
+    sum += (int64_t)vsum_s[0] + vsum_s[1] + vsum_s[2] + vsum_s[3];
+    sum_sq += vgetq_lane_u64(vsq, 0) + vgetq_lane_u64(vsq, 1);
+#endif
+    for (; i < n; i++){
+        int32_t x = signExtend(in[i] & mask, shift);
+        if (x < min) min = x;
+        if (x > max) max = x;
+        sum += x;
+        sum_sq += (uint64_t)((int64_t)x * x);
+        if (e){
+            edgeSample(e, x, out);
+        }
+    }
+    out->min = min;
+    out->max = max;
+    out->sum += sum;
+    out->sum_sq += sum_sq;
+}
+
+void acq_MeasureCnts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint8_t bits, bool is_signed, int32_t low, int32_t high, acq_meas_t *out){
+    uint32_t buf[MEAS_CHUNK];
+    edge_t edge;
+    edge_t *e = NULL;
+
+    out->min = INT32_MAX;
+    out->max = INT32_MIN;
+    out->sum = 0;
+    out->sum_sq = 0;
+    out->rising = 0;
+    out->falling = 0;
+    out->first_rising = out->last_rising = 0;
+    out->first_falling = out->last_falling = 0;
+
+    if (size == 0 || ring_size == 0){
+        return;
+    }
+    pos %= ring_size;
+
+    if (low <= high){
+        uint32_t mask = ((uint64_t)1 << bits) - 1;
+        edge.low = low;
+        edge.high = high;
+        edge.level = ((float)low + (float)high) / 2;
+        edge.level_i = (low + high + 1) >> 1;
+        edge.state = EDGE_NONE;
+        edge.prev = signExtend(ring[pos] & mask, is_signed ? 32 - bits : 0);
+        edge.idx = 0;
+        edge.cross = 0;
+        e = &edge;
+    }
+
+    while (size > 0){
+        uint32_t n = ring_size - pos;
+        if (n > size) n = size;
+        if (n > MEAS_CHUNK) n = MEAS_CHUNK;
+        for (uint32_t i = 0; i < n; i++){
+            buf[i] = ring[pos + i];
+        }
+        measureChunk(buf, n, bits, is_signed, e, out);
+        size -= n;
+        pos += n;
+        if (pos == ring_size){
+            pos = 0;
+        }
+    }
+}
+
+void acq_MeasureBins(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t bin_len, uint32_t bins, uint8_t bits, bool is_signed, bool find_pos, acq_bin_t *out){
+    uint32_t buf[MEAS_CHUNK];
+    uint32_t n = 0;     /* Words in buf */
+    uint32_t off = 0;   /* Next word of buf */
+    uint64_t left = (uint64_t)bin_len * bins;
+    uint32_t mask = ((uint64_t)1 << bits) - 1;
+    int32_t shift = is_signed ? 32 - bits : 0;
+
+    if (ring_size == 0){
+        return;
+    }
+    pos %= ring_size;
+
+    /* Bins shorter than a chunk share one copy of the device memory */
+    for (uint32_t b = 0; b < bins; b++){
+        acq_meas_t m;
+        uint32_t min_pos = 0;
+        uint32_t max_pos = 0;
+        m.min = INT32_MAX;
+        m.max = INT32_MIN;
+        m.sum = 0;
+        m.sum_sq = 0;
+        for (uint32_t k = bin_len; k > 0;){
+            if (off == n){
+                n = ring_size - pos;
+                if (n > left) n = left;
+                if (n > MEAS_CHUNK) n = MEAS_CHUNK;
+                for (uint32_t i = 0; i < n; i++){
+                    buf[i] = ring[pos + i];
+                }
+                left -= n;
+                pos += n;
+                if (pos == ring_size){
+                    pos = 0;
+                }
+                off = 0;
+            }
+            uint32_t c = n - off < k ? n - off : k;
+            int32_t min = m.min;
+            int32_t max = m.max;
+            measureChunk(buf + off, c, bits, is_signed, NULL, &m);
+            /* A new extreme of the bin occurs first in this part */
+            bool find_min = find_pos && m.min < min;
+            bool find_max = find_pos && m.max > max;
+            for (uint32_t i = 0; find_min || find_max; i++){
+                int32_t x = signExtend(buf[off + i] & mask, shift);
+                if (find_min && x == m.min){
+                    min_pos = bin_len - k + i;
+                    find_min = false;
+                }
+                if (find_max && x == m.max){
+                    max_pos = bin_len - k + i;
+                    find_max = false;
+                }
+            }
+            off += c;
+            k -= c;
+        }
+        out[b].min = m.min;
+        out[b].max = m.max;
+        out[b].sum = m.sum;
+        out[b].min_pos = min_pos;
+        out[b].max_pos = max_pos;
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library single pass signal measurement kernel
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef ACQ_MEASURE_H_
+#define ACQ_MEASURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Measures a span of the circular ADC buffer in one pass: min, max, sum and sum of
+ * squares of the counts, and the edges of a Schmitt trigger with the thresholds
+ * low and high. A rising edge needs a sample below low followed by one at or above
+ * high, a falling edge the opposite. The edge position is the crossing of the middle
+ * level (low + high) / 2 interpolated between the two samples around it, in samples
+ * from pos.
+ * Samples are handled in blocks of 8 with NEON. Blocks that cannot contain an edge
+ * skip the trigger, so the cost is that of min/max for signals with few edges.
+ * The kernel has no other dependencies, so it is shared with the apps-free workers.
+ */
+
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;
+    uint64_t sum_sq;
+    uint32_t rising;        /* Number of rising edges */
+    uint32_t falling;
+    float    first_rising;  /* Positions of the first and the last edge, valid if the count is > 0 */
+    float    last_rising;
+    float    first_falling;
+    float    last_falling;
+} acq_meas_t;
+
+/* Counts are masked to bits and sign extended when is_signed. With low > high no edges are detected */
+void acq_MeasureCnts(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t size, uint8_t bits, bool is_signed, int32_t low, int32_t high, acq_meas_t *out);
+
+/*
+ * Min, max and sum of consecutive bins of bin_len samples, the display decimation of a
+ * span of bins * bin_len samples from pos. Uses the same 8 sample blocks as above.
+ * With find_pos the positions of the extremes are found by a scalar scan of the part of
+ * the bin that changed them, which stops at the first match, otherwise they are 0.
+ */
+
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;
+    uint32_t min_pos;       /* First samples equal to min and max, from the bin start */
+    uint32_t max_pos;
+} acq_bin_t;
+
+void acq_MeasureBins(const volatile uint32_t *ring, uint32_t ring_size, uint32_t pos, uint32_t bin_len, uint32_t bins, uint8_t bits, bool is_signed, bool find_pos, acq_bin_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACQ_MEASURE_H_ */
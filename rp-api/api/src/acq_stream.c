@@ -0,0 +1,66 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library continuous acquisition cursor implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include "acq_stream.h"
+
+/* After an overrun the oldest part of the ring is about to be overwritten, so it is skipped */
+#define ACQ_STREAM_GUARD(ring_size) ((ring_size) / 8)
+
+void acq_stream_Reset(acq_stream_t *s, uint32_t ring_size, uint32_t wp, double time){
+    s->ring_size = ring_size;
+    s->last_wp = wp % ring_size;
+    s->read_pos = (s->last_wp + 1) % ring_size;
+    s->unread = 0;
+    s->last_time = time;
+    s->lost = 0;
+    s->overrun = false;
+}
+
+uint32_t acq_stream_Update(acq_stream_t *s, uint32_t wp, double time, double rate){
+    uint32_t ring = s->ring_size;
+    wp %= ring;
+    uint64_t written = (wp + ring - s->last_wp) % ring;
+    if (rate > 0 && time > s->last_time){
+        // Whole laps are only visible through the elapsed time
+        double expected = (time - s->last_time) * rate;
+        if (expected > written + ring / 2){
+            written += (uint64_t)((expected - written) / ring + 0.5) * ring;
+        }
+    }
+
+    uint32_t dropped = 0;
+    uint64_t total = s->unread + written;
+    if (total > ring){
+        uint32_t keep = ring - ACQ_STREAM_GUARD(ring);
+        uint64_t lost = total - keep;
+        dropped = lost < s->unread ? (uint32_t)lost : s->unread;
+        s->lost += lost;
+        s->overrun = true;
+        s->unread = keep;
+    }else{
+        s->unread = (uint32_t)total;
+    }
+    s->read_pos = (wp + 1 + ring - s->unread) % ring;
+    s->last_wp = wp;
+    s->last_time = time;
+    return dropped;
+}
+
+void acq_stream_Consume(acq_stream_t *s, uint32_t count){
+    if (count > s->unread){
+        count = s->unread;
+    }
+    s->read_pos = (s->read_pos + count) % s->ring_size;
+    s->unread -= count;
+}
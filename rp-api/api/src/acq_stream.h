@@ -0,0 +1,50 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library continuous acquisition cursor
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef ACQ_STREAM_H_
+#define ACQ_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Read cursor against the write pointer of the circular ADC buffer.
+ * The write pointer is the position of the last written sample and says nothing
+ * about whole laps of the ring, so the number of laps between two updates is
+ * estimated from the elapsed time and the sampling rate. An overrun is reported
+ * when more samples were written than there was free space, then the cursor
+ * moves to the oldest sample that is still safe to read.
+ * It does not access hardware, the caller passes the write pointer and the time.
+ */
+
+typedef struct {
+    uint32_t ring_size;
+    uint32_t read_pos;      // First unread sample
+    uint32_t unread;        // Samples from read_pos up to the write pointer
+    uint32_t last_wp;       // Write pointer at the last update
+    double   last_time;     // Time of the last update in seconds
+    uint64_t lost;          // Samples overwritten before they were read
+    bool     overrun;       // Overrun since the flag was cleared
+} acq_stream_t;
+
+void acq_stream_Reset(acq_stream_t *s, uint32_t ring_size, uint32_t wp, double time);
+
+/* rate is the sampling rate in Hz, or 0 when the writing has stopped and no laps are possible.
+ * Returns how many of the samples unread before the update were overwritten */
+uint32_t acq_stream_Update(acq_stream_t *s, uint32_t wp, double time, double rate);
+
+/* Marks the oldest unread samples as read */
+void acq_stream_Consume(acq_stream_t *s, uint32_t count);
+
+#endif /* ACQ_STREAM_H_ */
@@ -20,13 +20,22 @@
 #include <assert.h>
 #include "common.h"
 #include "redpitaya/rp.h"
+#ifdef RP_SIM
+#include "sim_backend.h"
+#endif
 
 static int fd = 0;
 
+/* @brief Serialises read-modify-write of the FPGA registers */
+static pthread_mutex_t cmn_reg_lock = PTHREAD_MUTEX_INITIALIZER;
+
 bool g_DebugReg = false;
 
 int cmn_Init()
 {
+#ifdef RP_SIM
+    return sim_Init();
+#endif
     if (!fd) {
         if((fd = open("/dev/uio/api", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
@@ -37,6 +46,9 @@ int cmn_Init()
 
 int cmn_Release()
 {
+#ifdef RP_SIM
+    return sim_Release();
+#endif
     if (fd) {
         if(close(fd) < 0) {
             return RP_ECMD;
@@ -46,8 +58,37 @@ int cmn_Release()
     return RP_OK;
 }
 
+pthread_mutex_t* cmn_LockScoped(pthread_mutex_t *mutex)
+{
+    if (mutex) {
+        pthread_mutex_lock(mutex);
+    }
+    return mutex;
+}
+
+void cmn_UnlockScoped(pthread_mutex_t **mutex)
+{
+    if (*mutex) {
+        pthread_mutex_unlock(*mutex);
+    }
+}
+
+void cmn_InitRecursiveLocks(pthread_mutex_t *mutex, size_t count)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    for (size_t i = 0; i < count; i++) {
+        pthread_mutex_init(&mutex[i], &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+}
+
 int cmn_Map(size_t size, size_t offset, void** mapped)
 {
+#ifdef RP_SIM
+    return sim_Map(size, offset, mapped);
+#endif
     if(fd == -1) {
         return RP_EMMD;
     }
@@ -65,6 +106,9 @@ int cmn_Map(size_t size, size_t offset, void** mapped)
 
 int cmn_Unmap(size_t size, void** mapped)
 {
+#ifdef RP_SIM
+    return sim_Unmap(size, mapped);
+#endif
     if(fd == -1) {
         return RP_EUMD;
     }
@@ -120,6 +164,7 @@ void cmn_DebugRegCh(const char* msg,int ch,uint32_t value){
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSetShift,uint32_t *settedValue)
 {
     VALIDATE_BITS(value, mask);
+    CMN_SCOPED_LOCK(&cmn_reg_lock);
     cmn_GetValue(field, settedValue, 0xffffffff);
     *settedValue &=  ~(mask << bitsToSetShift); // Clear all bits at specified location
     *settedValue +=  (value << bitsToSetShift); // Set value at specified location
@@ -146,6 +191,7 @@ int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask)
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
+    CMN_SCOPED_LOCK(&cmn_reg_lock);
     SET_BITS(*field, bits);
     return RP_OK;
 }
@@ -153,6 +199,7 @@ int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
+    CMN_SCOPED_LOCK(&cmn_reg_lock);
     UNSET_BITS(*field, bits);
     return RP_OK;
 }
@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "redpitaya/rp.h"
 #include "rp_hw-calib.h"
 
@@ -81,6 +82,29 @@ else { \
 
 #define FULL_SCALE_NORM     20.0    // V
 
+/*
+ * Locking model of the library. rp_Init and rp_Release must not run concurrently with other calls.
+ * - Read-modify-write of FPGA registers (cmn_SetBits, cmn_UnsetBits, cmn_SetValue) is done under one
+ *   short register lock, so settings of different channels sharing a register do not overwrite each other.
+ * - Generator settings of a channel are serialised by the recursive lock of the channel, the cache of
+ *   synthesized buffers by its own lock. Locks are always taken in this order.
+ * - Acquisition settings shared by all channels (decimation, trigger, arming) are serialised by the
+ *   acquisition core lock, per-channel settings (gain, AC/DC, thresholds) by the lock of the channel.
+ *   The core lock is taken before a channel lock.
+ * - Calibration parameters and the per-channel acquisition contexts are read-mostly. Readers copy a
+ *   snapshot without locking and retry when it was replaced during the copy, so data reads never wait
+ *   for a writer and do not slow each other down.
+ * - The hardware profile is not changed after it was loaded.
+ * - The stream and segmented capture starts hold the core lock, their readers have one consumer.
+ */
+
+/* Locks the mutex until the end of the enclosing block, locks of one block are released in reverse order.
+ * NULL is not locked */
+#define CMN_SCOPED_LOCK(MUTEX) CMN_SCOPED_LOCK_NAME(MUTEX, __LINE__)
+#define CMN_SCOPED_LOCK_NAME(MUTEX, LINE) CMN_SCOPED_LOCK_DECL(MUTEX, LINE)
+#define CMN_SCOPED_LOCK_DECL(MUTEX, LINE) \
+    pthread_mutex_t *cmn_scoped_lock_ ## LINE __attribute__((cleanup(cmn_UnlockScoped))) = cmn_LockScoped(MUTEX)
+
 
 int cmn_Init();
 int cmn_Release();
@@ -89,6 +113,10 @@ void cmn_DebugReg(const char* msg,uint32_t value);
 void cmn_DebugRegCh(const char* msg,int ch,uint32_t value);
 void cmn_enableDebugReg();
 
+pthread_mutex_t* cmn_LockScoped(pthread_mutex_t *mutex);
+void cmn_UnlockScoped(pthread_mutex_t **mutex);
+void cmn_InitRecursiveLocks(pthread_mutex_t *mutex, size_t count);
+
 int cmn_Map(size_t size, size_t offset, void** mapped);
 int cmn_Unmap(size_t size, void** mapped);
 
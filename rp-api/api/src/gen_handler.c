@@ -13,6 +13,7 @@
 */
 
 #include <float.h>
+#include <string.h>
 #include "math.h"
 #include "common.h"
 #include "generate.h"
@@ -32,7 +33,21 @@
     if (channel >= channels_rp_HPGetFastDACChannelsCount){ \
         fprintf(stderr,"[Error:%s] Channel is larger than allowed\n",X); \
         return RP_NOTS; \
-    }
+    } \
+    CMN_SCOPED_LOCK(genChannelLock(channel));
+
+/* @brief Settings of a channel are changed under its lock, see the locking model in common.h */
+static pthread_mutex_t gen_lock[2];
+static pthread_once_t gen_lock_once = PTHREAD_ONCE_INIT;
+
+static void initLocks(){
+    cmn_InitRecursiveLocks(gen_lock, 2);
+}
+
+static pthread_mutex_t* genChannelLock(rp_channel_t channel){
+    pthread_once(&gen_lock_once, initLocks);
+    return &gen_lock[channel];
+}
 
 float         ch_amplitude[2] = {1 , 1};
 float         ch_offset[2] = {0 , 0};
@@ -62,6 +77,45 @@ rp_gen_gain_t ch_gain[2] = {RP_GAIN_1X,RP_GAIN_1X};
 
 float ch_arbitraryData[2][DAC_BUFFER_SIZE];
 
+/* @brief Changed on every upload of arbitrary data, so the cached buffers of older data are not used */
+static uint32_t ch_arbitraryId[2] = {0 , 0};
+static uint32_t gen_arbitraryCounter = 0;
+
+#define GEN_CACHE_SIZE 8
+
+/* @brief Everything the DAC words of a synthesized buffer depend on.
+ * Parameters not used by the waveform stay zero, so for example the sine is shared by all frequencies. */
+typedef struct {
+    rp_waveform_t        waveform;
+    float                dutyCycle;
+    float                frequency;
+    float                riseTime;
+    float                fallTime;
+    float                sweepStartFreq;
+    float                sweepEndFreq;
+    float                phaseRad;
+    rp_gen_sweep_mode_t  sweepMode;
+    rp_gen_sweep_dir_t   sweepDir;
+    uint32_t             arbitraryId;
+    uint8_t              bits;
+    bool                 is_sign;
+    uint32_t             calib_version;
+} gen_synth_key_t;
+
+/* @brief Synthesized and converted DAC buffer. Switching to a cached waveform is a copy to the DAC memory */
+typedef struct {
+    bool             valid;
+    uint32_t         lastUse;
+    gen_synth_key_t  key;
+    uint32_t         size;
+    int32_t          cnts[DAC_BUFFER_SIZE];
+} gen_synth_entry_t;
+
+static gen_synth_entry_t gen_cache[GEN_CACHE_SIZE];
+static uint32_t gen_cacheUse = 0;
+/* @brief Held from the lookup until the buffer is copied to the DAC memory, as the entry can be replaced after */
+static pthread_mutex_t gen_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int gen_SetDefaultValues() {
 
     uint8_t channels = 0;
@@ -472,6 +526,7 @@ int gen_setArbWaveform(rp_channel_t channel, float *data, uint32_t length) {
     }
 
     ch_arb_size[channel] = length;
+    ch_arbitraryId[channel] = ++gen_arbitraryCounter;
     if(ch_waveform[channel ] == RP_WAVEFORM_ARBITRARY){
       	return synthesize_signal(channel);
     }
@@ -767,10 +822,86 @@ int gen_SynchroniseSM() {
     return generate_ResetSM();
 }
 
+static int buildSynthKey(rp_channel_t channel, gen_synth_key_t *key){
+    memset(key, 0, sizeof(gen_synth_key_t));
+
+    if (rp_HPGetFastDACBits(convertCh(channel), &key->bits) != RP_HP_OK){
+        fprintf(stderr,"[Error:buildSynthKey] Can't get fast DAC bits\n");
+        return RP_NOTS;
+    }
+
+    if (rp_HPGetFastDACIsSigned(channel, &key->is_sign) != RP_HP_OK){
+        fprintf(stderr,"[Error:buildSynthKey] Can't get fast DAC sign value\n");
+        return RP_NOTS;
+    }
+
+    key->waveform = ch_waveform[channel];
+    key->calib_version = rp_GetCalibrationVersion();
+    switch (key->waveform) {
+        case RP_WAVEFORM_SQUARE:
+            key->frequency = ch_frequency[channel];
+            key->riseTime = ch_riseTime[channel];
+            key->fallTime = ch_fallTime[channel];
+            break;
+        case RP_WAVEFORM_PWM:
+            key->dutyCycle = ch_dutyCycle[channel];
+            break;
+        case RP_WAVEFORM_ARBITRARY:
+            key->arbitraryId = ch_arbitraryId[channel];
+            break;
+        case RP_WAVEFORM_SWEEP:
+            key->frequency = ch_frequency[channel];
+            key->sweepStartFreq = ch_sweepStartFrequency[channel];
+            key->sweepEndFreq = ch_sweepEndFrequency[channel];
+            key->phaseRad = ch_phase[channel] / 180.0 *  M_PI;
+            key->sweepMode = ch_sweepMode[channel];
+            key->sweepDir = ch_sweepDir[channel];
+            break;
+        default:
+            break;
+    }
+    return RP_OK;
+}
+
+/* Returns the cached buffer of the key, or the least recently used entry marked invalid */
+static gen_synth_entry_t* findSynthEntry(const gen_synth_key_t *key, bool *found){
+    gen_synth_entry_t *entry = &gen_cache[0];
+    for (int i = 0; i < GEN_CACHE_SIZE; i++){
+        gen_synth_entry_t *e = &gen_cache[i];
+        if (e->valid && memcmp(&e->key, key, sizeof(gen_synth_key_t)) == 0){
+            e->lastUse = ++gen_cacheUse;
+            *found = true;
+            return e;
+        }
+        if (!e->valid || (entry->valid && e->lastUse < entry->lastUse)){
+            entry = e;
+        }
+    }
+    entry->valid = false;
+    *found = false;
+    return entry;
+}
+
 int synthesize_signal(rp_channel_t channel) {
 
     CHECK_CHANNEL("synthesize_signal")
 
+    gen_synth_key_t key;
+    int ret = buildSynthKey(channel, &key);
+    if (ret != RP_OK){
+        return ret;
+    }
+
+    int32_t phase = (ch_phase[channel] * DAC_BUFFER_SIZE / 360.0);
+    if(key.waveform == RP_WAVEFORM_SWEEP) phase = 0;
+
+    CMN_SCOPED_LOCK(&gen_cache_lock);
+    bool found = false;
+    gen_synth_entry_t *entry = findSynthEntry(&key, &found);
+    if (found){
+        return generate_writeCnts(channel, entry->cnts, phase, entry->size);
+    }
+
     float data[DAC_BUFFER_SIZE];
 
     rp_waveform_t waveform = ch_waveform[channel];
@@ -783,11 +914,9 @@ int synthesize_signal(rp_channel_t channel) {
     rp_gen_sweep_mode_t sweep_mode = ch_sweepMode[channel];
     rp_gen_sweep_dir_t sweep_dir = ch_sweepDir[channel];
     uint32_t size = ch_size[channel];
-    int32_t phase = (ch_phase[channel] * DAC_BUFFER_SIZE / 360.0);
     float phaseRad = ch_phase[channel] / 180.0 *  M_PI;
 
     uint16_t buf_size = DAC_BUFFER_SIZE;
-    if(waveform == RP_WAVEFORM_SWEEP) phase = 0;
 
     switch (waveform) {
         case RP_WAVEFORM_SINE     : synthesis_sin      (data,buf_size);                 break;
@@ -803,7 +932,16 @@ int synthesize_signal(rp_channel_t channel) {
         default:                    return RP_EIPV;
     }
     if (waveform != RP_WAVEFORM_ARBITRARY) size = buf_size;
-    return generate_writeData(channel, data, phase, size);
+
+    ret = generate_convertData(channel, data, DAC_BUFFER_SIZE, entry->cnts);
+    if (ret != RP_OK){
+        return ret;
+    }
+    entry->key = key;
+    entry->size = size;
+    entry->lastUse = ++gen_cacheUse;
+    entry->valid = true;
+    return generate_writeCnts(channel, entry->cnts, phase, size);
 }
 
 int synthesis_sin(float *data_out,uint16_t buffSize) {
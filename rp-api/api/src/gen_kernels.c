@@ -0,0 +1,78 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library DAC buffer conversion kernels implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include "gen_kernels.h"
+#include "common.h"
+#include "neon_asm.h"
+
+#ifdef ARCH_ARM
+#include <arm_neon.h>
+#endif
+
+#ifdef ARCH_ARM
+static bool isPowerOf2(double value){
+    int exp = 0;
+    return value > 0 && frexp(value, &exp) == 0.5;
+}
+#endif
+
+void gen_ConvertToCnts(const float *in, uint32_t size, const gen_cnt_param_t *param, int32_t *out){
+    uint32_t i = 0;
+#ifdef ARCH_ARM
+    /* Scaling by a power of 2 is exact, so the product gives the same float as the division */
+    if (isPowerOf2(param->gain) && isPowerOf2(param->fullScale)){
+        int32_t shift = param->bits - (param->is_signed ? 1 : 0);
+        int32_t limit = 1 << shift;
+        uint32_t mask = ((uint64_t)1 << param->bits) - 1;
+        float32x4_t vgain = vdupq_n_f32((float)(1.0 / param->gain));
+        float32x4_t vmaxv = vdupq_n_f32(param->fullScale);
+        float32x4_t vminv = vdupq_n_f32(param->is_signed ? -param->fullScale : 0);
+        float32x4_t vscale = vdupq_n_f32((float)limit / param->fullScale);
+        float32x4_t vhalf = vdupq_n_f32(0.5f);
+        float32x4_t vnhalf = vdupq_n_f32(-0.5f);
+        int32x4_t voffset = vdupq_n_s32(param->offset);
+        int32x4_t vmax = vdupq_n_s32(limit - 1);
+        int32x4_t vmin = vdupq_n_s32(-limit);
+        uint32x4_t vmask = vdupq_n_u32(mask);
+        for (; i + 4 <= size; i += 4){
+            float32x4_t v = vmulq_f32(vld1q_f32(in + i), vgain);
+            v = vminq_f32(vmaxq_f32(v, vminv), vmaxv);
+            v = vmulq_f32(v, vscale);
+            /* Round half away from zero like round(): truncate, then correct by the exact remainder */
+            int32x4_t c = vcvtq_s32_f32(v);
+            float32x4_t r = vsubq_f32(v, vcvtq_f32_s32(c));
+            c = vsubq_s32(c, vreinterpretq_s32_u32(vcgeq_f32(r, vhalf)));
+            c = vaddq_s32(c, vreinterpretq_s32_u32(vcleq_f32(r, vnhalf)));
+            c = vminq_s32(vmaxq_s32(vaddq_s32(c, voffset), vmin), vmax);
+            vst1q_s32(out + i, vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_s32(c), vmask)));
+        }
+    }
+#endif
+    for (; i < size; i++){
+        out[i] = (int32_t)cmn_convertToCnt(in[i], param->bits, param->fullScale, param->is_signed, param->gain, param->offset);
+    }
+}
+
+void gen_WriteCnts(volatile int32_t *ring, uint32_t ring_size, uint32_t pos, const int32_t *in, uint32_t size){
+    uint32_t done = 0;
+    pos %= ring_size;
+    while (done < size){
+        uint32_t start = (pos + done) % ring_size;
+        uint32_t len = size - done;
+        if (len > ring_size - start) len = ring_size - start;
+        memcpy_neon(ring + start, in + done, len * sizeof(int32_t));
+        done += len;
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library DAC buffer conversion kernels
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef GEN_KERNELS_H_
+#define GEN_KERNELS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Converts waveform samples to DAC words. The scalar path gives the same results as
+ * cmn_convertToCnt. With NEON the samples are converted four at once when gain and
+ * fullScale are powers of 2, as for the normalized waveforms of the generator.
+ */
+
+/* Conversion of one sample: round(value / gain / fullScale * 2^bits) + offset, limited and masked */
+typedef struct {
+    uint8_t bits;
+    bool    is_signed;
+    float   fullScale;
+    double  gain;
+    int32_t offset;
+} gen_cnt_param_t;
+
+void gen_ConvertToCnts(const float *in, uint32_t size, const gen_cnt_param_t *param, int32_t *out);
+
+/* Writes size words to the circular DAC buffer starting at pos, in at most two bursts */
+void gen_WriteCnts(volatile int32_t *ring, uint32_t ring_size, uint32_t pos, const int32_t *in, uint32_t size);
+
+#endif /* GEN_KERNELS_H_ */
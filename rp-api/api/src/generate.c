@@ -18,6 +18,7 @@
 #include <math.h>
 #include "common.h"
 #include "generate.h"
+#include "gen_kernels.h"
 
 static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_ch[2] = {NULL,NULL};
@@ -235,39 +236,41 @@ int generate_ResetChannelSM(rp_channel_t channel){
 }
 
 
-int generate_writeData(rp_channel_t channel, float *data, int32_t start, uint32_t length) {
-
-    float fs = 0;
-    if (rp_HPGetFastDACFullScale(convertCh(channel), &fs) != RP_HP_OK){
-        fprintf(stderr,"[Error:generate_writeData] Can't get fast DAC full scale\n");
-        return RP_NOTS;
-    }
+int generate_convertData(rp_channel_t channel, const float *data, uint32_t size, int32_t *cnts) {
 
     uint8_t bits = 0;
     if (rp_HPGetFastDACBits(convertCh(channel), &bits) != RP_HP_OK){
-        fprintf(stderr,"[Error:generate_writeData] Can't get fast DAC bits\n");
+        fprintf(stderr,"[Error:generate_convertData] Can't get fast DAC bits\n");
         return RP_NOTS;
     }
 
     bool is_sign = false;
     if (rp_HPGetFastDACIsSigned(channel,&is_sign) != RP_HP_OK){
-        fprintf(stderr,"[Error:generate_writeData] Can't get fast DAC sign value\n");
+        fprintf(stderr,"[Error:generate_convertData] Can't get fast DAC sign value\n");
         return RP_NOTS;
     }
 
-    volatile int32_t *dataOut = data_ch[channel];
+    gen_cnt_param_t param = { bits, is_sign, 1, 1, 0 };
+    gen_ConvertToCnts(data, size, &param, cnts);
+    return RP_OK;
+}
 
-    volatile ch_properties_t *properties;
-    getChannelPropertiesAddress(&properties, channel);
+int generate_writeCnts(rp_channel_t channel, const int32_t *cnts, int32_t start, uint32_t length) {
     generate_setWrapCounter(channel, length);
-
     if (start < 0) start += DAC_BUFFER_SIZE;
-    for(int i = start; i < start + DAC_BUFFER_SIZE; i++) {
-        dataOut[i % DAC_BUFFER_SIZE] =  cmn_convertToCnt(data[i-start],bits,1,is_sign,1,0);
-    }
+    gen_WriteCnts(data_ch[channel], DAC_BUFFER_SIZE, start, cnts, DAC_BUFFER_SIZE);
     return RP_OK;
 }
 
+int generate_writeData(rp_channel_t channel, float *data, int32_t start, uint32_t length) {
+    int32_t cnts[DAC_BUFFER_SIZE];
+    int ret = generate_convertData(channel, data, DAC_BUFFER_SIZE, cnts);
+    if (ret != RP_OK){
+        return ret;
+    }
+    return generate_writeCnts(channel, cnts, start, length);
+}
+
 int generate_setAmplitude(rp_channel_t channel,rp_gen_gain_t gain, float amplitude) {
 
     float fs = 0;
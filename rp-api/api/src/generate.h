@@ -129,6 +129,8 @@ int generate_ResetSM();
 int generate_ResetChannelSM(rp_channel_t channel);
 
 int generate_writeData(rp_channel_t channel, float *data, int32_t start, uint32_t length);
+int generate_convertData(rp_channel_t channel, const float *data, uint32_t size, int32_t *cnts);
+int generate_writeCnts(rp_channel_t channel, const int32_t *cnts, int32_t start, uint32_t length);
 
 int generate_setAmplitude(rp_channel_t channel, rp_gen_gain_t gain,  float amplitude);
 int generate_getAmplitude(rp_channel_t channel, rp_gen_gain_t gain, float *amplitude);
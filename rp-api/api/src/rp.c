@@ -65,6 +65,8 @@ int rp_IsApiInit(){
 
 int rp_Release()
 {
+    acq_StreamStop();
+    acq_SegmentedRelease();
     osc_Release();
     generate_Release();
     ams_Release();
@@ -1032,6 +1034,58 @@ int rp_AcqGetDataV2D(uint32_t pos, buffers_t *out){
     return acq_GetDataV2D(pos, out);
 }
 
+int rp_AcqStreamStart(){
+    return acq_StreamStart();
+}
+
+int rp_AcqStreamStop(){
+    return acq_StreamStop();
+}
+
+int rp_AcqStreamGetSpan(uint32_t min_samples, uint32_t timeout_ms, rp_acq_stream_span_t *span){
+    return acq_StreamGetSpan(min_samples, timeout_ms, span);
+}
+
+int rp_AcqStreamGetView(rp_channel_t channel, const rp_acq_stream_span_t *span, const volatile uint32_t **first, uint32_t *first_size, const volatile uint32_t **second, uint32_t *second_size){
+    return acq_StreamGetView(channel, span, first, first_size, second, second_size);
+}
+
+int rp_AcqStreamRelease(uint32_t count, bool *overwritten){
+    return acq_StreamRelease(count, overwritten);
+}
+
+int rp_AcqStreamRead(uint32_t min_samples, uint32_t timeout_ms, buffers_t *out, rp_acq_stream_span_t *span){
+    return acq_StreamRead(min_samples, timeout_ms, out, span);
+}
+
+int rp_AcqSegmentedInit(uint32_t segments, uint32_t pre_samples, uint32_t post_samples){
+    return acq_SegmentedInit(segments, pre_samples, post_samples);
+}
+
+int rp_AcqSegmentedRelease(){
+    return acq_SegmentedRelease();
+}
+
+int rp_AcqSegmentedCapture(uint32_t count, uint32_t timeout_ms, uint32_t *captured){
+    return acq_SegmentedCapture(count, timeout_ms, captured);
+}
+
+int rp_AcqSegmentedGetInfo(uint32_t first, uint32_t count, rp_acq_segment_info_t *info){
+    return acq_SegmentedGetInfo(first, count, info);
+}
+
+int rp_AcqSegmentedGetDataRaw(rp_channel_t channel, uint32_t first, uint32_t count, int16_t* buffer){
+    return acq_SegmentedGetDataRaw(channel, first, count, buffer);
+}
+
+int rp_AcqSegmentedGetDataV(rp_channel_t channel, uint32_t first, uint32_t count, float* buffer){
+    return acq_SegmentedGetDataV(channel, first, count, buffer);
+}
+
+int rp_AcqGetMeasurements(rp_channel_t channel, uint32_t pos, uint32_t size, float level, float hyst, rp_acq_signal_meas_t *meas){
+    return acq_GetMeasurements(channel, pos, size, level, hyst, meas);
+}
+
 int rp_AcqGetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
     return acq_GetOldestDataRaw(channel, size, buffer);
@@ -0,0 +1,500 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA backend implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "common.h"
+#include "oscilloscope.h"
+#include "generate.h"
+#include "sim_backend.h"
+#include "rp-i2c-mcp47x6-c.h"
+#include "rp-i2c-max7311-c.h"
+
+#define SIM_REGIONS         8
+#define SIM_CHANNELS        4
+#define SIM_THREAD_SLEEP    100     // us
+#define SIM_MAX_STEP        0.01    // Longest simulated time per thread iteration, s
+#define SIM_MAX_RING_STEP   (ADC_BUFFER_SIZE / 8)   // Most samples written per thread iteration
+
+typedef struct {
+    size_t offset;
+    size_t size;
+    void  *mem;
+} sim_region_t;
+
+typedef struct {
+    bool     armed;
+    bool     triggered;
+    bool     ext_pending;
+    bool     primed[SIM_CHANNELS];  // Level passed the hysteresis band, the next crossing triggers
+    uint32_t delay_left;
+    uint32_t dec_phase;
+    uint32_t wp;
+    uint32_t pre_count;
+} sim_osc_t;
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t       sim_thread;
+static bool            sim_thread_run = false;
+static bool            sim_init = false;
+static double          sim_time_scale = 1.0;
+static uint64_t        sim_cycles = 0;
+static atomic_uint_least64_t sim_cycles_pub;    // sim_cycles after the last step, read without the lock
+static uint32_t        sim_noise_state = 1;
+
+static sim_region_t    sim_regions[SIM_REGIONS];
+static sim_source_t    sim_sources[SIM_CHANNELS];
+static sim_osc_t       sim_osc;
+static uint64_t        sim_gen_phase[2];
+
+static uint8_t         sim_channels = 2;
+static uint8_t         sim_bits[SIM_CHANNELS];
+static bool            sim_is_sign[SIM_CHANNELS];
+static float           sim_fullScale[SIM_CHANNELS];
+static double          sim_rate = 125e6;
+static bool            sim_dac = true;
+static uint8_t         sim_dac_bits = 14;
+static float           sim_dac_fullScale = 1;
+
+static void* getRegion(size_t offset, size_t size){
+    for (int i = 0; i < SIM_REGIONS; i++){
+        if (sim_regions[i].mem && sim_regions[i].offset == offset){
+            return sim_regions[i].size >= size ? sim_regions[i].mem : NULL;
+        }
+    }
+    for (int i = 0; i < SIM_REGIONS; i++){
+        if (!sim_regions[i].mem){
+            sim_regions[i].mem = calloc(1, size);
+            sim_regions[i].offset = offset;
+            sim_regions[i].size = size;
+            return sim_regions[i].mem;
+        }
+    }
+    return NULL;
+}
+
+static float noise(){
+    sim_noise_state = sim_noise_state * 1664525u + 1013904223u;
+    return (float)(sim_noise_state >> 8) / (float)(1 << 23) - 1.f;
+}
+
+/* Output of the generator in volts. Bursts and external triggers are not modelled,
+ * a started channel plays its buffer continuously at the ADC clock */
+static float genOutput(int channel, uint32_t cycles){
+    volatile generate_control_t *gen = (volatile generate_control_t *)getRegion(GENERATE_BASE_ADDR, GENERATE_BASE_SIZE);
+    if (!gen || !sim_dac || channel > 1)
+        return 0;
+
+    volatile ch_properties_t *prop = channel == 0 ? &gen->properties_chA : &gen->properties_chB;
+    bool run = channel == 0 ? gen->AtriggerSelector && !gen->ASM_reset && !gen->AsetOutputTo0
+                            : gen->BtriggerSelector && !gen->BSM_reset && !gen->BsetOutputTo0;
+    if (!run)
+        return 0;
+
+    uint64_t wrap = (uint64_t)prop->counterWrap + 1;
+    sim_gen_phase[channel] = (sim_gen_phase[channel] + (uint64_t)prop->counterStep * cycles) % wrap;
+    const volatile int32_t *data = (const volatile int32_t *)((char*)gen + (channel == 0 ? CHA_DATA_OFFSET : CHB_DATA_OFFSET));
+    uint32_t index = (sim_gen_phase[channel] >> 16) % DAC_BUFFER_SIZE;
+
+    float value = cmn_convertToVoltSigned(data[index], sim_dac_bits, 1, 1, 1, 0);
+    float amplitude = cmn_convertToVoltSigned(prop->amplitudeScale, sim_dac_bits, sim_dac_fullScale, 1, 1, 0);
+    float offset = cmn_convertToVoltSigned(prop->amplitudeOffset, sim_dac_bits, sim_dac_fullScale, 1, 1, 0);
+    return value * amplitude + offset;
+}
+
+static float sourceOutput(int channel, double t, uint32_t cycles){
+    const sim_source_t *s = &sim_sources[channel];
+    double x = fmod(t * s->frequency, 1.0);
+    float v = s->offset;
+    switch (s->type)
+    {
+        case RP_SIM_SRC_ZERO:
+            v = 0;
+            break;
+        case RP_SIM_SRC_DC:
+            break;
+        case RP_SIM_SRC_SINE:
+            v += s->amplitude * sinf(2 * M_PI * x);
+            break;
+        case RP_SIM_SRC_SQUARE:
+            v += x < 0.5 ? s->amplitude : -s->amplitude;
+            break;
+        case RP_SIM_SRC_RAMP:
+            v += s->amplitude * (2 * x - 1);
+            break;
+        case RP_SIM_SRC_NOISE:
+            v += s->amplitude * noise();
+            break;
+        case RP_SIM_SRC_GEN:
+            v = genOutput(channel, cycles);
+            break;
+    }
+    if (s->noise != 0){
+        v += s->noise * noise();
+    }
+    return v;
+}
+
+static int32_t signedCnts(uint32_t cnts, int channel){
+    uint8_t bits = sim_bits[channel];
+    cnts &= ((uint32_t)1 << bits) - 1;
+    if (sim_is_sign[channel] && (cnts & (1 << (bits - 1)))){
+        return (int32_t)cnts - (1 << bits);
+    }
+    return cnts;
+}
+
+static bool levelTrigger(volatile osc_control_t *regs, volatile osc_control_t *regs_4ch, uint32_t source, const int32_t *cnts){
+    int channel;
+    bool positive;
+    switch (source)
+    {
+        case RP_TRIG_SRC_CHA_PE: channel = 0; positive = true;  break;
+        case RP_TRIG_SRC_CHA_NE: channel = 0; positive = false; break;
+        case RP_TRIG_SRC_CHB_PE: channel = 1; positive = true;  break;
+        case RP_TRIG_SRC_CHB_NE: channel = 1; positive = false; break;
+        case RP_TRIG_SRC_CHC_PE: channel = 2; positive = true;  break;
+        case RP_TRIG_SRC_CHC_NE: channel = 2; positive = false; break;
+        case RP_TRIG_SRC_CHD_PE: channel = 3; positive = true;  break;
+        case RP_TRIG_SRC_CHD_NE: channel = 3; positive = false; break;
+        default:
+            return false;
+    }
+    if (channel >= sim_channels)
+        return false;
+
+    volatile osc_control_t *r = channel < 2 ? regs : regs_4ch;
+    int32_t thr = signedCnts(channel % 2 ? r->chb_thr : r->cha_thr, channel);
+    int32_t hyst = (channel % 2 ? r->chb_hystersis : r->cha_hystersis) & HYSTERESIS_MASK;
+    int32_t v = cnts[channel];
+
+    /* The comparator is primed once the signal leaves the hysteresis band on the far side of the level */
+    if (positive){
+        if (v < thr - hyst) sim_osc.primed[channel] = true;
+        if (sim_osc.primed[channel] && v >= thr){
+            sim_osc.primed[channel] = false;
+            return true;
+        }
+    }else{
+        if (v > thr + hyst) sim_osc.primed[channel] = true;
+        if (sim_osc.primed[channel] && v <= thr){
+            sim_osc.primed[channel] = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void stepLocked(uint64_t cycles){
+    volatile osc_control_t *regs = (volatile osc_control_t *)getRegion(OSC_BASE_ADDR, OSC_BASE_SIZE);
+    volatile osc_control_t *regs_4ch = sim_channels == 4 ? (volatile osc_control_t *)getRegion(OSC_BASE_ADDR_4CH, OSC_BASE_SIZE) : NULL;
+    if (!regs || (sim_channels == 4 && !regs_4ch))
+        return;
+
+    volatile uint32_t *data[SIM_CHANNELS] = {
+        (volatile uint32_t *)((char*)regs + OSC_CHA_OFFSET),
+        (volatile uint32_t *)((char*)regs + OSC_CHB_OFFSET),
+        regs_4ch ? (volatile uint32_t *)((char*)regs_4ch + OSC_CHA_OFFSET) : NULL,
+        regs_4ch ? (volatile uint32_t *)((char*)regs_4ch + OSC_CHB_OFFSET) : NULL
+    };
+
+    sim_osc_t *o = &sim_osc;
+    uint32_t conf = regs->conf;
+
+    /* The reset bit reads back as 0 on the board. Here it stays set until the next step,
+     * so an arm written after the reset is applied after it */
+    if (conf & RST_WR_ST_MCH_MASK){
+        memset(o, 0, sizeof(sim_osc_t));
+        conf &= ~(RST_WR_ST_MCH_MASK | TRIG_ST_MCH_MASK | FILL_STATE_MASK);
+        regs->wr_ptr_cur = 0;
+        regs->wr_ptr_trigger = 0;
+        regs->pre_trigger_counter = 0;
+    }
+
+    if ((conf & START_DATA_WRITE_MASK) && !o->armed){
+        o->armed = true;
+        o->triggered = false;
+        o->ext_pending = false;
+        o->pre_count = 0;
+        memset(o->primed, 0, sizeof(o->primed));
+        conf &= ~(TRIG_ST_MCH_MASK | FILL_STATE_MASK);
+    }else if (!(conf & START_DATA_WRITE_MASK) && o->armed){
+        o->armed = false;
+    }
+
+    /* With arm keep a new trigger source re-arms the trigger while writing continues */
+    if (o->armed && o->triggered && o->delay_left == 0 && (regs->trig_source & TRIG_SRC_MASK)){
+        o->triggered = false;
+        o->pre_count = 0;
+        memset(o->primed, 0, sizeof(o->primed));
+        conf &= ~TRIG_ST_MCH_MASK;
+    }
+    regs->conf = conf;
+
+    uint32_t dec = regs->data_dec & DATA_DEC_MASK;
+    if (dec == 0) dec = 1;
+
+    while (cycles){
+        uint32_t to_sample = dec - o->dec_phase;
+        if (to_sample > cycles){
+            o->dec_phase += cycles;
+            sim_cycles += cycles;
+            break;
+        }
+        cycles -= to_sample;
+        sim_cycles += to_sample;
+        o->dec_phase = 0;
+
+        double t = (double)sim_cycles / sim_rate;
+        int32_t cnts[SIM_CHANNELS] = {0};
+        for (int ch = 0; ch < sim_channels; ch++){
+            float v = sourceOutput(ch, t, dec);
+            uint32_t word = cmn_convertToCnt(v, sim_bits[ch], sim_fullScale[ch], sim_is_sign[ch], 1, 0);
+            cnts[ch] = signedCnts(word, ch);
+            if (o->armed){
+                data[ch][o->wp] = word;
+            }
+        }
+
+        if (!o->armed)
+            continue;
+
+        uint32_t pos = o->wp;
+        o->wp = (o->wp + 1) % ADC_BUFFER_SIZE;
+
+        if (!o->triggered){
+            o->pre_count++;
+            uint32_t source = regs->trig_source & TRIG_SRC_MASK;
+            bool fire = false;
+            if (source == RP_TRIG_SRC_NOW){
+                fire = true;
+            }else if (source >= RP_TRIG_SRC_EXT_PE && source <= RP_TRIG_SRC_AWG_NE){
+                fire = o->ext_pending;
+            }else if (source != RP_TRIG_SRC_DISABLED){
+                fire = levelTrigger(regs, regs_4ch, source, cnts);
+            }
+            o->ext_pending = false;
+            if (fire){
+                o->triggered = true;
+                o->delay_left = regs->trigger_delay;
+                regs->wr_ptr_trigger = pos;
+                regs->pre_trigger_counter = o->pre_count;
+                regs->trig_source = 0;
+                regs->conf |= TRIG_ST_MCH_MASK;
+            }
+        }else if (o->delay_left){
+            o->delay_left--;
+        }
+
+        /* All data written: the samples after the trigger are in the buffer */
+        if (o->triggered && o->delay_left == 0){
+            regs->conf |= FILL_STATE_MASK;
+            if (!(regs->conf & ARM_KEEP_MASK)){
+                o->armed = false;
+                regs->conf &= ~START_DATA_WRITE_MASK;
+            }
+        }
+    }
+
+    /* Like the FPGA the register holds the last written sample, o->wp is the next one */
+    regs->wr_ptr_cur = (o->wp + ADC_BUFFER_SIZE - 1) % ADC_BUFFER_SIZE;
+    if (!o->triggered){
+        regs->pre_trigger_counter = o->pre_count;
+    }
+    atomic_store(&sim_cycles_pub, sim_cycles);
+}
+
+static double wallTime(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Cycles of SIM_MAX_RING_STEP of the ADC ring at the current decimation */
+static uint64_t simMaxStepCycles(){
+    volatile osc_control_t *regs = (volatile osc_control_t *)getRegion(OSC_BASE_ADDR, OSC_BASE_SIZE);
+    uint32_t dec = regs ? regs->data_dec & DATA_DEC_MASK : 1;
+    if (dec == 0) dec = 1;
+    return (uint64_t)SIM_MAX_RING_STEP * dec;
+}
+
+/* Follows the scaled wall clock. When the model is slower than that, the simulated time falls behind */
+static void* simThread(void *arg){
+    double last = wallTime();
+    while (sim_thread_run){
+        usleep(SIM_THREAD_SLEEP);
+        double now = wallTime();
+        double dt = (now - last) * sim_time_scale;
+        last = now;
+        if (dt <= 0)
+            continue;
+        if (dt > SIM_MAX_STEP)
+            dt = SIM_MAX_STEP;
+        pthread_mutex_lock(&sim_lock);
+        uint64_t cycles = (uint64_t)(dt * sim_rate);
+        uint64_t max_cycles = simMaxStepCycles();
+        stepLocked(cycles < max_cycles ? cycles : max_cycles);
+        pthread_mutex_unlock(&sim_lock);
+    }
+    return NULL;
+}
+
+int sim_Init(){
+    if (sim_init)
+        return RP_OK;
+
+    sim_channels = rp_HPGetFastADCChannelsCountOrDefault();
+    if (sim_channels > SIM_CHANNELS) sim_channels = SIM_CHANNELS;
+    for (int ch = 0; ch < sim_channels; ch++){
+        sim_bits[ch] = rp_HPGetFastADCBitsOrDefault(ch);
+        sim_is_sign[ch] = rp_HPGetFastADCIsSignedOrDefault(ch);
+        sim_fullScale[ch] = rp_HPGetFastADCFullScaleOrDefault(ch);
+    }
+    sim_rate = rp_HPGetBaseFastADCSpeedHzOrDefault();
+    sim_dac = rp_HPIsFastDAC_PresentOrDefault();
+    if (sim_dac){
+        sim_dac_bits = rp_HPGetFastDACBitsOrDefault(0);
+        sim_dac_fullScale = rp_HPGetFastDACFullScaleOrDefault(0);
+    }
+
+    memset(&sim_osc, 0, sizeof(sim_osc));
+    memset(sim_gen_phase, 0, sizeof(sim_gen_phase));
+    sim_cycles = 0;
+    atomic_store(&sim_cycles_pub, 0);
+    sim_init = true;
+
+    if (sim_time_scale > 0){
+        sim_thread_run = true;
+        if (pthread_create(&sim_thread, NULL, simThread, NULL) != 0){
+            fprintf(stderr,"[Error:sim_Init] Can't start the simulation thread\n");
+            sim_thread_run = false;
+        }
+    }
+    return RP_OK;
+}
+
+int sim_Release(){
+    if (!sim_init)
+        return RP_OK;
+    if (sim_thread_run){
+        sim_thread_run = false;
+        pthread_join(sim_thread, NULL);
+    }
+    for (int i = 0; i < SIM_REGIONS; i++){
+        free(sim_regions[i].mem);
+        sim_regions[i].mem = NULL;
+    }
+    sim_init = false;
+    return RP_OK;
+}
+
+int sim_Map(size_t size, size_t offset, void** mapped){
+    if (!sim_init)
+        return RP_EMMD;
+    pthread_mutex_lock(&sim_lock);
+    *mapped = getRegion(offset, size);
+    pthread_mutex_unlock(&sim_lock);
+    return *mapped ? RP_OK : RP_EMMD;
+}
+
+/* The memory stays with the model until sim_Release */
+int sim_Unmap(size_t size, void** mapped){
+    if (!mapped || !*mapped)
+        return RP_EUMD;
+    *mapped = NULL;
+    return RP_OK;
+}
+
+void sim_SetSource(int channel, const sim_source_t *source){
+    if (channel < 0 || channel >= SIM_CHANNELS || !source)
+        return;
+    pthread_mutex_lock(&sim_lock);
+    sim_sources[channel] = *source;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void sim_SetTimeScale(double scale){
+    if (scale < 0) scale = 0;
+    sim_time_scale = scale;
+    if (!sim_init)
+        return;
+    if (scale == 0 && sim_thread_run){
+        sim_thread_run = false;
+        pthread_join(sim_thread, NULL);
+    }else if (scale > 0 && !sim_thread_run){
+        sim_thread_run = true;
+        if (pthread_create(&sim_thread, NULL, simThread, NULL) != 0){
+            fprintf(stderr,"[Error:sim_SetTimeScale] Can't start the simulation thread\n");
+            sim_thread_run = false;
+        }
+    }
+}
+
+void sim_Step(uint64_t cycles){
+    pthread_mutex_lock(&sim_lock);
+    if (sim_init){
+        stepLocked(cycles);
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void sim_ExtTrigger(){
+    pthread_mutex_lock(&sim_lock);
+    sim_osc.ext_pending = true;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+uint64_t sim_GetCycles(){
+    pthread_mutex_lock(&sim_lock);
+    uint64_t cycles = sim_cycles;
+    pthread_mutex_unlock(&sim_lock);
+    return cycles;
+}
+
+double sim_GetTime(){
+    return atomic_load(&sim_cycles_pub) / sim_rate;
+}
+
+/*
+ * The 250-12 relays and the external trigger DAC sit on I2C, which the simulator does not have.
+ * These replace the rp-i2c calls of librp, so the host build does not need rp-i2c and libi2c.
+ */
+
+int rp_setAC_DC_C(char port, char mode){
+    (void)port;
+    (void)mode;
+    return RP_I2C_OK;
+}
+
+int rp_setAttenuator_C(char port, char mode){
+    (void)port;
+    (void)mode;
+    return RP_I2C_OK;
+}
+
+int rp_setGainOut_C(char port, char mode){
+    (void)port;
+    (void)mode;
+    return RP_I2C_OK;
+}
+
+int rp_setExtTriggerLevel(float voltage){
+    (void)voltage;
+    return RP_I2C_OK;
+}
@@ -0,0 +1,76 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA backend
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SIM_BACKEND_H_
+#define SIM_BACKEND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * In-memory replacement of the FPGA register maps, used when the library is built with RP_SIM.
+ * cmn_Map returns plain memory instead of the UIO mapping and a model updates it like the FPGA does:
+ *  - ADC rings of all channels with the write pointer, decimation and the pre trigger counter
+ *  - arm, arm keep, trigger sources NOW / channel level with hysteresis / external, trigger delay,
+ *    trigger write pointer, trigger and fill state bits
+ *  - generator buffers, which can be looped back to the ADC inputs
+ * The model runs on its own thread and follows the time scaled wall clock, or it is stepped
+ * by hand with sim_Step for deterministic tests. The thread writes at most 1/8 of the ADC ring
+ * per step, so a reader polling the write pointer sees every lap. On a slow host the simulated
+ * time falls behind the wall clock then.
+ * The board model is selected with the RP_HW_PROFILE_MODEL environment variable (see api-hw-profiles).
+ */
+
+typedef enum {
+    RP_SIM_SRC_ZERO,
+    RP_SIM_SRC_DC,
+    RP_SIM_SRC_SINE,
+    RP_SIM_SRC_SQUARE,
+    RP_SIM_SRC_RAMP,
+    RP_SIM_SRC_NOISE,
+    RP_SIM_SRC_GEN          // Output of the generator channel with the same index
+} sim_source_type_t;
+
+typedef struct {
+    sim_source_type_t type;
+    float amplitude;        // Volts
+    float offset;           // Volts
+    float frequency;        // Hz
+    float noise;            // Volts, uniform noise added to the signal
+} sim_source_t;
+
+int sim_Init();
+int sim_Release();
+int sim_Map(size_t size, size_t offset, void** mapped);
+int sim_Unmap(size_t size, void** mapped);
+
+void sim_SetSource(int channel, const sim_source_t *source);
+
+/* Speed of the simulated clock relative to the wall clock. 0 stops the thread, then only sim_Step advances the model */
+void sim_SetTimeScale(double scale);
+
+/* Advances the model by ADC clock cycles */
+void sim_Step(uint64_t cycles);
+
+/* Fires the external trigger */
+void sim_ExtTrigger();
+
+/* ADC clock cycles simulated since sim_Init */
+uint64_t sim_GetCycles();
+
+/* Simulated time since sim_Init in seconds */
+double sim_GetTime();
+
+#endif /* SIM_BACKEND_H_ */
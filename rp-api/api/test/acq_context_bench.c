@@ -0,0 +1,63 @@
+/**
+ * @brief Benchmark of the per-call overhead of short ADC reads
+ *
+ * Runs on the board, builds with -DBUILD_TEST=ON.
+ * Each read is done once with the cached channel context and once with the
+ * calibration set again before the read, which forces the context to be rebuilt
+ * the same way every read did before the cache.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "redpitaya/rp.h"
+#include "rp_hw-calib.h"
+
+#define LOOPS 100000
+
+static double nowUs(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double bench(uint32_t size, bool is_volt, bool rebuild){
+    int16_t raw[ADC_BUFFER_SIZE];
+    float volt[ADC_BUFFER_SIZE];
+    rp_calib_params_t calib = rp_GetCalibrationSettings();
+    double total = 0;
+    for (int i = 0; i < LOOPS; i++){
+        if (rebuild){
+            rp_CalibrationSetParams(calib);
+        }
+        uint32_t s = size;
+        double start = nowUs();
+        if (is_volt){
+            rp_AcqGetDataV(RP_CH_1, i, &s, volt);
+        }else{
+            rp_AcqGetDataRaw(RP_CH_1, i, &s, raw);
+        }
+        total += nowUs() - start;
+    }
+    return total / LOOPS;
+}
+
+int main(int argc, char **argv){
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+
+    uint32_t sizes[] = { 1, 16, 256, 1024 };
+    printf("%8s %16s %16s %16s %16s\n", "size", "raw cached us", "raw rebuild us", "volt cached us", "volt rebuild us");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+        printf("%8u %16.3f %16.3f %16.3f %16.3f\n", sizes[i],
+               bench(sizes[i], false, false), bench(sizes[i], false, true),
+               bench(sizes[i], true, false), bench(sizes[i], true, true));
+    }
+
+    rp_Release();
+    return 0;
+}
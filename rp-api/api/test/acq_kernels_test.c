@@ -0,0 +1,129 @@
+/**
+ * @brief Test of the ADC readout kernels against the per sample conversion
+ *
+ * Built with -DBUILD_TEST=ON and run by ctest. On the board (ARCH_ARM) it checks the
+ * NEON path, on x86 the scalar path:
+ *   gcc -O2 -std=gnu11 -Isrc test/acq_kernels_test.c src/acq_kernels.c -o acq_kernels_test
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "acq_kernels.h"
+
+#define RING_SIZE (16 * 1024)
+
+/* Reference: per sample path of acq_GetDataRaw and acq_GetDataVEx (cmn_* from common.c) */
+static int32_t refCalibCntsSigned(uint32_t cnts, uint8_t bits, uint32_t gain, uint32_t base, int32_t offset){
+    int32_t m;
+    if(cnts & (1 << (bits - 1))) {
+        m = -1 *((cnts ^ ((1 << bits) - 1)) + 1);
+    } else {
+        m = cnts;
+    }
+    m -= offset;
+    m = ((int32_t)gain * m) / (int32_t)base;
+    if(m < -(1 << (bits - 1)))
+        m = -(1 << (bits - 1));
+    else if(m > (1 << (bits - 1)))
+        m = (1 << (bits - 1));
+    return m;
+}
+
+static void refRaw(const uint32_t *ring, uint32_t pos, uint32_t size, uint8_t bits, bool is_sign, int16_t *out){
+    uint32_t mask = ((uint64_t)1 << bits) - 1;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t cnts = ring[(pos + i) % RING_SIZE] & mask;
+        out[i] = is_sign ? refCalibCntsSigned(cnts, bits, 1, 1, 0) : (int16_t)cnts;
+    }
+}
+
+static void refVolts(const uint32_t *ring, uint32_t pos, uint32_t size, const acq_volt_param_t *p, float *out){
+    uint32_t mask = ((uint64_t)1 << p->bits) - 1;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t cnts = ring[(pos + i) % RING_SIZE] & mask;
+        int32_t calib_cnts = refCalibCntsSigned(cnts, p->bits, p->gain, p->base, p->offset);
+        out[i] = (float)calib_cnts * p->fullScale / (float)(1 << (p->bits - 1));
+    }
+}
+
+static double nowUs(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(){
+    static uint32_t ring[RING_SIZE];
+    static int16_t raw[RING_SIZE], raw_ref[RING_SIZE];
+    static float volts[RING_SIZE], volts_ref[RING_SIZE];
+    static double volts_d[RING_SIZE];
+    int failed = 0;
+
+#ifdef ARCH_ARM
+    printf("Checking the NEON path\n");
+#else
+    printf("Checking the scalar path\n");
+#endif
+
+    srand(1);
+    for (int i = 0; i < RING_SIZE; i++){
+        ring[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand(); /* Upper bits are not part of the sample */
+    }
+
+    const uint32_t positions[] = { 0, 1, 5, RING_SIZE - 3, RING_SIZE - 1000, RING_SIZE + 7 };
+    const uint32_t sizes[] = { 0, 1, 3, 8, 17, 1000, 1500, RING_SIZE };
+    const uint8_t bits[] = { 14, 16, 12 };
+    const int32_t offsets[] = { 0, 37, -120 };
+    const uint32_t gains[] = { 32768, 31000, 34500 };
+    /* A base that is not a power of 2 takes the division path */
+    const uint32_t bases[] = { 32768, 30000 };
+
+    for (size_t b = 0; b < sizeof(bits); b++)
+    for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++)
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        uint32_t size = sizes[s];
+        for (int sign = 0; sign < 2; sign++){
+            acq_ReadRawCnts(ring, RING_SIZE, positions[p], size, bits[b], sign, raw);
+            refRaw(ring, positions[p], size, bits[b], sign, raw_ref);
+            if (memcmp(raw, raw_ref, size * sizeof(int16_t))){
+                printf("FAIL raw bits %d pos %u size %u signed %d\n", bits[b], positions[p], size, sign);
+                failed++;
+            }
+        }
+        for (size_t c = 0; c < sizeof(offsets) / sizeof(offsets[0]); c++)
+        for (size_t d = 0; d < sizeof(bases) / sizeof(bases[0]); d++){
+            acq_volt_param_t param = { bits[b], gains[c], bases[d], offsets[c], 1.1f };
+            acq_ReadVolts(ring, RING_SIZE, positions[p], size, &param, volts, NULL);
+            acq_ReadVolts(ring, RING_SIZE, positions[p], size, &param, NULL, volts_d);
+            refVolts(ring, positions[p], size, &param, volts_ref);
+            for (uint32_t i = 0; i < size; i++){
+                if (volts[i] != volts_ref[i] || volts_d[i] != (double)volts_ref[i]){
+                    printf("FAIL volts bits %d base %u pos %u size %u index %u: %f != %f\n", bits[b], bases[d], positions[p], size, i, volts[i], volts_ref[i]);
+                    failed++;
+                    break;
+                }
+            }
+        }
+    }
+
+    acq_volt_param_t param = { 14, 31000, 32768, 37, 1.0f };
+    const int loops = 200;
+    double t0 = nowUs();
+    for (int i = 0; i < loops; i++) refVolts(ring, i, RING_SIZE, &param, volts_ref);
+    double t1 = nowUs();
+    for (int i = 0; i < loops; i++) acq_ReadVolts(ring, RING_SIZE, i, RING_SIZE, &param, volts, NULL);
+    double t2 = nowUs();
+    printf("16k volts read: reference %.1f us, kernel %.1f us\n", (t1 - t0) / loops, (t2 - t1) / loops);
+
+    if (failed){
+        printf("FAILED %d checks\n", failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @brief Test of the single pass measurement kernel against a per sample reference
+ *
+ * Builds on the board with -DBUILD_TEST=ON (NEON path) or on x86 (scalar path):
+ *   gcc -O2 -std=gnu11 -Isrc test/acq_measure_test.c src/acq_measure.c -lm -o acq_measure_test
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "acq_measure.h"
+
+#define RING_SIZE (16 * 1024)
+
+static int32_t refCnts(uint32_t word, uint8_t bits, bool is_signed){
+    uint32_t cnts = word & (((uint64_t)1 << bits) - 1);
+    if (is_signed && (cnts & (1 << (bits - 1)))){
+        return (int32_t)cnts - (1 << bits);
+    }
+    return cnts;
+}
+
+/* Reference: separate passes as the workers did, the trigger one sample at a time */
+static void refMeasure(const uint32_t *ring, uint32_t pos, uint32_t size, uint8_t bits, bool is_signed, int32_t low, int32_t high, acq_meas_t *out){
+    memset(out, 0, sizeof(*out));
+    out->min = INT32_MAX;
+    out->max = INT32_MIN;
+    for (uint32_t i = 0; i < size; i++){
+        int32_t x = refCnts(ring[(pos + i) % RING_SIZE], bits, is_signed);
+        if (x < out->min) out->min = x;
+        if (x > out->max) out->max = x;
+        out->sum += x;
+        out->sum_sq += (uint64_t)((int64_t)x * x);
+    }
+    if (low > high || size == 0){
+        return;
+    }
+    float level = ((float)low + (float)high) / 2;
+    int32_t level_i = (int32_t)ceilf(level);
+    int state = 0; /* 0 unknown, 1 low, 2 high */
+    float cross = 0;
+    int32_t prev = refCnts(ring[pos % RING_SIZE], bits, is_signed);
+    for (uint32_t i = 0; i < size; i++){
+        int32_t x = refCnts(ring[(pos + i) % RING_SIZE], bits, is_signed);
+        bool up = prev < level_i && x >= level_i;
+        bool down = prev >= level_i && x < level_i;
+        if ((state == 2 && down) || (state != 2 && up)){
+            cross = (float)(i - 1) + (level - prev) / (float)(x - prev);
+        }
+        if (state == 2 && x < low){
+            if (out->falling++ == 0) out->first_falling = cross;
+            out->last_falling = cross;
+            state = 1;
+        } else if (state != 2 && x >= high){
+            if (state == 1){
+                if (out->rising++ == 0) out->first_rising = cross;
+                out->last_rising = cross;
+            }
+            state = 2;
+        } else if (state != 2 && x < low){
+            state = 1;
+        }
+        prev = x;
+    }
+}
+
+static uint32_t toWord(int32_t x, uint8_t bits){
+    /* Upper bits are not part of the sample */
+    return ((uint32_t)rand() << bits) | ((uint32_t)x & (((uint64_t)1 << bits) - 1));
+}
+
+static double nowUs(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(){
+    static uint32_t ring[RING_SIZE];
+    int failed = 0;
+
+    srand(1);
+    const uint32_t positions[] = { 0, 1, 5, RING_SIZE - 3, RING_SIZE - 1000, RING_SIZE + 7 };
+    const uint32_t sizes[] = { 0, 1, 3, 8, 17, 1000, 1500, RING_SIZE };
+    const uint8_t bits[] = { 14, 16, 12 };
+    const float periods[] = { 37.3f, 1000.5f, 5000.0f };
+
+    for (size_t b = 0; b < sizeof(bits); b++)
+    for (size_t w = 0; w < sizeof(periods) / sizeof(periods[0]) + 1; w++){
+        int32_t amp = (1 << (bits[b] - 1)) / 2;
+        for (int i = 0; i < RING_SIZE; i++){
+            /* Noisy sines and uniform noise as the last case */
+            int32_t x = w < sizeof(periods) / sizeof(periods[0])
+                ? (int32_t)(amp * sinf(2 * M_PI * i / periods[w])) + rand() % 41 - 20
+                : rand() % (2 * amp) - amp;
+            ring[i] = toWord(x, bits[b]);
+        }
+        for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++)
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        for (int h = 0; h < 3; h++){
+            /* Hysteresis of 0, 64 counts and none (edges disabled) */
+            int32_t low = h == 0 ? 10 : (h == 1 ? -32 : 1);
+            int32_t high = h == 0 ? 10 : (h == 1 ? 32 : 0);
+            acq_meas_t m, r;
+            acq_MeasureCnts(ring, RING_SIZE, positions[p], sizes[s], bits[b], true, low, high, &m);
+            refMeasure(ring, positions[p], sizes[s], bits[b], true, low, high, &r);
+            if (memcmp(&m, &r, sizeof(m))){
+                printf("FAIL bits %d wave %zu pos %u size %u hyst %d: min %d/%d max %d/%d rising %u/%u falling %u/%u first %f/%f last %f/%f\n",
+                       bits[b], w, positions[p], sizes[s], h, m.min, r.min, m.max, r.max, m.rising, r.rising, m.falling, r.falling,
+                       m.first_rising, r.first_rising, m.last_rising, r.last_rising);
+                failed++;
+            }
+        }
+    }
+
+    /* Unsigned counts */
+    for (int i = 0; i < RING_SIZE; i++){
+        ring[i] = toWord(8192 + (int32_t)(4000 * sinf(2 * M_PI * i / 300.0f)), 14);
+    }
+    acq_meas_t m, r;
+    acq_MeasureCnts(ring, RING_SIZE, 0, RING_SIZE, 14, false, 8000, 8400, &m);
+    refMeasure(ring, 0, RING_SIZE, 14, false, 8000, 8400, &r);
+    if (memcmp(&m, &r, sizeof(m))){
+        printf("FAIL unsigned\n");
+        failed++;
+    }
+    if (m.rising < 2 || fabsf((m.last_rising - m.first_rising) / (m.rising - 1) - 300.0f) > 0.01f){
+        printf("FAIL period %f\n", (m.last_rising - m.first_rising) / (m.rising - 1));
+        failed++;
+    }
+
+    /* Display bins, across the chunk size and the ring end */
+    static acq_bin_t bins[2048];
+    const uint32_t bin_lens[] = { 1, 2, 7, 8, 16, 600, 2048 };
+    for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++)
+    for (size_t l = 0; l < sizeof(bin_lens) / sizeof(bin_lens[0]); l++){
+        uint32_t n = RING_SIZE / bin_lens[l] < 2048 ? RING_SIZE / bin_lens[l] : 2048;
+        acq_MeasureBins(ring, RING_SIZE, positions[p], bin_lens[l], n, 14, false, true, bins);
+        for (uint32_t b = 0; b < n; b++){
+            uint32_t start = (positions[p] + b * bin_lens[l]) % RING_SIZE;
+            refMeasure(ring, start, bin_lens[l], 14, false, 1, 0, &r);
+            uint32_t min_pos = 0, max_pos = 0;
+            while (refCnts(ring[(start + min_pos) % RING_SIZE], 14, false) != r.min) min_pos++;
+            while (refCnts(ring[(start + max_pos) % RING_SIZE], 14, false) != r.max) max_pos++;
+            if (bins[b].min != r.min || bins[b].max != r.max || bins[b].sum != r.sum
+                || bins[b].min_pos != min_pos || bins[b].max_pos != max_pos){
+                printf("FAIL bins pos %u len %u bin %u: min %d/%d at %u/%u max %d/%d at %u/%u\n",
+                       positions[p], bin_lens[l], b, bins[b].min, r.min, bins[b].min_pos, min_pos,
+                       bins[b].max, r.max, bins[b].max_pos, max_pos);
+                failed++;
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < RING_SIZE; i++){
+        ring[i] = toWord((int32_t)(4000 * sinf(2 * M_PI * i / 1000.0f)), 14);
+    }
+    const int loops = 200;
+    double t0 = nowUs();
+    for (int i = 0; i < loops; i++) refMeasure(ring, i, RING_SIZE, 14, true, -400, 400, &r);
+    double t1 = nowUs();
+    for (int i = 0; i < loops; i++) acq_MeasureCnts(ring, RING_SIZE, i, RING_SIZE, 14, true, -400, 400, &m);
+    double t2 = nowUs();
+    printf("16k measurement: reference %.1f us, kernel %.1f us\n", (t1 - t0) / loops, (t2 - t1) / loops);
+    for (int i = 0; i < loops; i++) acq_MeasureBins(ring, RING_SIZE, i, 16, 1024, 14, true, false, bins);
+    double t3 = nowUs();
+    for (int i = 0; i < loops; i++) acq_MeasureBins(ring, RING_SIZE, i, 16, 1024, 14, true, true, bins);
+    double t4 = nowUs();
+    printf("16k in 1024 bins: kernel %.1f us, with positions %.1f us\n", (t3 - t2) / loops, (t4 - t3) / loops);
+
+    if (failed){
+        printf("FAILED %d checks\n", failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
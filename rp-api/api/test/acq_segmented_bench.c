@@ -0,0 +1,109 @@
+/**
+ * @brief Benchmark of the trigger rate and dead time of the segmented acquisition
+ *
+ * Runs on the board, builds with -DBUILD_TEST=ON.
+ * Usage: rp_acq_segmented_bench [records] [pre] [post] [decimation]
+ * The trigger source is RP_TRIG_SRC_NOW, so every record is captured as soon as the
+ * trigger is armed and the measured rate is the upper limit. The same number of records
+ * is also captured with the single shot loop: start, trigger, wait, read.
+ * With the simulated backend the writer is slower than the ADC clock, there the trigger to trigger
+ * time of the segmented records shows the gaps between them in ADC time.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "redpitaya/rp.h"
+
+static double nowS(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void printResult(const char *name, uint32_t records, double time, double record_time){
+    double period = time / records;
+    printf("%-12s %8u records %10.1f triggers/s  dead time %10.2f us per record\n",
+           name, records, records / time, (period - record_time) * 1e6);
+}
+
+int main(int argc, char **argv){
+    uint32_t records = argc > 1 ? atoi(argv[1]) : 1000;
+    uint32_t pre = argc > 2 ? atoi(argv[2]) : 256;
+    uint32_t post = argc > 3 ? atoi(argv[3]) : 768;
+    uint32_t decimation = argc > 4 ? atoi(argv[4]) : 1;
+
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(decimation);
+    float rate = 0;
+    rp_AcqGetSamplingRateHz(&rate);
+    double record_time = (pre + post) / rate;
+
+    // Single shot loop
+    int16_t *buffer = malloc((size_t)records * (pre + post) * sizeof(int16_t));
+    rp_AcqSetTriggerDelay(post - ADC_BUFFER_SIZE / 2);
+    uint32_t last_tp = ADC_BUFFER_SIZE, stale = 0;
+    double start = nowS();
+    for (uint32_t i = 0; i < records; i++){
+        rp_AcqStart();
+        rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+        rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+        bool fill = false;
+        while (state != RP_TRIG_STATE_TRIGGERED || !fill){
+            rp_AcqGetTriggerState(&state);
+            rp_AcqGetBufferFillState(&fill);
+        }
+        uint32_t tp = 0;
+        rp_AcqGetWritePointerAtTrig(&tp);
+        stale += tp == last_tp;
+        last_tp = tp;
+        uint32_t size = pre + post;
+        rp_AcqGetDataRaw(RP_CH_1, tp + ADC_BUFFER_SIZE - pre, &size, buffer + (size_t)i * (pre + post));
+    }
+    printResult("single shot", records, nowS() - start, record_time);
+    if (stale){
+        // The simulator applies the arm on its next step, until then the old trigger and fill state is read
+        printf("%-12s %8u records with the trigger pointer of the previous one\n", "stale", stale);
+    }
+
+    // Segmented
+    if (rp_AcqSegmentedInit(records, pre, post) != RP_OK){
+        fprintf(stderr, "Segment store init failed!\n");
+        rp_Release();
+        return 1;
+    }
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    uint32_t captured = 0;
+    start = nowS();
+    rp_AcqSegmentedCapture(records, 10000, &captured);
+    double time = nowS() - start;
+    if (captured){
+        printResult("segmented", captured, time, record_time);
+
+        rp_acq_segment_info_t *info = malloc(captured * sizeof(rp_acq_segment_info_t));
+        rp_AcqSegmentedGetInfo(0, captured, info);
+        uint32_t invalid = 0;
+        for (uint32_t i = 0; i < captured; i++){
+            invalid += !info[i].valid;
+        }
+        if (captured > 1){
+            double span = (info[captured - 1].timestamp_ns - info[0].timestamp_ns) * 1e-9;
+            printf("%-12s trigger to trigger %10.2f us, %u invalid records\n", "timestamps", span / (captured - 1) * 1e6, invalid);
+        }
+        start = nowS();
+        rp_AcqSegmentedGetDataRaw(RP_CH_1, 0, captured, buffer);
+        printf("%-12s %10.2f us per record\n", "read raw", (nowS() - start) / captured * 1e6);
+        free(info);
+    }
+
+    free(buffer);
+    rp_Release();
+    return 0;
+}
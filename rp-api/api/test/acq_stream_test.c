@@ -0,0 +1,103 @@
+/**
+ * @brief Test of the continuous acquisition cursor against a simulated writer
+ *
+ * Builds on the board with -DBUILD_TEST=ON or on x86:
+ *   gcc -O2 -std=gnu11 -Isrc test/acq_stream_test.c src/acq_stream.c -o acq_stream_test
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "acq_stream.h"
+
+#define RING_SIZE (16 * 1024)
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+/* Writer at a constant rate. written is the absolute number of samples, the write pointer is the last one */
+static uint32_t writePointer(uint64_t written){
+    return (uint32_t)((written + RING_SIZE - 1) % RING_SIZE);
+}
+
+/* Polls with random intervals up to max_poll seconds and reads all or a random part of the unread samples.
+ * Every sample must be either read in order or counted as lost */
+static void testRandom(double rate, double max_poll, bool read_all, bool expect_overrun, const char *name){
+    acq_stream_t s;
+    double time = 1.0;
+    uint64_t start = (uint64_t)(time * rate);
+    acq_stream_Reset(&s, RING_SIZE, writePointer(start), time);
+
+    uint64_t read = start;
+    bool ok = true;
+    bool overrun = false;
+    for (int i = 0; i < 100000 && ok; i++){
+        time += max_poll * (rand() / (double)RAND_MAX);
+        uint64_t written = (uint64_t)(time * rate);
+        acq_stream_Update(&s, writePointer(written), time, rate);
+        overrun |= s.overrun;
+        s.overrun = false;
+
+        // Unread samples end at the write pointer and start at the cursor
+        ok &= s.unread <= RING_SIZE;
+        ok &= s.read_pos == (written - s.unread) % RING_SIZE;
+        // Lost samples are skipped, the rest is read in order
+        ok &= (written - start) == (read - start) + s.lost + s.unread;
+
+        uint32_t count = read_all ? s.unread : rand() % (s.unread + 1);
+        acq_stream_Consume(&s, count);
+        read += count;
+    }
+    CHECK(ok, name);
+    CHECK(overrun == expect_overrun, name);
+}
+
+/* A poll after several laps of the ring is detected through the elapsed time */
+static void testLaps(){
+    acq_stream_t s;
+    double rate = 125e6;
+    acq_stream_Reset(&s, RING_SIZE, writePointer(1000), 0);
+    uint64_t written = 1000 + 5 * RING_SIZE + 100;
+    uint32_t dropped = acq_stream_Update(&s, writePointer(written), (written - 1000) / rate, rate);
+    CHECK(s.overrun && dropped == 0, "laps overrun");
+    CHECK(s.lost + s.unread == written - 1000, "laps lost");
+
+    // Without the rate the same write pointer looks like 100 new samples
+    acq_stream_Reset(&s, RING_SIZE, writePointer(1000), 0);
+    acq_stream_Update(&s, writePointer(written), (written - 1000) / rate, 0);
+    CHECK(!s.overrun && s.unread == 100, "stopped writer");
+}
+
+/* Samples overwritten while they were read are reported by the next update */
+static void testDropped(){
+    acq_stream_t s;
+    acq_stream_Reset(&s, RING_SIZE, writePointer(0), 0);
+    acq_stream_Update(&s, writePointer(RING_SIZE - 10), 1, 0);
+    CHECK(s.unread == RING_SIZE - 10, "dropped unread");
+    uint32_t dropped = acq_stream_Update(&s, writePointer(RING_SIZE + 20), 2, 0);
+    CHECK(dropped > 0 && s.overrun, "dropped reported");
+    CHECK(s.unread + s.lost == RING_SIZE + 20, "dropped count");
+}
+
+int main(){
+    srand(1234);
+    // Reader keeps up: polls more often than the ring fills
+    testRandom(1e6, 0.5 * RING_SIZE / 1e6, true, false, "reader in time");
+    testRandom(125e6, 0.5 * RING_SIZE / 125e6, true, false, "reader in time 125M");
+    // Reader leaves samples unread and falls behind
+    testRandom(1e6, 0.5 * RING_SIZE / 1e6, false, true, "reader partial");
+    // Reader polls too late and misses several laps
+    testRandom(1e6, 5.0 * RING_SIZE / 1e6, true, true, "reader late");
+    testLaps();
+    testDropped();
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @brief Benchmark of the generator waveform upload latency
+ *
+ * Runs on the board, builds with -DBUILD_TEST=ON.
+ * Measures a switch between waveforms which are already in the synthesis cache,
+ * the upload of new arbitrary data, which is synthesized and converted every time,
+ * and checks the conversion kernel against cmn_convertToCnt.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "redpitaya/rp.h"
+#include "common.h"
+#include "gen_kernels.h"
+
+#define LOOPS 1000
+
+static double nowUs(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int checkKernel(){
+    static float in[DAC_BUFFER_SIZE];
+    static int32_t out[DAC_BUFFER_SIZE];
+    const gen_cnt_param_t params[] = {
+        { 14, true, 1, 1, 0 },
+        { 16, true, 1, 1, 0 },
+        { 14, false, 1, 1, 0 },
+        { 14, true, 2, 0.5, 12 },
+        { 12, true, 0.9f, 1.1, -3 },
+    };
+    int errors = 0;
+    for (uint32_t i = 0; i < DAC_BUFFER_SIZE; i++){
+        in[i] = 2.5f * sinf(i * 0.01f) + (i % 7 == 0 ? 0.5f / 8192 : 0);
+    }
+    for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++){
+        const gen_cnt_param_t *param = &params[p];
+        gen_ConvertToCnts(in, DAC_BUFFER_SIZE, param, out);
+        for (uint32_t i = 0; i < DAC_BUFFER_SIZE; i++){
+            if ((uint32_t)out[i] != cmn_convertToCnt(in[i], param->bits, param->fullScale, param->is_signed, param->gain, param->offset)){
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+static double benchSwitch(){
+    const rp_waveform_t waveforms[] = { RP_WAVEFORM_SINE, RP_WAVEFORM_TRIANGLE, RP_WAVEFORM_RAMP_UP, RP_WAVEFORM_PWM };
+    double total = 0;
+    for (int i = 0; i < LOOPS; i++){
+        double start = nowUs();
+        rp_GenWaveform(RP_CH_1, waveforms[i % 4]);
+        total += nowUs() - start;
+    }
+    return total / LOOPS;
+}
+
+static double benchArbitrary(){
+    static float data[DAC_BUFFER_SIZE];
+    double total = 0;
+    rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY);
+    for (int i = 0; i < LOOPS; i++){
+        for (uint32_t j = 0; j < DAC_BUFFER_SIZE; j++){
+            data[j] = sinf(2 * M_PI * j / DAC_BUFFER_SIZE * (1 + i % 5));
+        }
+        double start = nowUs();
+        rp_GenArbWaveform(RP_CH_1, data, DAC_BUFFER_SIZE);
+        total += nowUs() - start;
+    }
+    return total / LOOPS;
+}
+
+int main(){
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+    int errors = checkKernel();
+    printf("Kernel mismatches: %d\n", errors);
+    rp_GenReset();
+    printf("Cached waveform switch: %.2f us\n", benchSwitch());
+    printf("Arbitrary upload:       %.2f us\n", benchArbitrary());
+    rp_Release();
+    return errors ? 1 : 0;
+}
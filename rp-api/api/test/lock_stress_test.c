@@ -0,0 +1,131 @@
+/**
+ * @brief Concurrency stress test of the library locking
+ *
+ * Builds on x86 with -DBUILD_SIM=ON -DBUILD_TEST=ON like sim_backend_test.
+ * Readers convert a captured DC level while other threads change the gain of the other
+ * channel, publish the calibration again and reconfigure both generator channels.
+ * The output enable bits of both channels share one register, each thread checks that
+ * the bit of its channel is never lost.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "redpitaya/rp.h"
+#include "rp_hw-calib.h"
+#include "sim_backend.h"
+
+#define READERS 4
+#define LOOPS 2000
+
+static atomic_int g_errors = 0;
+static atomic_bool g_stop = false;
+
+static void* reader(void *arg){
+    (void)arg;
+    float buf[1024];
+    while (!atomic_load(&g_stop)){
+        uint32_t size = 1024;
+        if (rp_AcqGetDataV(RP_CH_1, 0, &size, buf) != RP_OK || size != 1024){
+            atomic_fetch_add(&g_errors, 1);
+            continue;
+        }
+        for (uint32_t i = 0; i < size; i++){
+            if (fabsf(buf[i] - 0.25f) > 0.01f){
+                atomic_fetch_add(&g_errors, 1);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void* gainChanger(void *arg){
+    (void)arg;
+    for (int i = 0; i < LOOPS; i++){
+        rp_AcqSetGain(RP_CH_2, i % 2 ? RP_HIGH : RP_LOW);
+        rp_AcqSetTriggerLevel(RP_T_CH_2, 0.1f);
+    }
+    return NULL;
+}
+
+static void* calibPublisher(void *arg){
+    (void)arg;
+    rp_calib_params_t calib = rp_GetCalibrationSettings();
+    for (int i = 0; i < LOOPS; i++){
+        rp_CalibrationSetParams(calib);
+    }
+    return NULL;
+}
+
+static void* generator(void *arg){
+    rp_channel_t ch = *(rp_channel_t*)arg;
+    const rp_waveform_t waveforms[] = { RP_WAVEFORM_SINE, RP_WAVEFORM_SQUARE, RP_WAVEFORM_TRIANGLE, RP_WAVEFORM_PWM };
+    for (int i = 0; i < LOOPS; i++){
+        bool enable = i % 2;
+        bool state = !enable;
+        rp_GenWaveform(ch, waveforms[i % 4]);
+        rp_GenFreq(ch, 1000 + i);
+        if (enable){
+            rp_GenOutEnable(ch);
+        }else{
+            rp_GenOutDisable(ch);
+        }
+        rp_GenOutIsEnabled(ch, &state);
+        if (state != enable){
+            atomic_fetch_add(&g_errors, 1);
+        }
+    }
+    return NULL;
+}
+
+int main(){
+    setenv("RP_HW_PROFILE_MODEL", "STEM_125-14_v1.1", 0);
+    sim_SetTimeScale(0);
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+
+    sim_source_t dc = { RP_SIM_SRC_DC, 0, 0.25f, 0, 0 };
+    sim_SetSource(0, &dc);
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(1);
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    sim_Step(4 * ADC_BUFFER_SIZE);
+    rp_AcqStop();
+
+    pthread_t readers[READERS], gain, calib, gen[2];
+    rp_channel_t channels[2] = { RP_CH_1, RP_CH_2 };
+    for (int i = 0; i < READERS; i++){
+        pthread_create(&readers[i], NULL, reader, NULL);
+    }
+    pthread_create(&gain, NULL, gainChanger, NULL);
+    pthread_create(&calib, NULL, calibPublisher, NULL);
+    pthread_create(&gen[0], NULL, generator, &channels[0]);
+    pthread_create(&gen[1], NULL, generator, &channels[1]);
+
+    pthread_join(gain, NULL);
+    pthread_join(calib, NULL);
+    pthread_join(gen[0], NULL);
+    pthread_join(gen[1], NULL);
+    atomic_store(&g_stop, true);
+    for (int i = 0; i < READERS; i++){
+        pthread_join(readers[i], NULL);
+    }
+    rp_Release();
+
+    int errors = atomic_load(&g_errors);
+    if (errors){
+        printf("FAILED %d checks\n", errors);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}
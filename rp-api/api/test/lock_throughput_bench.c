@@ -0,0 +1,97 @@
+/**
+ * @brief Throughput of concurrent ADC readers with and without generator reconfiguration
+ *
+ * Runs on the board, builds with -DBUILD_TEST=ON.
+ * Every reader thread converts 1024 samples per call for one second. The run is repeated
+ * with a thread which changes the frequency and waveform of both generator channels.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "redpitaya/rp.h"
+
+#define MAX_READERS 4
+#define RUN_TIME_S 1.0
+
+static atomic_bool g_stop = false;
+
+static double nowS(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* reader(void *arg){
+    uint64_t *reads = (uint64_t*)arg;
+    float buf[1024];
+    while (!atomic_load_explicit(&g_stop, memory_order_relaxed)){
+        uint32_t size = 1024;
+        rp_AcqGetDataV(RP_CH_1, *reads * 1024, &size, buf);
+        (*reads)++;
+    }
+    return NULL;
+}
+
+static void* reconfigure(void *arg){
+    uint64_t *changes = (uint64_t*)arg;
+    const rp_waveform_t waveforms[] = { RP_WAVEFORM_SINE, RP_WAVEFORM_SQUARE };
+    while (!atomic_load_explicit(&g_stop, memory_order_relaxed)){
+        for (int ch = RP_CH_1; ch <= RP_CH_2; ch++){
+            rp_GenFreq(ch, 1000 + *changes % 1000);
+            rp_GenWaveform(ch, waveforms[*changes % 2]);
+        }
+        (*changes)++;
+    }
+    return NULL;
+}
+
+static void run(int readers, bool with_gen){
+    pthread_t threads[MAX_READERS], gen;
+    uint64_t reads[MAX_READERS] = {0};
+    uint64_t changes = 0;
+    atomic_store(&g_stop, false);
+    for (int i = 0; i < readers; i++){
+        pthread_create(&threads[i], NULL, reader, &reads[i]);
+    }
+    if (with_gen){
+        pthread_create(&gen, NULL, reconfigure, &changes);
+    }
+    double start = nowS();
+    while (nowS() - start < RUN_TIME_S){
+        struct timespec ts = { 0, 10000000 };
+        nanosleep(&ts, NULL);
+    }
+    atomic_store(&g_stop, true);
+    double time = nowS() - start;
+    uint64_t total = 0;
+    for (int i = 0; i < readers; i++){
+        pthread_join(threads[i], NULL);
+        total += reads[i];
+    }
+    if (with_gen){
+        pthread_join(gen, NULL);
+    }
+    printf("Readers: %d generator: %-3s reads/s: %10.0f per reader: %10.0f gen changes/s: %8.0f\n",
+           readers, with_gen ? "yes" : "no", total / time, total / time / readers, changes / time);
+}
+
+int main(){
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+    rp_AcqReset();
+    rp_GenReset();
+    for (int readers = 1; readers <= MAX_READERS; readers *= 2){
+        run(readers, false);
+        run(readers, true);
+    }
+    rp_Release();
+    return 0;
+}
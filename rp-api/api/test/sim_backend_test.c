@@ -0,0 +1,298 @@
+/**
+ * @brief Test of the acquisition and generation API against the simulated FPGA backend
+ *
+ * Builds on x86 with -DBUILD_SIM=ON -DBUILD_TEST=ON, after rp-hw-profiles and rp-hw-calib are installed
+ * to INSTALL_DIR with -DBUILD_SIM=ON. libi2c and api-250-12 are not needed.
+ * The model is stepped by hand, so the results do not depend on the host speed. The segmented
+ * capture runs it on its thread, the checks use the simulated time.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "redpitaya/rp.h"
+#include "sim_backend.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond, name) \
+    if (!(cond)) { printf("FAIL %s\n", name); g_failed++; }
+
+static bool triggered(){
+    rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+    rp_AcqGetTriggerState(&state);
+    return state == RP_TRIG_STATE_TRIGGERED;
+}
+
+static bool filled(){
+    bool fill = false;
+    rp_AcqGetBufferFillState(&fill);
+    return fill;
+}
+
+/* Steps the model until the samples after the trigger are written or the limit of decimated samples is reached */
+static bool capture(uint32_t decimation, uint32_t limit){
+    for (uint32_t i = 0; i < limit / 1024; i++){
+        sim_Step(1024 * decimation);
+        if (triggered() && filled()){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void testDC(){
+    sim_source_t a = { RP_SIM_SRC_DC, 0, 0.25f, 0, 0 };
+    sim_source_t b = { RP_SIM_SRC_DC, 0, -0.5f, 0, 0 };
+    sim_SetSource(0, &a);
+    sim_SetSource(1, &b);
+
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(1);
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    CHECK(capture(1, 4 * ADC_BUFFER_SIZE), "dc trigger");
+
+    float buf[1000];
+    uint32_t size = 1000;
+    rp_AcqGetDataV(RP_CH_1, 0, &size, buf);
+    bool ok = size == 1000;
+    for (uint32_t i = 0; i < size; i++) ok &= fabsf(buf[i] - 0.25f) < 0.01f;
+    CHECK(ok, "dc channel 1");
+    size = 1000;
+    rp_AcqGetDataV(RP_CH_2, 0, &size, buf);
+    ok = size == 1000;
+    for (uint32_t i = 0; i < size; i++) ok &= fabsf(buf[i] + 0.5f) < 0.01f;
+    CHECK(ok, "dc channel 2");
+}
+
+static void testLevelTrigger(){
+    sim_source_t a = { RP_SIM_SRC_SINE, 0.5f, 0, 1000, 0 };
+    sim_SetSource(0, &a);
+
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(64);
+    rp_AcqSetTriggerLevel(RP_T_CH_1, 0.1f);
+    rp_AcqSetTriggerDelay(0);
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE);
+    CHECK(capture(64, 8 * ADC_BUFFER_SIZE), "level trigger");
+
+    uint32_t tp = 0;
+    rp_AcqGetWritePointerAtTrig(&tp);
+    float buf[3];
+    uint32_t size = 3;
+    rp_AcqGetDataV(RP_CH_1, (tp + ADC_BUFFER_SIZE - 1) % ADC_BUFFER_SIZE, &size, buf);
+    CHECK(buf[0] < 0.1f && buf[1] >= 0.1f - 0.01f && buf[2] > buf[1], "level trigger edge");
+}
+
+static void testExtTrigger(){
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(8);
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_EXT_PE);
+    sim_Step(4 * ADC_BUFFER_SIZE * 8);
+    CHECK(!triggered(), "ext trigger waits");
+    sim_ExtTrigger();
+    CHECK(capture(8, 4 * ADC_BUFFER_SIZE), "ext trigger");
+}
+
+/* The capture waits for the writer, so the model runs on its thread here */
+static void testSegmented(){
+    sim_source_t a = { RP_SIM_SRC_SINE, 0.5f, 0, 10000, 0 };
+    sim_SetSource(0, &a);
+
+    const uint32_t records = 20, pre = 64, post = 256;
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(8);
+    rp_AcqSetTriggerLevel(RP_T_CH_1, 0.1f);
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE);
+    CHECK(rp_AcqSegmentedInit(records, pre, post) == RP_OK, "segmented init");
+
+    uint32_t captured = 0;
+    sim_SetTimeScale(1);
+    rp_AcqSegmentedCapture(records, 10000, &captured);
+    sim_SetTimeScale(0);
+    CHECK(captured == records, "segmented level records");
+
+    // One trigger per period of 1562.5 samples, the first one from the FPGA
+    rp_acq_segment_info_t info[20];
+    static float buf[20 * (64 + 256)];
+    rp_AcqSegmentedGetInfo(0, captured, info);
+    rp_AcqSegmentedGetDataV(RP_CH_1, 0, captured, buf);
+    bool ok = true;
+    for (uint32_t i = 0; i < captured; i++){
+        const float *r = buf + i * (pre + post);
+        ok &= info[i].valid && r[pre - 1] < 0.1f && r[pre] >= 0.1f - 0.01f;
+        if (i > 0){
+            uint32_t d = (info[i].trig_pos + ADC_BUFFER_SIZE - info[i - 1].trig_pos) % ADC_BUFFER_SIZE;
+            ok &= (d == 1562 || d == 1563) && info[i].pre_valid == pre;
+            ok &= llabs((int64_t)(info[i].timestamp_ns - info[i - 1].timestamp_ns) - 100000) <= 100;
+        }
+    }
+    CHECK(ok, "segmented level triggers");
+
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    sim_SetTimeScale(1);
+    rp_AcqSegmentedCapture(records, 10000, &captured);
+    sim_SetTimeScale(0);
+    CHECK(captured == records, "segmented now records");
+    rp_AcqSegmentedGetInfo(0, captured, info);
+    ok = true;
+    for (uint32_t i = 1; i < captured; i++){
+        ok &= info[i].valid && (info[i].trig_pos + ADC_BUFFER_SIZE - info[i - 1].trig_pos) % ADC_BUFFER_SIZE == pre + post;
+    }
+    CHECK(ok, "segmented now back to back");
+    rp_AcqSegmentedRelease();
+}
+
+/* Ramp of 4000 samples at decimation 1, each sample is 0.4 mV above the previous one */
+#define STREAM_RAMP_STEP (2 * 0.8f / 4000)
+
+/* Samples read in order continue the ramp, a gap or a repeated part breaks it */
+static bool rampContinues(float prev, float next){
+    return fabsf(next - prev - STREAM_RAMP_STEP) < 0.00025f || next - prev < -1.5f;
+}
+
+static bool streamSpan(rp_acq_stream_span_t *span){
+    return rp_AcqStreamGetSpan(0, 0, span) == RP_OK;
+}
+
+/* The writer is stepped by hand, the cursor follows the write pointer and the simulated time */
+static void testStream(){
+    sim_source_t a = { RP_SIM_SRC_RAMP, 0.8f, 0, 125e6 / 4000, 0 };
+    sim_SetSource(0, &a);
+
+    const uint32_t ring = ADC_BUFFER_SIZE, guard = ADC_BUFFER_SIZE / 8;
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(1);
+    rp_AcqStart();
+    sim_Step(1000);
+    CHECK(rp_AcqStreamStart() == RP_OK, "stream start");
+
+    // Reads across the end of the ring continue where the previous read stopped
+    static float buf[ADC_BUFFER_SIZE];
+    buffers_t out = { 0 };
+    out.ch_f[0] = buf;
+    rp_acq_stream_span_t span;
+    uint32_t expected_pos = 0;
+    float last = 0;
+    bool wrapped = false;
+    bool ok = true;
+    for (int i = 0; i < 10; i++){
+        sim_Step(5000);
+        out.size = ADC_BUFFER_SIZE;
+        ok &= rp_AcqStreamRead(0, 0, &out, &span) == RP_OK;
+        ok &= out.size == 5000 && span.size == 5000 && !span.overrun && span.lost == 0;
+        if (i > 0){
+            ok &= span.pos == expected_pos && rampContinues(last, buf[0]);
+        }
+        for (uint32_t j = 1; j < out.size; j++){
+            ok &= rampContinues(buf[j - 1], buf[j]);
+        }
+        wrapped |= span.pos + span.size > ring;
+        expected_pos = (span.pos + span.size) % ring;
+        last = buf[out.size - 1];
+    }
+    CHECK(ok && wrapped, "stream wrap");
+
+    // The view is split at the end of the ring, a partial release keeps the rest unread
+    sim_Step(ring - expected_pos + 100);
+    const volatile uint32_t *first = NULL, *second = NULL;
+    uint32_t first_size = 0, second_size = 0;
+    bool overwritten = true;
+    ok = streamSpan(&span) && span.pos == expected_pos && span.size == ring - expected_pos + 100;
+    ok &= rp_AcqStreamGetView(RP_CH_1, &span, &first, &first_size, &second, &second_size) == RP_OK;
+    ok &= first_size == ring - expected_pos && second_size == 100 && second + ring == first + first_size;
+    ok &= rp_AcqStreamRelease(1000, &overwritten) == RP_OK && !overwritten;
+    uint32_t unread = span.size - 1000;
+    ok &= streamSpan(&span) && span.pos == (expected_pos + 1000) % ring && span.size == unread;
+    CHECK(ok, "stream view and release");
+
+    // More than a lap without a read skips to the guard in front of the writer
+    uint32_t wp = 0;
+    uint64_t lost = 0;
+    sim_Step(ring + 5000);
+    rp_AcqGetWritePointer(&wp);
+    ok = streamSpan(&span) && span.overrun && span.size == ring - guard;
+    ok &= span.pos == (wp + 1 + guard) % ring;
+    ok &= span.lost == (uint64_t)unread + ring + 5000 - (ring - guard);
+    lost = span.lost;
+    ok &= streamSpan(&span) && !span.overrun && span.lost == lost;
+    CHECK(ok, "stream overrun");
+
+    // Several laps between two polls are counted from the simulated time
+    sim_Step(3 * ring + 300);
+    ok = streamSpan(&span) && span.overrun && span.size == ring - guard;
+    ok &= span.lost == lost + 3 * ring + 300;
+    lost = span.lost;
+    CHECK(ok, "stream laps");
+
+    // The writer reaches the samples while they are read, their release reports it
+    sim_Step(guard + 10);
+    overwritten = false;
+    ok = rp_AcqStreamRelease(span.size, &overwritten) == RP_OK && overwritten;
+    ok &= streamSpan(&span) && span.overrun && span.lost == lost + guard + 10;
+    ok &= span.size == guard + 10;
+    CHECK(ok, "stream release overwritten");
+
+    rp_AcqStreamStop();
+    rp_AcqStop();
+    CHECK(rp_AcqStreamGetSpan(0, 0, &span) != RP_OK, "stream stop");
+}
+
+static void testGenLoopback(){
+    sim_source_t a = { RP_SIM_SRC_GEN, 0, 0, 0, 0 };
+    sim_SetSource(0, &a);
+
+    rp_GenReset();
+    rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+    rp_GenFreq(RP_CH_1, 10000);
+    rp_GenAmp(RP_CH_1, 0.5f);
+    rp_GenOutEnable(RP_CH_1);
+    rp_GenTriggerOnly(RP_CH_1);
+
+    rp_AcqReset();
+    rp_AcqSetDecimationFactor(8);
+    rp_AcqStart();
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    CHECK(capture(8, 4 * ADC_BUFFER_SIZE), "loopback trigger");
+
+    // NOW fires at once, only the samples after the trigger belong to this capture
+    static float buf[ADC_BUFFER_SIZE / 2];
+    uint32_t tp = 0;
+    uint32_t size = ADC_BUFFER_SIZE / 2;
+    rp_AcqGetWritePointerAtTrig(&tp);
+    rp_AcqGetDataV(RP_CH_1, tp, &size, buf);
+    float min = buf[0], max = buf[0];
+    for (uint32_t i = 0; i < size; i++){
+        if (buf[i] < min) min = buf[i];
+        if (buf[i] > max) max = buf[i];
+    }
+    CHECK(fabsf(max - 0.5f) < 0.05f && fabsf(min + 0.5f) < 0.05f, "loopback amplitude");
+}
+
+int main(){
+    setenv("RP_HW_PROFILE_MODEL", "STEM_125-14_v1.1", 0);
+    sim_SetTimeScale(0);
+    if (rp_Init() != RP_OK){
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+    testDC();
+    testLevelTrigger();
+    testExtTrigger();
+    testSegmented();
+    testStream();
+    testGenLoopback();
+    rp_Release();
+    if (g_failed){
+        printf("FAILED %d checks\n", g_failed);
+        return 1;
+    }
+    printf("DONE\n");
+    return 0;
+}